@@ -10,6 +10,7 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cstdlib>
 #include <fstream>
 #include <functional>
@@ -93,6 +94,46 @@ class CaptureBufferCollector: public vtparser::NullParserEvents
     }
 };
 
+// Collects the reply to XTMETRICS, `DCS > y <report> ST`.
+class MetricsReportCollector: public vtparser::NullParserEvents
+{
+  public:
+    std::string report;
+    bool done = false;
+
+    void clear() override { _leader = 0; }
+    void collectLeader(char leader) override { _leader = leader; }
+
+    void hook(char function) override
+    {
+        _collecting = _leader == '>' && function == 'y';
+        if (_collecting)
+            report.clear();
+    }
+
+    void put(char ch) override
+    {
+        if (_collecting)
+            report += ch;
+    }
+
+    void put(std::string_view chars) override
+    {
+        if (_collecting)
+            report += chars;
+    }
+
+    void unhook() override
+    {
+        done = done || _collecting;
+        _collecting = false;
+    }
+
+  private:
+    char _leader = 0;
+    bool _collecting = false;
+};
+
 namespace
 {
     struct TTY
@@ -277,17 +318,26 @@ namespace
     }
 } // namespace
 
+namespace
+{
+    timeval toTimeval(double seconds)
+    {
+        auto constexpr MicrosPerSecond = 1'000'000;
+        auto const timeoutMicros = int(seconds * MicrosPerSecond);
+        auto timeout = timeval {};
+        timeout.tv_sec = timeoutMicros / MicrosPerSecond;
+        timeout.tv_usec = timeoutMicros % MicrosPerSecond;
+        return timeout;
+    }
+} // namespace
+
 bool captureScreen(CaptureSettings const& settings)
 {
     auto tty = TTY {};
     if (!tty.configured)
         return false;
 
-    auto constexpr MicrosPerSecond = 1'000'000;
-    auto const timeoutMicros = int(settings.timeout * MicrosPerSecond);
-    auto timeout = timeval {};
-    timeout.tv_sec = timeoutMicros / MicrosPerSecond;
-    timeout.tv_usec = timeoutMicros % MicrosPerSecond;
+    auto timeout = toTimeval(settings.timeout);
 
     auto const screenSizeOpt = tty.screenSize(&timeout);
     if (!screenSizeOpt.has_value())
@@ -320,4 +370,56 @@ bool captureScreen(CaptureSettings const& settings)
     return readCaptureReply(tty, &timeout, settings.words, output);
 }
 
+bool reportMetrics(double timeoutSeconds)
+{
+    auto tty = TTY {};
+    if (!tty.configured)
+        return false;
+
+    auto timeout = toTimeval(timeoutSeconds);
+    tty.write("\033[>y");
+
+    auto collector = MetricsReportCollector {};
+    auto parser = vtparser::Parser<vtparser::ParserEvents> { collector };
+    while (!collector.done)
+    {
+        auto const rv = tty.wait(&timeout);
+        if (rv < 0)
+        {
+            perror("select");
+            return false;
+        }
+        if (rv == 0)
+        {
+            cerr << "Time out. VTE did not respond to XTMETRICS `CSI > y`.\r\n";
+            return false;
+        }
+
+        char buf[4096];
+        auto const n = tty.read(buf, sizeof(buf));
+        if (n < 0)
+        {
+            perror("read");
+            return false;
+        }
+        parser.parseFragment(string_view(buf, static_cast<size_t>(n)));
+    }
+
+    // The report is of the form: enabled=<0|1>;<name>:<key>=<value>,...;...
+    auto const entries = crispy::split(collector.report, ';');
+    if (entries.empty() || entries.front() != "enabled=1"sv)
+        cout << "Metrics are not being collected. Use `contour metrics enable` to start collecting.\n";
+    for (auto const entry: entries)
+    {
+        auto const separator = entry.find(':');
+        if (separator == string_view::npos)
+            continue;
+        auto summary = string(entry.substr(separator + 1));
+        std::replace(summary.begin(), summary.end(), ',', ' ');
+        cout << fmt::format("{:<30} {}\n", entry.substr(0, separator), summary);
+    }
+
+    return true;
+}
+
 } // namespace contour
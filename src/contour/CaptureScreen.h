@@ -20,4 +20,9 @@ struct CaptureSettings
 
 bool captureScreen(CaptureSettings const& settings);
 
+/// Queries the connected terminal for its performance metrics (XTMETRICS) and prints them to standard output.
+///
+/// @param timeoutSeconds time to wait for the terminal to respond.
+bool reportMetrics(double timeoutSeconds);
+
 } // namespace contour
@@ -1625,6 +1625,13 @@ namespace
                 terminalProfile.permissions.displayHostWritableStatusLine = x.value();
         }
 
+        strValue = "ask";
+        if (tryLoadChildRelative(usedKeys, profile, basePath, "permissions.report_metrics", strValue, logger))
+        {
+            if (auto x = toPermission(strValue))
+                terminalProfile.permissions.reportMetrics = x.value();
+        }
+
         if (tryLoadChildRelative(
                 usedKeys, profile, basePath, "font.size", terminalProfile.fonts.size.pt, logger))
         {
@@ -1781,6 +1788,16 @@ namespace
                 terminalProfile.maxHistoryLineCount = LineCount(0);
         }
 
+        intValue = LineCount(0);
+        if (tryLoadChildRelative(usedKeys, profile, basePath, "history.spill_after", intValue, logger))
+        {
+            // value 0 keeps the whole history in memory
+            if (unbox(intValue) > 0)
+                terminalProfile.historySpillThreshold = intValue;
+            else
+                terminalProfile.historySpillThreshold = std::nullopt;
+        }
+
         tryLoadChildRelative(
             usedKeys, profile, basePath, "option_as_alt", terminalProfile.optionKeyAsAlt, logger);
 
@@ -2163,6 +2180,7 @@ void loadConfigFromFile(Config& config, fs::path const& fileName)
         if (!logFilePath.empty())
         {
             config.loggingSink = make_shared<logstore::sink>(logEnabled, make_shared<ofstream>(logFilePath));
+            config.loggingSink->set_async(true);
             logstore::set_sink(*config.loggingSink);
         }
     }
@@ -2171,6 +2189,9 @@ void loadConfigFromFile(Config& config, fs::path const& fileName)
     tryLoadValue(usedKeys, doc, "images.sixel_register_count", config.maxImageColorRegisters, logger);
     tryLoadValue(usedKeys, doc, "images.max_width", config.maxImageSize.width, logger);
     tryLoadValue(usedKeys, doc, "images.max_height", config.maxImageSize.height, logger);
+    if (auto maxImageMemoryMB = static_cast<unsigned>(config.maxImageMemory / (1024 * 1024));
+        tryLoadValue(usedKeys, doc, "images.max_memory", maxImageMemoryMB, logger))
+        config.maxImageMemory = static_cast<size_t>(maxImageMemoryMB) * 1024 * 1024;
 
     if (auto colorschemes = doc["color_schemes"]; colorschemes)
     {
@@ -2238,6 +2259,10 @@ void loadConfigFromFile(Config& config, fs::path const& fileName)
         config.ptyBufferObjectSize = 1024 * 256;
     }
 
+    tryLoadValue(usedKeys, doc, "pty_buffer_huge_pages", config.ptyBufferHugePages, logger);
+
+    tryLoadValue(usedKeys, doc, "io_threads", config.ioThreadCount, logger);
+
     tryLoadValue(usedKeys, doc, "reflow_on_resize", config.reflowOnResize, logger);
 
     tryLoadValue(usedKeys, doc, "default_profile", config.defaultProfileName, logger);
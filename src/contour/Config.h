@@ -174,6 +174,7 @@ struct TerminalProfile
     vtbackend::VTType terminalId = vtbackend::VTType::VT525;
 
     vtbackend::MaxHistoryLineCount maxHistoryLineCount = vtbackend::LineCount(1000);
+    std::optional<vtbackend::LineCount> historySpillThreshold;
     vtbackend::LineCount historyScrollMultiplier = vtbackend::LineCount(3);
     ScrollBarPosition scrollbarPosition = ScrollBarPosition::Right;
     vtbackend::StatusDisplayPosition statusDisplayPosition = vtbackend::StatusDisplayPosition::Bottom;
@@ -190,6 +191,7 @@ struct TerminalProfile
         Permission captureBuffer = Permission::Ask;
         Permission changeFont = Permission::Ask;
         Permission displayHostWritableStatusLine = Permission::Ask;
+        Permission reportMetrics = Permission::Ask;
     } permissions;
 
     bool drawBoldTextWithBrightColors = false;
@@ -279,6 +281,14 @@ struct Config
     // Defaults to 1 MB, that's roughly 10k lines when column count is 100.
     size_t ptyBufferObjectSize = 1024lu * 1024lu;
 
+    // Whether PTY Buffer Objects are to be backed by transparent huge pages, where supported.
+    bool ptyBufferHugePages = false;
+
+    // Number of threads that process the PTY input of all terminal sessions together.
+    //
+    // With 0, every terminal session processes its PTY input on a thread of its own.
+    size_t ioThreadCount = 0;
+
     bool reflowOnResize = true;
 
     std::unordered_map<std::string, vtbackend::ColorPalette> colorschemes;
@@ -332,6 +342,7 @@ struct Config
     bool sixelScrolling = true;
     vtbackend::ImageSize maxImageSize = {}; // default to runtime system screen size.
     unsigned maxImageColorRegisters = 4096;
+    size_t maxImageMemory = vtbackend::ImagePool::DefaultMemoryBudget;
 
     std::set<std::string> experimentalFeatures;
 };
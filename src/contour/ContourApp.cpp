@@ -155,6 +155,10 @@ ContourApp::ContourApp(): app("contour", "Contour Terminal Emulator", CONTOUR_VE
     link("contour.capture", bind(&ContourApp::captureAction, this));
     link("contour.list-debug-tags", bind(&ContourApp::listDebugTagsAction, this));
     link("contour.set.profile", bind(&ContourApp::profileAction, this));
+    link("contour.metrics.report", bind(&ContourApp::metricsReportAction, this));
+    link("contour.metrics.enable", bind(&ContourApp::metricsAction, this, 1));
+    link("contour.metrics.disable", bind(&ContourApp::metricsAction, this, 2));
+    link("contour.metrics.reset", bind(&ContourApp::metricsAction, this, 3));
     link("contour.generate.parser-table", bind(&ContourApp::parserTableAction, this));
     link("contour.generate.terminfo", bind(&ContourApp::terminfoAction, this));
     link("contour.generate.config", bind(&ContourApp::configAction, this));
@@ -294,6 +298,21 @@ int ContourApp::profileAction()
     return EXIT_SUCCESS;
 }
 
+int ContourApp::metricsReportAction()
+{
+    if (contour::reportMetrics(parameters().get<double>("contour.metrics.report.timeout")))
+        return EXIT_SUCCESS;
+    else
+        return EXIT_FAILURE;
+}
+
+int ContourApp::metricsAction(int control)
+{
+    // See XTMETRICS: 1 = start collecting, 2 = stop collecting, 3 = discard the collected metrics.
+    cout << fmt::format("\033[>{}y", control);
+    return EXIT_SUCCESS;
+}
+
 crispy::cli::command ContourApp::parameterDefinition() const
 {
     return CLI::command {
@@ -383,6 +402,22 @@ crispy::cli::command ContourApp::parameterDefinition() const
                                   "FILE",
                                   CLI::presence::Required },
                 } },
+            CLI::command {
+                "metrics",
+                "Performance metrics of the currently running terminal, such as input and render latencies.",
+                CLI::option_list {},
+                CLI::command_list {
+                    CLI::command { "report",
+                                   "Prints the performance metrics collected so far.",
+                                   CLI::option_list { CLI::option {
+                                       "timeout",
+                                       CLI::value { 1.0 },
+                                       "Sets timeout seconds to wait for terminal to respond.",
+                                       "SECONDS" } } },
+                    CLI::command { "enable", "Starts collecting performance metrics." },
+                    CLI::command { "disable", "Stops collecting performance metrics." },
+                    CLI::command { "reset", "Discards the performance metrics collected so far." },
+                } },
             CLI::command {
                 "set",
                 "Sets various aspects of the connected terminal.",
@@ -21,6 +21,8 @@ class ContourApp: public crispy::app
     int listDebugTagsAction();
     int parserTableAction();
     int profileAction();
+    int metricsReportAction();
+    int metricsAction(int control);
     int terminfoAction();
     int configAction();
     int integrationAction();
@@ -128,8 +128,10 @@ namespace
 
         settings.pageSize = profile.terminalSize;
         settings.ptyBufferObjectSize = config.ptyBufferObjectSize;
+        settings.ptyBufferHugePages = config.ptyBufferHugePages;
         settings.ptyReadBufferSize = config.ptyReadBufferSize;
         settings.maxHistoryLineCount = profile.maxHistoryLineCount;
+        settings.historySpillThreshold = profile.historySpillThreshold;
         settings.copyLastMarkRangeOffset = profile.copyLastMarkRangeOffset;
         settings.cursorBlinkInterval = profile.inputModes.insert.cursor.cursorBlinkInterval;
         settings.cursorShape = profile.inputModes.insert.cursor.cursorShape;
@@ -139,6 +141,7 @@ namespace
         settings.mouseProtocolBypassModifiers = config.bypassMouseProtocolModifiers;
         settings.maxImageSize = config.maxImageSize;
         settings.maxImageRegisterCount = config.maxImageColorRegisters;
+        settings.maxImageMemory = config.maxImageMemory;
         settings.statusDisplayType = profile.initialStatusDisplayType;
         settings.statusDisplayPosition = profile.statusDisplayPosition;
         settings.syncWindowTitleWithHostWritableStatusDisplay =
@@ -218,6 +221,8 @@ TerminalSession::~TerminalSession()
         _exitWatcherThread->terminate();
     if (_screenUpdateThread)
         _screenUpdateThread->join();
+    if (_inputReactor)
+        _inputReactor->remove(_terminal);
 }
 
 void TerminalSession::detachDisplay(display::TerminalDisplay& display)
@@ -264,7 +269,14 @@ void TerminalSession::start()
 {
     sessionLog()("Starting terminal session.");
     _terminal.device().start();
-    _screenUpdateThread = make_unique<std::thread>(bind(&TerminalSession::mainLoop, this));
+    _inputReactor = _app.sessionsManager().inputReactor();
+    if (_inputReactor)
+    {
+        sessionLog()("Processing PTY input on the shared input reactor.");
+        _inputReactor->add(_terminal, [this]() { onClosed(); });
+    }
+    else
+        _screenUpdateThread = make_unique<std::thread>(bind(&TerminalSession::mainLoop, this));
     _exitWatcherThread->start(QThread::LowPriority);
 }
 
@@ -363,6 +375,7 @@ void TerminalSession::executeRole(GuardedRole role, bool allow, bool remember)
         case GuardedRole::ShowHostWritableStatusLine:
             executeShowHostWritableStatusLine(allow, remember);
             break;
+        case GuardedRole::ReportMetrics: executePendingMetricsRequest(allow, remember); break;
     }
 }
 
@@ -396,6 +409,7 @@ void TerminalSession::requestPermission(config::Permission allowedByConfig, Guar
                     case GuardedRole::ChangeFont: emit requestPermissionForFontChange(); break;
                     case GuardedRole::CaptureBuffer: emit requestPermissionForBufferCapture(); break;
                     case GuardedRole::ShowHostWritableStatusLine: emit requestPermissionForShowHostWritableStatusLine(); break;
+                    case GuardedRole::ReportMetrics: emit requestPermissionForReportMetrics(); break;
                         // clang-format on
                 }
             }
@@ -450,6 +464,39 @@ void TerminalSession::executePendingBufferCapture(bool allow, bool remember)
     flushInput();
 }
 
+void TerminalSession::requestMetrics(vtbackend::MetricsRequest request)
+{
+    if (!_display)
+        return;
+
+    {
+        auto const _ = std::scoped_lock { _pendingMetricsRequestsMutex };
+        _pendingMetricsRequests.emplace_back(request);
+    }
+
+    _display->post(
+        [this]() { requestPermission(_profile.permissions.reportMetrics, GuardedRole::ReportMetrics); });
+}
+
+void TerminalSession::executePendingMetricsRequest(bool allow, bool remember)
+{
+    if (remember)
+        _rememberedPermissions[GuardedRole::ReportMetrics] = allow;
+
+    auto requests = std::vector<vtbackend::MetricsRequest> {};
+    {
+        auto const _ = std::scoped_lock { _pendingMetricsRequestsMutex };
+        std::swap(requests, _pendingMetricsRequests);
+    }
+
+    if (!allow || requests.empty())
+        return;
+
+    for (auto const request: requests)
+        _terminal.executeMetricsRequest(request);
+    flushInput();
+}
+
 void TerminalSession::requestShowHostWritableStatusLine()
 {
     if (_display)
@@ -1451,6 +1498,7 @@ void TerminalSession::configureTerminal()
     _terminal.setTerminalId(_profile.terminalId);
     _terminal.setMaxImageColorRegisters(_config.maxImageColorRegisters);
     _terminal.setMaxImageSize(_config.maxImageSize);
+    _terminal.setMaxImageMemory(_config.maxImageMemory);
     _terminal.setMode(vtbackend::DECMode::NoSixelScrolling, !_config.sixelScrolling);
     _terminal.setStatusDisplay(_profile.initialStatusDisplayType);
     sessionLog()("maxImageSize={}, sixelScrolling={}", _config.maxImageSize, _config.sixelScrolling);
@@ -1462,6 +1510,7 @@ void TerminalSession::configureTerminal()
     configureCursor(_profile.inputModes.insert.cursor);
     updateColorPreference(_app.colorPreference());
     _terminal.setMaxHistoryLineCount(_profile.maxHistoryLineCount);
+    _terminal.setHistorySpillThreshold(_profile.historySpillThreshold);
     _terminal.setHighlightTimeout(_profile.highlightTimeout);
     _terminal.viewport().setScrollOff(_profile.modalCursorScrollOff);
 }
@@ -6,6 +6,7 @@
 #include <contour/Config.h>
 #include <contour/helper.h>
 
+#include <vtbackend/InputReactor.h>
 #include <vtbackend/Terminal.h>
 
 #include <vtrasterizer/Renderer.h>
@@ -42,6 +43,7 @@ enum class GuardedRole
     ChangeFont,
     CaptureBuffer,
     ShowHostWritableStatusLine,
+    ReportMetrics,
 };
 
 /**
@@ -223,6 +225,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     Q_INVOKABLE void applyPendingFontChange(bool answer, bool remember);
     Q_INVOKABLE void executePendingBufferCapture(bool answer, bool remember);
     Q_INVOKABLE void executeShowHostWritableStatusLine(bool answer, bool remember);
+    Q_INVOKABLE void executePendingMetricsRequest(bool answer, bool remember);
     Q_INVOKABLE void adaptToWidgetSize();
 
     void updateColorPreference(vtbackend::ColorPreference preference);
@@ -230,6 +233,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     // vtbackend::Events
     //
     void requestCaptureBuffer(vtbackend::LineCount lineCount, bool logical) override;
+    void requestMetrics(vtbackend::MetricsRequest request) override;
     void bell() override;
     void bufferChanged(vtbackend::ScreenType) override;
     void renderBufferUpdated() override;
@@ -370,6 +374,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     void requestPermissionForFontChange();
     void requestPermissionForBufferCapture();
     void requestPermissionForShowHostWritableStatusLine();
+    void requestPermissionForReportMetrics();
     void showNotification(QString const& title, QString const& content);
     void fontSizeChanged();
 
@@ -419,6 +424,7 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
     bool _terminating = false;
     std::thread::id _mainLoopThreadID {};
     std::unique_ptr<std::thread> _screenUpdateThread;
+    vtbackend::InputReactor* _inputReactor = nullptr; // Processes the PTY input instead, if set.
 
     // state vars
     //
@@ -436,6 +442,8 @@ class TerminalSession: public QAbstractItemModel, public vtbackend::Terminal::Ev
         bool logical;
     };
     std::optional<CaptureBufferRequest> _pendingBufferCapture;
+    std::vector<vtbackend::MetricsRequest> _pendingMetricsRequests; // in the order they were made
+    std::mutex _pendingMetricsRequestsMutex;
     std::optional<vtbackend::FontDef> _pendingFontChange;
     PermissionCache _rememberedPermissions;
     std::unique_ptr<QThread> _exitWatcherThread;
@@ -469,6 +477,7 @@ struct formatter<contour::GuardedRole>
             case contour::GuardedRole::ChangeFont: return fmt::format_to(ctx.out(), "Change Font");
             case contour::GuardedRole::CaptureBuffer: return fmt::format_to(ctx.out(), "Capture Buffer");
             case contour::GuardedRole::ShowHostWritableStatusLine:  return fmt::format_to(ctx.out(), "show Host Writable Statusline");
+            case contour::GuardedRole::ReportMetrics: return fmt::format_to(ctx.out(), "Report Metrics");
                 // clang-format on
         }
         crispy::unreachable();
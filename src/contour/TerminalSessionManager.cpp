@@ -67,6 +67,18 @@ void TerminalSessionManager::removeSession(TerminalSession& thatSession)
     // Notify app if all sessions have been killed to trigger app termination.
 }
 
+vtbackend::InputReactor* TerminalSessionManager::inputReactor()
+{
+    auto const threadCount = _app.config().ioThreadCount;
+    if (!threadCount || !vtbackend::InputReactor::supported())
+        return nullptr;
+
+    if (!_inputReactor)
+        _inputReactor = make_unique<vtbackend::InputReactor>(threadCount);
+
+    return _inputReactor.get();
+}
+
 void TerminalSessionManager::updateColorPreference(vtbackend::ColorPreference const& preference)
 {
     for (auto& session: _sessions)
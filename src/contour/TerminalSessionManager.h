@@ -3,9 +3,12 @@
 #include <contour/TerminalSession.h>
 #include <contour/helper.h>
 
+#include <vtbackend/InputReactor.h>
+
 #include <QtCore/QAbstractListModel>
 #include <QtQml/QQmlEngine>
 
+#include <memory>
 #include <vector>
 
 namespace contour
@@ -37,6 +40,10 @@ class TerminalSessionManager: public QAbstractListModel
 
     void updateColorPreference(vtbackend::ColorPreference const& preference);
 
+    /// Returns the reactor that processes the PTY input of all sessions,
+    /// or nullptr if every session is to process its input on a thread of its own.
+    [[nodiscard]] vtbackend::InputReactor* inputReactor();
+
   private:
     std::unique_ptr<vtpty::Pty> createPty();
 
@@ -44,6 +51,7 @@ class TerminalSessionManager: public QAbstractListModel
     std::chrono::seconds _earlyExitThreshold;
 
     std::vector<TerminalSession*> _sessions;
+    std::unique_ptr<vtbackend::InputReactor> _inputReactor;
 };
 
 } // namespace contour
@@ -669,22 +669,16 @@ void TerminalDisplay::paint()
         auto const _ = gsl::finally([this]() { window()->endExternalCommands(); });
 #endif
 
-        [[maybe_unused]] auto const lastState = _state.fetchAndClear();
-
-#if defined(CONTOUR_PERF_STATS)
-        {
-            ++renderCount_;
-            auto const updateCount = stats_.updatesSinceRendering.exchange(0);
-            auto const renderCount = stats_.consecutiveRenderCount.exchange(0);
-            if (displayLog)
-                displayLog()("paintGL/{}: {} renders, {} updates since last paint ({}/{}).",
-                             renderCount_.load(),
-                             renderCount,
-                             updateCount,
-                             lastState,
-                             to_string(_session->terminal().renderBufferState()));
-        }
-#endif
+        auto const lastState = _state.fetchAndClear();
+
+        ++_renderCount;
+        auto const updateCount = _updatesSinceRendering.exchange(0);
+        if (displayLog)
+            displayLog()("paintGL/{}: {} updates since last paint ({}/{}).",
+                         _renderCount.load(),
+                         updateCount,
+                         lastState,
+                         to_string(_session->terminal().renderBufferState()));
 
         terminal().tick(steady_clock::now());
         _renderer->render(terminal(), _renderingPressure);
@@ -245,9 +245,7 @@ class TerminalDisplay: public QQuickItem
     /// otherwise.
     bool setScreenDirty()
     {
-#if defined(CONTOUR_PERF_STATS)
-        stats_.updatesSinceRendering++;
-#endif
+        _updatesSinceRendering++;
         return _state.touch();
     }
 
@@ -277,17 +275,9 @@ class TerminalDisplay: public QQuickItem
 
     vtbackend::LineCount _lastHistoryLineCount = vtbackend::LineCount(0);
 
-    // ======================================================================
-
-#if defined(CONTOUR_PERF_STATS)
-    struct Stats
-    {
-        std::atomic<uint64_t> updatesSinceRendering = 0;
-        std::atomic<uint64_t> consecutiveRenderCount = 0;
-    };
-    Stats stats_;
-    std::atomic<uint64_t> renderCount_ = 0;
-#endif
+    // Number of frames painted and screen updates since the last one, for logging.
+    std::atomic<uint64_t> _renderCount = 0;
+    std::atomic<uint64_t> _updatesSinceRendering = 0;
 };
 
 } // namespace contour::display
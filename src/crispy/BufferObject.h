@@ -10,8 +10,10 @@
 
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iterator>
 #include <list>
@@ -19,6 +21,12 @@
 #include <mutex>
 #include <string_view>
 
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+
+    #include <unistd.h>
+#endif
+
 #define BUFFER_OBJECT_INLINE 1
 
 namespace crispy
@@ -41,6 +49,19 @@ auto const inline bufferObjectLog = logstore::category("BufferObject",
                                                        logstore::category::state::Disabled,
                                                        logstore::category::visibility::Hidden);
 
+/// Describes the memory a buffer_object's storage is allocated from.
+enum class buffer_object_memory : uint8_t
+{
+    /// Heap memory, allocated via malloc().
+    Heap,
+
+    /// Anonymous memory mapping, with all pages faulted in upfront where supported.
+    Mapped,
+
+    /// Like Mapped, but additionally advised to be backed by transparent huge pages.
+    HugePages,
+};
+
 /**
  * BufferObject is the buffer object a Pty's read-call will use to store
  * the read data.
@@ -63,7 +84,14 @@ class buffer_object: public std::enable_shared_from_this<buffer_object<T>>
     explicit buffer_object(size_t capacity) noexcept;
     ~buffer_object();
 
-    static buffer_object_ptr<T> create(size_t capacity, buffer_object_release<T> release = {});
+    static buffer_object_ptr<T> create(size_t capacity,
+                                       buffer_object_release<T> release = {},
+                                       buffer_object_memory memory = buffer_object_memory::Heap);
+
+    /// Destroys a buffer object that has been created via create().
+    static void destroy(buffer_object* ptr) noexcept;
+
+    [[nodiscard]] buffer_object_memory memory() const noexcept { return _memory; }
 
     void reset() noexcept;
 
@@ -121,6 +149,7 @@ class buffer_object: public std::enable_shared_from_this<buffer_object<T>>
 #endif
     T* _hotEnd;
     T* _end;
+    buffer_object_memory _memory = buffer_object_memory::Heap;
 
     friend class BufferFragment<T>;
 
@@ -138,7 +167,8 @@ template <typename T>
 class buffer_object_pool
 {
   public:
-    explicit buffer_object_pool(size_t bufferSize = 4096);
+    explicit buffer_object_pool(size_t bufferSize = 4096,
+                                buffer_object_memory memory = buffer_object_memory::Heap);
     ~buffer_object_pool();
 
     void releaseUnusedBuffers();
@@ -150,6 +180,7 @@ class buffer_object_pool
 
     bool _reuseBuffers = true;
     size_t _bufferSize;
+    buffer_object_memory _memory;
     std::list<buffer_object_ptr<T>> _unusedBuffers;
 };
 
@@ -236,9 +267,43 @@ buffer_object<T>::~buffer_object()
 }
 
 template <typename T>
-buffer_object_ptr<T> buffer_object<T>::create(size_t capacity, buffer_object_release<T> release)
+buffer_object_ptr<T> buffer_object<T>::create(size_t capacity,
+                                              buffer_object_release<T> release,
+                                              [[maybe_unused]] buffer_object_memory memory)
 {
 #if defined(BUFFER_OBJECT_INLINE)
+    #if !defined(_WIN32)
+    if (memory != buffer_object_memory::Heap)
+    {
+        // Large buffers are mapped directly, rounded up to whole (huge) pages rather than to the next power
+        // of two, and faulted in upfront so that reading into them never stalls on a page fault.
+        size_t constexpr HugePageSize = 2 * 1024 * 1024;
+        auto const pageSize = memory == buffer_object_memory::HugePages
+                                  ? HugePageSize
+                                  : static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        auto const totalCapacity = (sizeof(buffer_object) + capacity + pageSize - 1) / pageSize * pageSize;
+        auto flags = MAP_PRIVATE | MAP_ANONYMOUS;
+        #if defined(MAP_POPULATE)
+        if (memory == buffer_object_memory::Mapped)
+            flags |= MAP_POPULATE;
+        #endif
+        void* mapping = mmap(nullptr, totalCapacity, PROT_READ | PROT_WRITE, flags, -1, 0);
+        if (mapping != MAP_FAILED)
+        {
+        #if defined(MADV_HUGEPAGE)
+            if (memory == buffer_object_memory::HugePages)
+                madvise(mapping, totalCapacity, MADV_HUGEPAGE);
+        #endif
+            auto* ptr = new (mapping) buffer_object(totalCapacity - sizeof(buffer_object));
+            ptr->_memory = memory;
+            return buffer_object_ptr<T>(ptr, std::move(release));
+        }
+        bufferObjectLog()("Mapping {} failed. Falling back to heap memory. {}",
+                          crispy::humanReadableBytes(totalCapacity),
+                          strerror(errno));
+    }
+    #endif
+
     auto const totalCapacity = nextPowerOfTwo(static_cast<uint32_t>(sizeof(buffer_object) + capacity));
     auto const nettoCapacity = totalCapacity - sizeof(buffer_object);
     auto ptr = (buffer_object*) malloc(totalCapacity);
@@ -249,6 +314,26 @@ buffer_object_ptr<T> buffer_object<T>::create(size_t capacity, buffer_object_rel
 #endif
 }
 
+template <typename T>
+void buffer_object<T>::destroy(buffer_object* ptr) noexcept
+{
+#if defined(BUFFER_OBJECT_INLINE)
+    auto const memory = ptr->_memory;
+    auto const totalCapacity = sizeof(buffer_object) + ptr->capacity();
+    std::destroy_n(ptr, 1);
+    #if !defined(_WIN32)
+    if (memory != buffer_object_memory::Heap)
+    {
+        munmap(ptr, totalCapacity);
+        return;
+    }
+    #endif
+    free(ptr);
+#else
+    delete ptr;
+#endif
+}
+
 template <typename T>
 gsl::span<T const> buffer_object<T>::writeAtEnd(gsl::span<T const> data) noexcept
 {
@@ -335,7 +420,8 @@ inline std::size_t BufferFragment<T>::endOffset() const noexcept
 
 // {{{ BufferObjectPool implementation
 template <typename T>
-buffer_object_pool<T>::buffer_object_pool(size_t bufferSize): _bufferSize { bufferSize }
+buffer_object_pool<T>::buffer_object_pool(size_t bufferSize, buffer_object_memory memory):
+    _bufferSize { bufferSize }, _memory { memory }
 {
     bufferObjectLog()("Creating BufferObject pool with chunk size {}",
                       crispy::humanReadableBytes(bufferSize));
@@ -365,7 +451,7 @@ template <typename T>
 buffer_object_ptr<T> buffer_object_pool<T>::allocateBufferObject()
 {
     if (_unusedBuffers.empty())
-        return buffer_object<T>::create(_bufferSize, [this](auto p) { release(p); });
+        return buffer_object<T>::create(_bufferSize, [this](auto p) { release(p); }, _memory);
 
     buffer_object_ptr<T> buffer = std::move(_unusedBuffers.front());
     if (bufferObjectLog)
@@ -385,14 +471,7 @@ void buffer_object_pool<T>::release(buffer_object<T>* ptr)
         _unusedBuffers.emplace_back(ptr, [this](auto p) { release(p); });
     }
     else
-    {
-#if defined(BUFFER_OBJECT_INLINE)
-        std::destroy_n(ptr, 1);
-        free(ptr);
-#else
-        delete ptr;
-#endif
-    }
+        buffer_object<T>::destroy(ptr);
 }
 // }}}
 
@@ -7,3 +7,34 @@ TEST_CASE("buffer_object", "[buffer_object]")
 {
     // TODO
 }
+
+TEST_CASE("buffer_object_pool.mapped", "[buffer_object]")
+{
+    auto pool = crispy::buffer_object_pool<char>(256 * 1024, crispy::buffer_object_memory::Mapped);
+
+    auto buffer = pool.allocateBufferObject();
+    CHECK(buffer->capacity() >= 256 * 1024);
+    CHECK(buffer->bytesUsed() == 0);
+#if !defined(_WIN32)
+    CHECK(buffer->memory() == crispy::buffer_object_memory::Mapped);
+#endif
+
+    auto const text = std::string_view { "Hello, World!" };
+    auto const* const address = buffer.get();
+    {
+        auto const written = buffer->writeAtEnd(gsl::span<char const>(text.data(), text.size()));
+        buffer->advance(written.size());
+        auto const fragment = buffer->ref(0, text.size());
+        CHECK(fragment.view() == text);
+
+        // The fragment keeps the buffer alive.
+        buffer.reset();
+        CHECK(pool.unusedBuffers() == 0);
+    }
+
+    // Released buffers are recycled, and come back empty.
+    CHECK(pool.unusedBuffers() == 1);
+    buffer = pool.allocateBufferObject();
+    CHECK(buffer.get() == address);
+    CHECK(buffer->bytesUsed() == 0);
+}
@@ -19,7 +19,7 @@ struct CRISPY_PACKED owned
     owned(owned&& v) noexcept: _ptr { v.release() } {}
     owned& operator=(owned&& v) noexcept
     {
-        _ptr = v.release();
+        reset(v.release());
         return *this;
     }
 
@@ -73,6 +73,18 @@ struct lru_capacity
     uint32_t value;
 };
 
+// Number of entries reserved for newly created entries (probationary segment) in a
+// strong_lru_hashtable, or 0 for plain LRU.
+//
+// Newly created entries are put into the probationary segment at the back of the LRU chain,
+// and only make it into the protected segment at the front of the LRU chain
+// once they have been accessed again. Since eviction takes place in the probationary segment first,
+// a burst of entries that are used only once cannot flush the protected entries.
+struct lru_probation_capacity
+{
+    uint32_t value;
+};
+
 // LRU hashtable implementation with the goal to minimize runtime allocations
 // and maximize speed.
 //
@@ -85,7 +97,10 @@ template <typename Value>
 class strong_lru_hashtable
 {
   private:
-    strong_lru_hashtable(strong_hashtable_size hashCount, lru_capacity entryCount, std::string name);
+    strong_lru_hashtable(strong_hashtable_size hashCount,
+                         lru_capacity entryCount,
+                         std::string name,
+                         lru_probation_capacity probationCount);
 
   public:
     ~strong_lru_hashtable();
@@ -98,7 +113,8 @@ class strong_lru_hashtable
     template <typename Allocator = std::allocator<unsigned char>>
     [[nodiscard]] static ptr create(strong_hashtable_size hashCount,
                                     lru_capacity entryCount,
-                                    std::string name = "");
+                                    std::string name = "",
+                                    lru_probation_capacity probationCount = { 0 });
 
     /// Returns the actual number of entries currently hold in this hashtable.
     [[nodiscard]] size_t size() const noexcept;
@@ -106,6 +122,9 @@ class strong_lru_hashtable
     /// Returns the maximum number of entries that can be stored in this hashtable.
     [[nodiscard]] size_t capacity() const noexcept;
 
+    /// Returns the number of entries in the protected segment of the LRU chain.
+    [[nodiscard]] size_t protectedSize() const noexcept { return _protectedCount; }
+
     /// Returns the total storage sized used by this object.
     [[nodiscard]] size_t storageSize() const noexcept;
 
@@ -124,7 +143,8 @@ class strong_lru_hashtable
     void touch(strong_hash const& hash) noexcept;
 
     /// Returns an ordered list of keys in this hash.
-    /// Ordering is from most recent to least recent access.
+    /// Ordering is from most recent to least recent access, protected entries first,
+    /// which is the reverse of the eviction order.
     [[nodiscard]] std::vector<strong_hash> hashes() const;
 
     /// Tests for the exitence of the given hash key in this hash table.
@@ -211,6 +231,8 @@ class strong_lru_hashtable
 
         std::optional<Value> value = std::nullopt;
 
+        bool probationary = false;
+
 #if defined(DEBUG_STRONG_LRU_HASHTABLE)
         uint32_t ordering = 0;
 #endif
@@ -231,6 +253,13 @@ class strong_lru_hashtable
     // Relinks the given entry to the front of the LRU-chain.
     void linkToLRUChainHead(uint32_t entryIndex) noexcept;
 
+    // Links the given entry to the front of the probationary segment of the LRU-chain.
+    void linkToProbationHead(uint32_t entryIndex) noexcept;
+
+    // Moves the given entry to the front of the LRU-chain (protected segment) upon access,
+    // moving the least recently used protected entries back into the probationary segment if needed.
+    void promote(uint32_t entryIndex) noexcept;
+
     // Unlinks given entry from LRU chain without touching the entry itself.
     void unlinkFromLRUChain(entry& entry) noexcept;
 
@@ -258,6 +287,15 @@ class strong_lru_hashtable
     lru_capacity _capacity;
     std::string _name;
 
+    // Maximum number of entries in the protected segment (front) of the LRU chain.
+    uint32_t _protectedCapacity;
+
+    // Number of entries in the protected segment of the LRU chain.
+    uint32_t _protectedCount = 0;
+
+    // First entry of the probationary segment (back) of the LRU chain, or 0 if empty.
+    uint32_t _probationHead = 0;
+
     // The hash table maps hash codes to indices into the entry table.
     uint32_t* _hashTable;
     entry* _entries;
@@ -272,12 +310,14 @@ class strong_lru_hashtable
 template <typename Value>
 strong_lru_hashtable<Value>::strong_lru_hashtable(strong_hashtable_size hashCount,
                                                   lru_capacity entryCount,
-                                                  std::string name):
+                                                  std::string name,
+                                                  lru_probation_capacity probationCount):
     _stats {},
     _hashMask { hashCount.value - 1 },
     _hashCount { hashCount },
     _capacity { entryCount },
     _name { std::move(name) },
+    _protectedCapacity { entryCount.value - probationCount.value },
     _hashTable { (uint32_t*) (this + 1) },
     _entries { [this]() {
         constexpr uintptr_t Alignment = std::alignment_of_v<entry>;
@@ -293,6 +333,7 @@ strong_lru_hashtable<Value>::strong_lru_hashtable(strong_hashtable_size hashCoun
     Require(detail::isPowerOfTwo(hashCount.value));
     Require(hashCount.value >= 1);
     Require(entryCount.value >= 2);
+    Require(probationCount.value <= entryCount.value);
 
     memset(_hashTable, 0, hashCount.value * sizeof(uint32_t));
 
@@ -328,7 +369,8 @@ template <typename Value>
 template <typename Allocator>
 auto strong_lru_hashtable<Value>::create(strong_hashtable_size hashCount,
                                          lru_capacity entryCount,
-                                         std::string name) -> ptr
+                                         std::string name,
+                                         lru_probation_capacity probationCount) -> ptr
 {
     // payload memory layout
     // =====================
@@ -350,7 +392,7 @@ auto strong_lru_hashtable<Value>::create(strong_hashtable_size hashCount,
     // clang-format on
 
     memset((void*) obj, 0, size);
-    new (obj) strong_lru_hashtable(hashCount, entryCount, std::move(name));
+    new (obj) strong_lru_hashtable(hashCount, entryCount, std::move(name), probationCount);
 
     auto deleter = [size, allocator = std::move(allocator)](auto p) mutable {
         std::destroy_n(p, 1);
@@ -423,6 +465,8 @@ void strong_lru_hashtable<Value>::clear()
 
     auto const oldSize = static_cast<int>(_size);
     _size = 0;
+    _protectedCount = 0;
+    _probationHead = 0;
     validateChange(-oldSize);
 }
 
@@ -446,12 +490,8 @@ void strong_lru_hashtable<Value>::remove(strong_hash const& hash)
     if (entryIndex == 0)
         return;
 
-    entry& prev = _entries[ent->prevInLRU];
-    entry& next = _entries[ent->nextInLRU];
+    unlinkFromLRUChain(*ent);
 
-    // unlink from LRU chain
-    prev.nextInLRU = ent->nextInLRU;
-    next.prevInLRU = ent->prevInLRU;
     if (prevWithSameHash)
     {
         Require(_entries[prevWithSameHash].nextWithSameHash == entryIndex);
@@ -468,8 +508,6 @@ void strong_lru_hashtable<Value>::remove(strong_hash const& hash)
     sentinel.nextWithSameHash = entryIndex;
 
     --_size;
-
-    validateChange(-1);
 }
 
 template <typename Value>
@@ -563,8 +601,7 @@ inline Value& strong_lru_hashtable<Value>::get_or_emplace(strong_hash const& has
         if (candidateEntry.hashValue == hash)
         {
             ++_stats.hits;
-            unlinkFromLRUChain(candidateEntry);
-            linkToLRUChainHead(entryIndex);
+            promote(entryIndex);
             return *candidateEntry.value;
         }
         entryIndex = candidateEntry.nextWithSameHash;
@@ -594,8 +631,7 @@ inline Value* strong_lru_hashtable<Value>::get_or_try_emplace(strong_hash const&
         if (candidateEntry.hashValue == hash)
         {
             ++_stats.hits;
-            unlinkFromLRUChain(candidateEntry);
-            linkToLRUChainHead(entryIndex);
+            promote(entryIndex);
             return &candidateEntry.value.value();
         }
         entryIndex = candidateEntry.nextWithSameHash;
@@ -709,6 +745,9 @@ void strong_lru_hashtable<Value>::inspect(std::ostream& output) const
     output << fmt::format("entry capacity      : {} ({} utilization)\n",
                           _capacity.value,
                           humanReadableUtiliation(_size, _capacity.value));
+    if (_protectedCapacity != _capacity.value)
+        output << fmt::format(
+            "protected entries   : {} (capacity {})\n", _protectedCount, _protectedCapacity);
     output << fmt::format("-------------------------------------------------------------\n", _name);
 }
 
@@ -733,8 +772,7 @@ uint32_t strong_lru_hashtable<Value>::findEntry(strong_hash const& hash, bool fo
     if (result)
     {
         ++_stats.hits;
-        unlinkFromLRUChain(*result);
-        linkToLRUChainHead(entryIndex);
+        promote(entryIndex);
     }
     else if (force)
     {
@@ -758,6 +796,12 @@ inline void strong_lru_hashtable<Value>::unlinkFromLRUChain(entry& ent) noexcept
 {
     entry& prev = _entries[ent.prevInLRU];
     entry& next = _entries[ent.nextInLRU];
+
+    if (!ent.probationary)
+        --_protectedCount;
+    else if (&ent == _entries + _probationHead)
+        _probationHead = ent.nextInLRU;
+
     prev.nextInLRU = ent.nextInLRU;
     next.prevInLRU = ent.prevInLRU;
 
@@ -775,8 +819,10 @@ inline void strong_lru_hashtable<Value>::linkToLRUChainHead(uint32_t entryIndex)
 
     newHead.nextInLRU = sentinel.nextInLRU;
     newHead.prevInLRU = 0;
+    newHead.probationary = false;
     oldHead.prevInLRU = entryIndex;
     sentinel.nextInLRU = entryIndex;
+    ++_protectedCount;
 
 #if defined(DEBUG_STRONG_LRU_HASHTABLE)
     newHead.ordering = sentinel.ordering++;
@@ -785,6 +831,51 @@ inline void strong_lru_hashtable<Value>::linkToLRUChainHead(uint32_t entryIndex)
     Require(validateChange(1) == static_cast<int>(_size));
 }
 
+template <typename Value>
+inline void strong_lru_hashtable<Value>::linkToProbationHead(uint32_t entryIndex) noexcept
+{
+    // The entry must be already unlinked.
+    // It is inserted in front of the current probation head, or at the tail if there is none.
+
+    entry& next = _entries[_probationHead];
+    entry& prev = _entries[next.prevInLRU];
+    entry& newHead = _entries[entryIndex];
+
+    newHead.prevInLRU = next.prevInLRU;
+    newHead.nextInLRU = _probationHead;
+    newHead.probationary = true;
+    prev.nextInLRU = entryIndex;
+    next.prevInLRU = entryIndex;
+    _probationHead = entryIndex;
+
+#if defined(DEBUG_STRONG_LRU_HASHTABLE)
+    newHead.ordering = sentinelEntry().ordering++;
+#endif
+
+    Require(validateChange(1) == static_cast<int>(_size));
+}
+
+template <typename Value>
+inline void strong_lru_hashtable<Value>::promote(uint32_t entryIndex) noexcept
+{
+    unlinkFromLRUChain(_entries[entryIndex]);
+    linkToLRUChainHead(entryIndex);
+
+    while (_protectedCount > _protectedCapacity)
+    {
+        // Demote the least recently used protected entry, which directly precedes the probationary segment,
+        // by moving the segment boundary.
+        uint32_t const demotedIndex = _entries[_probationHead].prevInLRU;
+        entry& demoted = _entries[demotedIndex];
+        demoted.probationary = true;
+        _probationHead = demotedIndex;
+        --_protectedCount;
+#if defined(DEBUG_STRONG_LRU_HASHTABLE)
+        demoted.ordering = sentinelEntry().ordering++;
+#endif
+    }
+}
+
 template <typename Value>
 uint32_t strong_lru_hashtable<Value>::allocateEntry(strong_hash const& hash, uint32_t* slot)
 {
@@ -807,7 +898,10 @@ uint32_t strong_lru_hashtable<Value>::allocateEntry(strong_hash const& hash, uin
     poppedEntry.nextWithSameHash = *slot;
     *slot = poppedEntryIndex;
 
-    linkToLRUChainHead(poppedEntryIndex);
+    if (_protectedCapacity == _capacity.value)
+        linkToLRUChainHead(poppedEntryIndex);
+    else
+        linkToProbationHead(poppedEntryIndex);
 
     return poppedEntryIndex;
 }
@@ -822,12 +916,8 @@ void strong_lru_hashtable<Value>::recycle()
 
     uint32_t const entryIndex = sentinel.prevInLRU;
     entry& ent = _entries[entryIndex];
-    entry& prev = _entries[ent.prevInLRU];
 
-    prev.nextInLRU = 0;
-    sentinel.prevInLRU = ent.prevInLRU;
-
-    validateChange(-1);
+    unlinkFromLRUChain(ent);
 
     uint32_t* nextIndex = hashTableSlot(ent.hashValue);
     while (*nextIndex != entryIndex)
@@ -853,9 +943,18 @@ inline int strong_lru_hashtable<Value>::validateChange(int adj)
     entry const& sentinel = sentinelEntry();
     size_t lastOrdering = sentinel.ordering;
 
+    bool probationary = false;
+
     for (uint32_t entryIndex = sentinel.nextInLRU; entryIndex != 0;)
     {
         entry const& entry = _entries[entryIndex];
+        if (entryIndex == _probationHead)
+        {
+            // Each segment is ordered on its own.
+            probationary = true;
+            lastOrdering = sentinel.ordering;
+        }
+        Require(entry.probationary == probationary);
         Require(entry.ordering < lastOrdering);
         lastOrdering = entry.ordering;
         entryIndex = entry.nextInLRU;
@@ -411,3 +411,47 @@ TEST_CASE("strong_lru_hashtable.peek", "")
         REQUIRE(joinHumanReadable(cache.hashes()) == sh(4, 3, 2, 1));
     }
 }
+
+TEST_CASE("strong_lru_hashtable.probation", "[lrucache]")
+{
+    auto cachePtr = strong_lru_hashtable<int>::create(
+        strong_hashtable_size { 16 }, lru_capacity { 6 }, "", lru_probation_capacity { 2 });
+    auto& cache = *cachePtr;
+
+    // New entries are admitted into the probationary segment only.
+    for (int i = 1; i <= 4; ++i)
+        cache[h(i)] = 2 * i;
+    CHECK(cache.protectedSize() == 0);
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(4, 3, 2, 1));
+
+    // Accessing them again promotes them into the protected segment.
+    for (int i = 1; i <= 4; ++i)
+        (void) cache.at(h(i));
+    CHECK(cache.protectedSize() == 4);
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(4, 3, 2, 1));
+
+    // A burst of entries that are used once only recycles the probationary segment.
+    for (int i = 100; i < 120; ++i)
+        cache[h(i)] = i;
+    CHECK(cache.size() == 6);
+    CHECK(cache.protectedSize() == 4);
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(4, 3, 2, 1, 119, 118));
+
+    // Exceeding the protected capacity demotes the least recently used protected entry.
+    (void) cache.at(h(118));
+    (void) cache.at(h(119));
+    CHECK(cache.protectedSize() == 4);
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(119, 118, 4, 3, 2, 1));
+
+    cache[h(5)] = 10;
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(119, 118, 4, 3, 5, 2));
+    CHECK(!cache.contains(h(1)));
+
+    cache.remove(h(5));
+    cache.remove(h(119));
+    CHECK(cache.protectedSize() == 3);
+    REQUIRE(joinHumanReadable(cache.hashes()) == sh(118, 4, 3, 2));
+
+    auto const stats = cache.fetchAndClearStats();
+    CHECK(stats.recycles == 19);
+}
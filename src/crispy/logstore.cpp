@@ -1,9 +1,281 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <crispy/logstore.h>
 
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+
 namespace logstore
 {
 
+namespace detail
+{
+    namespace
+    {
+        // Set once the asynchronous writer is gone, such that messages written during
+        // the destruction of static objects are still written, synchronously.
+        constinit std::atomic<bool> asyncWriterDestroyed = false; // NOLINT
+
+        // Size of the ring buffers created from now on.
+        constinit std::atomic<size_t> asyncBufferSize = sink::DefaultAsyncBufferSize; // NOLINT
+
+        struct record_header
+        {
+            sink* target;
+            category const* messageCategory;
+            source_location location;
+            std::chrono::system_clock::time_point time;
+            size_t textSize;
+        };
+
+        static_assert(std::is_trivially_copyable_v<record_header>);
+
+        constexpr size_t alignedRecordSize(size_t textSize) noexcept
+        {
+            return (sizeof(record_header) + textSize + 7) & ~size_t { 7 };
+        }
+
+        /// Single-producer single-consumer ring buffer of log records, owned by one logging thread.
+        class record_ring
+        {
+          public:
+            explicit record_ring(size_t capacity):
+                _capacity { capacity }, _data { std::make_unique<char[]>(capacity) }
+            {
+            }
+
+            [[nodiscard]] size_t capacity() const noexcept { return _capacity; }
+
+            /// Appends a record, or returns false if there is not enough room left for it.
+            bool try_push(record_header const& header, std::string_view text) noexcept
+            {
+                auto const size = alignedRecordSize(text.size());
+                auto const tail = _tail.load(std::memory_order_relaxed);
+                if (_capacity - (tail - _head.load(std::memory_order_acquire)) < size)
+                    return false;
+
+                copyIn(tail, &header, sizeof(header));
+                copyIn(tail + sizeof(header), text.data(), text.size());
+                _tail.store(tail + size, std::memory_order_release);
+                return true;
+            }
+
+            /// Removes all records that are available, passing them on to @p consume.
+            template <typename Consumer>
+            void pop_all(Consumer&& consume)
+            {
+                auto head = _head.load(std::memory_order_relaxed);
+                auto const tail = _tail.load(std::memory_order_acquire);
+                while (head != tail)
+                {
+                    auto header = record_header {};
+                    copyOut(head, &header, sizeof(header));
+                    auto text = std::string(header.textSize, '\0');
+                    copyOut(head + sizeof(header), text.data(), text.size());
+                    head += alignedRecordSize(header.textSize);
+                    _head.store(head, std::memory_order_release);
+                    consume(header, std::move(text));
+                }
+            }
+
+            [[nodiscard]] bool empty() const noexcept
+            {
+                return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+            }
+
+            std::atomic<bool> abandoned = false; // Set when the owning thread has exited.
+
+          private:
+            void copyIn(size_t position, void const* source, size_t count) noexcept
+            {
+                auto const offset = position % _capacity;
+                auto const first = std::min(count, _capacity - offset);
+                std::memcpy(_data.get() + offset, source, first);
+                std::memcpy(_data.get(), static_cast<char const*>(source) + first, count - first);
+            }
+
+            void copyOut(size_t position, void* target, size_t count) const noexcept
+            {
+                auto const offset = position % _capacity;
+                auto const first = std::min(count, _capacity - offset);
+                std::memcpy(target, _data.get() + offset, first);
+                std::memcpy(static_cast<char*>(target) + first, _data.get(), count - first);
+            }
+
+            size_t _capacity;
+            std::unique_ptr<char[]> _data;
+            alignas(64) std::atomic<size_t> _head = 0; // Advanced by the writer thread only.
+            alignas(64) std::atomic<size_t> _tail = 0; // Advanced by the owning thread only.
+        };
+
+        struct ring_holder
+        {
+            std::shared_ptr<record_ring> ring;
+
+            ~ring_holder()
+            {
+                if (ring)
+                    ring->abandoned = true;
+            }
+        };
+    } // namespace
+
+    /// Drains the ring buffers of all logging threads on a background thread.
+    class async_writer
+    {
+      public:
+        static async_writer& get()
+        {
+            static async_writer instance;
+            return instance;
+        }
+
+        async_writer(): _thread { [this]() { run(); } } {}
+
+        ~async_writer()
+        {
+            _running = false;
+            wake();
+            _thread.join();
+            drain();
+            asyncWriterDestroyed = true;
+        }
+
+        async_writer(async_writer const&) = delete;
+        async_writer(async_writer&&) = delete;
+        async_writer& operator=(async_writer const&) = delete;
+        async_writer& operator=(async_writer&&) = delete;
+
+        void enqueue(sink& target, message_builder const& message)
+        {
+            auto const text = std::string_view(message.text());
+            auto& ring = localRing();
+            if (alignedRecordSize(text.size()) > ring.capacity() / 2)
+            {
+                // Too large to be handed over. Writes it right away, after everything logged before.
+                drain();
+                target._writer(message.message());
+                return;
+            }
+
+            auto const header = record_header {
+                &target, &message.get_category(), message.location(), message.time(), text.size(),
+            };
+            while (!ring.try_push(header, text))
+                std::this_thread::yield();
+
+            // Only the first record after the writer went to sleep needs to wake it up.
+            if (!_pending.exchange(true, std::memory_order_acq_rel))
+                wake();
+        }
+
+        /// Writes all records that are available in any ring buffer.
+        ///
+        /// @returns true if there were any.
+        bool drain()
+        {
+            auto const _ = std::lock_guard { _drainMutex };
+
+            auto rings = std::vector<std::shared_ptr<record_ring>> {};
+            {
+                auto const _ = std::lock_guard { _ringsMutex };
+                rings = _rings;
+                std::erase_if(_rings, [](auto const& ring) { return ring->abandoned && ring->empty(); });
+            }
+
+            _records.clear();
+            for (auto const& ring: rings)
+                ring->pop_all([this](record_header const& header, std::string text) {
+                    _records.emplace_back(header, std::move(text));
+                });
+
+            if (_records.empty())
+                return false;
+
+            // Each ring holds the records of one thread in order, so it's only across threads
+            // that they need to be put in order.
+            if (rings.size() > 1)
+                std::stable_sort(_records.begin(), _records.end(), [](auto const& a, auto const& b) {
+                    return a.first.time < b.first.time;
+                });
+
+            // Writes consecutive messages to the same sink at once.
+            auto batch = std::string {};
+            auto* batchTarget = static_cast<sink*>(nullptr);
+            for (auto& [header, text]: _records)
+            {
+                if (header.target != batchTarget && !batch.empty())
+                {
+                    batchTarget->_writer(batch);
+                    batch.clear();
+                }
+                batchTarget = header.target;
+                auto const message =
+                    message_builder(*header.messageCategory, header.location, header.time, std::move(text));
+                batch += message.message();
+            }
+            if (!batch.empty())
+                batchTarget->_writer(batch);
+
+            return true;
+        }
+
+      private:
+        record_ring& localRing()
+        {
+            thread_local auto holder = ring_holder {};
+            if (!holder.ring)
+            {
+                holder.ring = std::make_shared<record_ring>(asyncBufferSize.load(std::memory_order_relaxed));
+                auto const _ = std::lock_guard { _ringsMutex };
+                _rings.emplace_back(holder.ring);
+            }
+            return *holder.ring;
+        }
+
+        void wake()
+        {
+            // Taking the lock ensures the writer is either waiting already or sees the flags set.
+            {
+                auto const _ = std::lock_guard { _wakeMutex };
+            }
+            _wakeCondition.notify_one();
+        }
+
+        void run()
+        {
+            while (true)
+            {
+                {
+                    auto lock = std::unique_lock { _wakeMutex };
+                    _wakeCondition.wait(lock, [this]() { return _pending.load() || !_running.load(); });
+                    if (!_running)
+                        return;
+                }
+
+                // Records pushed while draining wake the writer up again.
+                _pending.store(false, std::memory_order_release);
+                drain();
+            }
+        }
+
+        std::mutex _ringsMutex;
+        std::vector<std::shared_ptr<record_ring>> _rings;
+
+        std::mutex _drainMutex;
+        std::vector<std::pair<record_header, std::string>> _records;
+
+        std::mutex _wakeMutex;
+        std::condition_variable _wakeCondition;
+        std::atomic<bool> _pending = false; // Set when records have been pushed since the last drain.
+
+        std::atomic<bool> _running = true;
+        std::thread _thread;
+    };
+} // namespace detail
+
 sink::sink(bool enabled, writer wr): _enabled { enabled }, _writer { std::move(wr) }
 {
 }
@@ -24,6 +296,46 @@ sink::sink(bool enabled, std::shared_ptr<std::ostream> f):
 {
 }
 
+sink::~sink()
+{
+    set_async(false);
+}
+
+void sink::set_writer(writer writer)
+{
+    if (async())
+        flush();
+    _writer = std::move(writer);
+}
+
+void sink::set_async(bool async)
+{
+    if (async)
+        detail::async_writer::get();
+    else if (_async.load(std::memory_order_relaxed))
+        flush();
+    _async.store(async, std::memory_order_relaxed);
+}
+
+void sink::set_async_buffer_size(size_t bytes)
+{
+    detail::asyncBufferSize.store(bytes, std::memory_order_relaxed);
+}
+
+void sink::flush()
+{
+    if (!detail::asyncWriterDestroyed)
+        detail::async_writer::get().drain();
+}
+
+void sink::enqueue(message_builder const& message)
+{
+    if (detail::asyncWriterDestroyed)
+        _writer(message.message());
+    else
+        detail::async_writer::get().enqueue(*this, message);
+}
+
 sink& sink::console()
 {
     static auto instance = sink(false, std::cout);
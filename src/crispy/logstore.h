@@ -9,7 +9,9 @@
 #include <gsl/pointers>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <iterator>
@@ -41,6 +43,11 @@ namespace logstore
 class category;
 class sink;
 
+namespace detail
+{
+    class async_writer;
+}
+
 class source_location_custom
 {
   public:
@@ -77,7 +84,20 @@ class message_builder
   private:
     gsl::not_null<category const*> _category;
     source_location _location;
+    std::chrono::system_clock::time_point _time;
     std::string _buffer;
+    bool _pending = true; // Whether the message is yet to be written to its category's sink.
+
+    friend class detail::async_writer;
+
+    // Reconstructs a message that has already been handed over to an asynchronous sink.
+    message_builder(category const& cat,
+                    source_location loc,
+                    std::chrono::system_clock::time_point time,
+                    std::string text) noexcept:
+        _category { &cat }, _location { loc }, _time { time }, _buffer { std::move(text) }, _pending { false }
+    {
+    }
 
   public:
     explicit message_builder(category const& cat, source_location loc = source_location::current());
@@ -85,6 +105,9 @@ class message_builder
     [[nodiscard]] category const& get_category() const noexcept { return *_category; }
     [[nodiscard]] source_location const& location() const noexcept { return _location; }
 
+    /// Point in time the message was created at.
+    [[nodiscard]] std::chrono::system_clock::time_point time() const noexcept { return _time; }
+
     [[nodiscard]] std::string const& text() const noexcept { return _buffer; }
 
     message_builder& append(std::string_view msg)
@@ -145,9 +168,9 @@ class category
     [[nodiscard]] std::string_view name() const noexcept { return _name; }
     [[nodiscard]] std::string_view description() const noexcept { return _description; }
 
-    [[nodiscard]] bool is_enabled() const noexcept { return _state == state::Enabled; }
-    void enable(bool enabled = true) noexcept { _state = enabled ? state::Enabled : state::Disabled; }
-    void disable() noexcept { _state = state::Disabled; }
+    [[nodiscard]] bool is_enabled() const noexcept { return _enabled.load(std::memory_order_relaxed); }
+    void enable(bool enabled = true) noexcept { _enabled.store(enabled, std::memory_order_relaxed); }
+    void disable() noexcept { enable(false); }
 
     [[nodiscard]] bool visible() const noexcept { return _visibility == visibility::Public; }
     void set_visible(bool visible) { _visibility = visible ? visibility::Public : visibility::Hidden; }
@@ -175,7 +198,7 @@ class category
   private:
     std::string_view _name;
     std::string_view _description;
-    state _state;
+    std::atomic<bool> _enabled; // Checked before building any message, and thus kept to a single load.
     visibility _visibility;
     formatter _formatter;
     std::reference_wrapper<logstore::sink> _sink;
@@ -192,20 +215,51 @@ class sink
     sink(bool enabled, writer writer);
     sink(bool enabled, std::ostream& output);
     sink(bool enabled, std::shared_ptr<std::ostream> f);
+    ~sink();
+
+    sink(sink const&) = delete;
+    sink(sink&&) = delete;
+    sink& operator=(sink const&) = delete;
+    sink& operator=(sink&&) = delete;
 
     void set_writer(writer writer);
 
     /// Writes given built message to this sink.
     void write(message_builder const& message);
 
-    void set_enabled(bool enabled) { _enabled = enabled; }
+    void set_enabled(bool enabled) { _enabled.store(enabled, std::memory_order_relaxed); }
+
+    /// Hands messages over to a background thread, which formats and writes them in batches,
+    /// rather than doing so on the logging thread.
+    ///
+    /// Each logging thread passes its messages through a ring buffer of its own, so that
+    /// logging neither waits for the output nor takes a lock, other than for waking up the
+    /// background thread once per batch, unless the ring buffer is full.
+    /// Messages are written in the order they were created in.
+    void set_async(bool async);
+    [[nodiscard]] bool async() const noexcept { return _async.load(std::memory_order_relaxed); }
+
+    /// Default size of the ring buffer of each thread logging asynchronously, in bytes.
+    static constexpr size_t DefaultAsyncBufferSize = 64 * 1024;
+
+    /// Sets the size of the ring buffers of the threads that start logging asynchronously
+    /// from now on, in bytes. Messages larger than half of it are written synchronously.
+    static void set_async_buffer_size(size_t bytes);
+
+    /// Waits until the messages handed over to asynchronous sinks so far have been written.
+    static void flush();
 
     /// Retrieves reference to standard debug-logging sink.
     static sink& console();
     static sink& error_console(); // NOLINT(readability-identifier-naming)
 
   private:
-    bool _enabled;
+    friend class detail::async_writer;
+
+    void enqueue(message_builder const& message);
+
+    std::atomic<bool> _enabled;
+    std::atomic<bool> _async = false;
     writer _writer;
 };
 
@@ -293,13 +347,14 @@ inline void configure(std::string_view filterString)
 }
 
 inline message_builder::message_builder(logstore::category const& cat, source_location location):
-    _category { &cat }, _location { location }
+    _category { &cat }, _location { location }, _time { std::chrono::system_clock::now() }
 {
 }
 
 inline message_builder::~message_builder()
 {
-    _category->sink().write(*this);
+    if (_pending)
+        _category->sink().write(*this);
 }
 
 inline category::category(std::string_view name,
@@ -308,7 +363,7 @@ inline category::category(std::string_view name,
                           visibility visibility) noexcept:
     _name { name },
     _description { desc },
-    _state { state },
+    _enabled { state == category::state::Enabled },
     _visibility { visibility },
     _sink { logstore::sink::console() }
 {
@@ -339,13 +394,13 @@ inline std::string category::defaultFormatter(message_builder const& message)
 
 inline void sink::write(message_builder const& message)
 {
-    if (_enabled && message.get_category().is_enabled())
-        _writer(message.message());
-}
+    if (!_enabled.load(std::memory_order_relaxed) || !message.get_category().is_enabled())
+        return;
 
-inline void sink::set_writer(writer writer)
-{
-    _writer = std::move(writer);
+    if (async())
+        enqueue(message);
+    else
+        _writer(message.message());
 }
 // }}}
 
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/logstore.h>
+#include <crispy/utils.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+auto const inline testLog = logstore::category("test.logstore", "Logs for the logstore tests.");
+} // namespace
+
+TEST_CASE("logstore.sink.async")
+{
+    auto constexpr ThreadCount = 4;
+    auto constexpr MessageCount = 10'000;
+
+    auto lines = std::vector<std::string> {};
+    auto lock = std::mutex {};
+    auto output = logstore::sink(true, [&](std::string_view text) {
+        auto const _ = std::lock_guard { lock };
+        for (auto const line: crispy::split(text, '\n'))
+            if (!line.empty())
+                lines.emplace_back(line);
+    });
+    output.set_async(true);
+
+    auto& category = *logstore::get(testLog.name());
+    category.set_sink(output);
+    category.set_formatter({});
+
+    SECTION("disabled")
+    {
+        testLog()("not written");
+        logstore::sink::flush();
+        CHECK(lines.empty());
+    }
+
+    SECTION("woken up")
+    {
+        category.enable();
+        testLog()("woken up");
+
+        // The background thread writes the message without being flushed.
+        auto const written = [&]() {
+            auto const _ = std::lock_guard { lock };
+            return !lines.empty();
+        };
+        for (auto i = 0; i < 500 && !written(); ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(written());
+    }
+
+    SECTION("enabled")
+    {
+        category.enable();
+
+        // Small ring buffers fill up, having the logging threads wait for the background thread.
+        logstore::sink::set_async_buffer_size(4096);
+        auto threads = std::vector<std::thread> {};
+        for (auto i = 0; i < ThreadCount; ++i)
+            threads.emplace_back([i]() {
+                for (auto k = 0; k < MessageCount; ++k)
+                    testLog()("{} {}", i, k);
+            });
+        for (auto& thread: threads)
+            thread.join();
+        logstore::sink::flush();
+        logstore::sink::set_async_buffer_size(logstore::sink::DefaultAsyncBufferSize);
+
+        // Nothing is lost, and each thread's messages keep their order.
+        REQUIRE(lines.size() == ThreadCount * MessageCount);
+        auto next = std::vector<int>(ThreadCount, 0);
+        for (auto const& line: lines)
+        {
+            auto const separator = line.find(' ');
+            auto const i = std::stoi(line.substr(0, separator));
+            REQUIRE(std::stoi(line.substr(separator + 1)) == next.at(i));
+            ++next.at(i);
+        }
+
+        // Switching back to synchronous writes takes effect right away.
+        output.set_async(false);
+        testLog()("sync");
+        CHECK(lines.back() == "sync");
+    }
+
+    category.disable();
+    category.set_sink(logstore::sink::console());
+}
@@ -0,0 +1,172 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/lz.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace crispy::lz
+{
+
+namespace
+{
+    constexpr size_t MinMatch = 4;
+    constexpr size_t LastLiterals = 5; // The last bytes of a block are always encoded as literals.
+    constexpr size_t MaxOffset = 0xFFFF;
+    constexpr size_t HashBits = 12;
+    constexpr uint8_t RunMask = 0x0F;
+
+    uint32_t read32(uint8_t const* p) noexcept
+    {
+        uint32_t value = 0;
+        std::memcpy(&value, p, sizeof(value));
+        return value;
+    }
+
+    size_t hash(uint32_t value) noexcept
+    {
+        return (value * 2654435761u) >> (32 - HashBits);
+    }
+
+    void writeLength(std::vector<uint8_t>& output, size_t length)
+    {
+        for (; length >= 255; length -= 255)
+            output.push_back(255);
+        output.push_back(static_cast<uint8_t>(length));
+    }
+
+    bool readLength(uint8_t const*& input, uint8_t const* end, size_t& length) noexcept
+    {
+        while (input != end)
+        {
+            auto const byte = *input++;
+            length += byte;
+            if (byte != 255)
+                return true;
+        }
+        return false;
+    }
+
+    // Emits one sequence, or the final literals-only sequence if matchLength is 0.
+    void emitSequence(std::vector<uint8_t>& output,
+                      uint8_t const* literals,
+                      size_t literalCount,
+                      size_t offset,
+                      size_t matchLength)
+    {
+        auto const matchCode = matchLength ? matchLength - MinMatch : 0;
+        auto const literalNibble = static_cast<uint8_t>(std::min<size_t>(literalCount, RunMask));
+        auto const matchNibble = static_cast<uint8_t>(std::min<size_t>(matchCode, RunMask));
+        output.push_back(static_cast<uint8_t>(literalNibble << 4 | matchNibble));
+
+        if (literalCount >= RunMask)
+            writeLength(output, literalCount - RunMask);
+        output.insert(output.end(), literals, literals + literalCount);
+
+        if (!matchLength)
+            return;
+
+        output.push_back(static_cast<uint8_t>(offset & 0xFF));
+        output.push_back(static_cast<uint8_t>(offset >> 8));
+        if (matchCode >= RunMask)
+            writeLength(output, matchCode - RunMask);
+    }
+} // namespace
+
+std::vector<uint8_t> compress(gsl::span<uint8_t const> input)
+{
+    auto const* const begin = input.data();
+    auto const* const end = begin + input.size();
+
+    auto output = std::vector<uint8_t> {};
+    output.reserve(input.size() + input.size() / 255 + 16);
+
+    auto const* anchor = begin;
+    if (input.size() > MinMatch + LastLiterals)
+    {
+        // Maps the hash of 4 bytes to the position they have last been seen at.
+        auto table = std::array<uint32_t, size_t { 1 } << HashBits> {};
+        auto const* const matchLimit = end - LastLiterals;
+        auto const* ip = begin;
+        while (ip + MinMatch <= matchLimit)
+        {
+            auto const sequence = read32(ip);
+            auto& slot = table[hash(sequence)];
+            auto const* const candidate = begin + slot;
+            slot = static_cast<uint32_t>(ip - begin);
+
+            if (candidate >= ip || static_cast<size_t>(ip - candidate) > MaxOffset
+                || read32(candidate) != sequence)
+            {
+                ++ip;
+                continue;
+            }
+
+            auto length = MinMatch;
+            while (ip + length < matchLimit && candidate[length] == ip[length])
+                ++length;
+
+            emitSequence(output,
+                         anchor,
+                         static_cast<size_t>(ip - anchor),
+                         static_cast<size_t>(ip - candidate),
+                         length);
+            ip += length;
+            anchor = ip;
+        }
+    }
+    emitSequence(output, anchor, static_cast<size_t>(end - anchor), 0, 0);
+
+    return output;
+}
+
+bool decompress(gsl::span<uint8_t const> input, gsl::span<uint8_t> output) noexcept
+{
+    auto const* ip = input.data();
+    auto const* const inputEnd = ip + input.size();
+    auto* const outputBegin = output.data();
+    auto* const outputEnd = outputBegin + output.size();
+    auto* op = outputBegin;
+
+    while (ip != inputEnd)
+    {
+        auto const token = *ip++;
+
+        auto literalCount = static_cast<size_t>(token >> 4u);
+        if (literalCount == RunMask && !readLength(ip, inputEnd, literalCount))
+            return false;
+        if (static_cast<size_t>(inputEnd - ip) < literalCount
+            || static_cast<size_t>(outputEnd - op) < literalCount)
+            return false;
+        std::memcpy(op, ip, literalCount);
+        op += literalCount;
+        ip += literalCount;
+
+        if (ip == inputEnd)
+            break; // The last sequence has no match.
+
+        if (inputEnd - ip < 2)
+            return false;
+        auto const offset = static_cast<size_t>(ip[0] | ip[1] << 8u);
+        ip += 2;
+        if (offset == 0 || offset > static_cast<size_t>(op - outputBegin))
+            return false;
+
+        auto matchLength = static_cast<size_t>(token & RunMask);
+        if (matchLength == RunMask && !readLength(ip, inputEnd, matchLength))
+            return false;
+        matchLength += MinMatch;
+        if (static_cast<size_t>(outputEnd - op) < matchLength)
+            return false;
+
+        // Byte-wise, as the match may overlap with the bytes being written.
+        auto const* match = op - offset;
+        for (size_t i = 0; i < matchLength; ++i)
+            op[i] = match[i];
+        op += matchLength;
+    }
+
+    return op == outputEnd;
+}
+
+} // namespace crispy::lz
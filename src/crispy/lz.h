@@ -0,0 +1,30 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <gsl/span>
+
+#include <cstdint>
+#include <vector>
+
+/// Small LZ77 block codec in the spirit of LZ4.
+///
+/// The encoded block is a sequence of (literal run, back reference) pairs.
+/// Each sequence starts with a token byte holding the literal length in the upper nibble
+/// and the match length minus 4 in the lower nibble, either of which is extended by
+/// additional bytes of 255 if it is 15. The literals follow, and then the 2-byte little endian
+/// offset of the back reference. The last sequence consists of literals only.
+///
+/// The codec is meant for compressing data that is kept in memory only, it favors speed over ratio,
+/// and the block does not store its own decompressed size.
+namespace crispy::lz
+{
+
+/// Compresses @p input into a self-contained block.
+[[nodiscard]] std::vector<uint8_t> compress(gsl::span<uint8_t const> input);
+
+/// Decompresses the block @p input into @p output.
+///
+/// @returns true if the block decompressed into exactly output.size() bytes, false if the block is malformed.
+[[nodiscard]] bool decompress(gsl::span<uint8_t const> input, gsl::span<uint8_t> output) noexcept;
+
+} // namespace crispy::lz
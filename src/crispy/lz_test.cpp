@@ -0,0 +1,86 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/lz.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std::string_view_literals;
+
+namespace
+{
+
+std::vector<uint8_t> bytes(std::string_view text)
+{
+    return { text.begin(), text.end() };
+}
+
+std::vector<uint8_t> roundtrip(std::vector<uint8_t> const& input)
+{
+    auto const compressed = crispy::lz::compress(input);
+    auto output = std::vector<uint8_t>(input.size());
+    REQUIRE(crispy::lz::decompress(compressed, output));
+    return output;
+}
+
+} // namespace
+
+TEST_CASE("lz.roundtrip.short", "[lz]")
+{
+    for (auto const text: { ""sv, "a"sv, "abcd"sv, "abcdabcda"sv, "Hello, World!"sv })
+        CHECK(roundtrip(bytes(text)) == bytes(text));
+}
+
+TEST_CASE("lz.roundtrip.repetitive", "[lz]")
+{
+    auto input = std::string {};
+    for (int i = 0; i < 1000; ++i)
+        input += "drwxr-xr-x  2 user group  4096 Jan  1 00:00 directory-" + std::to_string(i % 17) + '\n';
+
+    auto const compressed = crispy::lz::compress(bytes(input));
+    CHECK(compressed.size() * 10 < input.size());
+    CHECK(roundtrip(bytes(input)) == bytes(input));
+}
+
+TEST_CASE("lz.roundtrip.long_runs", "[lz]")
+{
+    // Run lengths beyond what fits into the token's nibbles, and matches overlapping their output.
+    auto input = std::vector<uint8_t>(70000, 0x20);
+    for (size_t i = 0; i < 300; ++i)
+        input[1000 + i] = static_cast<uint8_t>(i * 7);
+    CHECK(roundtrip(input) == input);
+}
+
+TEST_CASE("lz.roundtrip.incompressible", "[lz]")
+{
+    auto input = std::vector<uint8_t>(5000);
+    auto state = uint32_t { 1 };
+    for (auto& byte: input)
+    {
+        state = state * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(state >> 24);
+    }
+    CHECK(roundtrip(input) == input);
+}
+
+TEST_CASE("lz.decompress.malformed", "[lz]")
+{
+    auto const input = bytes("abcabcabcabcabcabcabcabc");
+    auto const compressed = crispy::lz::compress(input);
+
+    auto output = std::vector<uint8_t>(input.size());
+    CHECK_FALSE(crispy::lz::decompress(compressed, gsl::span(output).subspan(1)));
+
+    auto tooLarge = std::vector<uint8_t>(input.size() + 1);
+    CHECK_FALSE(crispy::lz::decompress(compressed, tooLarge));
+
+    auto truncated = compressed;
+    truncated.pop_back();
+    CHECK_FALSE(crispy::lz::decompress(truncated, output));
+
+    // Back reference pointing before the start of the output.
+    auto const badOffset = std::vector<uint8_t> { 0x10, 'a', 0x05, 0x00 };
+    CHECK_FALSE(crispy::lz::decompress(badOffset, output));
+}
@@ -0,0 +1,144 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/metrics.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using std::string;
+using std::string_view;
+
+namespace crispy::metrics
+{
+
+// {{{ metric
+metric::metric(registry& owner, string_view name, string_view description):
+    _registry { owner }, _name { name }, _description { description }
+{
+    assert(!_registry.get(_name));
+    _registry._metrics.emplace_back(*this);
+}
+
+metric::~metric()
+{
+    auto& metrics = _registry._metrics;
+    auto const i =
+        std::find_if(metrics.begin(), metrics.end(), [this](metric const& x) { return &x == this; });
+    if (i != metrics.end())
+        metrics.erase(i);
+}
+// }}}
+
+// {{{ counter
+string counter::summary() const
+{
+    return fmt::format("count={}", value());
+}
+// }}}
+
+// {{{ hit_rate
+double hit_rate::rate() const noexcept
+{
+    auto const hitCount = hits();
+    auto const lookups = hitCount + misses();
+    return lookups ? static_cast<double>(hitCount) / static_cast<double>(lookups) : 0.0;
+}
+
+void hit_rate::reset() noexcept
+{
+    _hits.store(0, std::memory_order_relaxed);
+    _misses.store(0, std::memory_order_relaxed);
+}
+
+string hit_rate::summary() const
+{
+    return fmt::format("hits={},misses={},rate={:.4f}", hits(), misses(), rate());
+}
+// }}}
+
+// {{{ histogram
+histogram::histogram(registry& owner, string_view name, string_view description, string_view unit):
+    metric(owner, name, description), _unit { unit }
+{
+}
+
+double histogram::mean() const noexcept
+{
+    auto const n = count();
+    return n ? static_cast<double>(_sum.load(std::memory_order_relaxed)) / static_cast<double>(n) : 0.0;
+}
+
+uint64_t histogram::percentile(double percentile) const noexcept
+{
+    // Buckets are read one by one while other threads may still be recording,
+    // so the total is taken from the buckets themselves rather than from _count.
+    auto total = uint64_t { 0 };
+    for (auto const& bucket: _buckets)
+        total += bucket.load(std::memory_order_relaxed);
+    if (!total)
+        return 0;
+
+    auto const fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+    auto const rank =
+        std::max(uint64_t { 1 }, static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total))));
+
+    auto seen = uint64_t { 0 };
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        seen += _buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+void histogram::reset() noexcept
+{
+    for (auto& bucket: _buckets)
+        bucket.store(0, std::memory_order_relaxed);
+    _count.store(0, std::memory_order_relaxed);
+    _sum.store(0, std::memory_order_relaxed);
+    _max.store(0, std::memory_order_relaxed);
+}
+
+string histogram::summary() const
+{
+    return fmt::format("unit={},count={},mean={:.0f},p50={},p90={},p99={},p999={},max={}",
+                       unit(),
+                       count(),
+                       mean(),
+                       percentile(50),
+                       percentile(90),
+                       percentile(99),
+                       percentile(99.9),
+                       max());
+}
+// }}}
+
+// {{{ registry
+metric* registry::get(string_view name) const
+{
+    for (auto const& metric: _metrics)
+        if (metric.get().name() == name)
+            return &metric.get();
+    return nullptr;
+}
+
+void registry::reset()
+{
+    for (auto const& metric: _metrics)
+        metric.get().reset();
+}
+
+string registry::report() const
+{
+    auto output = fmt::format("enabled={}", enabled() ? 1 : 0);
+    for (auto const& metric: _metrics)
+        output += fmt::format(";{}:{}", metric.get().name(), metric.get().summary());
+    return output;
+}
+// }}}
+
+} // namespace crispy::metrics
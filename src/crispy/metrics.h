@@ -0,0 +1,261 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Low overhead performance metrics that can be turned on and off at runtime.
+///
+/// Metrics register themselves upon construction with the registry they belong to,
+/// such as the one of a terminal session, so that they are reported, reset
+/// and turned on and off together.
+/// While collecting is disabled (the default), recording a metric costs a single relaxed atomic load.
+namespace crispy::metrics
+{
+
+class metric;
+
+/// A set of metrics that are collected, reported and reset together.
+class registry
+{
+  public:
+    registry() = default;
+    ~registry() = default;
+
+    registry(registry const&) = delete;
+    registry(registry&&) = delete;
+    registry& operator=(registry const&) = delete;
+    registry& operator=(registry&&) = delete;
+
+    /// Tests whether the metrics of this registry are currently being collected.
+    [[nodiscard]] bool enabled() const noexcept { return _collecting.load(std::memory_order_relaxed); }
+
+    /// Starts or stops collecting metrics. Values collected so far are kept.
+    void enable(bool enabled = true) noexcept { _collecting.store(enabled, std::memory_order_relaxed); }
+
+    /// All metrics of this registry, in the order of their construction.
+    [[nodiscard]] std::vector<std::reference_wrapper<metric>> const& metrics() const noexcept
+    {
+        return _metrics;
+    }
+
+    /// @returns the metric of the given name or nullptr if there is none.
+    [[nodiscard]] metric* get(std::string_view name) const;
+
+    /// Discards the values collected so far of all metrics.
+    void reset();
+
+    /// Reports all metrics in a single line, suitable for transmission as VT reply.
+    ///
+    /// The report starts with "enabled=1" or "enabled=0", followed by one "<name>:<summary>" entry
+    /// per metric, each separated by a semicolon.
+    [[nodiscard]] std::string report() const;
+
+  private:
+    friend class metric;
+
+    std::atomic<bool> _collecting = false;
+    std::vector<std::reference_wrapper<metric>> _metrics;
+};
+
+/// Base of all metric types.
+class metric
+{
+  public:
+    metric(registry& owner, std::string_view name, std::string_view description);
+    virtual ~metric();
+
+    metric(metric const&) = delete;
+    metric(metric&&) = delete;
+    metric& operator=(metric const&) = delete;
+    metric& operator=(metric&&) = delete;
+
+    [[nodiscard]] std::string_view name() const noexcept { return _name; }
+    [[nodiscard]] std::string_view description() const noexcept { return _description; }
+
+    /// Tests whether the metric's registry is currently collecting.
+    [[nodiscard]] bool enabled() const noexcept { return _registry.enabled(); }
+
+    /// Discards all values collected so far.
+    virtual void reset() noexcept = 0;
+
+    /// Summarizes the collected values as comma separated key=value pairs, such as "count=3,max=7".
+    [[nodiscard]] virtual std::string summary() const = 0;
+
+  private:
+    registry& _registry;
+    std::string_view _name;
+    std::string_view _description;
+};
+
+/// Monotonically increasing number of events, such as texture atlas uploads.
+class counter final: public metric
+{
+  public:
+    using metric::metric;
+
+    void add(uint64_t n = 1) noexcept
+    {
+        if (enabled())
+            _value.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t value() const noexcept { return _value.load(std::memory_order_relaxed); }
+
+    void reset() noexcept override { _value.store(0, std::memory_order_relaxed); }
+    [[nodiscard]] std::string summary() const override;
+
+  private:
+    std::atomic<uint64_t> _value = 0;
+};
+
+/// Hits and misses of a cache lookup.
+class hit_rate final: public metric
+{
+  public:
+    using metric::metric;
+
+    void hit(uint64_t n = 1) noexcept
+    {
+        if (enabled())
+            _hits.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void miss(uint64_t n = 1) noexcept
+    {
+        if (enabled())
+            _misses.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] uint64_t hits() const noexcept { return _hits.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t misses() const noexcept { return _misses.load(std::memory_order_relaxed); }
+
+    /// @returns the ratio of hits to lookups, or 0 if there were no lookups yet.
+    [[nodiscard]] double rate() const noexcept;
+
+    void reset() noexcept override;
+    [[nodiscard]] std::string summary() const override;
+
+  private:
+    std::atomic<uint64_t> _hits = 0;
+    std::atomic<uint64_t> _misses = 0;
+};
+
+/// Distribution of recorded values, such as latencies in nanoseconds or sizes in bytes.
+///
+/// Values are counted in log-linear buckets, as HDR histograms do:
+/// values below 32 are counted exactly, and all others in one of 16 buckets
+/// per power of two, i.e. with a relative error of at most 1/16th.
+/// This covers the full range of 64-bit values in less than a thousand buckets,
+/// and recording a value is a few bit operations and atomic increments, without any locking.
+class histogram final: public metric
+{
+  public:
+    static constexpr size_t SubBucketBits = 4;
+    static constexpr size_t SubBucketCount = size_t { 1 } << SubBucketBits;
+    static constexpr size_t BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+
+    /// @param unit the unit of the recorded values, such as "ns" or "bytes".
+    histogram(registry& owner, std::string_view name, std::string_view description, std::string_view unit);
+
+    [[nodiscard]] std::string_view unit() const noexcept { return _unit; }
+
+    void record(uint64_t value) noexcept
+    {
+        if (!enabled())
+            return;
+
+        _buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        _count.fetch_add(1, std::memory_order_relaxed);
+        _sum.fetch_add(value, std::memory_order_relaxed);
+        auto currentMax = _max.load(std::memory_order_relaxed);
+        while (value > currentMax
+               && !_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed))
+            ;
+    }
+
+    [[nodiscard]] uint64_t count() const noexcept { return _count.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t max() const noexcept { return _max.load(std::memory_order_relaxed); }
+    [[nodiscard]] double mean() const noexcept;
+
+    /// @returns the highest value that is equivalent to the value at the given percentile (0..100),
+    ///          i.e. the upper bound of its bucket, but never more than the maximum recorded value.
+    [[nodiscard]] uint64_t percentile(double percentile) const noexcept;
+
+    void reset() noexcept override;
+    [[nodiscard]] std::string summary() const override;
+
+    [[nodiscard]] static constexpr size_t bucketIndex(uint64_t value) noexcept
+    {
+        if (value < 2 * SubBucketCount)
+            return static_cast<size_t>(value);
+        // Keeps the SubBucketBits bits below the most significant bit of the value.
+        auto const shift = static_cast<size_t>(std::bit_width(value)) - (SubBucketBits + 1);
+        return (shift * SubBucketCount) + static_cast<size_t>(value >> shift);
+    }
+
+    [[nodiscard]] static constexpr uint64_t bucketLowerBound(size_t index) noexcept
+    {
+        if (index < 2 * SubBucketCount)
+            return index;
+        auto const shift = (index / SubBucketCount) - 1;
+        return uint64_t { (index % SubBucketCount) + SubBucketCount } << shift;
+    }
+
+    [[nodiscard]] static constexpr uint64_t bucketUpperBound(size_t index) noexcept
+    {
+        if (index < 2 * SubBucketCount)
+            return index;
+        auto const shift = (index / SubBucketCount) - 1;
+        return bucketLowerBound(index) + ((uint64_t { 1 } << shift) - 1);
+    }
+
+  private:
+    std::string_view _unit;
+    std::array<std::atomic<uint64_t>, BucketCount> _buckets {};
+    std::atomic<uint64_t> _count = 0;
+    std::atomic<uint64_t> _sum = 0;
+    std::atomic<uint64_t> _max = 0;
+};
+
+/// Records the time from construction to destruction in nanoseconds into the given histogram.
+///
+/// The clock is only read while the histogram's registry is collecting.
+class scoped_timer
+{
+  public:
+    explicit scoped_timer(histogram& histogram) noexcept:
+        _histogram { histogram },
+        _start { histogram.enabled() ? std::chrono::steady_clock::now()
+                                     : std::chrono::steady_clock::time_point {} }
+    {
+    }
+
+    ~scoped_timer()
+    {
+        if (_start == std::chrono::steady_clock::time_point {})
+            return;
+        auto const elapsed = std::chrono::steady_clock::now() - _start;
+        _histogram.record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+
+    scoped_timer(scoped_timer const&) = delete;
+    scoped_timer(scoped_timer&&) = delete;
+    scoped_timer& operator=(scoped_timer const&) = delete;
+    scoped_timer& operator=(scoped_timer&&) = delete;
+
+  private:
+    histogram& _histogram;
+    std::chrono::steady_clock::time_point _start;
+};
+
+} // namespace crispy::metrics
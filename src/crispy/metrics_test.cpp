@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/metrics.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace crispy;
+
+TEST_CASE("metrics.histogram.buckets")
+{
+    using metrics::histogram;
+
+    // Small values are exact.
+    for (uint64_t value = 0; value < 32; ++value)
+    {
+        CHECK(histogram::bucketIndex(value) == value);
+        CHECK(histogram::bucketUpperBound(histogram::bucketIndex(value)) == value);
+    }
+
+    // Buckets are contiguous and each value lies within the bounds of its bucket.
+    for (size_t index = 1; index < histogram::BucketCount; ++index)
+        CHECK(histogram::bucketLowerBound(index) == histogram::bucketUpperBound(index - 1) + 1);
+    for (uint64_t const value: { 32ull, 33ull, 63ull, 64ull, 1000ull, 123456789ull, ~0ull })
+    {
+        auto const index = histogram::bucketIndex(value);
+        REQUIRE(index < histogram::BucketCount);
+        CHECK(histogram::bucketLowerBound(index) <= value);
+        CHECK(value <= histogram::bucketUpperBound(index));
+        // The relative error is bounded by the number of sub buckets.
+        auto const bucketWidth = histogram::bucketUpperBound(index) - histogram::bucketLowerBound(index);
+        CHECK(bucketWidth <= value / histogram::SubBucketCount);
+    }
+    CHECK(histogram::bucketIndex(~0ull) == histogram::BucketCount - 1);
+}
+
+TEST_CASE("metrics.histogram.percentile")
+{
+    auto registry = metrics::registry {};
+    auto histogram = metrics::histogram(registry, "test.histogram", "", "ns");
+
+    SECTION("disabled")
+    {
+        histogram.record(42);
+        CHECK(histogram.count() == 0);
+        CHECK(histogram.percentile(50) == 0);
+    }
+
+    SECTION("enabled")
+    {
+        registry.enable();
+        for (uint64_t value = 1; value <= 1000; ++value)
+            histogram.record(value);
+
+        CHECK(histogram.count() == 1000);
+        CHECK(histogram.max() == 1000);
+        CHECK(histogram.mean() == 500.5);
+        // Reported values are at most one bucket width (1/16th) above the exact value.
+        CHECK(500 <= histogram.percentile(50));
+        CHECK(histogram.percentile(50) <= 500 + 500 / 16);
+        CHECK(990 <= histogram.percentile(99));
+        CHECK(histogram.percentile(99) <= 1000);
+        CHECK(histogram.percentile(100) == 1000);
+        CHECK(histogram.percentile(0) == 1);
+
+        histogram.reset();
+        CHECK(histogram.count() == 0);
+        CHECK(histogram.max() == 0);
+    }
+}
+
+TEST_CASE("metrics.histogram.threads")
+{
+    auto constexpr ThreadCount = 4;
+    auto constexpr RecordCount = 10'000;
+
+    auto registry = metrics::registry {};
+    auto histogram = metrics::histogram(registry, "test.histogram", "", "bytes");
+    registry.enable();
+
+    auto threads = std::vector<std::thread> {};
+    for (auto i = 0; i < ThreadCount; ++i)
+        threads.emplace_back([&, i]() {
+            for (auto k = 0; k < RecordCount; ++k)
+                histogram.record(static_cast<uint64_t>(i * RecordCount + k));
+        });
+    for (auto& thread: threads)
+        thread.join();
+
+    CHECK(histogram.count() == ThreadCount * RecordCount);
+    CHECK(histogram.max() == ThreadCount * RecordCount - 1);
+}
+
+TEST_CASE("metrics.report")
+{
+    auto registry = metrics::registry {};
+    auto counter = metrics::counter(registry, "test.counter", "");
+    auto hitRate = metrics::hit_rate(registry, "test.hit_rate", "");
+    auto histogram = metrics::histogram(registry, "test.histogram", "", "ns");
+    CHECK(registry.get("test.counter") == &counter);
+
+    registry.enable();
+    counter.add(3);
+    hitRate.hit(2);
+    hitRate.hit();
+    hitRate.miss();
+    histogram.record(7);
+
+    auto const report = registry.report();
+    CHECK(report.starts_with("enabled=1;"));
+    CHECK(report.find(";test.counter:count=3") != std::string::npos);
+    CHECK(report.find(";test.hit_rate:hits=3,misses=1,rate=0.7500") != std::string::npos);
+    CHECK(report.find(";test.histogram:unit=ns,count=1,mean=7,p50=7,p90=7,p99=7,p999=7,max=7")
+          != std::string::npos);
+
+    registry.enable(false);
+    CHECK(registry.report().starts_with("enabled=0;"));
+    registry.reset();
+    CHECK(counter.value() == 0);
+    CHECK(hitRate.rate() == 0.0);
+}
+
+TEST_CASE("metrics.registry")
+{
+    // Metrics of the same name in different registries, such as of two terminal sessions,
+    // are collected and reset independently.
+    auto first = metrics::registry {};
+    auto second = metrics::registry {};
+    auto firstCounter = metrics::counter(first, "test.counter", "");
+    auto secondCounter = metrics::counter(second, "test.counter", "");
+
+    first.enable();
+    firstCounter.add();
+    secondCounter.add();
+    CHECK(firstCounter.value() == 1);
+    CHECK(secondCounter.value() == 0);
+
+    second.enable();
+    secondCounter.add(2);
+    first.reset();
+    CHECK(firstCounter.value() == 0);
+    CHECK(secondCounter.value() == 2);
+    CHECK(second.report() == "enabled=1;test.counter:count=2");
+
+    {
+        auto const temporary = metrics::counter(first, "test.temporary", "");
+        CHECK(first.metrics().size() == 2);
+    }
+    CHECK(first.metrics().size() == 1);
+    CHECK(first.get("test.temporary") == nullptr);
+}
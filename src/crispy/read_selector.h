@@ -4,8 +4,12 @@
 #include <crispy/assert.h>
 
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
+#include <cstdint>
+#include <cstring>
 #include <deque>
 #include <initializer_list>
 #include <optional>
@@ -16,25 +20,36 @@
 
     #include <sys/select.h>
 
+    #include <fcntl.h>
     #include <unistd.h>
 #endif
 
 #if defined(__linux__)
     #include <sys/epoll.h>
     #include <sys/eventfd.h>
-#else
-    #include <fcntl.h>
 #endif
 
 namespace crispy
 {
 
+/// Determines when a read selector reports a file descriptor as readable.
+enum class read_trigger : uint8_t
+{
+    /// Reported for as long as there is data to be read.
+    Level,
+
+    /// Reported only once new data has arrived, so the caller must read until EAGAIN
+    /// (or remember that it did not) before waiting again.
+    Edge,
+};
+
 /// Implements waiting for a set of file descriptors to become readable.
 ///
+/// select() has no notion of edge triggering, so file descriptors are always reported level-triggered.
 class posix_read_selector
 {
   public:
-    posix_read_selector()
+    explicit posix_read_selector([[maybe_unused]] read_trigger trigger = read_trigger::Level)
     {
         int pfd[2];
         int const rv = pipe(pfd);
@@ -72,8 +87,23 @@ class posix_read_selector
     {
         assert(std::count(_fds.begin(), _fds.end(), fd) == 1);
         _fds.erase(std::remove(_fds.begin(), _fds.end(), fd), _fds.end());
+        _writeFds.erase(std::remove(_writeFds.begin(), _writeFds.end(), fd), _writeFds.end());
+        _pending.erase(std::remove(_pending.begin(), _pending.end(), fd), _pending.end());
     }
 
+    /// Sets whether to also wait for the given file descriptor, which is being waited on for reading,
+    /// to become writable.
+    void want_write(int fd, bool enabled) noexcept
+    {
+        assert(std::count(_fds.begin(), _fds.end(), fd) == 1);
+        _writeFds.erase(std::remove(_writeFds.begin(), _writeFds.end(), fd), _writeFds.end());
+        if (enabled)
+            _writeFds.push_back(fd);
+    }
+
+    /// Returns the file descriptors the last wait found writable, out of those passed to want_write().
+    [[nodiscard]] std::vector<int> const& writable() const noexcept { return _writable; }
+
     void wakeup() noexcept
     {
         if (_breakPipeWriter.is_open())
@@ -88,9 +118,37 @@ class posix_read_selector
     {
         assert(!_fds.empty());
 
+        _writable.clear();
         if (auto const fd = try_pop_pending(); fd.has_value())
             return fd;
 
+        if (!wait(timeout))
+            return std::nullopt;
+
+        return try_pop_pending();
+    }
+
+    /// Waits for any of the file descriptors to become readable and returns all of them that are.
+    ///
+    /// An empty result with errno set to EINTR means the wait was interrupted by wakeup(),
+    /// and with errno set to EAGAIN that it timed out or that writable() is not empty.
+    std::vector<int> const& wait_many(std::optional<std::chrono::milliseconds> timeout = std::nullopt) noexcept
+    {
+        assert(!_fds.empty());
+
+        _ready.clear();
+        _writable.clear();
+        if (_pending.empty() && !wait(timeout))
+            return _ready;
+
+        _ready.assign(_pending.begin(), _pending.end());
+        _pending.clear();
+        return _ready;
+    }
+
+  private:
+    bool wait(std::optional<std::chrono::milliseconds> timeout) noexcept
+    {
         FD_ZERO(&_reader);
         FD_ZERO(&_writer);
         FD_ZERO(&_except);
@@ -103,6 +161,8 @@ class posix_read_selector
             if (fd > maxfd)
                 maxfd = fd;
         }
+        for (auto const fd: _writeFds)
+            FD_SET(fd, &_writer);
 
         auto tv = std::unique_ptr<timeval>();
         if (timeout.has_value())
@@ -114,10 +174,13 @@ class posix_read_selector
 
         auto const result = ::select(maxfd + 1, &_reader, &_writer, &_except, tv.get());
 
+        if (result == 0)
+            errno = EAGAIN;
         if (result <= 0)
-            return std::nullopt;
+            return false;
 
-        if (FD_ISSET(_breakPipeReader, &_reader))
+        auto const piped = FD_ISSET(_breakPipeReader, &_reader);
+        if (piped)
         {
             // Drain the pipe.
             char buf[256];
@@ -129,10 +192,18 @@ class posix_read_selector
             if (FD_ISSET(fd, &_reader))
                 _pending.push_back(fd);
 
-        return try_pop_pending();
+        for (int const fd: _writeFds)
+            if (FD_ISSET(fd, &_writer))
+                _writable.push_back(fd);
+
+        if (_pending.empty())
+        {
+            errno = piped ? EINTR : EAGAIN;
+            return !_writable.empty();
+        }
+        return true;
     }
 
-  private:
     std::optional<int> try_pop_pending() noexcept
     {
         if (_pending.empty())
@@ -151,7 +222,10 @@ class posix_read_selector
     fd_set _writer {};
     fd_set _except {};
     std::vector<int> _fds;
+    std::vector<int> _writeFds;
     std::deque<int> _pending;
+    std::vector<int> _ready;
+    std::vector<int> _writable;
     file_descriptor _breakPipeReader;
     file_descriptor _breakPipeWriter;
 };
@@ -164,27 +238,55 @@ class posix_read_selector
 class epoll_read_selector
 {
   public:
-    epoll_read_selector();
+    explicit epoll_read_selector(read_trigger trigger = read_trigger::Level);
+    epoll_read_selector(epoll_read_selector&&) noexcept = default;
+    epoll_read_selector& operator=(epoll_read_selector&&) noexcept = default;
+    epoll_read_selector(epoll_read_selector const&) = delete;
+    epoll_read_selector& operator=(epoll_read_selector const&) = delete;
     ~epoll_read_selector() = default;
 
+    static epoll_read_selector create(std::initializer_list<int> fds,
+                                      read_trigger trigger = read_trigger::Level);
+
     void want_read(int fd) noexcept;
     void cancel_read(int fd) noexcept;
     [[nodiscard]] size_t size() const noexcept;
 
+    /// Sets whether to also wait for the given file descriptor, which is being waited on for reading,
+    /// to become writable.
+    void want_write(int fd, bool enabled) noexcept;
+
+    /// Returns the file descriptors the last wait found writable, out of those passed to want_write().
+    [[nodiscard]] std::vector<int> const& writable() const noexcept { return _writable; }
+
+    /// Returns the epoll file descriptor, which is readable whenever a wait would not block,
+    /// so that it can be waited on along with others.
+    [[nodiscard]] int native_handle() const noexcept { return _epollFd.get(); }
+
     void wakeup() const noexcept;
     std::optional<int> wait_one(std::optional<std::chrono::milliseconds> timeout = std::nullopt) noexcept;
 
+    /// Waits for any of the file descriptors to become readable and returns all of them that are.
+    ///
+    /// An empty result with errno set to EINTR means the wait was interrupted by wakeup(),
+    /// and with errno set to EAGAIN that it timed out or that writable() is not empty.
+    std::vector<int> const& wait_many(std::optional<std::chrono::milliseconds> timeout = std::nullopt) noexcept;
+
   private:
+    bool wait(std::optional<std::chrono::milliseconds> timeout) noexcept;
     std::optional<int> try_pop_pending() noexcept;
 
   private:
     file_descriptor _epollFd;
     file_descriptor _eventFd;
+    read_trigger _trigger;
     size_t _size = 0;
     std::deque<int> _pending;
+    std::vector<int> _ready;
+    std::vector<int> _writable;
 };
 
-inline epoll_read_selector::epoll_read_selector()
+inline epoll_read_selector::epoll_read_selector(read_trigger trigger): _trigger { trigger }
 {
     _epollFd = file_descriptor::from_native(epoll_create1(EPOLL_CLOEXEC));
     _eventFd = file_descriptor::from_native(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC));
@@ -195,11 +297,21 @@ inline epoll_read_selector::epoll_read_selector()
     epoll_ctl(_epollFd, EPOLL_CTL_ADD, _eventFd, &event);
 }
 
+inline epoll_read_selector epoll_read_selector::create(std::initializer_list<int> fds, read_trigger trigger)
+{
+    auto selector = epoll_read_selector { trigger };
+    for (auto const fd: fds)
+        selector.want_read(fd);
+    return selector;
+}
+
 // NOLINTNEXTLINE(readability-make-member-function-const)
 inline void epoll_read_selector::want_read(int fd) noexcept
 {
     auto event = epoll_event {};
     event.events = EPOLLIN;
+    if (_trigger == read_trigger::Edge)
+        event.events |= EPOLLET;
     event.data.fd = fd;
     epoll_ctl(_epollFd, EPOLL_CTL_ADD, fd, &event);
     _size++;
@@ -212,6 +324,7 @@ inline void epoll_read_selector::cancel_read(int fd) noexcept
     event.events = EPOLLIN;
     event.data.fd = fd;
     epoll_ctl(_epollFd, EPOLL_CTL_DEL, fd, &event);
+    _pending.erase(std::remove(_pending.begin(), _pending.end(), fd), _pending.end());
     _size--;
 }
 
@@ -220,6 +333,19 @@ inline size_t epoll_read_selector::size() const noexcept
     return _size;
 }
 
+// NOLINTNEXTLINE(readability-make-member-function-const)
+inline void epoll_read_selector::want_write(int fd, bool enabled) noexcept
+{
+    auto event = epoll_event {};
+    event.events = EPOLLIN;
+    if (enabled)
+        event.events |= EPOLLOUT;
+    if (_trigger == read_trigger::Edge)
+        event.events |= EPOLLET;
+    event.data.fd = fd;
+    epoll_ctl(_epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
 inline void epoll_read_selector::wakeup() const noexcept
 {
     auto const value = eventfd_t { 1 };
@@ -231,7 +357,10 @@ inline void epoll_read_selector::wakeup() const noexcept
 inline std::optional<int> epoll_read_selector::try_pop_pending() noexcept
 {
     if (_pending.empty())
+    {
+        errno = EAGAIN;
         return std::nullopt;
+    }
 
     auto const fd = _pending.front();
     _pending.pop_front();
@@ -241,9 +370,31 @@ inline std::optional<int> epoll_read_selector::try_pop_pending() noexcept
 inline std::optional<int> epoll_read_selector::wait_one(
     std::optional<std::chrono::milliseconds> timeout) noexcept
 {
+    _writable.clear();
     if (auto const fd = try_pop_pending(); fd.has_value())
         return fd;
 
+    if (!wait(timeout))
+        return std::nullopt;
+
+    return try_pop_pending();
+}
+
+inline std::vector<int> const& epoll_read_selector::wait_many(
+    std::optional<std::chrono::milliseconds> timeout) noexcept
+{
+    _ready.clear();
+    _writable.clear();
+    if (_pending.empty() && !wait(timeout))
+        return _ready;
+
+    _ready.assign(_pending.begin(), _pending.end());
+    _pending.clear();
+    return _ready;
+}
+
+inline bool epoll_read_selector::wait(std::optional<std::chrono::milliseconds> timeout) noexcept
+{
     auto events = std::array<epoll_event, 64> { {} };
     for (;;)
     {
@@ -254,14 +405,14 @@ inline std::optional<int> epoll_read_selector::wait_one(
         if (result == 0)
         {
             errno = EAGAIN;
-            return std::nullopt;
+            return false;
         }
 
         if (result < 0)
         {
             if (errno == EINTR)
                 continue;
-            return std::nullopt;
+            return false;
         }
 
         bool piped = false;
@@ -271,16 +422,19 @@ inline std::optional<int> epoll_read_selector::wait_one(
             {
                 eventfd_t dummy {};
                 piped = ::read(_eventFd, &dummy, sizeof(dummy)) > 0;
+                continue;
             }
-            else
+            if (events[i].events & EPOLLOUT)
+                _writable.push_back(events[i].data.fd);
+            if (events[i].events & ~uint32_t { EPOLLOUT })
                 _pending.push_back(events[i].data.fd);
         }
 
-        if (auto fd = try_pop_pending(); fd.has_value())
-            return fd;
+        if (!_pending.empty())
+            return true;
 
         errno = piped ? EINTR : EAGAIN;
-        return std::nullopt;
+        return !_writable.empty();
     }
 }
 
@@ -0,0 +1,234 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <crispy/read_selector.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#if !defined(_WIN32)
+
+    #include <algorithm>
+    #include <string_view>
+    #include <thread>
+    #include <vector>
+
+    #include <sys/socket.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+
+using crispy::file_descriptor;
+using crispy::read_trigger;
+using namespace std::chrono_literals;
+
+namespace
+{
+
+struct test_pipe
+{
+    file_descriptor reader;
+    file_descriptor writer;
+
+    test_pipe()
+    {
+        int pfd[2];
+        Require(pipe(pfd) == 0);
+        reader = file_descriptor::from_native(pfd[0]);
+        writer = file_descriptor::from_native(pfd[1]);
+        fcntl(pfd[0], F_SETFL, fcntl(pfd[0], F_GETFL) | O_NONBLOCK);
+    }
+
+    void write(std::string_view text) const { REQUIRE(::write(writer, text.data(), text.size()) > 0); }
+
+    size_t drain() const
+    {
+        char buf[256];
+        auto total = size_t { 0 };
+        while (true)
+        {
+            auto const rv = ::read(reader, buf, sizeof(buf));
+            if (rv <= 0)
+                return total;
+            total += static_cast<size_t>(rv);
+        }
+    }
+};
+
+template <typename Selector>
+void testWaitOne()
+{
+    auto a = test_pipe {};
+    auto b = test_pipe {};
+    auto selector = Selector {};
+    selector.want_read(a.reader);
+    selector.want_read(b.reader);
+    CHECK(selector.size() == 2);
+
+    CHECK(!selector.wait_one(0ms).has_value());
+    CHECK(errno == EAGAIN);
+
+    b.write("b");
+    auto const fd = selector.wait_one(0ms);
+    REQUIRE(fd.has_value());
+    CHECK(*fd == b.reader.get());
+    CHECK(b.drain() == 1);
+
+    selector.cancel_read(b.reader);
+    CHECK(selector.size() == 1);
+    b.write("b");
+    CHECK(!selector.wait_one(0ms).has_value());
+}
+
+template <typename Selector>
+void testWaitMany()
+{
+    auto a = test_pipe {};
+    auto b = test_pipe {};
+    auto selector = Selector {};
+    selector.want_read(a.reader);
+    selector.want_read(b.reader);
+
+    a.write("a");
+    b.write("bb");
+    auto ready = selector.wait_many(0ms);
+    std::sort(ready.begin(), ready.end());
+    auto expected = std::vector<int> { a.reader.get(), b.reader.get() };
+    std::sort(expected.begin(), expected.end());
+    CHECK(ready == expected);
+    CHECK(a.drain() == 1);
+    CHECK(b.drain() == 2);
+
+    CHECK(selector.wait_many(0ms).empty());
+    CHECK(errno == EAGAIN);
+}
+
+template <typename Selector>
+void testWakeup()
+{
+    auto a = test_pipe {};
+    auto selector = Selector {};
+    selector.want_read(a.reader);
+
+    auto waker = std::thread { [&]() {
+        std::this_thread::sleep_for(10ms);
+        selector.wakeup();
+    } };
+    auto const& ready = selector.wait_many(5s);
+    waker.join();
+    CHECK(ready.empty());
+    CHECK(errno == EINTR);
+}
+
+template <typename Selector>
+void testWantWrite()
+{
+    int sv[2];
+    Require(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) == 0);
+    auto a = file_descriptor::from_native(sv[0]);
+    auto b = file_descriptor::from_native(sv[1]);
+    for (int const fd: sv)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    auto selector = Selector {};
+    selector.want_read(a);
+    CHECK(selector.wait_many(0ms).empty());
+    CHECK(selector.writable().empty());
+
+    selector.want_write(a, true);
+    CHECK(selector.wait_many(0ms).empty());
+    CHECK(errno == EAGAIN);
+    CHECK(selector.writable() == std::vector { a.get() });
+
+    // Not reported anymore once the socket buffer is full ...
+    char buf[4096] {};
+    while (::write(a, buf, sizeof(buf)) > 0)
+        ;
+    CHECK(selector.wait_many(0ms).empty());
+    CHECK(selector.writable().empty());
+
+    // ... until the other end has read from it.
+    while (::read(b, buf, sizeof(buf)) > 0)
+        ;
+    CHECK(selector.wait_many(1s).empty());
+    CHECK(selector.writable() == std::vector { a.get() });
+
+    // Readability is still reported along with it.
+    REQUIRE(::write(b, "b", 1) == 1);
+    CHECK(selector.wait_many(0ms) == std::vector { a.get() });
+
+    selector.want_write(a, false);
+    (void) selector.wait_many(0ms);
+    CHECK(selector.writable().empty());
+}
+
+} // namespace
+
+TEST_CASE("posix_read_selector.wait_one", "[read_selector]")
+{
+    testWaitOne<crispy::posix_read_selector>();
+}
+
+TEST_CASE("posix_read_selector.wait_many", "[read_selector]")
+{
+    testWaitMany<crispy::posix_read_selector>();
+}
+
+TEST_CASE("posix_read_selector.wakeup", "[read_selector]")
+{
+    testWakeup<crispy::posix_read_selector>();
+}
+
+TEST_CASE("posix_read_selector.want_write", "[read_selector]")
+{
+    testWantWrite<crispy::posix_read_selector>();
+}
+
+    #if defined(__linux__)
+TEST_CASE("epoll_read_selector.wait_one", "[read_selector]")
+{
+    testWaitOne<crispy::epoll_read_selector>();
+}
+
+TEST_CASE("epoll_read_selector.wait_many", "[read_selector]")
+{
+    testWaitMany<crispy::epoll_read_selector>();
+}
+
+TEST_CASE("epoll_read_selector.wakeup", "[read_selector]")
+{
+    testWakeup<crispy::epoll_read_selector>();
+}
+
+TEST_CASE("epoll_read_selector.want_write", "[read_selector]")
+{
+    testWantWrite<crispy::epoll_read_selector>();
+}
+
+TEST_CASE("epoll_read_selector.level_triggered", "[read_selector]")
+{
+    auto a = test_pipe {};
+    auto selector = crispy::epoll_read_selector::create({ a.reader }, read_trigger::Level);
+
+    // Data that has not been read is reported again.
+    a.write("a");
+    CHECK(selector.wait_many(0ms).size() == 1);
+    CHECK(selector.wait_many(0ms).size() == 1);
+}
+
+TEST_CASE("epoll_read_selector.edge_triggered", "[read_selector]")
+{
+    auto a = test_pipe {};
+    auto selector = crispy::epoll_read_selector::create({ a.reader }, read_trigger::Edge);
+
+    // Data that has not been read is reported only once ...
+    a.write("a");
+    CHECK(selector.wait_many(0ms).size() == 1);
+    CHECK(selector.wait_many(0ms).empty());
+
+    // ... until more data arrives.
+    a.write("b");
+    CHECK(selector.wait_many(0ms).size() == 1);
+    CHECK(a.drain() == 2);
+    CHECK(selector.wait_many(0ms).empty());
+}
+    #endif
+
+#endif
@@ -0,0 +1,126 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <text_shaper/mock_shaper.h>
+
+#include <crispy/assert.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+using std::nullopt;
+using std::optional;
+using std::u32string_view;
+
+namespace text
+{
+
+mock_shaper::mock_shaper(DPI dpi): _dpi { dpi }
+{
+}
+
+optional<font_key> mock_shaper::load_font(font_description const& description, font_size size)
+{
+    auto const key = font_key { static_cast<unsigned>(_fonts.size()) };
+    _fonts.emplace_back(font_info { size, description.familyName == "emoji" });
+    return key;
+}
+
+font_metrics mock_shaper::metrics(font_key key) const
+{
+    Require(key.value < _fonts.size());
+
+    // Proportions of a typical monospace font.
+    auto const pixels = _fonts[key.value].size.pt * _dpi.y / 72.0;
+    auto const lineHeight = std::max(2, static_cast<int>(std::ceil(pixels * 1.2)));
+    auto const ascender = std::max(1, static_cast<int>(std::round(pixels * 0.95)));
+
+    auto output = font_metrics {};
+    output.lineHeight = lineHeight;
+    output.advance = std::max(1, static_cast<int>(std::round(pixels * 0.6)));
+    output.ascender = ascender;
+    output.descender = ascender - lineHeight;
+    output.underlinePosition = -std::max(1, static_cast<int>(std::round(pixels / 10)));
+    output.underlineThickness = std::max(1, static_cast<int>(std::round(pixels / 16)));
+    return output;
+}
+
+glyph_position mock_shaper::glyphFor(font_key font, char32_t codepoint) const
+{
+    auto gpos = glyph_position {};
+    gpos.glyph =
+        glyph_key { _fonts[font.value].size, font, glyph_index { static_cast<unsigned>(codepoint) } };
+#if defined(GLYPH_KEY_DEBUG)
+    gpos.glyph.text = std::u32string(1, codepoint);
+#endif
+    gpos.advance.x = metrics(font).advance;
+    return gpos;
+}
+
+void mock_shaper::shape(font_key font,
+                        u32string_view codepoints,
+                        gsl::span<unsigned> clusters,
+                        unicode::Script /*script*/,
+                        unicode::PresentationStyle presentation,
+                        shape_result& result)
+{
+    assert(clusters.size() == codepoints.size());
+    Require(font.value < _fonts.size());
+
+    for (size_t i = 0; i < codepoints.size(); ++i)
+    {
+        if (i != 0 && clusters[i] == clusters[i - 1])
+            continue;
+        auto gpos = glyphFor(font, codepoints[i]);
+        gpos.presentation = presentation;
+        result.emplace_back(gpos);
+    }
+}
+
+optional<glyph_position> mock_shaper::shape(font_key font, char32_t codepoint)
+{
+    Require(font.value < _fonts.size());
+    return glyphFor(font, codepoint);
+}
+
+optional<rasterized_glyph> mock_shaper::rasterize(glyph_key glyph, render_mode /*mode*/)
+{
+    if (glyph.font.value >= _fonts.size())
+        return nullopt;
+
+    auto const color = _fonts[glyph.font.value].color;
+    auto const fontMetrics = metrics(glyph.font);
+    auto const width = fontMetrics.advance * (color ? 2 : 1);
+    auto const height = fontMetrics.ascender;
+    auto const index = glyph.index.value;
+
+    auto output = rasterized_glyph {};
+    output.index = glyph.index;
+    output.bitmapSize = vtbackend::ImageSize { vtbackend::Width::cast_from(width),
+                                               vtbackend::Height::cast_from(height) };
+    output.position = crispy::point { 0, height };
+    output.format = color ? bitmap_format::rgba : bitmap_format::alpha_mask;
+    output.bitmap.resize(pixel_size(output.format) * static_cast<size_t>(width * height));
+
+    // A pattern that differs from glyph to glyph, so that the bitmaps are not all the same.
+    auto* pixel = output.bitmap.data();
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            auto const value = (static_cast<unsigned>(x + y) + index) % 3 ? uint8_t { 0xFF } : uint8_t { 0 };
+            if (!color)
+                *pixel++ = value;
+            else
+            {
+                *pixel++ = static_cast<uint8_t>(index * 37);
+                *pixel++ = static_cast<uint8_t>(index * 73);
+                *pixel++ = static_cast<uint8_t>(index * 109);
+                *pixel++ = value;
+            }
+        }
+    }
+
+    return output;
+}
+
+} // namespace text
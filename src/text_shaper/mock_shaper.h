@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <text_shaper/font.h>
+#include <text_shaper/shaper.h>
+
+#include <vector>
+
+namespace text
+{
+
+/**
+ * Text shaping API implementation that does not require any font files.
+ *
+ * Every codepoint cluster is shaped into a single glyph, identified by the cluster's first codepoint,
+ * and glyphs are rasterized into synthetic bitmaps of the size of a grid cell.
+ * Fonts with the family name "emoji" are treated as color fonts.
+ *
+ * This makes rendering deterministic and independent of the host's fonts,
+ * which is useful for testing and benchmarking everything around the actual text shaping.
+ *
+ * This should be available on all platforms.
+ */
+class mock_shaper: public shaper
+{
+  public:
+    explicit mock_shaper(DPI dpi);
+
+    void set_dpi(DPI dpi) override { _dpi = dpi; }
+
+    void set_locator(font_locator& /*locator*/) override {}
+
+    void clear_cache() override {}
+
+    [[nodiscard]] std::optional<font_key> load_font(font_description const& description,
+                                                    font_size size) override;
+
+    [[nodiscard]] font_metrics metrics(font_key key) const override;
+
+    void shape(font_key font,
+               std::u32string_view codepoints,
+               gsl::span<unsigned> clusters,
+               unicode::Script script,
+               unicode::PresentationStyle presentation,
+               shape_result& result) override;
+
+    [[nodiscard]] std::optional<glyph_position> shape(font_key font, char32_t codepoint) override;
+
+    [[nodiscard]] std::optional<rasterized_glyph> rasterize(glyph_key glyph, render_mode mode) override;
+
+  private:
+    struct font_info
+    {
+        font_size size;
+        bool color;
+    };
+
+    [[nodiscard]] glyph_position glyphFor(font_key font, char32_t codepoint) const;
+
+    DPI _dpi;
+    std::vector<font_info> _fonts;
+};
+
+} // namespace text
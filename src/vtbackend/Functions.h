@@ -13,6 +13,7 @@
 #include <gsl/span>
 
 #include <array>
+#include <limits>
 #include <optional>
 #include <string>
 
@@ -115,6 +116,7 @@ constexpr inline auto TBC = FunctionDocumentation { .mnemonic = "TBC", .comment
 constexpr inline auto VPA = FunctionDocumentation { .mnemonic = "VPA", .comment = "Vertical Position Absolute" };
 constexpr inline auto WINMANIP = FunctionDocumentation { .mnemonic = "WINMANIP", .comment = "Window Manipulation" };
 constexpr inline auto XTCAPTURE = FunctionDocumentation { .mnemonic = "XTCAPTURE", .comment = "Report screen buffer capture." };
+constexpr inline auto XTMETRICS = FunctionDocumentation { .mnemonic = "XTMETRICS", .comment = "Report or control performance metrics." };
 constexpr inline auto XTPOPCOLORS = FunctionDocumentation { .mnemonic = "XTPOPCOLORS", .comment = "Pops the color palette from the palette's saved-stack." };
 constexpr inline auto XTPUSHCOLORS = FunctionDocumentation { .mnemonic = "XTPUSHCOLORS", .comment = "Pushes the color palette onto the palette's saved-stack." };
 constexpr inline auto XTREPORTCOLORS = FunctionDocumentation { .mnemonic = "XTREPORTCOLORS", .comment = "Reports number of color palettes on the stack." };
@@ -576,6 +578,7 @@ constexpr inline auto TBC         = detail::CSI(std::nullopt, 0, 1, std::nullopt
 constexpr inline auto VPA         = detail::CSI(std::nullopt, 0, 1, std::nullopt, 'd', VTType::VT100, documentation::VPA);
 constexpr inline auto WINMANIP    = detail::CSI(std::nullopt, 1, 3, std::nullopt, 't', VTExtension::XTerm, documentation::WINMANIP);
 constexpr inline auto XTCAPTURE   = detail::CSI('>', 0, 2, std::nullopt, 't', VTExtension::Contour, documentation::XTCAPTURE);
+constexpr inline auto XTMETRICS   = detail::CSI('>', 0, 1, std::nullopt, 'y', VTExtension::Contour, documentation::XTMETRICS);
 constexpr inline auto XTPOPCOLORS    = detail::CSI(std::nullopt, 0, ArgsMax, '#', 'Q', VTExtension::XTerm, documentation::XTPOPCOLORS);
 constexpr inline auto XTPUSHCOLORS   = detail::CSI(std::nullopt, 0, ArgsMax, '#', 'P', VTExtension::XTerm, documentation::XTPUSHCOLORS);
 constexpr inline auto XTREPORTCOLORS = detail::CSI(std::nullopt, 0, 0, '#', 'R', VTExtension::XTerm, documentation::XTREPORTCOLORS);
@@ -662,6 +665,7 @@ constexpr static auto allFunctionsArray() noexcept
         // CSI
         ANSISYSSC,
         XTCAPTURE,
+        XTMETRICS,
         CBT,
         CHA,
         CHT,
@@ -775,19 +779,99 @@ constexpr static auto allFunctionsArray() noexcept
     return funcs;
 }
 
-inline auto allFunctions() noexcept
+namespace detail
 {
-    static auto const funcs = []() constexpr {
+    /// All function definitions, sorted in the order select() expects them.
+    constexpr inline auto SortedFunctions = []() constexpr {
         auto funcs = allFunctionsArray();
         crispy::sort(funcs, [](FunctionDefinition const& a, FunctionDefinition const& b) constexpr {
             return compare(a, b);
         });
         return funcs;
     }();
+} // namespace detail
 
-    return funcs;
+inline auto allFunctions() noexcept
+{
+    return detail::SortedFunctions;
 }
 
+/// Compile-time index over allFunctions() that finds the definition matching a FunctionSelector
+/// in constant time.
+///
+/// Definitions are bucketed by their category and final character, or by their numeric identifier
+/// in case of OSC. A bucket holds no more than a handful of definitions, differing in leader,
+/// intermediate, or the number of parameters only. These are scanned in sorted order, such that
+/// a selector matching more than one definition always resolves to the first of them.
+class FunctionDispatchTable
+{
+  public:
+    using Index = uint8_t;
+
+    static constexpr size_t Size = detail::SortedFunctions.size();
+    static_assert(Size < std::numeric_limits<Index>::max());
+
+    constexpr FunctionDispatchTable() noexcept
+    {
+        // Counting sort of all definitions by their key, keeping their relative order.
+        for (auto const& definition: detail::SortedFunctions)
+            ++_bucketBegin[keyOf(definition) + 1];
+        for (size_t key = 1; key < _bucketBegin.size(); ++key)
+            _bucketBegin[key] += _bucketBegin[key - 1];
+        auto next = _bucketBegin;
+        for (size_t i = 0; i < Size; ++i)
+            _entries[next[keyOf(detail::SortedFunctions[i])]++] = static_cast<Index>(i);
+    }
+
+    /// Finds the first definition matching @p selector that is also accepted by @p isEnabled.
+    ///
+    /// @p isEnabled is invoked with the index of a candidate definition into allFunctions().
+    ///
+    /// @return the index of the matching definition into allFunctions(), or Size if none matched.
+    template <typename Predicate>
+    [[nodiscard]] constexpr size_t find(FunctionSelector const& selector, Predicate isEnabled) const noexcept
+    {
+        auto const key = keyOf(selector.category, selector.finalSymbol, selector.argc);
+        for (auto i = _bucketBegin[key]; i < _bucketBegin[key + 1]; ++i)
+        {
+            auto const index = _entries[i];
+            if (isEnabled(index) && compare(selector, detail::SortedFunctions[index]) == 0)
+                return index;
+        }
+        return Size;
+    }
+
+    /// @return the index of @p definition into allFunctions(), or Size if it is not a known definition.
+    [[nodiscard]] static constexpr size_t indexOf(FunctionDefinition const& definition) noexcept
+    {
+        for (size_t i = 0; i < Size; ++i)
+            if (detail::SortedFunctions[i] == definition)
+                return i;
+        return Size;
+    }
+
+  private:
+    static constexpr size_t FinalSymbolCount = 0x80;
+    static constexpr size_t CategoryCount = 5;
+
+    static constexpr size_t keyOf(FunctionCategory category, char finalSymbol, int argc) noexcept
+    {
+        auto const symbol = category == FunctionCategory::OSC ? static_cast<unsigned>(argc)
+                                                              : static_cast<unsigned char>(finalSymbol);
+        return static_cast<size_t>(category) * FinalSymbolCount + symbol % FinalSymbolCount;
+    }
+
+    static constexpr size_t keyOf(FunctionDefinition const& definition) noexcept
+    {
+        return keyOf(definition.category, definition.finalSymbol, definition.maximumParameters);
+    }
+
+    std::array<Index, CategoryCount * FinalSymbolCount + 1> _bucketBegin {};
+    std::array<Index, Size> _entries {};
+};
+
+constexpr inline auto FunctionDispatch = FunctionDispatchTable {};
+
 // Class to store all supported VT sequence and support properly enabling/disabling them
 // The storage stores all available definition at all time and is partitioned into
 // two parts first part contains all active sequences and last part contains all
@@ -815,8 +899,23 @@ class SupportedSequences
         return gsl::span<FunctionDefinition const>(cbegin(), _lastIndex);
     }
 
+    /// Selects the active FunctionDefinition matching @p selector in constant time.
+    ///
+    /// @return the matching FunctionDefinition or nullptr if none matched.
+    [[nodiscard]] constexpr FunctionDefinition const* select(FunctionSelector const& selector) const noexcept
+    {
+        auto const index = FunctionDispatch.find(selector, [this](size_t i) { return _enabled[i]; });
+        return index != FunctionDispatchTable::Size ? &detail::SortedFunctions[index] : nullptr;
+    }
+
+    /// Tests whether the definition at the given index into allFunctions() is active.
+    [[nodiscard]] constexpr bool isActive(size_t index) const noexcept { return _enabled[index]; }
+
     CRISPY_CONSTEXPR void reset(VTType vt) noexcept
     {
+        for (size_t i = 0; i < _enabled.size(); ++i)
+            _enabled[i] = detail::SortedFunctions[i].conformanceLevel <= vt;
+
         // Partition the array such that first half contains all sequences with VTType less than or
         // equal to given VTTYpe.
         auto* itr = std::partition(
@@ -839,6 +938,7 @@ class SupportedSequences
             // Move the disabled sequence to the end of array, keep the rest of active sequences sorted
             std::rotate(seqIter, seqIter + 1, _supportedSequences.data() + _supportedSequences.size());
             --_lastIndex;
+            _enabled[FunctionDispatchTable::indexOf(seq)] = false;
         }
     }
 
@@ -851,6 +951,7 @@ class SupportedSequences
             // Maybe could be done better since rest of the data is sorted
             std::iter_swap(end(), seqIter);
             ++_lastIndex;
+            _enabled[FunctionDispatchTable::indexOf(seq)] = true;
             gsl::span<FunctionDefinition> arr(begin(), end());
             crispy::sort(arr, [](FunctionDefinition const& a, FunctionDefinition const& b) constexpr {
                 return compare(a, b);
@@ -861,6 +962,13 @@ class SupportedSequences
   private:
     std::array<FunctionDefinition, allFunctionsArray().size()> _supportedSequences = allFunctions();
     size_t _lastIndex = allFunctions().size(); // No of total active sequences
+
+    // Whether or not the definition at the same index in allFunctions() is active.
+    std::array<bool, FunctionDispatchTable::Size> _enabled = []() constexpr {
+        auto enabled = std::array<bool, FunctionDispatchTable::Size> {};
+        enabled.fill(true);
+        return enabled;
+    }();
 };
 
 /// Selects a FunctionDefinition based on a FunctionSelector.
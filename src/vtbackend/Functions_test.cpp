@@ -96,3 +96,47 @@ TEST_CASE("Functions.EnableAndDisable", "[Functions]")
     REQUIRE(f);
     CHECK(*f == DECSLRM);
 }
+
+TEST_CASE("Functions.DispatchTable", "[Functions]")
+{
+    auto const checkAll = [](SupportedSequences const& availableSequences) {
+        for (FunctionDefinition const& definition: availableSequences.allSequences())
+        {
+            for (int argc = 0; argc <= 12; ++argc)
+            {
+                auto const selector = FunctionSelector { .category = definition.category,
+                                                         .leader = definition.leader,
+                                                         .argc = definition.category == FunctionCategory::OSC
+                                                                     ? definition.maximumParameters + argc
+                                                                     : argc,
+                                                         .intermediate = definition.intermediate,
+                                                         .finalSymbol = definition.finalSymbol };
+                auto const* expected = vtbackend::select(selector, availableSequences.activeSequences());
+                auto const* actual = availableSequences.select(selector);
+                INFO(fmt::format("{} with {} arguments", definition, argc));
+                REQUIRE(!expected == !actual);
+                if (expected)
+                    CHECK(*expected == *actual);
+            }
+        }
+    };
+
+    // SCOSC and DECSLRM both match CSI s without arguments, which is why the terminal
+    // only ever enables one of them at a time.
+    SupportedSequences availableSequences;
+    availableSequences.disableSequence(DECSLRM);
+    checkAll(availableSequences);
+
+    availableSequences.enableSequence(DECSLRM);
+    availableSequences.disableSequence(SCOSC);
+    checkAll(availableSequences);
+
+    availableSequences.reset(VTType::VT100);
+    checkAll(availableSequences);
+
+    availableSequences.reset(VTType::VT420);
+    availableSequences.disableSequence(SCOSC);
+    checkAll(availableSequences);
+    CHECK(availableSequences.select({ FunctionCategory::CSI, 0, 2, 0, 's' }) != nullptr);
+    CHECK(availableSequences.select({ FunctionCategory::CSI, '<', 0, '/', '~' }) == nullptr);
+}
@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/Grid.h>
+#include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/primitives.h>
 
 #include <crispy/assert.h>
@@ -9,6 +10,7 @@
 
 #include <algorithm>
 #include <iostream>
+#include <limits>
 
 using std::max;
 using std::min;
@@ -108,7 +110,7 @@ Grid<Cell>::Grid(PageSize pageSize, bool reflowOnResize, MaxHistoryLineCount max
         pageSize,
         [maxHistoryLineCount]() -> LineCount {
             if (auto const* maxLineCount = std::get_if<LineCount>(&maxHistoryLineCount))
-                return *maxLineCount;
+                return std::min(*maxLineCount, DefaultHotHistoryLimit);
             else
                 return LineCount::cast_from(0);
         }(),
@@ -124,18 +126,58 @@ CRISPY_REQUIRES(CellConcept<Cell>)
 void Grid<Cell>::setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount)
 {
     verifyState();
+    reflowHotHistory(-boxed_cast<LineOffset>(historyLineCount()) - 1);
     rezeroBuffers();
     _historyLimit = maxHistoryLineCount;
-    _lines.resize(unbox<size_t>(_pageSize.lines + this->maxHistoryLineCount()));
-    _linesUsed = min(_linesUsed, _pageSize.lines + this->maxHistoryLineCount());
+    _lines.resize(unbox<size_t>(_pageSize.lines + hotHistoryCapacity()));
+    _linesUsed = min(_linesUsed, _pageSize.lines + hotHistoryCapacity());
+    if (!freezesHistory())
+        _frozenHistory.clear();
+    else if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
+    {
+        auto const frozenLimit = *maxLineCount - _hotHistoryLimit;
+        _frozenHistory.discardOldest(_frozenHistory.size() - min(_frozenHistory.size(), frozenLimit));
+    }
+    updateHistorySpill();
     verifyState();
 }
 
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::setHotHistoryLimit(LineCount limit)
+{
+    _hotHistoryLimit = limit;
+    setMaxHistoryLineCount(_historyLimit);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::setHistorySpillThreshold(std::optional<LineCount> threshold)
+{
+    _historySpillThreshold = threshold;
+    updateHistorySpill();
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::updateHistorySpill()
+{
+    // Only infinite history spills, as the spill file is append-only and would
+    // otherwise keep growing with lines that are discarded from the history.
+    if (!_historySpillThreshold || !std::holds_alternative<Infinite>(_historyLimit))
+        _frozenHistory.setSpillThreshold(std::nullopt);
+    else
+        _frozenHistory.setSpillThreshold(*_historySpillThreshold
+                                         - min(*_historySpillThreshold, _hotHistoryLimit));
+}
+
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
 void Grid<Cell>::clearHistory()
 {
     _linesUsed = _pageSize.lines;
+    _frozenHistory.clear();
+    _unreflowedHistory.clear();
     verifyState();
 }
 
@@ -184,39 +226,111 @@ std::string Grid<Cell>::renderMainPageText() const
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-Line<Cell>& Grid<Cell>::lineAt(LineOffset line) noexcept
+Line<Cell>& Grid<Cell>::lineAt(LineOffset line)
 {
     // Require(*line < *_pageSize.lines);
+    if (auto* frozenLine = frozenLineAt(line))
+        return *frozenLine;
     return _lines[unbox<long>(line)];
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-Line<Cell> const& Grid<Cell>::lineAt(LineOffset line) const noexcept
+Line<Cell> const& Grid<Cell>::lineAt(LineOffset line) const
 {
     // Require(*line < *_pageSize.lines);
-    return const_cast<Grid&>(*this).lineAt(line);
+    if (auto const* frozenLine = frozenLineAt(line))
+        return *frozenLine;
+    return _lines[unbox<long>(line)];
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-Cell& Grid<Cell>::at(LineOffset line, ColumnOffset column) noexcept
+Line<Cell>* Grid<Cell>::frozenLineAt(LineOffset line) const
+{
+    auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    if (line >= hotTop)
+        return nullptr;
+
+    auto const frozenIndex = boxed_cast<LineOffset>(_frozenHistory.size()) + (line - hotTop);
+    if (frozenIndex < LineOffset(0))
+        return nullptr;
+
+    return &_frozenHistory.at(unbox<size_t>(frozenIndex), _pageSize.columns);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::logicalLineTop(LineOffset line) const
+{
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    while (top < line && lineAt(line).wrapped())
+        --line;
+    return line;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::logicalLineBottom(LineOffset line) const
+{
+    auto const bottom = boxed_cast<LineOffset>(_pageSize.lines) - 1;
+    while (line < bottom && lineAt(line + 1).wrapped())
+        ++line;
+    return line;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::skipUnmatchableHistory(LineOffset line,
+                                              gsl::span<uint16_t const> trigramHashes) const noexcept
+{
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    while (top <= line && line < top + boxed_cast<LineOffset>(_frozenHistory.size()))
+    {
+        auto const range = _frozenHistory.unmatchableBlockRange(unbox<size_t>(line - top), trigramHashes);
+        if (!range)
+            break;
+        line = top + LineOffset::cast_from(range->second + 1);
+    }
+    return line;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::skipUnmatchableHistoryReverse(LineOffset line,
+                                                     gsl::span<uint16_t const> trigramHashes) const noexcept
+{
+    auto const top = -boxed_cast<LineOffset>(historyLineCount());
+    while (top <= line && line < top + boxed_cast<LineOffset>(_frozenHistory.size()))
+    {
+        auto const range = _frozenHistory.unmatchableBlockRange(unbox<size_t>(line - top), trigramHashes);
+        if (!range)
+            break;
+        line = top + LineOffset::cast_from(range->first) - 1;
+    }
+    return line;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+Cell& Grid<Cell>::at(LineOffset line, ColumnOffset column)
 {
     return useCellAt(line, column);
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-Cell& Grid<Cell>::useCellAt(LineOffset line, ColumnOffset column) noexcept
+Cell& Grid<Cell>::useCellAt(LineOffset line, ColumnOffset column)
 {
     return lineAt(line).useCellAt(column);
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-Cell const& Grid<Cell>::at(LineOffset line, ColumnOffset column) const noexcept
+Cell const& Grid<Cell>::at(LineOffset line, ColumnOffset column) const
 {
-    return const_cast<Grid&>(*this).at(line, column);
+    // Not routed through useCellAt(), as reading a cell must not invalidate the line's revision.
+    return lineAt(line).inflatedBuffer()[unbox<size_t>(column)];
 }
 
 template <typename Cell>
@@ -262,7 +376,7 @@ gsl::span<Line<Cell>> Grid<Cell>::mainPage()
 // {{{ Grid impl: Line access
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-gsl::span<Cell const> Grid<Cell>::lineBufferRightTrimmed(LineOffset line) const noexcept
+gsl::span<Cell const> Grid<Cell>::lineBufferRightTrimmed(LineOffset line) const
 {
     return detail::trimRight(lineBuffer(line));
 }
@@ -308,19 +422,18 @@ std::string Grid<Cell>::lineText(Line<Cell> const& line) const
 {
     std::stringstream sstr;
     int skipCount = 0;
-    for (Cell const& cell: line.inflatedBuffer())
-    {
+    line.visitCells([&](Cell const& cell) {
         if (skipCount > 0)
         {
             skipCount--;
-            continue;
+            return;
         }
         if (cell.codepointCount() == 0)
             sstr << ' ';
         else
             sstr << cell.toUtf8();
         skipCount = cell.width() - 1;
-    }
+    });
     return sstr.str();
 }
 
@@ -335,7 +448,7 @@ void Grid<Cell>::setLineText(LineOffset line, std::string_view text)
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-bool Grid<Cell>::isLineBlank(LineOffset line) const noexcept
+bool Grid<Cell>::isLineBlank(LineOffset line) const
 {
     auto const isBlank = [](auto const& cell) noexcept {
         return CellUtil::empty(cell);
@@ -350,7 +463,7 @@ bool Grid<Cell>::isLineBlank(LineOffset line) const noexcept
  */
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-int Grid<Cell>::computeLogicalLineNumberFromBottom(LineCount n) const noexcept
+int Grid<Cell>::computeLogicalLineNumberFromBottom(LineCount n) const
 {
     int logicalLineCount = 0;
     auto outputRelativePhysicalLine = *_pageSize.lines - 1;
@@ -381,15 +494,17 @@ int Grid<Cell>::computeLogicalLineNumberFromBottom(LineCount n) const noexcept
 // {{{ Grid impl: scrolling
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes) noexcept
+LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes)
 {
     verifyState();
     // Number of lines in the ring buffer that are not yet
     // used by the grid system.
     auto const linesAvailable = LineCount::cast_from(_lines.size() - unbox<size_t>(_linesUsed));
-    if (std::holds_alternative<Infinite>(_historyLimit) && linesAvailable < linesCountToScrollUp)
+    auto const linesAllocatable = _pageSize.lines + _hotHistoryLimit - LineCount::cast_from(_lines.size());
+    if (std::holds_alternative<Infinite>(_historyLimit) && linesAvailable < linesCountToScrollUp
+        && linesAllocatable > LineCount(0))
     {
-        auto const linesToAllocate = unbox(linesCountToScrollUp - linesAvailable);
+        auto const linesToAllocate = unbox(min(linesCountToScrollUp - linesAvailable, linesAllocatable));
 
         for ([[maybe_unused]] auto const _: ranges::views::iota(0, linesToAllocate))
         {
@@ -401,6 +516,7 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
     if (unbox<size_t>(_linesUsed) == _lines.size()) // with all grid lines in-use
     {
         // TODO: ensure explicit test for this case
+        freezeOldestHistoryLines(min(linesCountToScrollUp, LineCount::cast_from(_lines.size())));
         rotateBuffersLeft(linesCountToScrollUp);
 
         // Initialize (/reset) new lines.
@@ -409,6 +525,7 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
              ++y)
             lineAt(y).reset(defaultLineFlags(), defaultAttributes);
 
+        packHistoryLines(linesCountToScrollUp);
         return linesCountToScrollUp;
     }
     else
@@ -431,6 +548,7 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
         if (linesAppendCount < linesCountToScrollUp)
         {
             auto const incrementCount = linesCountToScrollUp - linesAppendCount;
+            freezeOldestHistoryLines(min(incrementCount, LineCount::cast_from(_lines.size())));
             rotateBuffersLeft(incrementCount);
 
             // Initialize (/reset) new lines.
@@ -439,13 +557,63 @@ LineCount Grid<Cell>::scrollUp(LineCount linesCountToScrollUp, GraphicsAttribute
                  ++y)
                 lineAt(y).reset(defaultLineFlags(), defaultAttributes);
         }
+        packHistoryLines(linesCountToScrollUp);
         return LineCount::cast_from(linesAppendCount);
     }
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes, Margin margin) noexcept
+void Grid<Cell>::packHistoryLines(LineCount count) noexcept
+{
+    // Lines that just went into the history are most likely never mutated again,
+    // so keep them in their compact form rather than as a vector of cells.
+    auto const n = std::min(count, hotHistoryLineCount());
+    for (auto y = LineOffset(-1); y >= -boxed_cast<LineOffset>(n); --y)
+        if (lineAt(y).isInflatedBuffer() || lineAt(y).isSpanBuffer())
+            (void) lineAt(y).pack();
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::freezeOldestHistoryLines(LineCount count)
+{
+    // Moves the oldest lines of the fully used ring buffer into the frozen history,
+    // right before they would be rotated out and reused as new lines at the bottom.
+    if (!freezesHistory())
+    {
+        discardUnreflowedHistory(count);
+        return;
+    }
+
+    auto const oldest = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    for (auto y = oldest; y < oldest + boxed_cast<LineOffset>(count); ++y)
+    {
+        auto& line = _lines[unbox<long>(y)];
+
+        // Unreflowed lines are frozen with the width they were laid out with, for reflowing them later.
+        if (!_unreflowedHistory.empty())
+        {
+            if (line.size() > _unreflowedHistory.front().columns)
+                line.resize(_unreflowedHistory.front().columns);
+            discardUnreflowedHistory(LineCount(1));
+        }
+
+        _frozenHistory.push(std::move(line));
+        line = Line<Cell>(defaultLineFlags(), TrivialLineBuffer { _pageSize.columns, GraphicsAttributes {} });
+    }
+
+    if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
+    {
+        auto const frozenLimit = *maxLineCount - _hotHistoryLimit;
+        if (_frozenHistory.size() > frozenLimit)
+            _frozenHistory.discardOldest(_frozenHistory.size() - frozenLimit);
+    }
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes, Margin margin)
 {
     verifyState();
     Require(0 <= *margin.horizontal.from && *margin.horizontal.to < *_pageSize.columns);
@@ -496,6 +664,16 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
              ++targetLineOffset)
         {
             auto const sourceLineOffset = targetLineOffset + *n2;
+            if constexpr (UseSpanLineBuffers)
+            {
+                auto* target = lineAt(targetLineOffset).useSpanBuffer();
+                auto const* source = lineAt(sourceLineOffset).useSpanBuffer();
+                if (target && source)
+                {
+                    target->copyColumns(*source, margin.horizontal.from, margin.horizontal.length());
+                    continue;
+                }
+            }
             auto t = &useCellAt(targetLineOffset, margin.horizontal.from);
             auto s = &at(sourceLineOffset, margin.horizontal.from);
             std::copy_n(s, columnsToMove, t);
@@ -503,6 +681,18 @@ LineCount Grid<Cell>::scrollUp(LineCount n, GraphicsAttributes defaultAttributes
 
         for (LineOffset line = margin.vertical.to - *n2 + 1; line <= margin.vertical.to; ++line)
         {
+            if constexpr (UseSpanLineBuffers)
+            {
+                if (auto* spans = lineAt(line).useSpanBuffer())
+                {
+                    spans->fill(margin.horizontal.from,
+                                margin.horizontal.length(),
+                                SpanLineBuffer::Column {},
+                                defaultAttributes,
+                                HyperlinkId {});
+                    continue;
+                }
+            }
             auto a = &useCellAt(line, margin.horizontal.from);
             auto b = a + unbox(margin.horizontal.length());
             while (a != b)
@@ -611,6 +801,8 @@ CRISPY_REQUIRES(CellConcept<Cell>)
 void Grid<Cell>::reset()
 {
     _linesUsed = _pageSize.lines;
+    _frozenHistory.clear();
+    _unreflowedHistory.clear();
     _lines.rotate_right(_lines.zero_index());
     for (int i = 0; i < unbox(_pageSize.lines); ++i)
         _lines[i].reset(defaultLineFlags(), GraphicsAttributes {});
@@ -632,9 +824,10 @@ CellLocation Grid<Cell>::growLines(LineCount newHeight, CellLocation cursor)
     if (*cursor.line + 1 == *_pageSize.lines)
     {
         auto const totalLinesToExtend = newHeight - _pageSize.lines;
-        auto const linesToTakeFromSavedLines = std::min(totalLinesToExtend, historyLineCount());
+        auto const linesToTakeFromSavedLines = std::min(totalLinesToExtend, hotHistoryLineCount());
         Require(totalLinesToExtend >= linesToTakeFromSavedLines);
         Require(*linesToTakeFromSavedLines >= 0);
+        reflowHistory(-boxed_cast<LineOffset>(linesToTakeFromSavedLines));
         rotateBuffersRight(linesToTakeFromSavedLines);
         _pageSize.lines += linesToTakeFromSavedLines;
         cursorMove.line += boxed_cast<LineOffset>(linesToTakeFromSavedLines);
@@ -645,7 +838,7 @@ CellLocation Grid<Cell>::growLines(LineCount newHeight, CellLocation cursor)
     Require(*totalLinesToExtend >= 0);
     // ? Require(linesToTakeFromSavedLines == LineCount(0));
 
-    auto const newTotalLineCount = maxHistoryLineCount() + newHeight;
+    auto const newTotalLineCount = hotHistoryCapacity() + newHeight;
     auto const currentTotalLineCount = LineCount::cast_from(_lines.size());
     auto const linesToFill = max(0, *newTotalLineCount - *currentTotalLineCount);
 
@@ -656,7 +849,7 @@ CellLocation Grid<Cell>::growLines(LineCount newHeight, CellLocation cursor)
     _linesUsed = min(_linesUsed + totalLinesToExtend, LineCount::cast_from(_lines.size()));
 
     Ensures(_pageSize.lines == newHeight);
-    Ensures(_lines.size() >= unbox<size_t>(maxHistoryLineCount() + _pageSize.lines));
+    Ensures(_lines.size() >= unbox<size_t>(totalLineCount()));
     verifyState();
 
     return cursorMove;
@@ -677,6 +870,9 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
     // Shrinking in line count with the cursor at the bottom margin will move
     // the top lines into the scrollback area.
 
+    // Number of logical lines at the bottom to reflow right away, covering the page and one page above it.
+    auto const reflowMargin = std::max(newSize.lines, _pageSize.lines) * 2;
+
     // {{{ helper methods
     auto const shrinkLines = [this](LineCount newHeight, CellLocation cursor) -> CellLocation {
         // Shrink existing line count to newSize.lines
@@ -691,7 +887,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             _pageSize.lines - boxed_cast<LineCount>(cursor.line + 1);
         auto const cutoffCount = min(numLinesToShrink, linesAvailableBelowCursorBeforeShrink);
         auto const numLinesToPushUp = numLinesToShrink - cutoffCount;
-        auto const numLinesToPushUpCapped = min(numLinesToPushUp, maxHistoryLineCount());
+        auto const numLinesToPushUpCapped = min(numLinesToPushUp, hotHistoryCapacity());
 
         gridLog()(" -> shrink lines: numLinesToShrink {}, linesAvailableBelowCursorBeforeShrink {}, "
                   "cutoff {}, pushUp "
@@ -730,7 +926,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
         return CellLocation {};
     };
 
-    auto const growColumns = [this, wrapPending](ColumnCount newColumnCount) -> CellLocation {
+    auto const growColumns = [this, wrapPending, reflowMargin](ColumnCount newColumnCount) -> CellLocation {
         using LineBuffer = typename Line<Cell>::InflatedBuffer;
 
         if (!_reflowOnResize)
@@ -776,7 +972,16 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
                     gridLog()("{} |> \"{}\"", msg, Line<Cell>(lineFlags, logicalLineBuffer).toUtf8());
                 };
 
-            for (int i = -*historyLineCount(); i < *_pageSize.lines; ++i)
+            auto const reflowTop = deferHistoryReflow(reflowMargin);
+            for (int i = -*hotHistoryLineCount(); i < *reflowTop; ++i)
+            {
+                auto& line = _lines[i];
+                if (line.size() < newColumnCount)
+                    line.resize(newColumnCount);
+                grownLines.emplace_back(std::move(line));
+            }
+
+            for (int i = *reflowTop; i < *_pageSize.lines; ++i)
             {
                 auto& line = _lines[i];
                 // logLogicalLine(line.flags(), fmt::format("Line[{:>2}]: next line: \"{}\"", i,
@@ -798,6 +1003,11 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
                         buffer.displayWidth = newColumnCount;
                         grownLines.emplace_back(line);
                     }
+                    else if (line.isPackedBuffer())
+                    {
+                        line.packedBuffer().displayWidth = newColumnCount;
+                        grownLines.emplace_back(line);
+                    }
                     else
                     {
                         // logLogicalLine(line.flags(), " - start new logical line");
@@ -827,7 +1037,7 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             _linesUsed = LineCount::cast_from(grownLines.size());
 
             // Fill scrollback lines.
-            auto const totalLineCount = unbox<size_t>(_pageSize.lines + maxHistoryLineCount());
+            auto const totalLineCount = unbox<size_t>(this->totalLineCount());
             while (grownLines.size() < totalLineCount)
                 grownLines.emplace_back(
                     defaultLineFlags(),
@@ -845,7 +1055,8 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
     };
 
     auto const shrinkColumns =
-        [this](ColumnCount newColumnCount, LineCount /*newLineCount*/, CellLocation cursor) -> CellLocation {
+        [this, reflowMargin](ColumnCount newColumnCount, LineCount /*newLineCount*/, CellLocation cursor)
+        -> CellLocation {
         using LineBuffer = typename Line<Cell>::InflatedBuffer;
 
         if (!_reflowOnResize)
@@ -889,12 +1100,19 @@ CellLocation Grid<Cell>::resize(PageSize newSize, CellLocation currentCursorPos,
             LineBuffer wrappedColumns;
             LineFlags previousFlags = _lines.front().inheritableFlags();
 
-            auto const totalLineCount = unbox<size_t>(_pageSize.lines + maxHistoryLineCount());
+            auto const totalLineCount = unbox<size_t>(this->totalLineCount());
             shrinkedLines.reserve(totalLineCount);
-            Require(totalLineCount == unbox<size_t>(this->totalLineCount()));
 
+            // Unreflowed history lines are at least as wide as the page, and thus need no padding.
+            auto const reflowTop = deferHistoryReflow(reflowMargin);
             auto numLinesWritten = LineCount(0);
-            for (auto i = -*historyLineCount(); i < *_pageSize.lines; ++i)
+            for (auto i = -*hotHistoryLineCount(); i < *reflowTop; ++i)
+            {
+                shrinkedLines.emplace_back(std::move(_lines[i]));
+                numLinesWritten++;
+            }
+
+            for (auto i = *reflowTop; i < *_pageSize.lines; ++i)
             {
                 auto& line = _lines[i];
 
@@ -989,13 +1207,200 @@ void Grid<Cell>::clampHistory()
     // TODO: needed?
 }
 
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineCount Grid<Cell>::unreflowedHistoryLineCount() const noexcept
+{
+    auto count = LineCount(0);
+    for (auto const& lines: _unreflowedHistory)
+        count += lines.count;
+    return count;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::deferHistoryReflow(LineCount margin)
+{
+    // The last few logical lines are reflowed right away. Counting logical rather than physical lines
+    // ensures they still fill the page when reflowed into fewer lines.
+    auto const logicalLinesTop = [this](LineCount count) {
+        auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+        auto top = boxed_cast<LineOffset>(_pageSize.lines);
+        while (top > hotTop && count > LineCount(0))
+            if (!_lines[unbox<long>(--top)].wrapped())
+                --count;
+        return top;
+    };
+
+    // Any of them left unreflowed by a previous resize are brought to the current page width first.
+    auto top = logicalLinesTop(margin);
+    while (top < -boxed_cast<LineOffset>(hotHistoryLineCount() - unreflowedHistoryLineCount()))
+    {
+        reflowHistory(top);
+        top = logicalLinesTop(margin);
+    }
+
+    auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    auto const deferredCount = boxed_cast<LineCount>(top - hotTop) - unreflowedHistoryLineCount();
+    if (deferredCount > LineCount(0))
+    {
+        if (!_unreflowedHistory.empty() && _unreflowedHistory.back().columns == _pageSize.columns)
+            _unreflowedHistory.back().count += deferredCount;
+        else
+            _unreflowedHistory.push_back(UnreflowedLines { deferredCount, _pageSize.columns });
+    }
+
+    return top;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::discardUnreflowedHistory(LineCount count) noexcept
+{
+    auto i = _unreflowedHistory.begin();
+    for (; i != _unreflowedHistory.end() && count >= i->count; ++i)
+        count -= i->count;
+    if (i != _unreflowedHistory.end())
+        i->count -= count;
+    _unreflowedHistory.erase(_unreflowedHistory.begin(), i);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+LineOffset Grid<Cell>::reflowedHistoryTop() const noexcept
+{
+    auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    if (auto const unreflowedLineCount = unreflowedHistoryLineCount(); unreflowedLineCount != LineCount(0))
+        return hotTop + boxed_cast<LineOffset>(unreflowedLineCount);
+    if (!_reflowOnResize)
+        return -boxed_cast<LineOffset>(historyLineCount());
+    return hotTop - boxed_cast<LineOffset>(_frozenHistory.reflowedLineCount(_pageSize.columns));
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::reflowHistory(LineOffset top)
+{
+    // Reflowing may change the number of history lines, so a top above all of them asks for all.
+    auto const all = top < -boxed_cast<LineOffset>(historyLineCount());
+    reflowHotHistory(top);
+
+    // Frozen history lines are reflowed in whole blocks, once all live history lines are reflowed.
+    auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    if (top >= hotTop || !_reflowOnResize || !freezesHistory())
+        return;
+
+    _frozenHistory.reflow(_pageSize.columns,
+                          all ? LineCount(std::numeric_limits<int>::max()) : boxed_cast<LineCount>(hotTop - top));
+    if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
+    {
+        auto const frozenLimit = *maxLineCount - _hotHistoryLimit;
+        if (_frozenHistory.size() > frozenLimit)
+            _frozenHistory.discardOldest(_frozenHistory.size() - frozenLimit);
+    }
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Grid<Cell>::reflowHotHistory(LineOffset top)
+{
+    auto const hotTop = -boxed_cast<LineOffset>(hotHistoryLineCount());
+    auto const unreflowedBottom = hotTop + boxed_cast<LineOffset>(unreflowedHistoryLineCount());
+    if (top >= unreflowedBottom)
+        return;
+
+    // The reflowed lines may take up more or fewer lines than before,
+    // so keep going upwards until they reach up to the requested line.
+    auto const reflowAll = top < hotTop;
+    auto reflowedLogicalLines = std::vector<Lines<Cell>> {};
+    auto reflowedLineCount = LineCount(0);
+    auto reflowTop = unreflowedBottom;
+    while (!_unreflowedHistory.empty()
+           && (reflowAll || unreflowedBottom - boxed_cast<LineOffset>(reflowedLineCount) > top))
+    {
+        auto& lines = _unreflowedHistory.back();
+        auto const runTop = reflowTop - boxed_cast<LineOffset>(lines.count);
+        auto const bottom = reflowTop;
+        reflowTop = bottom - 1;
+        while (reflowTop > runTop && _lines[unbox<long>(reflowTop)].wrapped())
+            --reflowTop;
+
+        reflowedLogicalLines.emplace_back(reflowLogicalLine(reflowTop, bottom, lines.columns));
+        reflowedLineCount += LineCount::cast_from(reflowedLogicalLines.back().size());
+
+        lines.count -= boxed_cast<LineCount>(bottom - reflowTop);
+        if (lines.count == LineCount(0))
+            _unreflowedHistory.pop_back();
+    }
+
+    auto reflowedLines = Lines<Cell> {};
+    reflowedLines.reserve(_lines.size());
+    for (auto y = hotTop; y < reflowTop; ++y)
+        reflowedLines.emplace_back(std::move(_lines[unbox<long>(y)]));
+    for (auto logicalLine = reflowedLogicalLines.rbegin(); logicalLine != reflowedLogicalLines.rend();
+         ++logicalLine)
+        for (auto& line: *logicalLine)
+            reflowedLines.emplace_back(std::move(line));
+    for (auto y = unreflowedBottom; y < boxed_cast<LineOffset>(_pageSize.lines); ++y)
+        reflowedLines.emplace_back(std::move(_lines[unbox<long>(y)]));
+
+    _linesUsed = LineCount::cast_from(reflowedLines.size());
+    while (reflowedLines.size() < _lines.size())
+        reflowedLines.emplace_back(defaultLineFlags(),
+                                   TrivialLineBuffer { _pageSize.columns, GraphicsAttributes {} });
+    reflowedLines.rotate_left(unbox<size_t>(_linesUsed - _pageSize.lines));
+    _lines = std::move(reflowedLines);
+
+    verifyState();
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+Lines<Cell> Grid<Cell>::reflowLogicalLine(LineOffset top, LineOffset bottom, ColumnCount layoutWidth)
+{
+    auto output = Lines<Cell> {};
+    auto& firstLine = _lines[unbox<long>(top)];
+
+    if (bottom - top == LineOffset(1))
+    {
+        auto const flags = firstLine.inheritableFlags();
+        auto wrappedColumns = firstLine.reflow(_pageSize.columns);
+        output.emplace_back(std::move(firstLine));
+        if (!wrappedColumns.empty())
+            detail::addNewWrappedLines(output, _pageSize.columns, std::move(wrappedColumns), flags, false);
+        return output;
+    }
+
+    // All but the last line are filled up to the width they were laid out with,
+    // as trailing blanks there are part of the text.
+    auto logicalLineBuffer = typename Line<Cell>::InflatedBuffer {};
+    for (auto y = top; y < bottom; ++y)
+    {
+        auto const& line = _lines[unbox<long>(y)];
+        auto const cells = y + 1 < bottom ? line.cells().first(
+                               std::min(unbox<size_t>(layoutWidth), unbox<size_t>(line.size())))
+                                          : line.trim_blank_right();
+        logicalLineBuffer.insert(logicalLineBuffer.end(), cells.begin(), cells.end());
+    }
+
+    if (logicalLineBuffer.empty())
+        output.emplace_back(firstLine.flags(), TrivialLineBuffer { _pageSize.columns, GraphicsAttributes {} });
+    else
+        detail::addNewWrappedLines(output,
+                                   _pageSize.columns,
+                                   std::move(logicalLineBuffer),
+                                   firstLine.flags().without(LineFlag::Wrapped),
+                                   !firstLine.wrapped());
+    return output;
+}
+
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
 void Grid<Cell>::appendNewLines(LineCount count, GraphicsAttributes attr)
 {
     auto const wrappableFlag = _lines.back().wrappableFlag();
 
-    if (historyLineCount() == maxHistoryLineCount())
+    if (hotHistoryLineCount() == hotHistoryCapacity())
     {
         // We've reached to history line count limit already.
         // Rotate lines that would fall off down to the bottom again in a clean state.
@@ -1057,7 +1462,7 @@ std::string dumpGrid(Grid<Cell> const& grid)
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
 CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
-                                                   u32string_view wordDelimiters) const noexcept
+                                                   u32string_view wordDelimiters) const
 {
     auto const left = [this, wordDelimiters, position]() {
         auto last = position;
@@ -1123,7 +1528,7 @@ CellLocationRange Grid<Cell>::wordRangeUnderCursor(CellLocation position,
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-bool Grid<Cell>::cellEmptyOrContainsOneOf(CellLocation position, u32string_view delimiters) const noexcept
+bool Grid<Cell>::cellEmptyOrContainsOneOf(CellLocation position, u32string_view delimiters) const
 {
     // Word selection may be off by one
     position.column = min(position.column, boxed_cast<ColumnOffset>(pageSize().columns - 1));
@@ -1134,7 +1539,7 @@ bool Grid<Cell>::cellEmptyOrContainsOneOf(CellLocation position, u32string_view
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-u32string Grid<Cell>::extractText(CellLocationRange range) const noexcept
+u32string Grid<Cell>::extractText(CellLocationRange range) const
 {
     if (range.first.line > range.second.line)
         std::swap(range.first, range.second);
@@ -2,7 +2,9 @@
 #pragma once
 
 #include <vtbackend/GraphicsAttributes.h>
+#include <vtbackend/HistoryStore.h>
 #include <vtbackend/Line.h>
+#include <vtbackend/SearchPattern.h>
 #include <vtbackend/cell/CellConcept.h>
 #include <vtbackend/primitives.h>
 
@@ -23,6 +25,7 @@
 #include <algorithm>
 #include <string>
 #include <string_view>
+#include <vector>
 
 namespace vtbackend
 {
@@ -104,6 +107,10 @@ constexpr bool operator!=(Margin const& a, PageSize b) noexcept
 template <typename Cell>
 using Lines = crispy::ring<Line<Cell>>;
 
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+class Grid;
+
 struct RenderPassHints
 {
     bool containsBlinkingCells = false;
@@ -112,21 +119,28 @@ struct RenderPassHints
 /**
  * Represents a logical grid line, i.e. a sequence lines that were written without
  * an explicit linefeed, triggering an auto-wrap.
+ *
+ * The grid lines are looked up on each access instead of being referenced up front,
+ * because a reference to a frozen history line only stays valid until other frozen
+ * history lines are accessed (see Grid::lineAt()).
  */
 template <typename Cell>
 struct LogicalLine
 {
     LineOffset top {};
     LineOffset bottom {};
-    std::vector<std::reference_wrapper<Line<Cell>>> lines {};
+    Grid<Cell> const* grid = nullptr;
+
+    /// Returns the grid line at @p line, which must be within top and bottom.
+    [[nodiscard]] Line<Cell> const& lineAt(LineOffset line) const { return grid->lineAt(line); }
 
     [[nodiscard]] Line<Cell> joinWithRightTrimmed() const
     {
         // TODO: determine final line's column count and pass it to ctor.
         typename Line<Cell>::Buffer output;
-        auto lineFlags = lines.front().get().flags();
-        for (Line<Cell> const& line: lines)
-            for (Cell const& cell: line.cells())
+        auto lineFlags = lineAt(top).flags();
+        for (auto line = top; line <= bottom; ++line)
+            for (Cell const& cell: lineAt(line).cells())
                 output.emplace_back(cell);
 
         while (!output.empty() && output.back().empty())
@@ -138,55 +152,85 @@ struct LogicalLine
     [[nodiscard]] std::string text() const
     {
         std::string output;
-        for (auto const& line: lines)
-            output += line.get().toUtf8();
+        for (auto line = top; line <= bottom; ++line)
+            output += lineAt(line).toUtf8();
         return output;
     }
 
+    /// Collects the text of this logical line into @p output, to be matched by a SearchPattern.
+    ///
+    /// Columns in the collected text count from the top line's first column,
+    /// continuing at each following line.
+    void collectSearchText(SearchText& output) const
+    {
+        output.clear();
+        auto const lineLength = this->lineLength();
+        auto offset = size_t { 0 };
+        for (auto line = top; line <= bottom; ++line)
+        {
+            lineAt(line).visitText([&](size_t column, char32_t codepoint, uint8_t width) {
+                output.append(offset + column, codepoint, width);
+            });
+            offset += lineLength;
+        }
+    }
+
+    /// Translates a column of the text collected by collectSearchText() into a grid location.
+    [[nodiscard]] CellLocation locationOf(size_t column) const
+    {
+        auto const lineLength = this->lineLength();
+        return CellLocation { top + LineOffset::cast_from(column / lineLength),
+                              ColumnOffset::cast_from(column % lineLength) };
+    }
+
+    /// Translates a grid location within this logical line into a column of the text
+    /// collected by collectSearchText().
+    [[nodiscard]] size_t columnOf(CellLocation location) const
+    {
+        return unbox<size_t>(location.line - top) * lineLength() + unbox<size_t>(location.column);
+    }
+
     // Searches from left to right, taking into account line wrapping
     [[nodiscard]] std::optional<vtbackend::CellLocation> search(std::u32string_view searchText,
                                                                 ColumnOffset startPosition) const
     {
-        auto const lineLength = unbox<size_t>(lines.front().get().size());
-        auto i = top;
+        auto const lineLength = this->lineLength();
         if (searchText.size() > lineLength)
         {
-            for (auto line = lines.begin(); line != lines.end(); ++line)
+            for (auto line = top; line <= bottom; ++line)
             {
                 std::u32string_view const textOnThisLine(searchText.data(),
                                                          lineLength - unbox<size_t>(startPosition));
                 // Find how much of searchText is on this line
-                auto const result = searchPartialMatch(textOnThisLine, line->get());
+                auto const result = searchPartialMatch(textOnThisLine, lineAt(line));
                 if (result != 0)
                 {
                     // Match the remaining text
                     std::u32string_view const remainingTextToMatch(searchText.data() + result,
                                                                    searchText.size() - result);
                     if (matchTextAt(remainingTextToMatch, ColumnOffset(0), line + 1))
-                        return CellLocation { i, ColumnOffset(static_cast<int>(lineLength - result)) };
+                        return CellLocation { line, ColumnOffset(static_cast<int>(lineLength - result)) };
                 }
                 startPosition = ColumnOffset(0);
-                ++i;
             }
             return std::nullopt;
         }
-        for (auto line = lines.begin(); line != lines.end(); ++line)
+        for (auto line = top; line <= bottom; ++line)
         {
-            auto result = line->get().search(searchText, startPosition);
+            auto result = lineAt(line).search(searchText, startPosition);
             if (result.has_value())
             {
                 if (result->partialMatchLength == 0)
-                    return CellLocation { i, result->column };
+                    return CellLocation { line, result->column };
                 auto remainingText = searchText;
                 remainingText.remove_prefix(result->partialMatchLength);
-                if (line + 1 != lines.end() && (line + 1)->get().matchTextAt(remainingText, ColumnOffset(0)))
-                    return CellLocation { i,
+                if (line < bottom && lineAt(line + 1).matchTextAt(remainingText, ColumnOffset(0)))
+                    return CellLocation { line,
                                           ColumnOffset::cast_from(
-                                              static_cast<int>(unbox<size_t>(line->get().size())
+                                              static_cast<int>(unbox<size_t>(lineAt(line).size())
                                                                - result->partialMatchLength)) };
             }
             startPosition = ColumnOffset(0);
-            ++i;
         }
         return std::nullopt;
     }
@@ -195,23 +239,21 @@ struct LogicalLine
     [[nodiscard]] std::optional<vtbackend::CellLocation> searchReverse(std::u32string_view searchText,
                                                                        ColumnOffset startPosition) const
     {
-        auto i = bottom;
-        auto const lineLength = unbox<size_t>(lines.front().get().size());
+        auto const lineLength = this->lineLength();
         if (searchText.size() > lineLength)
         {
-            for (auto line = lines.rbegin(); line != lines.rend(); ++line)
+            for (auto line = bottom; line >= top; --line)
             {
                 std::u32string_view const textOnThisLine(searchText.data() + searchText.size()
                                                              - unbox<size_t>(startPosition),
                                                          unbox<size_t>(startPosition));
-                auto const result = searchPartialMatchReverse(textOnThisLine, line->get());
+                auto const result = searchPartialMatchReverse(textOnThisLine, lineAt(line));
                 if (result != 0)
                 {
                     std::u32string_view remainingText(searchText.data(), searchText.size() - result);
                     // Check if the searchText can even fit in the available lines
                     auto const willFit = [&] {
-                        auto const count = static_cast<size_t>(
-                            std::max(long { 0 }, static_cast<long>(std::distance(line + 1, lines.rend()))));
+                        auto const count = unbox<size_t>(line - top);
                         auto const total = count * lineLength;
                         return total >= remainingText.size();
                     }();
@@ -223,39 +265,39 @@ struct LogicalLine
                         (lineLength - (remainingText.size() % lineLength)) % lineLength);
 
                     // Line where the remaining text should start at
-                    long const startLine = static_cast<long>(std::ceil(
+                    auto const startLine = LineOffset::cast_from(std::ceil(
                         static_cast<double>(remainingText.size()) / static_cast<double>(lineLength)));
 
-                    if (matchTextAtReverse(remainingText, startCol, line + startLine))
-                        return CellLocation { LineOffset::cast_from(i.value - startLine), startCol };
+                    if (matchTextAtReverse(remainingText, startCol, line - startLine))
+                        return CellLocation { line - startLine, startCol };
                 }
                 startPosition = ColumnOffset::cast_from(lineLength - 1);
-                --i;
             }
             return std::nullopt;
         }
         auto const lastColumn = ColumnOffset::cast_from(lineLength);
-        for (auto line = lines.rbegin(); line != lines.rend(); ++line)
+        for (auto line = bottom; line >= top; --line)
         {
-            auto result = line->get().searchReverse(searchText, startPosition);
+            auto result = lineAt(line).searchReverse(searchText, startPosition);
             if (result.has_value())
             {
                 if (result->partialMatchLength == 0)
-                    return CellLocation { i, result->column };
+                    return CellLocation { line, result->column };
                 auto remainingText = searchText;
                 remainingText.remove_suffix(result->partialMatchLength);
-                if (line + 1 != lines.rend()
-                    && (line + 1)->get().matchTextAt(remainingText,
-                                                     lastColumn - static_cast<int>(remainingText.size())))
-                    return CellLocation { i - 1, lastColumn - static_cast<int>(remainingText.size()) };
+                if (line > top
+                    && lineAt(line - 1).matchTextAt(remainingText,
+                                                    lastColumn - static_cast<int>(remainingText.size())))
+                    return CellLocation { line - 1, lastColumn - static_cast<int>(remainingText.size()) };
             }
             startPosition = lastColumn - 1;
-            --i;
         }
         return std::nullopt;
     }
 
   private:
+    [[nodiscard]] size_t lineLength() const { return unbox<size_t>(lineAt(top).size()); }
+
     // Finds the maximum number of charecters of searchText that can be matched from right end of line
     [[nodiscard]] size_t searchPartialMatch(std::u32string_view searchText,
                                             const Line<Cell>& line) const noexcept
@@ -283,10 +325,10 @@ struct LogicalLine
         return 0;
     }
 
-    [[nodiscard]] auto segmentSearchText(std::u32string_view searchText, ColumnOffset startCol) const noexcept
+    [[nodiscard]] auto segmentSearchText(std::u32string_view searchText, ColumnOffset startCol) const
     {
         std::vector<std::u32string_view> segments;
-        auto const lineLength = unbox<size_t>(lines.front().get().size());
+        auto const lineLength = this->lineLength();
         if (startCol > ColumnOffset(0))
         {
             segments.emplace_back(searchText.data(), lineLength - unbox<size_t>(startCol));
@@ -306,15 +348,14 @@ struct LogicalLine
     }
 
     // Match searchText right to left starting at startCol in line startLine
-    template <typename Itr>
     [[nodiscard]] bool matchTextAt(std::u32string_view searchText,
                                    ColumnOffset startCol,
-                                   Itr startLine) const noexcept
+                                   LineOffset startLine) const
     {
         auto segments = segmentSearchText(searchText, startCol);
         for (auto segment: segments)
         {
-            if (!startLine->get().matchTextAt(segment, startCol))
+            if (startLine > bottom || !lineAt(startLine).matchTextAt(segment, startCol))
                 return false;
             ++startLine;
         }
@@ -322,18 +363,17 @@ struct LogicalLine
     }
 
     // Match searchText right to left starting at startCol in line startLine
-    template <typename Itr>
     [[nodiscard]] bool matchTextAtReverse(std::u32string_view searchText,
                                           ColumnOffset startCol,
-                                          Itr startLine) const noexcept
+                                          LineOffset startLine) const
     {
         auto segments = segmentSearchText(searchText, startCol);
         for (auto i: segments)
         {
-            if (!startLine->get().matchTextAt(i, startCol))
+            if (!lineAt(startLine).matchTextAt(i, startCol))
                 return false;
             startCol = ColumnOffset::cast_from(0);
-            --startLine;
+            ++startLine;
         }
         return true;
     }
@@ -356,23 +396,24 @@ struct LogicalLines
 {
     LineOffset topMostLine;
     LineOffset bottomMostLine;
-    std::reference_wrapper<Lines<Cell>> lines;
+    std::reference_wrapper<Grid<Cell>> grid;
 
     // NOLINTNEXTLINE(readability-identifier-naming)
     struct iterator // {{{
     {
-        std::reference_wrapper<Lines<Cell>> lines;
+        std::reference_wrapper<Grid<Cell>> grid;
         LineOffset top;
         LineOffset next; // index to next logical line's beginning
         LineOffset bottom;
         LogicalLine<Cell> current;
 
-        iterator(std::reference_wrapper<Lines<Cell>> lines,
+        iterator(std::reference_wrapper<Grid<Cell>> grid,
                  LineOffset top,
                  LineOffset next,
                  LineOffset bottom):
-            lines { lines }, top { top }, next { next }, bottom { bottom }
+            grid { grid }, top { top }, next { next }, bottom { bottom }
         {
+            current.grid = &grid.get();
             Require(top <= next);
             Require(next <= bottom + 1);
             ++*this;
@@ -390,13 +431,12 @@ struct LogicalLines
                 return *this;
             }
 
-            // Require(!lines.get()[unbox<int>(next)].wrapped());
+            // Require(!grid.get().lineAt(next).wrapped());
 
             current.top = LineOffset::cast_from(next);
-            current.lines.clear();
             do
-                current.lines.emplace_back(lines.get()[unbox(next++)]);
-            while (next <= bottom && lines.get()[unbox(next)].wrapped());
+                ++next;
+            while (next <= bottom && grid.get().lineAt(next).wrapped());
 
             current.bottom = LineOffset::cast_from(next - 1);
 
@@ -415,16 +455,12 @@ struct LogicalLines
             auto const bottomMost = next - 1;
             do
                 --next;
-            while (lines.get()[unbox(next)].wrapped());
+            while (grid.get().lineAt(next).wrapped());
             auto const topMost = next;
 
             current.top = topMost;
             current.bottom = bottomMost;
 
-            current.lines.clear();
-            for (auto i = topMost; i <= bottomMost; ++i)
-                current.lines.emplace_back(lines.get()[unbox(i)]);
-
             return *this;
         }
 
@@ -445,10 +481,10 @@ struct LogicalLines
         bool operator!=(iterator const& other) const noexcept { return current != other.current; }
     }; // }}}
 
-    [[nodiscard]] iterator begin() const { return iterator(lines, topMostLine, topMostLine, bottomMostLine); }
+    [[nodiscard]] iterator begin() const { return iterator(grid, topMostLine, topMostLine, bottomMostLine); }
     [[nodiscard]] iterator end() const
     {
-        return iterator(lines, topMostLine, bottomMostLine + 1, bottomMostLine);
+        return iterator(grid, topMostLine, bottomMostLine + 1, bottomMostLine);
     }
 };
 
@@ -457,23 +493,24 @@ struct ReverseLogicalLines
 {
     LineOffset topMostLine;
     LineOffset bottomMostLine;
-    std::reference_wrapper<Lines<Cell>> lines;
+    std::reference_wrapper<Grid<Cell>> grid;
 
     // NOLINTNEXTLINE(readability-identifier-naming)
     struct iterator // {{{
     {
-        std::reference_wrapper<Lines<Cell>> lines;
+        std::reference_wrapper<Grid<Cell>> grid;
         LineOffset top;
         LineOffset next; // index to next logical line's beginning
         LineOffset bottom;
         LogicalLine<Cell> current;
 
-        iterator(std::reference_wrapper<Lines<Cell>> lines,
+        iterator(std::reference_wrapper<Grid<Cell>> grid,
                  LineOffset top,
                  LineOffset next,
                  LineOffset bottom):
-            lines { lines }, top { top }, next { next }, bottom { bottom }
+            grid { grid }, top { top }, next { next }, bottom { bottom }
         {
+            current.grid = &grid.get();
             Require(top - 1 <= next);
             Require(next <= bottom);
             ++*this;
@@ -490,13 +527,12 @@ struct ReverseLogicalLines
                 return *this;
             }
 
-            Require(!lines.get()[unbox(next)].wrapped());
+            Require(!grid.get().lineAt(next).wrapped());
 
             current.top = LineOffset::cast_from(next);
-            current.lines.clear();
             do
-                current.lines.emplace_back(lines.get()[unbox(next++)]);
-            while (next <= bottom && lines.get()[unbox(next)].wrapped());
+                ++next;
+            while (next <= bottom && grid.get().lineAt(next).wrapped());
 
             current.bottom = LineOffset::cast_from(next - 1);
 
@@ -513,7 +549,7 @@ struct ReverseLogicalLines
             }
 
             auto const bottomMost = next;
-            while (lines.get()[unbox(next)].wrapped())
+            while (grid.get().lineAt(next).wrapped())
                 --next;
             auto const topMost = next;
             --next; // jump to next logical line's bottom line above the current logical one
@@ -521,10 +557,6 @@ struct ReverseLogicalLines
             current.top = topMost;
             current.bottom = bottomMost;
 
-            current.lines.clear();
-            for (auto i = topMost; i <= bottomMost; ++i)
-                current.lines.emplace_back(lines.get()[unbox(i)]);
-
             return *this;
         }
 
@@ -547,11 +579,11 @@ struct ReverseLogicalLines
 
     [[nodiscard]] iterator begin() const
     {
-        return iterator(lines, topMostLine, bottomMostLine, bottomMostLine);
+        return iterator(grid, topMostLine, bottomMostLine, bottomMostLine);
     }
     [[nodiscard]] iterator end() const
     {
-        return iterator(lines, topMostLine, topMostLine - 1, bottomMostLine);
+        return iterator(grid, topMostLine, topMostLine - 1, bottomMostLine);
     }
 };
 
@@ -580,6 +612,16 @@ struct ReverseLogicalLines
  *       ^                          ^
  *       1                          pageSize.columns
  * </pre>
+ *
+ * <h3>History</h3>
+ *
+ * Only the most recent hotHistoryLimit() scrollback lines live in the same ring buffer as the main page.
+ * Older scrollback lines are frozen into a HistoryStore of compressed line blocks,
+ * that are decompressed on demand when accessed via lineAt().
+ * Frozen lines are not reflowed by resize() itself, but lazily: until reflowHistory() asks for them,
+ * they are cropped or padded to the page width when accessed, and then their blocks are reflowed
+ * from the most recent ones upwards only as far as needed (see HistoryStore::reflow()).
+ * With infinite history and a historySpillThreshold() set, the oldest frozen lines are spilled to disk.
  */
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
@@ -587,6 +629,9 @@ class Grid
 {
     // TODO: Rename all "History" to "Scrollback"?
   public:
+    /// Default number of history lines kept as live lines, see hotHistoryLimit().
+    static constexpr LineCount DefaultHotHistoryLimit = LineCount(1024);
+
     Grid(PageSize pageSize, bool reflowOnResize, MaxHistoryLineCount maxHistoryLineCount);
 
     Grid(): Grid(PageSize { LineCount(25), ColumnCount(80) }, false, LineCount(0)) {}
@@ -599,21 +644,74 @@ class Grid
         if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
             return *maxLineCount;
         else
-            return LineCount::cast_from(_lines.size()) - _pageSize.lines;
+            return hotHistoryCapacity() + _frozenHistory.size();
     }
 
     void setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount);
 
+    /// Maximum number of history lines that are kept as live lines right above the main page.
+    ///
+    /// Any history lines beyond that are frozen into compressed blocks.
+    [[nodiscard]] LineCount hotHistoryLimit() const noexcept { return _hotHistoryLimit; }
+
+    /// Sets the maximum number of live history lines, to be set before the history is being filled.
+    void setHotHistoryLimit(LineCount limit);
+
     [[nodiscard]] LineCount totalLineCount() const noexcept
     {
-        return maxHistoryLineCount() + _pageSize.lines;
+        return hotHistoryCapacity() + _pageSize.lines;
     }
 
-    [[nodiscard]] LineCount historyLineCount() const noexcept { return _linesUsed - _pageSize.lines; }
+    [[nodiscard]] LineCount historyLineCount() const noexcept
+    {
+        return hotHistoryLineCount() + _frozenHistory.size();
+    }
+
+    /// Number of history lines that are kept as live lines.
+    [[nodiscard]] LineCount hotHistoryLineCount() const noexcept { return _linesUsed - _pageSize.lines; }
+
+    /// Number of history lines that have been frozen into compressed blocks.
+    [[nodiscard]] LineCount frozenHistoryLineCount() const noexcept { return _frozenHistory.size(); }
+
+    [[nodiscard]] HistoryStore<Cell> const& frozenHistory() const noexcept { return _frozenHistory; }
+    [[nodiscard]] HistoryStore<Cell>& frozenHistory() noexcept { return _frozenHistory; }
+
+    /// Number of most recent history lines kept in memory with infinite history,
+    /// or std::nullopt if all history lines are kept in memory.
+    [[nodiscard]] std::optional<LineCount> historySpillThreshold() const noexcept
+    {
+        return _historySpillThreshold;
+    }
+
+    /// Sets the number of most recent history lines to keep in memory with infinite history.
+    ///
+    /// The compressed blocks of any older frozen history lines are spilled to a temporary file.
+    void setHistorySpillThreshold(std::optional<LineCount> threshold);
 
     [[nodiscard]] bool reflowOnResize() const noexcept { return _reflowOnResize; }
     void setReflowOnResize(bool enabled) { _reflowOnResize = enabled; }
 
+    /// Number of the oldest live history lines that are not reflowed to the page width yet.
+    ///
+    /// @see resize(), reflowHistory()
+    [[nodiscard]] LineCount unreflowedHistoryLineCount() const noexcept;
+
+    /// Offset of the top most history line down from which all lines are reflowed to the page width.
+    ///
+    /// @see reflowHistory()
+    [[nodiscard]] LineOffset reflowedHistoryTop() const noexcept;
+
+    /// Reflows the history lines at or below @p top that have been left unreflowed by resize().
+    ///
+    /// Logical lines are reflowed from the bottom up until all lines from @p top down to the main page
+    /// are reflowed. Offsets of the lines below the reflowed ones do not change.
+    /// A @p top above the top most live history line reflows all of them, and frozen history lines
+    /// as far as needed.
+    void reflowHistory(LineOffset top);
+
+    /// Reflows all history lines that have been left unreflowed by resize().
+    void reflowHistory() { reflowHistory(-boxed_cast<LineOffset>(historyLineCount()) - 1); }
+
     [[nodiscard]] PageSize pageSize() const noexcept { return _pageSize; }
 
     /// Resizes the main page area of the grid and adapts the scrollback area's width accordingly.
@@ -622,20 +720,30 @@ class Grid
     /// @param currentCursorPos  current cursor position
     /// @param wrapPending       AutoWrap is on and a wrap is pending
     ///
+    /// With text reflow enabled, only the main page and the history lines of up to one page above it
+    /// are reflowed right away. Older history lines keep the width they were laid out with, padded to
+    /// the page width if narrower, until they are asked for via reflowHistory(). Thus they are reflowed
+    /// at most once, no matter how often the grid is resized in the meantime.
+    /// Frozen history lines are cropped or padded when accessed, until reflowHistory() reflows them.
+    ///
     /// @returns updated cursor position.
     [[nodiscard]] CellLocation resize(PageSize newSize, CellLocation currentCursorPos, bool wrapPending);
     // }}}
 
     // {{{ Line API
     /// @returns reference to Line at given relative offset @p line.
-    [[nodiscard]] Line<Cell>& lineAt(LineOffset line) noexcept;
-    [[nodiscard]] Line<Cell> const& lineAt(LineOffset line) const noexcept;
+    ///
+    /// Accessing a frozen history line may decompress its block, which allocates.
+    /// A reference to a frozen history line is only valid until other frozen history lines are accessed,
+    /// see HistoryStore::at().
+    [[nodiscard]] Line<Cell>& lineAt(LineOffset line);
+    [[nodiscard]] Line<Cell> const& lineAt(LineOffset line) const;
 
-    [[nodiscard]] gsl::span<Cell const> lineBuffer(LineOffset line) const noexcept
+    [[nodiscard]] gsl::span<Cell const> lineBuffer(LineOffset line) const
     {
         return lineAt(line).cells();
     }
-    [[nodiscard]] gsl::span<Cell const> lineBufferRightTrimmed(LineOffset line) const noexcept;
+    [[nodiscard]] gsl::span<Cell const> lineBufferRightTrimmed(LineOffset line) const;
 
     [[nodiscard]] std::string lineText(LineOffset line) const;
     [[nodiscard]] std::string lineTextTrimmed(LineOffset line) const;
@@ -646,19 +754,19 @@ class Grid
     // void resetLine(LineOffset line, GraphicsAttributes attribs) noexcept
     // { lineAt(line).reset(attribs); }
 
-    [[nodiscard]] ColumnCount lineLength(LineOffset line) const noexcept { return lineAt(line).size(); }
-    [[nodiscard]] bool isLineBlank(LineOffset line) const noexcept;
-    [[nodiscard]] bool isLineWrapped(LineOffset line) const noexcept;
+    [[nodiscard]] ColumnCount lineLength(LineOffset line) const { return lineAt(line).size(); }
+    [[nodiscard]] bool isLineBlank(LineOffset line) const;
+    [[nodiscard]] bool isLineWrapped(LineOffset line) const;
 
-    [[nodiscard]] int computeLogicalLineNumberFromBottom(LineCount n) const noexcept;
+    [[nodiscard]] int computeLogicalLineNumberFromBottom(LineCount n) const;
 
     [[nodiscard]] size_t zero_index() const noexcept { return _lines.zero_index(); }
     // }}}
 
     /// Gets a reference to the cell relative to screen origin (top left, 0:0).
-    [[nodiscard]] Cell& useCellAt(LineOffset line, ColumnOffset column) noexcept;
-    [[nodiscard]] Cell& at(LineOffset line, ColumnOffset column) noexcept;
-    [[nodiscard]] Cell const& at(LineOffset line, ColumnOffset column) const noexcept;
+    [[nodiscard]] Cell& useCellAt(LineOffset line, ColumnOffset column);
+    [[nodiscard]] Cell& at(LineOffset line, ColumnOffset column);
+    [[nodiscard]] Cell const& at(LineOffset line, ColumnOffset column) const;
 
     // page view API
     [[nodiscard]] gsl::span<Line<Cell>> pageAtScrollOffset(ScrollOffset scrollOffset);
@@ -670,26 +778,46 @@ class Grid
     {
         return LogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()),
                                     boxed_cast<LineOffset>(_pageSize.lines - 1),
-                                    _lines };
+                                    *this };
     }
 
     [[nodiscard]] LogicalLines<Cell> logicalLinesFrom(LineOffset offset)
     {
-        return LogicalLines<Cell> { offset, boxed_cast<LineOffset>(_pageSize.lines - 1), _lines };
+        return LogicalLines<Cell> { offset, boxed_cast<LineOffset>(_pageSize.lines - 1), *this };
     }
 
     [[nodiscard]] ReverseLogicalLines<Cell> logicalLinesReverse()
     {
         return ReverseLogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()),
                                            boxed_cast<LineOffset>(_pageSize.lines - 1),
-                                           _lines };
+                                           *this };
     }
 
     [[nodiscard]] ReverseLogicalLines<Cell> logicalLinesReverseFrom(LineOffset offset)
     {
-        return ReverseLogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()), offset, _lines };
+        return ReverseLogicalLines<Cell> { boxed_cast<LineOffset>(-historyLineCount()), offset, *this };
     }
 
+    /// Returns the top most line of the logical line that contains @p line.
+    [[nodiscard]] LineOffset logicalLineTop(LineOffset line) const;
+
+    /// Returns the bottom most line of the logical line that contains @p line.
+    [[nodiscard]] LineOffset logicalLineBottom(LineOffset line) const;
+
+    /// Returns the first line at or below @p line that is not part of a frozen history block
+    /// which cannot contain a search term with the given trigram hashes.
+    ///
+    /// @see TrigramFilter::hashes()
+    [[nodiscard]] LineOffset skipUnmatchableHistory(LineOffset line,
+                                                    gsl::span<uint16_t const> trigramHashes) const noexcept;
+
+    /// Returns the first line at or above @p line that is not part of a frozen history block
+    /// which cannot contain a search term with the given trigram hashes.
+    ///
+    /// The returned line is above the top most history line if there is nothing left to search.
+    [[nodiscard]] LineOffset skipUnmatchableHistoryReverse(
+        LineOffset line, gsl::span<uint16_t const> trigramHashes) const noexcept;
+
     // {{{ buffer manipulation
 
     /// Completely deletes all scrollback lines.
@@ -702,10 +830,10 @@ class Grid
     /// @param margin the margin coordinates to perform the scrolling action into.
     ///
     /// @return Number of lines the main page has been scrolled.
-    LineCount scrollUp(LineCount n, GraphicsAttributes defaultAttributes, Margin margin) noexcept;
+    LineCount scrollUp(LineCount n, GraphicsAttributes defaultAttributes, Margin margin);
 
     /// Scrolls up main page by @p n lines and re-initializes grid cells with @p defaultAttributes.
-    LineCount scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes = {}) noexcept;
+    LineCount scrollUp(LineCount linesCountToScrollUp, GraphicsAttributes defaultAttributes = {});
 
     /// Scrolls down by @p n lines within the given margin.
     ///
@@ -720,12 +848,27 @@ class Grid
 
     // {{{ Rendering API
     /// Renders the full screen by passing every grid cell to the callback.
+    ///
+    /// If the renderer provides reuseLine(), each line is first offered to it along with
+    /// its revision, and only rendered if the renderer could not reuse a previous rendering of it.
+    /// If the renderer provides renderSpanLine(), span lines are passed to it as a whole,
+    /// rather than cell by cell.
     template <typename RendererT>
     [[nodiscard]] RenderPassHints render(
         RendererT&& render,
         ScrollOffset scrollOffset = {},
         HighlightSearchMatches highlightSearchMatches = HighlightSearchMatches::Yes) const;
 
+    /// Renders a single line at the given screen line offset.
+    ///
+    /// @see render()
+    template <typename RendererT>
+    static void renderLine(RendererT& render,
+                           Line<Cell> const& line,
+                           LineOffset y,
+                           HighlightSearchMatches highlightSearchMatches,
+                           RenderPassHints& hints);
+
     /// Takes text-screenshot of the main page.
     [[nodiscard]] std::string renderMainPageText() const;
 
@@ -743,17 +886,17 @@ class Grid
 
     // Retrieves the cell location range of the underlying word at the given cursor position.
     [[nodiscard]] CellLocationRange wordRangeUnderCursor(CellLocation position,
-                                                         std::u32string_view delimiters) const noexcept;
+                                                         std::u32string_view delimiters) const;
 
     [[nodiscard]] bool cellEmptyOrContainsOneOf(CellLocation position,
-                                                std::u32string_view delimiters) const noexcept;
+                                                std::u32string_view delimiters) const;
 
     // Lineary extracts the text of a given grid cell range.
-    [[nodiscard]] std::u32string extractText(CellLocationRange range) const noexcept;
+    [[nodiscard]] std::u32string extractText(CellLocationRange range) const;
 
     // Conditionally extends the cell location forward if the grid cell at the given location holds a wide
     // character.
-    [[nodiscard]] CellLocation stretchedColumn(CellLocation coord) const noexcept
+    [[nodiscard]] CellLocation stretchedColumn(CellLocation coord) const
     {
         CellLocation stretched = coord;
         if (auto const w = cellWidthAt(coord); w > 1) // wide character
@@ -765,7 +908,7 @@ class Grid
         return stretched;
     }
 
-    [[nodiscard]] CellLocation rightMostNonEmptyAt(LineOffset lineOffset) const noexcept
+    [[nodiscard]] CellLocation rightMostNonEmptyAt(LineOffset lineOffset) const
     {
         auto const& line = lineAt(lineOffset);
 
@@ -779,6 +922,25 @@ class Grid
             return CellLocation { lineOffset, columnOffset };
         }
 
+        if (line.isPackedBuffer())
+        {
+            if (line.empty())
+                return CellLocation { lineOffset, ColumnOffset(0) };
+
+            auto columnOffset = ColumnOffset::cast_from(line.packedBuffer().usedColumns - 1);
+            while (columnOffset > ColumnOffset(0) && line.cellEmptyAt(columnOffset))
+                --columnOffset;
+            return CellLocation { lineOffset, columnOffset };
+        }
+
+        if (line.isSpanBuffer())
+        {
+            auto columnOffset = ColumnOffset::cast_from(line.size() - 1);
+            while (columnOffset > ColumnOffset(0) && line.cellEmptyAt(columnOffset))
+                --columnOffset;
+            return CellLocation { lineOffset, columnOffset };
+        }
+
         auto const& inflatedLine = line.cells();
         auto columnOffset = ColumnOffset::cast_from(_pageSize.columns - 1);
         while (columnOffset > ColumnOffset(0) && inflatedLine[unbox<size_t>(columnOffset)].empty())
@@ -786,20 +948,48 @@ class Grid
         return CellLocation { lineOffset, columnOffset };
     }
 
-    [[nodiscard]] uint8_t cellWidthAt(CellLocation position) const noexcept
+    [[nodiscard]] uint8_t cellWidthAt(CellLocation position) const
     {
         return lineAt(position.line).cellWidthAt(position.column);
     }
 
   private:
+    /// Returns the frozen history line at @p line, or nullptr if @p line is not part of the frozen history.
+    [[nodiscard]] Line<Cell>* frozenLineAt(LineOffset line) const;
+
     CellLocation growLines(LineCount newHeight, CellLocation cursor);
     void appendNewLines(LineCount count, GraphicsAttributes attr);
+    void packHistoryLines(LineCount count) noexcept;
+    void freezeOldestHistoryLines(LineCount count);
+    void updateHistorySpill();
     void clampHistory();
+    LineOffset deferHistoryReflow(LineCount margin);
+    void discardUnreflowedHistory(LineCount count) noexcept;
+    void reflowHotHistory(LineOffset top);
+    Lines<Cell> reflowLogicalLine(LineOffset top, LineOffset bottom, ColumnCount layoutWidth);
+
+    // Number of history lines the ring buffer of live lines holds at most.
+    [[nodiscard]] LineCount hotHistoryCapacity() const noexcept
+    {
+        if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
+            return std::min(*maxLineCount, _hotHistoryLimit);
+        else
+            return LineCount::cast_from(_lines.size()) - _pageSize.lines;
+    }
+
+    // Tests if history lines beyond the hot history capacity are frozen rather than discarded.
+    [[nodiscard]] bool freezesHistory() const noexcept
+    {
+        if (auto const* maxLineCount = std::get_if<LineCount>(&_historyLimit))
+            return *maxLineCount > _hotHistoryLimit;
+        else
+            return true;
+    }
 
     // {{{ buffer helpers
     void resizeBuffers(PageSize newSize)
     {
-        auto const newTotalLineCount = historyLineCount() + newSize.lines;
+        auto const newTotalLineCount = hotHistoryLineCount() + newSize.lines;
         _lines.resize(unbox<size_t>(newTotalLineCount));
         _pageSize = newSize;
     }
@@ -826,6 +1016,27 @@ class Grid
 
     // Number of lines used in the Lines buffer.
     LineCount _linesUsed;
+
+    // History lines that scrolled out of the Lines buffer, oldest first.
+    //
+    // Mutable, because reading a frozen line decompresses its block into the store's cache of
+    // thawed blocks. That leaves the history's contents untouched, but may invalidate references
+    // to frozen lines handed out before. Reading lines thus needs the same exclusive access to the grid
+    // as modifying it, which the terminal lock provides.
+    mutable HistoryStore<Cell> _frozenHistory;
+    LineCount _hotHistoryLimit = DefaultHotHistoryLimit;
+    std::optional<LineCount> _historySpillThreshold;
+
+    // A run of the oldest live history lines that are not reflowed to the page width yet,
+    // along with the width they were laid out with.
+    struct UnreflowedLines
+    {
+        LineCount count;
+        ColumnCount columns;
+    };
+
+    // Runs of unreflowed history lines, oldest first. See resize().
+    std::vector<UnreflowedLines> _unreflowedHistory;
 };
 
 template <typename Cell>
@@ -851,7 +1062,7 @@ constexpr LineCount Grid<Cell>::linesUsed() const noexcept
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-bool Grid<Cell>::isLineWrapped(LineOffset line) const noexcept
+bool Grid<Cell>::isLineWrapped(LineOffset line) const
 {
     return line >= -boxed_cast<LineOffset>(historyLineCount())
            && boxed_cast<LineCount>(line) < _pageSize.lines && lineAt(line).wrapped();
@@ -870,34 +1081,61 @@ template <typename RendererT>
     auto y = LineOffset(0);
     auto hints = RenderPassHints {};
     for (int i = -*scrollOffset, e = i + *_pageSize.lines; i != e; ++i, ++y)
+        renderLine(render, lineAt(LineOffset(i)), y, highlightSearchMatches, hints);
+    render.finish();
+    return hints;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+template <typename RendererT>
+void Grid<Cell>::renderLine(RendererT& render,
+                            Line<Cell> const& line,
+                            LineOffset y,
+                            HighlightSearchMatches highlightSearchMatches,
+                            RenderPassHints& hints)
+{
+    if constexpr (requires { render.reuseLine(line, y, hints); })
     {
-        auto x = ColumnOffset(0);
-        Line<Cell> const& line = _lines[i];
-        // NB: trivial liner rendering only works trivially if we don't do cell-based operations
-        // on the text. Therefore, we only move to the trivial fast path here if we don't want to
-        // highlight search matches.
-        if (line.isTrivialBuffer() && highlightSearchMatches == HighlightSearchMatches::No)
-        {
-            auto const cellFlags = line.trivialBuffer().textAttributes.flags;
-            hints.containsBlinkingCells = hints.containsBlinkingCells || (cellFlags & CellFlag::Blinking)
-                                          || (cellFlags & CellFlag::RapidBlinking);
-            render.renderTrivialLine(line.trivialBuffer(), y);
-        }
-        else
+        line.updateRevision();
+        if (render.reuseLine(line, y, hints))
+            return;
+    }
+
+    if constexpr (requires { render.renderSpanLine(line.spanBuffer(), y); })
+    {
+        if (line.isSpanBuffer())
         {
-            render.startLine(y);
-            for (Cell const& cell: line.cells())
-            {
+            for (auto const& span: line.spanBuffer().spans)
                 hints.containsBlinkingCells = hints.containsBlinkingCells
-                                              || (cell.flags() & CellFlag::Blinking)
-                                              || (cell.flags() & CellFlag::RapidBlinking);
-                render.renderCell(cell, y, x++);
-            }
-            render.endLine();
+                                              || (span.attributes.flags & CellFlag::Blinking)
+                                              || (span.attributes.flags & CellFlag::RapidBlinking);
+            render.renderSpanLine(line.spanBuffer(), y);
+            return;
         }
     }
-    render.finish();
-    return hints;
+
+    // NB: trivial liner rendering only works trivially if we don't do cell-based operations
+    // on the text. Therefore, we only move to the trivial fast path here if we don't want to
+    // highlight search matches.
+    if (line.isTrivialBuffer() && highlightSearchMatches == HighlightSearchMatches::No)
+    {
+        auto const cellFlags = line.trivialBuffer().textAttributes.flags;
+        hints.containsBlinkingCells = hints.containsBlinkingCells || (cellFlags & CellFlag::Blinking)
+                                      || (cellFlags & CellFlag::RapidBlinking);
+        render.renderTrivialLine(line.trivialBuffer(), y);
+    }
+    else
+    {
+        auto x = ColumnOffset(0);
+        render.startLine(y);
+        line.visitCells([&](Cell const& cell) {
+            hints.containsBlinkingCells = hints.containsBlinkingCells || (cell.flags() & CellFlag::Blinking)
+                                          || (cell.flags() & CellFlag::RapidBlinking);
+            render.renderCell(cell, y, x++);
+        });
+        render.endLine();
+    }
 }
 // }}}
 
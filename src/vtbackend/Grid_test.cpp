@@ -1,5 +1,6 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/Grid.h>
+#include <vtbackend/TrigramFilter.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/primitives.h>
 
@@ -9,6 +10,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <chrono>
+#include <thread>
+
 using namespace vtbackend;
 using namespace std::string_literals;
 using namespace std::string_view_literals;
@@ -838,6 +842,77 @@ TEST_CASE("Grid.reflow.tripple", "[grid]")
     }
 }
 
+TEST_CASE("Grid.reflow.lazyHistory", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, true, LineCount(20));
+    grid.setLineText(LineOffset(0), "0000");
+    for (int i = 1; i < 10; ++i)
+    {
+        grid.setLineText(LineOffset(1), fmt::format("{:04}", i));
+        grid.scrollUp(LineCount(1));
+    }
+    REQUIRE(grid.historyLineCount() == LineCount(9));
+
+    // Only the last four logical lines, covering the page and one page above it, are reflowed right away.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    logGridText(grid, "after resize 2x2");
+    REQUIRE(grid.unreflowedHistoryLineCount() == LineCount(7));
+    REQUIRE(grid.historyLineCount() == LineCount(12));
+    CHECK(grid.lineText(LineOffset(-12)) == "0000");
+    CHECK(grid.lineText(LineOffset(-6)) == "0006");
+    CHECK(grid.lineText(LineOffset(-5)) == "00");
+    CHECK(grid.lineText(LineOffset(-4)) == "07");
+    CHECK(grid.lineText(LineOffset(-1)) == "00");
+    CHECK(grid.lineText(LineOffset(0)) == "09");
+
+    SECTION("on demand")
+    {
+        grid.reflowHistory(LineOffset(-7));
+        CHECK(grid.unreflowedHistoryLineCount() == LineCount(6));
+        CHECK(grid.historyLineCount() == LineCount(13));
+        CHECK(grid.lineText(LineOffset(-8)) == "0005");
+        CHECK(grid.lineText(LineOffset(-7)) == "00");
+        CHECK(grid.lineText(LineOffset(-6)) == "06");
+        CHECK(grid.lineAt(LineOffset(-6)).wrapped());
+        CHECK(grid.lineText(LineOffset(-5)) == "00");
+
+        grid.reflowHistory();
+        CHECK(grid.unreflowedHistoryLineCount() == LineCount(0));
+        CHECK(grid.historyLineCount() == LineCount(19));
+        CHECK(grid.lineText(LineOffset(-19)) == "00");
+        CHECK(grid.lineText(LineOffset(-18)) == "00");
+        CHECK(grid.lineAt(LineOffset(-18)).wrapped());
+        CHECK(grid.lineText(LineOffset(0)) == "09");
+    }
+
+    SECTION("repeated resize")
+    {
+        // Unreflowed lines keep their layout, padded to the page width.
+        (void) grid.resize(PageSize { LineCount(2), ColumnCount(6) }, CellLocation {}, false);
+        logGridText(grid, "after resize 6x2");
+        CHECK(grid.unreflowedHistoryLineCount() == LineCount(7));
+        CHECK(grid.historyLineCount() == LineCount(9));
+        CHECK(grid.lineText(LineOffset(-9)) == "0000  ");
+        CHECK(grid.lineText(LineOffset(-2)) == "0007  ");
+        CHECK(grid.lineText(LineOffset(0)) == "0009  ");
+
+        grid.reflowHistory();
+        CHECK(grid.unreflowedHistoryLineCount() == LineCount(0));
+        CHECK(grid.historyLineCount() == LineCount(9));
+        CHECK(grid.lineText(LineOffset(-9)) == "0000  ");
+        CHECK(!grid.lineAt(LineOffset(-8)).wrapped());
+    }
+
+    SECTION("scrolled out")
+    {
+        // Reaching the history limit discards the oldest lines, unreflowed or not.
+        grid.scrollUp(LineCount(13));
+        CHECK(grid.historyLineCount() == LineCount(20));
+        CHECK(grid.unreflowedHistoryLineCount() == LineCount(2));
+        CHECK(grid.lineText(-boxed_cast<LineOffset>(grid.historyLineCount())) == "0005");
+    }
+}
+
 TEST_CASE("Grid infinite", "[grid]")
 {
     auto gridFinite = Grid<Cell>(PageSize { LineCount(2), ColumnCount(8) }, true, LineCount(0));
@@ -858,6 +933,233 @@ TEST_CASE("Grid infinite", "[grid]")
     REQUIRE(gridInfinite.lineText(LineOffset(-98)) == "ABCDEFGH");
 }
 
+namespace
+{
+// Writes the numbered lines 0..count-1, each scrolling into the history.
+void writeNumberedLines(Grid<Cell>& grid, int count)
+{
+    auto const bottom = boxed_cast<LineOffset>(grid.pageSize().lines) - 1;
+    for (int i = 0; i < count; ++i)
+    {
+        grid.setLineText(bottom, fmt::format("{:04}", i));
+        grid.scrollUp(LineCount(1));
+    }
+}
+} // namespace
+
+TEST_CASE("Grid.frozenHistory", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, LineCount(2000));
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, 1000);
+
+    CHECK(grid.historyLineCount() == LineCount(1000));
+    CHECK(grid.hotHistoryLineCount() == LineCount(4));
+    CHECK(grid.frozenHistoryLineCount() == LineCount(996));
+    CHECK(grid.frozenHistory().compressedSize() > 0);
+
+    // Line i is now at offset i - 999, across the frozen and the hot history lines.
+    for (int i = 0; i < 1000; ++i)
+        REQUIRE(grid.lineTextTrimmed(LineOffset(i - 999)) == fmt::format("{:04}", i));
+    CHECK(grid.lineTextTrimmed(LineOffset(-1000)).empty());
+    CHECK(grid.frozenHistory().thawedBlockCount() <= HistoryStore<Cell>::MaxThawedBlockCount);
+
+    auto logicalLineCount = 0;
+    for ([[maybe_unused]] auto const& logicalLine: grid.logicalLines())
+        ++logicalLineCount;
+    CHECK(logicalLineCount == 1002);
+
+    // Frozen lines keep their width, and are only viewed as cropped to the page width after a resize.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(3) }, CellLocation {}, false);
+    auto const compressedSize = grid.frozenHistory().compressedSize();
+    CHECK(grid.lineAt(LineOffset(-900)).size() == ColumnCount(3));
+    CHECK(grid.lineTextTrimmed(LineOffset(-900)) == "009");
+    for (int i = 0; i < 1000; ++i)
+        REQUIRE(grid.lineTextTrimmed(LineOffset(i - 999)) == fmt::format("{:04}", i).substr(0, 3));
+    CHECK(grid.frozenHistory().compressedSize() == compressedSize);
+
+    // Modifying a cropped line keeps the columns that have been cropped off.
+    grid.lineAt(LineOffset(-900)).useCellAt(ColumnOffset(0)).write(GraphicsAttributes {}, U'X', 1);
+    grid.lineAt(LineOffset(-900)).setMarked(true);
+    for (int i = 0; i < 1000; ++i)
+        (void) grid.lineAt(LineOffset(i - 999));
+
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(10) }, CellLocation {}, false);
+    CHECK(grid.lineAt(LineOffset(-900)).size() == ColumnCount(10));
+    CHECK(grid.lineTextTrimmed(LineOffset(-900)) == "X099");
+    CHECK(grid.lineAt(LineOffset(-900)).marked());
+    CHECK(grid.lineTextTrimmed(LineOffset(-899)) == "0100");
+
+    grid.clearHistory();
+    CHECK(grid.historyLineCount() == LineCount(0));
+    CHECK(grid.frozenHistoryLineCount() == LineCount(0));
+}
+
+TEST_CASE("Grid.frozenHistory.reflow", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(4) }, true, Infinite());
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, 1000);
+    REQUIRE(grid.frozenHistoryLineCount() == LineCount(996));
+    auto const compressedSize = grid.frozenHistory().compressedSize();
+
+    // Frozen lines are left as they are by resizing, and reflowed in whole blocks only as far as asked for.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(2) }, CellLocation {}, false);
+    grid.reflowHistory(grid.reflowedHistoryTop() - 10);
+    CHECK(grid.reflowedHistoryTop() <= -boxed_cast<LineOffset>(grid.hotHistoryLineCount()) - 10);
+    CHECK(grid.reflowedHistoryTop() > -boxed_cast<LineOffset>(grid.historyLineCount()));
+    CHECK(grid.lineTextTrimmed(-boxed_cast<LineOffset>(grid.historyLineCount())).empty());
+
+    grid.reflowHistory();
+    CHECK(grid.reflowedHistoryTop() == -boxed_cast<LineOffset>(grid.historyLineCount()));
+    CHECK(grid.historyLineCount() == LineCount(2000));
+    auto logicalLineCount = 0;
+    for (auto const& logicalLine: grid.logicalLines())
+    {
+        if (logicalLineCount == 0)
+            REQUIRE(logicalLine.text() == "  ");
+        else if (logicalLineCount <= 1000)
+            REQUIRE(logicalLine.text() == fmt::format("{:04}", logicalLineCount - 1));
+        ++logicalLineCount;
+    }
+    CHECK(logicalLineCount == 1002);
+
+    // Growing back lays the frozen lines out as they were.
+    (void) grid.resize(PageSize { LineCount(2), ColumnCount(4) }, CellLocation {}, false);
+    grid.reflowHistory();
+    CHECK(grid.historyLineCount() == LineCount(1000));
+    for (int i = 0; i < 1000; ++i)
+        REQUIRE(grid.lineTextTrimmed(LineOffset(i - 999)) == fmt::format("{:04}", i));
+    CHECK(grid.frozenHistory().compressedSize() <= compressedSize * 2);
+}
+
+TEST_CASE("Grid.frozenHistory.limit", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, LineCount(300));
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, 1000);
+
+    CHECK(grid.historyLineCount() == LineCount(300));
+    CHECK(grid.frozenHistoryLineCount() == LineCount(296));
+    CHECK(grid.lineTextTrimmed(LineOffset(-300)) == "0699");
+    CHECK(grid.lineTextTrimmed(LineOffset(-1)) == "0998");
+
+    grid.setMaxHistoryLineCount(LineCount(100));
+    CHECK(grid.historyLineCount() == LineCount(100));
+    CHECK(grid.lineTextTrimmed(LineOffset(-100)) == "0899");
+}
+
+TEST_CASE("Grid.frozenHistory.infinite", "[grid]")
+{
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, Infinite());
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, 600);
+
+    CHECK(grid.historyLineCount() == LineCount(600));
+    CHECK(grid.frozenHistoryLineCount() == LineCount(596));
+    CHECK(grid.lineTextTrimmed(LineOffset(-599)) == "0000");
+    CHECK(grid.lineTextTrimmed(LineOffset(0)) == "0599");
+}
+
+TEST_CASE("Grid.frozenHistory.spill", "[grid]")
+{
+    auto constexpr BlockLineCount = static_cast<int>(HistoryStore<Cell>::BlockLineCount);
+    auto constexpr TotalLineCount = BlockLineCount * 4 + 4;
+
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, Infinite());
+    grid.setHotHistoryLimit(LineCount(4));
+    grid.setHistorySpillThreshold(LineCount(4 + BlockLineCount));
+
+    auto const waitForSpilledBlocks = [&](size_t count) {
+        for (int i = 0; i < 500 && grid.frozenHistory().spilledBlockCount() < count; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            grid.frozenHistory().collectSpilledBlocks();
+        }
+        return grid.frozenHistory().spilledBlockCount();
+    };
+
+    writeNumberedLines(grid, TotalLineCount);
+    REQUIRE(grid.frozenHistoryLineCount() == LineCount(BlockLineCount * 4));
+
+    // All but the most recent block are older than the threshold.
+    REQUIRE(waitForSpilledBlocks(3) == 3);
+    auto reference = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, Infinite());
+    reference.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(reference, TotalLineCount);
+    CHECK(grid.frozenHistory().compressedSize() * 3 < reference.frozenHistory().compressedSize());
+
+    for (int i = 0; i < TotalLineCount; i += 37)
+        REQUIRE(grid.lineTextTrimmed(LineOffset(i - TotalLineCount + 1)) == fmt::format("{:04}", i));
+
+    // The spill file is reset along with the history.
+    grid.clearHistory();
+    CHECK(grid.frozenHistory().spilledBlockCount() == 0);
+    writeNumberedLines(grid, TotalLineCount);
+    REQUIRE(waitForSpilledBlocks(3) == 3);
+    CHECK(grid.lineTextTrimmed(LineOffset(1 - TotalLineCount)) == "0000");
+}
+
+TEST_CASE("Grid.frozenHistory.searchIndex", "[grid]")
+{
+    auto constexpr BlockLineCount = static_cast<int>(HistoryStore<Cell>::BlockLineCount);
+    auto constexpr TotalLineCount = BlockLineCount * 4 + 4;
+
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, Infinite());
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, TotalLineCount);
+    REQUIRE(grid.frozenHistoryLineCount() == LineCount(BlockLineCount * 4));
+
+    auto const top = -boxed_cast<LineOffset>(grid.historyLineCount());
+    auto const blockTop = [&](int block) {
+        return top + LineOffset(block * BlockLineCount);
+    };
+
+    // The most recent block is never skipped, as the next line may still continue its last line.
+    auto const absent = TrigramFilter::hashes(U"XYZ");
+    CHECK(grid.skipUnmatchableHistory(top, absent) == blockTop(3));
+    CHECK(grid.skipUnmatchableHistoryReverse(blockTop(3) - 1, absent) == top - 1);
+
+    auto const present = TrigramFilter::hashes(U"0513");
+    CHECK(grid.skipUnmatchableHistory(blockTop(1), present) == blockTop(2));
+    CHECK(grid.skipUnmatchableHistoryReverse(blockTop(2) - 1, present) < blockTop(1));
+
+    // Search terms shorter than a trigram cannot skip anything.
+    CHECK(grid.skipUnmatchableHistory(top, TrigramFilter::hashes(U"XY")) == top);
+
+    // Reading lines does not affect the index, but modifying them does.
+    CHECK(grid.lineTextTrimmed(blockTop(0)).empty());
+    CHECK(grid.skipUnmatchableHistory(top, absent) == blockTop(3));
+    grid.setLineText(blockTop(0), "XYZ");
+    CHECK(grid.skipUnmatchableHistory(top, absent) == top);
+}
+
+TEST_CASE("Grid.frozenHistory.modified", "[grid]")
+{
+    auto constexpr BlockLineCount = static_cast<int>(HistoryStore<Cell>::BlockLineCount);
+    auto constexpr TotalLineCount =
+        BlockLineCount * static_cast<int>(HistoryStore<Cell>::MaxThawedBlockCount + 2);
+
+    auto grid = Grid<Cell>(PageSize { LineCount(2), ColumnCount(10) }, false, Infinite());
+    grid.setHotHistoryLimit(LineCount(4));
+    writeNumberedLines(grid, TotalLineCount);
+
+    auto const offsetOf = [&](int i) {
+        return LineOffset(i - TotalLineCount + 1);
+    };
+    grid.setLineText(offsetOf(10), "modified");
+    grid.lineAt(offsetOf(11)).setMarked(true);
+
+    // Access all other blocks, such that the modified block gets evicted.
+    for (int i = BlockLineCount; i < TotalLineCount - BlockLineCount; i += BlockLineCount)
+        REQUIRE(grid.lineTextTrimmed(offsetOf(i)) == fmt::format("{:04}", i));
+    CHECK(grid.frozenHistory().thawedBlockCount() == HistoryStore<Cell>::MaxThawedBlockCount);
+
+    CHECK(grid.lineTextTrimmed(offsetOf(10)) == "modified");
+    CHECK(grid.lineAt(offsetOf(11)).marked());
+    CHECK(grid.lineTextTrimmed(offsetOf(12)) == "0012");
+}
+
 TEST_CASE("Grid resize with wrap", "[grid]")
 {
     auto grid = Grid<Cell>(PageSize { LineCount(3), ColumnCount(5) }, true, LineCount(0));
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistorySpillFile.h>
+#include <vtbackend/logging.h>
+
+#include <crispy/logstore.h>
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if !defined(_WIN32)
+    #include <sys/mman.h>
+
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+namespace vtbackend
+{
+
+#if !defined(_WIN32)
+
+namespace
+{
+    bool writeFully(int fd, uint8_t const* data, size_t size, size_t offset) noexcept
+    {
+        while (size)
+        {
+            auto const written = pwrite(fd, data, size, static_cast<off_t>(offset));
+            if (written < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            data += written;
+            size -= static_cast<size_t>(written);
+            offset += static_cast<size_t>(written);
+        }
+        return true;
+    }
+} // namespace
+
+std::unique_ptr<HistorySpillFile> HistorySpillFile::create()
+{
+    auto const* tempDirectory = std::getenv("TMPDIR");
+    auto path = std::string(tempDirectory && *tempDirectory ? tempDirectory : "/tmp");
+    path += "/contour-history-XXXXXX";
+
+    auto const fd = mkstemp(path.data());
+    if (fd < 0)
+    {
+        errorLog()("Failed to create history spill file {}. {}", path, strerror(errno));
+        return nullptr;
+    }
+
+    // Nobody else needs to find the file, and the OS reclaims it once it is closed.
+    unlink(path.c_str());
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+
+    terminalLog()("Spilling history to {}.", path);
+    return std::unique_ptr<HistorySpillFile>(new HistorySpillFile(fd));
+}
+
+HistorySpillFile::HistorySpillFile(int fd): _fd { fd }, _flusher { [this]() { flushLoop(); } }
+{
+}
+
+HistorySpillFile::~HistorySpillFile()
+{
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _stopping = true;
+        _queue.clear();
+    }
+    _condition.notify_all();
+    _flusher.join();
+
+    unmap();
+    close(_fd);
+}
+
+void HistorySpillFile::write(Data data)
+{
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _queue.emplace_back(std::move(data));
+    }
+    _condition.notify_all();
+}
+
+std::vector<HistorySpillFile::CompletedWrite> HistorySpillFile::takeCompletedWrites()
+{
+    auto lock = std::unique_lock { _mutex, std::try_to_lock };
+    if (!lock.owns_lock())
+        return {};
+    return std::exchange(_completed, {});
+}
+
+gsl::span<uint8_t const> HistorySpillFile::read(Extent extent)
+{
+    if (extent.offset + extent.size > _mappingSize)
+    {
+        // Remap to cover everything written so far, such that reading older blocks needs no remapping.
+        unmap();
+        auto const fileSize = size();
+        auto* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_SHARED, _fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+            errorLog()("Failed to map history spill file. {}", strerror(errno));
+            return {};
+        }
+        _mapping = static_cast<uint8_t const*>(mapping);
+        _mappingSize = fileSize;
+    }
+
+    return { _mapping + extent.offset, extent.size };
+}
+
+void HistorySpillFile::reset()
+{
+    auto lock = std::unique_lock { _mutex };
+    _queue.clear();
+    _condition.wait(lock, [this]() { return !_writing; });
+    _completed.clear();
+    _fileSize = 0;
+    if (ftruncate(_fd, 0) != 0)
+        errorLog()("Failed to truncate history spill file. {}", strerror(errno));
+    unmap();
+}
+
+size_t HistorySpillFile::size() const
+{
+    auto const _ = std::lock_guard { _mutex };
+    return _fileSize;
+}
+
+void HistorySpillFile::flushLoop()
+{
+    auto lock = std::unique_lock { _mutex };
+    while (true)
+    {
+        _condition.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+        if (_stopping)
+            return;
+
+        auto data = std::move(_queue.front());
+        _queue.pop_front();
+        auto const extent = Extent { _fileSize, data->size() };
+        _writing = true;
+
+        lock.unlock();
+        auto const written = writeFully(_fd, data->data(), extent.size, extent.offset);
+        lock.lock();
+
+        _writing = false;
+        if (written)
+        {
+            _fileSize += extent.size;
+            _completed.emplace_back(CompletedWrite { std::move(data), extent });
+        }
+        else
+        {
+            errorLog()("Failed to write to history spill file. {}", strerror(errno));
+            _completed.emplace_back(CompletedWrite { std::move(data), std::nullopt });
+        }
+        _condition.notify_all();
+    }
+}
+
+void HistorySpillFile::unmap() noexcept
+{
+    if (_mapping)
+        munmap(const_cast<uint8_t*>(_mapping), _mappingSize);
+    _mapping = nullptr;
+    _mappingSize = 0;
+}
+
+#else
+
+std::unique_ptr<HistorySpillFile> HistorySpillFile::create()
+{
+    return nullptr;
+}
+
+HistorySpillFile::HistorySpillFile(int fd): _fd { fd }
+{
+}
+
+HistorySpillFile::~HistorySpillFile() = default;
+
+void HistorySpillFile::write(Data /*data*/)
+{
+}
+
+std::vector<HistorySpillFile::CompletedWrite> HistorySpillFile::takeCompletedWrites()
+{
+    return {};
+}
+
+gsl::span<uint8_t const> HistorySpillFile::read(Extent /*extent*/)
+{
+    return {};
+}
+
+void HistorySpillFile::reset()
+{
+}
+
+size_t HistorySpillFile::size() const
+{
+    return 0;
+}
+
+void HistorySpillFile::flushLoop()
+{
+}
+
+void HistorySpillFile::unmap() noexcept
+{
+}
+
+#endif
+
+} // namespace vtbackend
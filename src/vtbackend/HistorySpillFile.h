@@ -0,0 +1,101 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <gsl/span>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Append-only temporary file that compressed history blocks are paged out to.
+ *
+ * Blocks are handed over via write() and written by a background flusher thread,
+ * such that the terminal's PTY thread never blocks on disk I/O.
+ * Finished writes are picked up via takeCompletedWrites() and tell the caller where in the file
+ * a block has been written to, so it can release its in-memory copy.
+ *
+ * The file is memory-mapped for reading, and unlinked right after creation,
+ * so that it is reclaimed by the OS as soon as the session is gone.
+ * Space of blocks that are no longer needed is only reclaimed by reset().
+ */
+class HistorySpillFile
+{
+  public:
+    using Data = std::shared_ptr<std::vector<uint8_t> const>;
+
+    /// Location of a block in the file.
+    struct Extent
+    {
+        size_t offset = 0;
+        size_t size = 0;
+    };
+
+    struct CompletedWrite
+    {
+        Data data;
+        std::optional<Extent> extent; // Not set if writing failed.
+    };
+
+    /// Creates a new spill file in the system's temporary directory,
+    /// or returns nullptr if that is not possible.
+    [[nodiscard]] static std::unique_ptr<HistorySpillFile> create();
+
+    ~HistorySpillFile();
+
+    HistorySpillFile(HistorySpillFile const&) = delete;
+    HistorySpillFile(HistorySpillFile&&) = delete;
+    HistorySpillFile& operator=(HistorySpillFile const&) = delete;
+    HistorySpillFile& operator=(HistorySpillFile&&) = delete;
+
+    /// Queues @p data to be appended to the file.
+    void write(Data data);
+
+    /// Returns the writes that have finished since the last call, in the order they were queued.
+    ///
+    /// Never blocks, and returns nothing if the flusher is busy publishing its results.
+    [[nodiscard]] std::vector<CompletedWrite> takeCompletedWrites();
+
+    /// Returns the bytes of a completed write.
+    ///
+    /// The returned span is valid until the next call to read() or reset().
+    [[nodiscard]] gsl::span<uint8_t const> read(Extent extent);
+
+    /// Drops all queued writes and truncates the file.
+    void reset();
+
+    /// Number of bytes written to the file so far.
+    [[nodiscard]] size_t size() const;
+
+  private:
+    explicit HistorySpillFile(int fd);
+
+    void flushLoop();
+    void unmap() noexcept;
+
+    int _fd;
+
+    mutable std::mutex _mutex;
+    std::condition_variable _condition;
+    std::deque<Data> _queue;
+    std::vector<CompletedWrite> _completed;
+    size_t _fileSize = 0; // Offset the next block is written at.
+    bool _writing = false;
+    bool _stopping = false;
+
+    // Only accessed by the reading thread.
+    uint8_t const* _mapping = nullptr;
+    size_t _mappingSize = 0;
+
+    std::thread _flusher;
+};
+
+} // namespace vtbackend
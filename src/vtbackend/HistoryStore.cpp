@@ -0,0 +1,836 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/HistoryStore.h>
+
+#include <crispy/assert.h>
+#include <crispy/lz.h>
+
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
+
+namespace vtbackend
+{
+
+namespace
+{
+    // Each line is serialized as its LineFlags, followed by one of the following record types.
+    enum class LineRecord : uint8_t
+    {
+        Packed, // The PackedLineBuffer's members.
+        Live,   // Index into the block's live lines.
+    };
+
+    void writeVarint(std::vector<uint8_t>& output, size_t value)
+    {
+        while (value >= 0x80)
+        {
+            output.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        output.push_back(static_cast<uint8_t>(value));
+    }
+
+    void writeAttributes(std::vector<uint8_t>& output, GraphicsAttributes const& attributes)
+    {
+        static_assert(std::is_trivially_copyable_v<GraphicsAttributes>);
+        auto const* bytes = reinterpret_cast<uint8_t const*>(&attributes);
+        output.insert(output.end(), bytes, bytes + sizeof(GraphicsAttributes));
+    }
+
+    void writePackedLine(std::vector<uint8_t>& output, PackedLineBuffer const& buffer)
+    {
+        writeVarint(output, unbox<size_t>(buffer.displayWidth));
+        writeAttributes(output, buffer.fillAttributes);
+        writeVarint(output, unbox<size_t>(buffer.usedColumns));
+
+        writeVarint(output, buffer.text.size());
+        output.insert(output.end(), buffer.text.begin(), buffer.text.end());
+
+        writeVarint(output, buffer.columns.size());
+        for (auto const& column: buffer.columns)
+        {
+            output.push_back(column.byteCount);
+            output.push_back(column.width);
+        }
+
+        writeVarint(output, buffer.runs.size());
+        for (auto const& run: buffer.runs)
+        {
+            writeVarint(output, run.columnCount);
+            writeVarint(output, unbox<size_t>(run.hyperlink));
+            writeAttributes(output, run.attributes);
+        }
+    }
+
+    // Feeds the codepoints of consecutive columns into a TrigramFilter.
+    //
+    // Only each column's first codepoint is considered, as Line::search() matches one character
+    // of the search term per column. Blank columns never match, and thus break the sequence.
+    class TrigramCollector
+    {
+      public:
+        explicit TrigramCollector(TrigramFilter& filter) noexcept: _filter { filter } {}
+
+        void push(char32_t codepoint) noexcept
+        {
+            if (!codepoint)
+                _first = _second = 0;
+            else
+            {
+                if (_first)
+                    _filter.add(_first, _second, codepoint);
+                _first = _second;
+                _second = codepoint;
+            }
+        }
+
+        void reset() noexcept { push(0); }
+
+      private:
+        TrigramFilter& _filter;
+        char32_t _first = 0;
+        char32_t _second = 0;
+    };
+
+    char32_t firstCodepoint(uint8_t const* utf8) noexcept
+    {
+        auto const lead = utf8[0];
+        if (lead < 0x80)
+            return lead;
+        if ((lead & 0xE0) == 0xC0)
+            return char32_t(lead & 0x1F) << 6 | (utf8[1] & 0x3F);
+        if ((lead & 0xF0) == 0xE0)
+            return char32_t(lead & 0x0F) << 12 | char32_t(utf8[1] & 0x3F) << 6 | (utf8[2] & 0x3F);
+        return char32_t(lead & 0x07) << 18 | char32_t(utf8[1] & 0x3F) << 12 | char32_t(utf8[2] & 0x3F) << 6
+               | (utf8[3] & 0x3F);
+    }
+
+    void collectTrigrams(TrigramCollector& collector, PackedLineBuffer const& buffer) noexcept
+    {
+        auto const* text = reinterpret_cast<uint8_t const*>(buffer.text.data());
+        for (auto const& column: buffer.columns)
+        {
+            collector.push(column.byteCount ? firstCodepoint(text) : 0);
+            text += column.byteCount;
+        }
+        if (buffer.columns.size() < unbox<size_t>(buffer.displayWidth))
+            collector.reset();
+    }
+
+    template <typename Cell>
+    void collectTrigrams(TrigramCollector& collector, InflatedLineBuffer<Cell> const& cells) noexcept
+    {
+        for (auto const& cell: cells)
+            collector.push(cell.codepointCount() ? cell.codepoint(0) : 0);
+    }
+
+    // Lays out the logical line of @p lines anew with a width of @p columns, appending to @p output.
+    template <typename Cell>
+    void reflowLogicalLine(gsl::span<Line<Cell>> lines, ColumnCount columns, std::vector<Line<Cell>>& output)
+    {
+        auto& firstLine = lines.front();
+        auto const flags = firstLine.flags();
+        auto cells = InflatedLineBuffer<Cell> {};
+        if (lines.size() == 1)
+        {
+            cells = firstLine.reflow(columns);
+            output.emplace_back(std::move(firstLine));
+            if (cells.empty())
+                return;
+        }
+        else
+        {
+            // All but the last line are filled up to the width they were laid out with,
+            // as trailing blanks there are part of the text.
+            for (auto const& line: lines.first(lines.size() - 1))
+                cells.insert(cells.end(), line.cells().begin(), line.cells().end());
+            auto const lastCells = lines.back().trim_blank_right();
+            cells.insert(cells.end(), lastCells.begin(), lastCells.end());
+            if (cells.empty())
+            {
+                output.emplace_back(flags, TrivialLineBuffer { columns, GraphicsAttributes {} });
+                return;
+            }
+        }
+
+        auto const width = unbox<size_t>(columns);
+        for (size_t column = 0; column < cells.size(); column += width)
+        {
+            auto const first = std::next(cells.begin(), static_cast<ptrdiff_t>(column));
+            auto buffer = InflatedLineBuffer<Cell>(
+                first, std::next(first, static_cast<ptrdiff_t>(std::min(width, cells.size() - column))));
+            buffer.resize(width);
+            auto const continued = column != 0 || lines.size() == 1;
+            output.emplace_back(continued ? flags.without(LineFlag::Wrapped) | LineFlag::Wrapped : flags,
+                                std::move(buffer));
+        }
+    }
+
+    struct RecordReader
+    {
+        uint8_t const* current;
+        uint8_t const* end;
+
+        [[nodiscard]] bool atEnd() const noexcept { return current == end; }
+
+        uint8_t readByte() noexcept
+        {
+            assert(current != end);
+            return *current++;
+        }
+
+        size_t readVarint() noexcept
+        {
+            auto value = size_t { 0 };
+            for (auto shift = 0u;; shift += 7)
+            {
+                auto const byte = readByte();
+                value |= static_cast<size_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80))
+                    return value;
+            }
+        }
+
+        GraphicsAttributes readAttributes() noexcept
+        {
+            assert(static_cast<size_t>(end - current) >= sizeof(GraphicsAttributes));
+            auto attributes = GraphicsAttributes {};
+            std::memcpy(&attributes, current, sizeof(GraphicsAttributes));
+            current += sizeof(GraphicsAttributes);
+            return attributes;
+        }
+
+        PackedLineBuffer readPackedLine()
+        {
+            auto buffer = PackedLineBuffer {};
+            buffer.displayWidth = ColumnCount::cast_from(readVarint());
+            buffer.fillAttributes = readAttributes();
+            buffer.usedColumns = ColumnCount::cast_from(readVarint());
+
+            auto const textSize = readVarint();
+            assert(static_cast<size_t>(end - current) >= textSize);
+            buffer.text.assign(reinterpret_cast<char const*>(current), textSize);
+            current += textSize;
+
+            buffer.columns.resize(readVarint());
+            for (auto& column: buffer.columns)
+            {
+                column.byteCount = readByte();
+                column.width = readByte();
+            }
+
+            buffer.runs.resize(readVarint());
+            for (auto& run: buffer.runs)
+            {
+                run.columnCount = static_cast<uint16_t>(readVarint());
+                run.hyperlink = HyperlinkId(static_cast<uint16_t>(readVarint()));
+                run.attributes = readAttributes();
+            }
+
+            return buffer;
+        }
+    };
+} // namespace
+
+template <typename Cell>
+bool HistoryStore<Cell>::LineView::modified() const noexcept
+{
+    return line.revision() != revision || line.flags().value() != flags.value();
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::LineView::writeBack(Line<Cell>& original)
+{
+    if (!modified())
+        return;
+
+    auto const width = original.size();
+    if (line.size() < width)
+    {
+        // Keep the columns that have been cropped off in the view.
+        auto const cells = line.cells();
+        auto buffer = InflatedLineBuffer<Cell>(original.cells().begin(), original.cells().end());
+        std::copy(cells.begin(), cells.end(), buffer.begin());
+        original = Line<Cell>(line.flags(), std::move(buffer));
+    }
+    else
+    {
+        // Drop the padding again, unless something has been written into it.
+        auto const padding = line.cells().subspan(unbox<size_t>(width));
+        auto const padded = std::all_of(padding.begin(), padding.end(), [](Cell const& cell) {
+            return cell.empty();
+        });
+        original = std::move(line);
+        if (padded)
+            original.resize(width);
+    }
+}
+
+template <typename Cell>
+bool HistoryStore<Cell>::ThawedBlock::modified() const noexcept
+{
+    for (size_t i = 0; i < lines.size(); ++i)
+        if (lines[i].revision() != revisions[i] || lines[i].flags().value() != flags[i].value()
+            || (views[i] && views[i]->modified()))
+            return true;
+    return false;
+}
+
+template <typename Cell>
+Line<Cell>& HistoryStore<Cell>::lineView(Line<Cell>& line, std::optional<LineView>& view, ColumnCount columns)
+{
+    if (view && view->line.size() == columns)
+        return view->line;
+
+    if (view)
+        view->writeBack(line);
+    if (line.size() == columns)
+    {
+        view.reset();
+        return line;
+    }
+
+    view.emplace(LineView { line });
+    view->line.resize(columns);
+    view->line.updateRevision();
+    view->revision = view->line.revision();
+    view->flags = view->line.flags();
+    return view->line;
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::writeBack(std::vector<Line<Cell>>& lines, LineViews& views)
+{
+    for (size_t i = 0; i < std::min(lines.size(), views.size()); ++i)
+    {
+        if (views[i])
+            views[i]->writeBack(lines[i]);
+        views[i].reset();
+    }
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::push(Line<Cell> line)
+{
+    if (_pendingLines.empty() && !_blocks.empty() && line.wrapped())
+        _blocks.back().continuesInto = true;
+
+    _pendingLines.emplace_back(std::move(line));
+    if (_pendingLines.size() == BlockLineCount)
+        freezePendingLines();
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::freezePendingLines()
+{
+    writeBack(_pendingLines, _pendingViews);
+    auto const firstLine = _blocks.empty() ? 0 : _blocks.back().firstLine + _blocks.back().lineCount;
+    auto& block = _blocks.emplace_back(freeze(std::move(_pendingLines)));
+    block.firstLine = firstLine;
+    _blockLineCount += block.lineCount;
+    _pendingLines.clear();
+
+    if (_spillFile)
+    {
+        collectSpilledBlocks();
+        spillOldBlocks();
+    }
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::discardOldest(LineCount count)
+{
+    _discardedLineCount += unbox<size_t>(std::min(count, size()));
+
+    while (!_blocks.empty() && _discardedLineCount >= _blocks.front().lineCount)
+    {
+        auto const isFirstBlock = [this](ThawedBlock const& thawed) {
+            return thawed.blockNumber == _firstBlockNumber;
+        };
+        _thawedBlocks.erase(std::remove_if(_thawedBlocks.begin(), _thawedBlocks.end(), isFirstBlock),
+                            _thawedBlocks.end());
+        _discardedLineCount -= _blocks.front().lineCount;
+        _blockLineCount -= _blocks.front().lineCount;
+        _blocks.pop_front();
+        ++_firstBlockNumber;
+    }
+
+    if (_blocks.empty() && _discardedLineCount)
+    {
+        writeBack(_pendingLines, _pendingViews);
+        _pendingLines.erase(_pendingLines.begin(),
+                            std::next(_pendingLines.begin(), static_cast<ptrdiff_t>(_discardedLineCount)));
+        _discardedLineCount = 0;
+    }
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::clear()
+{
+    _firstBlockNumber += _blocks.size();
+    _blocks.clear();
+    _blockLineCount = 0;
+    _discardedLineCount = 0;
+    _pendingLines.clear();
+    _pendingViews.clear();
+    _thawedBlocks.clear();
+
+    if (_spillFile)
+        _spillFile->reset();
+    _spillingBlocks.clear();
+    _nextSpillBlockNumber = _firstBlockNumber;
+}
+
+template <typename Cell>
+Line<Cell>& HistoryStore<Cell>::at(size_t index, ColumnCount columns)
+{
+    auto const position = index + _discardedLineCount;
+    auto const blockIndex = blockIndexOf(position);
+
+    if (blockIndex < _blocks.size())
+    {
+        auto& thawed = thawedBlock(_firstBlockNumber + blockIndex);
+        auto const i = _blocks.front().firstLine + position - _blocks[blockIndex].firstLine;
+        return lineView(thawed.lines[i], thawed.views[i], columns);
+    }
+
+    auto const i = position - _blockLineCount;
+    _pendingViews.resize(BlockLineCount);
+    return lineView(_pendingLines.at(i), _pendingViews[i], columns);
+}
+
+template <typename Cell>
+std::optional<std::pair<size_t, size_t>> HistoryStore<Cell>::unmatchableBlockRange(
+    size_t index, gsl::span<uint16_t const> trigramHashes) const noexcept
+{
+    auto const position = index + _discardedLineCount;
+    auto const blockIndex = blockIndexOf(position);
+    if (blockIndex >= _blocks.size())
+        return std::nullopt;
+
+    auto const& block = _blocks[blockIndex];
+    if (block.continuesFrom || block.continuesInto || block.trigrams.mayContain(trigramHashes))
+        return std::nullopt;
+
+    // The last block's successor may still be pushed as a continuation line.
+    if (blockIndex + 1 == _blocks.size() && _pendingLines.empty())
+        return std::nullopt;
+
+    auto const blockNumber = _firstBlockNumber + blockIndex;
+    if (std::any_of(_thawedBlocks.begin(), _thawedBlocks.end(), [=](ThawedBlock const& thawed) {
+            return thawed.blockNumber == blockNumber && thawed.modified();
+        }))
+        return std::nullopt;
+
+    auto const begin = block.firstLine - _blocks.front().firstLine;
+    auto const first = std::max(begin, _discardedLineCount) - _discardedLineCount;
+    auto const last = begin + block.lineCount - 1 - _discardedLineCount;
+    return std::pair { first, last };
+}
+
+template <typename Cell>
+LineCount HistoryStore<Cell>::reflowedLineCount(ColumnCount columns) const noexcept
+{
+    // Lines are counted per logical line, from the most recent one up to the first one that is
+    // not laid out with the given width. Blocks only tell whether all of their lines are.
+    auto count = size_t { 0 };
+    auto logicalLineCount = size_t { 0 };
+    for (auto line = _pendingLines.rbegin(); line != _pendingLines.rend(); ++line)
+    {
+        if (line->size() != columns)
+            return LineCount::cast_from(count);
+        ++logicalLineCount;
+        if (!line->wrapped())
+        {
+            count += logicalLineCount;
+            logicalLineCount = 0;
+        }
+    }
+
+    for (auto block = _blocks.rbegin(); block != _blocks.rend(); ++block)
+    {
+        if (block->columns != columns)
+            return LineCount::cast_from(count);
+        logicalLineCount += block->lineCount;
+        if (!block->continuesFrom)
+        {
+            count += logicalLineCount;
+            logicalLineCount = 0;
+        }
+    }
+
+    // The oldest logical line may have been discarded partially.
+    count += logicalLineCount;
+    return std::min(LineCount::cast_from(count), size());
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::reflow(ColumnCount columns, LineCount count)
+{
+    // The count refers to lines as reflowed, which may be more or fewer than as they are laid out now.
+    if (reflowedLineCount(columns) >= std::min(count, size()))
+        return;
+
+    // Pending lines are reflowed as a block of their own.
+    if (!_pendingLines.empty())
+        freezePendingLines();
+
+    auto reflowedCount = size_t { 0 };
+    auto end = _blocks.size();
+    auto firstReflowed = end;
+    while (end != 0 && reflowedCount < unbox<size_t>(count))
+    {
+        auto begin = end - 1;
+        while (begin != 0 && _blocks[begin].continuesFrom)
+            --begin;
+
+        if (std::any_of(std::next(_blocks.begin(), static_cast<ptrdiff_t>(begin)),
+                        std::next(_blocks.begin(), static_cast<ptrdiff_t>(end)),
+                        [=](Block const& block) { return block.columns != columns; }))
+        {
+            reflowBlocks(begin, end, columns);
+            firstReflowed = begin;
+        }
+
+        for (auto i = begin; i != end; ++i)
+            reflowedCount += _blocks[i].lineCount;
+        end = begin;
+    }
+
+    // The lines of the reflowed blocks and all later ones have been renumbered.
+    for (auto i = std::max(firstReflowed, size_t { 1 }); i < _blocks.size(); ++i)
+        _blocks[i].firstLine = _blocks[i - 1].firstLine + _blocks[i - 1].lineCount;
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::reflowBlocks(size_t begin, size_t end, ColumnCount columns)
+{
+    auto lines = std::vector<Line<Cell>> {};
+    for (auto i = begin; i != end; ++i)
+        for (auto& line: takeLines(i))
+            lines.emplace_back(std::move(line));
+
+    if (begin == 0)
+    {
+        lines.erase(lines.begin(), std::next(lines.begin(), static_cast<ptrdiff_t>(_discardedLineCount)));
+        _blockLineCount -= _discardedLineCount;
+        _blocks.front().lineCount -= _discardedLineCount;
+        _discardedLineCount = 0;
+    }
+
+    auto reflowedLines = std::vector<Line<Cell>> {};
+    reflowedLines.reserve(lines.size());
+    for (size_t top = 0; top < lines.size();)
+    {
+        auto bottom = top + 1;
+        while (bottom < lines.size() && lines[bottom].wrapped())
+            ++bottom;
+        reflowLogicalLine(gsl::span(lines).subspan(top, bottom - top), columns, reflowedLines);
+        top = bottom;
+    }
+
+    // The lines are frozen into the same blocks again, such that the numbers of all blocks stay valid.
+    auto const blockCount = end - begin;
+    auto const lineCount = reflowedLines.size();
+    auto const continuesInto = _blocks[end - 1].continuesInto;
+    for (size_t i = 0; i < blockCount; ++i)
+    {
+        auto const first = lineCount * i / blockCount;
+        auto const last = lineCount * (i + 1) / blockCount;
+        auto const nextFirst = lineCount * (i + 2) / blockCount;
+        auto& block = _blocks[begin + i];
+        auto const firstLine = block.firstLine;
+        _blockLineCount -= block.lineCount;
+
+        block = freeze(std::vector<Line<Cell>>(
+            std::make_move_iterator(std::next(reflowedLines.begin(), static_cast<ptrdiff_t>(first))),
+            std::make_move_iterator(std::next(reflowedLines.begin(), static_cast<ptrdiff_t>(last)))));
+        block.firstLine = firstLine;
+        _blockLineCount += block.lineCount;
+
+        // With fewer lines than blocks, the empty blocks are considered part of the logical line around.
+        if (first == last)
+            block.continuesFrom = true;
+        block.continuesInto = i + 1 == blockCount ? continuesInto
+                                                  : last == nextFirst || reflowedLines[last].wrapped();
+
+        if (_spillFile && _firstBlockNumber + begin + i < _nextSpillBlockNumber)
+            spill(_firstBlockNumber + begin + i);
+    }
+}
+
+template <typename Cell>
+std::vector<Line<Cell>> HistoryStore<Cell>::takeLines(size_t blockIndex)
+{
+    auto const blockNumber = _firstBlockNumber + blockIndex;
+    auto const thawed = std::find_if(_thawedBlocks.begin(), _thawedBlocks.end(), [=](auto const& thawed) {
+        return thawed.blockNumber == blockNumber;
+    });
+    if (thawed != _thawedBlocks.end())
+    {
+        writeBack(thawed->lines, thawed->views);
+        auto lines = std::move(thawed->lines);
+        _thawedBlocks.erase(thawed);
+        return lines;
+    }
+
+    auto const& block = _blocks[blockIndex];
+    if (!block.lineCount)
+        return {};
+    return thaw(decompress(compressedData(block), block), block);
+}
+
+template <typename Cell>
+size_t HistoryStore<Cell>::blockIndexOf(size_t position) const noexcept
+{
+    if (position >= _blockLineCount)
+        return _blocks.size();
+
+    // The last block starting at or before the line, which skips any empty blocks.
+    auto const line = _blocks.front().firstLine + position;
+    auto const startsAfter = [](size_t value, Block const& block) { return value < block.firstLine; };
+    auto const next = std::upper_bound(_blocks.begin(), _blocks.end(), line, startsAfter);
+    return static_cast<size_t>(std::distance(_blocks.begin(), next)) - 1;
+}
+
+template <typename Cell>
+size_t HistoryStore<Cell>::compressedSize() const noexcept
+{
+    auto total = size_t { 0 };
+    for (auto const& block: _blocks)
+        total += block.spilling ? block.spilling->size() : block.data.size();
+    return total;
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::setSpillThreshold(std::optional<LineCount> threshold)
+{
+    _spillThreshold = threshold;
+    if (!_spillThreshold)
+        return;
+
+    if (!_spillFile)
+    {
+        _spillFile = HistorySpillFile::create();
+        _nextSpillBlockNumber = _firstBlockNumber;
+    }
+    if (_spillFile)
+        spillOldBlocks();
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::collectSpilledBlocks()
+{
+    if (!_spillFile)
+        return;
+
+    for (auto& write: _spillFile->takeCompletedWrites())
+    {
+        if (_spillingBlocks.empty())
+            break;
+        auto const blockNumber = _spillingBlocks.front();
+        _spillingBlocks.pop_front();
+
+        // The block may have been discarded or modified (and thus frozen again) in the meantime.
+        if (blockNumber < _firstBlockNumber)
+            continue;
+        auto& block = _blocks[blockNumber - _firstBlockNumber];
+        if (block.spilling != write.data || !write.extent)
+            continue; // A block that failed to be written simply stays in memory.
+
+        block.spilled = write.extent;
+        block.spilling.reset();
+    }
+}
+
+template <typename Cell>
+size_t HistoryStore<Cell>::spilledBlockCount() const noexcept
+{
+    return static_cast<size_t>(
+        std::count_if(_blocks.begin(), _blocks.end(), [](Block const& block) { return block.spilled; }));
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::spillOldBlocks()
+{
+    if (!_spillThreshold)
+        return;
+
+    auto const endBlockNumber = _firstBlockNumber + _blocks.size();
+    _nextSpillBlockNumber = std::max(_nextSpillBlockNumber, _firstBlockNumber);
+
+    // A block is spilled once all of its lines are older than the threshold.
+    auto const threshold = unbox<size_t>(*_spillThreshold);
+    auto const newerLineCount = [this](Block const& block) {
+        return _blocks.back().firstLine + _blocks.back().lineCount - block.firstLine - block.lineCount
+               + _pendingLines.size();
+    };
+    while (_nextSpillBlockNumber < endBlockNumber
+           && newerLineCount(_blocks[_nextSpillBlockNumber - _firstBlockNumber]) >= threshold)
+    {
+        spill(_nextSpillBlockNumber);
+        ++_nextSpillBlockNumber;
+    }
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::spill(size_t blockNumber)
+{
+    auto& block = _blocks[blockNumber - _firstBlockNumber];
+    block.spilling = std::make_shared<std::vector<uint8_t> const>(std::move(block.data));
+    block.data = {};
+    _spillFile->write(block.spilling);
+    _spillingBlocks.push_back(blockNumber);
+}
+
+template <typename Cell>
+gsl::span<uint8_t const> HistoryStore<Cell>::compressedData(Block const& block)
+{
+    if (block.spilled)
+        return _spillFile->read(*block.spilled);
+    if (block.spilling)
+        return *block.spilling;
+    return block.data;
+}
+
+template <typename Cell>
+typename HistoryStore<Cell>::ThawedBlock& HistoryStore<Cell>::thawedBlock(size_t blockNumber)
+{
+    auto const i = std::find_if(_thawedBlocks.begin(), _thawedBlocks.end(), [=](auto const& thawed) {
+        return thawed.blockNumber == blockNumber;
+    });
+    if (i != _thawedBlocks.end())
+    {
+        std::rotate(i, std::next(i), _thawedBlocks.end());
+        return _thawedBlocks.back();
+    }
+
+    if (_thawedBlocks.size() == MaxThawedBlockCount)
+    {
+        evict(_thawedBlocks.front());
+        _thawedBlocks.erase(_thawedBlocks.begin());
+    }
+
+    auto thawed = ThawedBlock {};
+    thawed.blockNumber = blockNumber;
+    auto const& block = _blocks[blockNumber - _firstBlockNumber];
+    thawed.records = decompress(compressedData(block), block);
+    thawed.lines = thaw(thawed.records, block);
+    thawed.views.resize(thawed.lines.size());
+    for (auto& line: thawed.lines)
+    {
+        line.updateRevision();
+        thawed.revisions.push_back(line.revision());
+        thawed.flags.push_back(line.flags());
+    }
+    return _thawedBlocks.emplace_back(std::move(thawed));
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::evict(ThawedBlock& thawedBlock)
+{
+    writeBack(thawedBlock.lines, thawedBlock.views);
+    if (!thawedBlock.modified())
+        return;
+
+    // Lines that have only been accessed mutably, without changing them, need no compression.
+    auto modifiedBlock = Block {};
+    auto const records = serialize(thawedBlock.lines, modifiedBlock);
+    if (records == thawedBlock.records && modifiedBlock.liveLines.empty())
+        return;
+
+    // A modified block stays in memory from now on, even if it had been spilled before.
+    auto& block = _blocks[thawedBlock.blockNumber - _firstBlockNumber];
+    compress(modifiedBlock, records);
+    modifiedBlock.firstLine = block.firstLine;
+    modifiedBlock.continuesInto = block.continuesInto;
+    block = std::move(modifiedBlock);
+}
+
+template <typename Cell>
+typename HistoryStore<Cell>::Block HistoryStore<Cell>::freeze(std::vector<Line<Cell>> lines)
+{
+    auto block = Block {};
+    compress(block, serialize(lines, block));
+    return block;
+}
+
+template <typename Cell>
+std::vector<uint8_t> HistoryStore<Cell>::serialize(std::vector<Line<Cell>>& lines, Block& block)
+{
+    block.continuesFrom = !lines.empty() && lines.front().wrapped();
+    block.lineCount = lines.size();
+    block.columns = lines.empty() ? ColumnCount(0) : lines.front().size();
+
+    auto records = std::vector<uint8_t> {};
+    auto trigrams = TrigramCollector { block.trigrams };
+    for (auto& line: lines)
+    {
+        if (line.size() != block.columns)
+            block.columns = ColumnCount(0);
+        records.push_back(line.flags().value());
+        if (!line.wrapped())
+            trigrams.reset();
+
+        if (line.isTrivialBuffer())
+            (void) line.inflatedBuffer();
+        if (line.pack())
+        {
+            records.push_back(static_cast<uint8_t>(LineRecord::Packed));
+            writePackedLine(records, line.packedBuffer());
+            collectTrigrams(trigrams, line.packedBuffer());
+        }
+        else
+        {
+            collectTrigrams(trigrams, line.inflatedBuffer());
+            records.push_back(static_cast<uint8_t>(LineRecord::Live));
+            writeVarint(records, block.liveLines.size());
+            block.liveLines.emplace_back(std::move(line));
+        }
+    }
+    return records;
+}
+
+template <typename Cell>
+void HistoryStore<Cell>::compress(Block& block, std::vector<uint8_t> const& records)
+{
+    block.dataSize = records.size();
+    block.data = crispy::lz::compress(records);
+    block.data.shrink_to_fit();
+}
+
+template <typename Cell>
+std::vector<uint8_t> HistoryStore<Cell>::decompress(gsl::span<uint8_t const> data, Block const& block)
+{
+    auto records = std::vector<uint8_t>(block.dataSize);
+    [[maybe_unused]] auto const decompressed = crispy::lz::decompress(data, records);
+    Require(decompressed);
+    return records;
+}
+
+template <typename Cell>
+std::vector<Line<Cell>> HistoryStore<Cell>::thaw(gsl::span<uint8_t const> records, Block const& block)
+{
+    auto lines = std::vector<Line<Cell>> {};
+    lines.reserve(BlockLineCount);
+
+    auto reader = RecordReader { records.data(), records.data() + records.size() };
+    while (!reader.atEnd())
+    {
+        auto const flags = LineFlags::from_value(reader.readByte());
+        if (static_cast<LineRecord>(reader.readByte()) == LineRecord::Packed)
+            lines.emplace_back(flags, reader.readPackedLine());
+        else
+            lines.emplace_back(block.liveLines[reader.readVarint()]);
+    }
+
+    return lines;
+}
+
+} // namespace vtbackend
+
+#include <vtbackend/cell/CompactCell.h>
+template class vtbackend::HistoryStore<vtbackend::CompactCell>;
+
+#include <vtbackend/cell/SimpleCell.h>
+template class vtbackend::HistoryStore<vtbackend::SimpleCell>;
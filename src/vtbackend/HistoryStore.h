@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/HistorySpillFile.h>
+#include <vtbackend/Line.h>
+#include <vtbackend/TrigramFilter.h>
+#include <vtbackend/primitives.h>
+
+#include <gsl/span>
+
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Storage for the oldest scrollback history lines of a Grid.
+ *
+ * Lines are appended in the order they leave the grid's ring buffer of live lines,
+ * and kept live until a block of BlockLineCount lines is complete. Reflowing the lines
+ * changes their number, so blocks may hold more or fewer lines than that.
+ * Complete blocks are serialized (in packed line form) and compressed,
+ * such that a very long history costs only a few bytes per line.
+ *
+ * A block is decompressed on demand when one of its lines is accessed, and the most recently
+ * used blocks are kept decompressed. A decompressed block whose lines have been modified
+ * is serialized again when it gets evicted, and compressed again only if that changed its records.
+ *
+ * Lines keep the width they have been laid out with, until reflow() lays them out anew.
+ * Accessing a line of a different width yields a copy of it, cropped or padded to the requested width,
+ * that lives as long as the line's decompressed block. Modifications to such a copy are written back
+ * to the line.
+ *
+ * With a spill threshold set, the compressed blocks of lines older than that are moved out of memory
+ * into a HistorySpillFile. Blocks are written by the spill file's background thread, and their
+ * in-memory copy is released once push() or collectSpilledBlocks() picks up the finished write.
+ * Spilled blocks are read back from the file's memory mapping.
+ *
+ * Each block keeps a TrigramFilter of its text in memory, such that searching the history
+ * can skip blocks that cannot contain the search term without decompressing them.
+ *
+ * References returned by at() remain valid until the store is modified or
+ * MaxThawedBlockCount other blocks have been accessed.
+ */
+template <typename Cell>
+class HistoryStore
+{
+  public:
+    static constexpr size_t BlockLineCount = 256;
+    static constexpr size_t MaxThawedBlockCount = 8;
+
+    /// Number of lines in this store.
+    [[nodiscard]] LineCount size() const noexcept
+    {
+        return LineCount::cast_from(_blockLineCount + _pendingLines.size() - _discardedLineCount);
+    }
+
+    [[nodiscard]] bool empty() const noexcept { return size() == LineCount(0); }
+
+    /// Appends @p line as the most recent line.
+    void push(Line<Cell> line);
+
+    /// Discards the @p count oldest lines.
+    void discardOldest(LineCount count);
+
+    /// Discards all lines.
+    void clear();
+
+    /// Returns the line at @p index, 0 being the oldest line, with a width of @p columns.
+    ///
+    /// A line laid out with a different width is returned as a cropped or padded copy.
+    [[nodiscard]] Line<Cell>& at(size_t index, ColumnCount columns);
+
+    /// Number of the most recent lines that are laid out with a width of @p columns,
+    /// up to the first logical line that is not.
+    [[nodiscard]] LineCount reflowedLineCount(ColumnCount columns) const noexcept;
+
+    /// Reflows logical lines to a width of @p columns, starting with the most recent ones,
+    /// until at least @p count of the most recent lines are laid out with that width.
+    ///
+    /// Lines are reflowed per run of blocks that no logical line crosses the boundary of.
+    /// The reflowed lines are frozen into the same number of blocks again, and spilled again
+    /// if these had been spilled before.
+    void reflow(ColumnCount columns, LineCount count);
+
+    /// Returns the range of line indices of the block containing the line at @p index,
+    /// if that block cannot contain a search term with the given trigram hashes.
+    ///
+    /// Blocks that a logical line crosses the boundary of are never reported,
+    /// and neither are decompressed blocks whose lines have been modified since.
+    [[nodiscard]] std::optional<std::pair<size_t, size_t>> unmatchableBlockRange(
+        size_t index, gsl::span<uint16_t const> trigramHashes) const noexcept;
+
+    /// Number of bytes the compressed blocks take in memory.
+    [[nodiscard]] size_t compressedSize() const noexcept;
+
+    /// Number of most recent lines kept in memory before their blocks are spilled to disk,
+    /// or std::nullopt if spilling is disabled.
+    [[nodiscard]] std::optional<LineCount> spillThreshold() const noexcept { return _spillThreshold; }
+
+    /// Sets the spill threshold, creating the spill file if needed.
+    ///
+    /// Blocks that have already been spilled remain on disk when spilling gets disabled.
+    void setSpillThreshold(std::optional<LineCount> threshold);
+
+    /// Releases the in-memory copy of all blocks that have been written to the spill file since.
+    void collectSpilledBlocks();
+
+    /// Number of blocks that are read from the spill file.
+    [[nodiscard]] size_t spilledBlockCount() const noexcept;
+
+    /// Number of blocks currently kept decompressed.
+    [[nodiscard]] size_t thawedBlockCount() const noexcept { return _thawedBlocks.size(); }
+
+  private:
+    struct Block
+    {
+        std::vector<uint8_t> data;         // Compressed line records, unless handed to the spill file.
+        size_t dataSize = 0;               // Size of the line records when decompressed.
+        std::vector<Line<Cell>> liveLines; // Lines that have no packed form, such as image fragments.
+        size_t firstLine = 0;              // Number of lines of the store before this block's first line.
+        size_t lineCount = 0;
+        ColumnCount columns {};            // Width all lines are laid out with, or 0 if it differs.
+
+        HistorySpillFile::Data spilling;                // Compressed line records, while being spilled.
+        std::optional<HistorySpillFile::Extent> spilled; // Location in the spill file, once spilled.
+
+        TrigramFilter trigrams;       // Trigrams of the text as matched by Line::search().
+        bool continuesFrom = false;   // The first line continues a logical line of the previous block.
+        bool continuesInto = false;   // The next block's first line continues this block's last line.
+    };
+
+    // A copy of a line, resized to the width it is accessed with.
+    struct LineView
+    {
+        Line<Cell> line;
+        uint32_t revision = 0; // Revision of the copy at the time of copying, to detect modifications.
+        LineFlags flags;
+
+        [[nodiscard]] bool modified() const noexcept;
+        // Writes any modifications of the copy back to @p original, leaving the copy unusable.
+        void writeBack(Line<Cell>& original);
+    };
+
+    // Copies of the lines that are accessed with a different width, indexed like the lines.
+    using LineViews = std::vector<std::optional<LineView>>;
+
+    struct ThawedBlock
+    {
+        size_t blockNumber = 0;
+        std::vector<Line<Cell>> lines;
+        LineViews views;
+
+        std::vector<uint8_t> records; // The decompressed line records, to detect changes when evicted.
+
+        // Revisions and flags of the lines at the time of thawing, to detect modifications.
+        std::vector<uint32_t> revisions;
+        std::vector<LineFlags> flags;
+
+        [[nodiscard]] bool modified() const noexcept;
+    };
+
+    [[nodiscard]] static Line<Cell>& lineView(Line<Cell>& line,
+                                              std::optional<LineView>& view,
+                                              ColumnCount columns);
+    static void writeBack(std::vector<Line<Cell>>& lines, LineViews& views);
+
+    [[nodiscard]] static std::vector<uint8_t> serialize(std::vector<Line<Cell>>& lines, Block& block);
+    static void compress(Block& block, std::vector<uint8_t> const& records);
+    [[nodiscard]] static Block freeze(std::vector<Line<Cell>> lines);
+    [[nodiscard]] static std::vector<uint8_t> decompress(gsl::span<uint8_t const> data, Block const& block);
+    [[nodiscard]] static std::vector<Line<Cell>> thaw(gsl::span<uint8_t const> records, Block const& block);
+    [[nodiscard]] gsl::span<uint8_t const> compressedData(Block const& block);
+    void freezePendingLines();
+    void spillOldBlocks();
+    void spill(size_t blockNumber);
+
+    [[nodiscard]] size_t blockIndexOf(size_t position) const noexcept;
+    [[nodiscard]] ThawedBlock& thawedBlock(size_t blockNumber);
+    void evict(ThawedBlock& thawedBlock);
+
+    [[nodiscard]] std::vector<Line<Cell>> takeLines(size_t blockIndex);
+    void reflowBlocks(size_t begin, size_t end, ColumnCount columns);
+
+    std::deque<Block> _blocks;
+    size_t _firstBlockNumber = 0;   // Block number of _blocks.front().
+    size_t _blockLineCount = 0;     // Number of lines in all blocks, including the discarded ones.
+    size_t _discardedLineCount = 0; // Number of discarded lines at the front of the first block.
+
+    std::vector<Line<Cell>> _pendingLines; // Lines of the incomplete, most recent block.
+    LineViews _pendingViews;               // Views of the pending lines, with BlockLineCount entries.
+
+    std::vector<ThawedBlock> _thawedBlocks; // Ordered from least to most recently used.
+
+    std::optional<LineCount> _spillThreshold;
+    std::unique_ptr<HistorySpillFile> _spillFile;
+    size_t _nextSpillBlockNumber = 0;  // Block number of the oldest block not handed to the spill file.
+    std::deque<size_t> _spillingBlocks; // Block numbers being written, in the order of their writes.
+};
+
+} // namespace vtbackend
@@ -4,7 +4,9 @@
 #include <crispy/StrongLRUHashtable.h>
 
 #include <algorithm>
+#include <functional>
 #include <memory>
+#include <string_view>
 
 using std::copy;
 using std::make_shared;
@@ -26,9 +28,24 @@ ImageStats& ImageStats::get()
 Image::~Image()
 {
     --ImageStats::get().instances;
+    if (_data)
+        ImageStats::get().bytes -= _data->size();
+    else
+        --ImageStats::get().evicted;
     _onImageRemove(this);
 }
 
+void Image::evict() noexcept
+{
+    // Fragments being rendered right now keep their reference to the data until done.
+    auto const data = std::atomic_exchange(&_data, std::shared_ptr<Data const> {});
+    if (!data)
+        return;
+
+    ImageStats::get().bytes -= data->size();
+    ++ImageStats::get().evicted;
+}
+
 RasterizedImage::~RasterizedImage()
 {
     --ImageStats::get().rasterized;
@@ -39,12 +56,13 @@ ImageFragment::~ImageFragment()
     --ImageStats::get().fragments;
 }
 
-ImagePool::ImagePool(OnImageRemove onImageRemove, ImageId nextImageId):
+ImagePool::ImagePool(OnImageRemove onImageRemove, ImageId nextImageId, size_t memoryBudget):
     _nextImageId { nextImageId },
     _imageNameToImageCache { crispy::strong_hashtable_size { 1024 },
                              crispy::lru_capacity { 100 },
                              "ImagePool name-to-image mappings" },
-    _onImageRemove { std::move(onImageRemove) }
+    _onImageRemove { std::move(onImageRemove) },
+    _memoryBudget { memoryBudget }
 {
 }
 
@@ -59,6 +77,27 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
 
     Image::Data fragData;
     fragData.resize(_cellSize.area() * 4); // RGBA
+
+    auto const data = _image->data();
+    if (!data)
+    {
+        // Hatches the cell with diagonal lines that continue across the cells the image spans.
+        auto constexpr PlaceholderColor = RGBAColor { 0x80, 0x80, 0x80, 0xFF };
+        auto* target = fragData.data();
+        for (int y = 0; y < unbox<int>(_cellSize.height); ++y)
+        {
+            for (int x = 0; x < unbox<int>(_cellSize.width); ++x)
+            {
+                auto const color =
+                    (*xOffset + x + *yOffset + y) % 8 == 0 ? PlaceholderColor : _defaultColor;
+                *target++ = color.red();
+                *target++ = color.green();
+                *target++ = color.blue();
+                *target++ = color.alpha();
+            }
+        }
+        return fragData;
+    }
     auto const availableWidth =
         min(unbox<int>(_image->width()) - *pixelOffset.column, unbox<int>(_cellSize.width));
     auto const availableHeight =
@@ -91,7 +130,7 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
     {
         auto const startOffset = static_cast<size_t>(
             ((*pixelOffset.line + y) * unbox<int>(_image->width()) + *pixelOffset.column) * 4);
-        const auto* const source = &_image->data()[startOffset];
+        const auto* const source = &(*data)[startOffset];
         target = copy(source, source + static_cast<ptrdiff_t>(availableWidth) * 4, target);
 
         // fill vertical gap on right
@@ -118,10 +157,66 @@ Image::Data RasterizedImage::fragment(CellLocation pos) const
 
 shared_ptr<Image const> ImagePool::create(ImageFormat format, ImageSize size, Image::Data&& data)
 {
-    // TODO: This operation should be idempotent, i.e. if that image has been created already, return a
-    // reference to that.
+    std::erase_if(_images, [](Entry const& entry) { return entry.image.expired(); });
+
+    auto const bytes = std::string_view(reinterpret_cast<char const*>(data.data()), data.size());
+    auto const contentHash = std::hash<std::string_view> {}(bytes) ^ (std::hash<size_t> {}(size.area()) << 1);
+
+    for (auto i = _images.begin(); i != _images.end(); ++i)
+    {
+        if (i->contentHash != contentHash)
+            continue;
+
+        auto image = i->image.lock();
+        if (!image || image->format() != format || image->size() != size)
+            continue;
+
+        if (auto const pixels = image->data(); pixels && *pixels == data)
+        {
+            // Moves the image to the back, as if it had just been created.
+            std::rotate(i, std::next(i), _images.end());
+            return image;
+        }
+    }
+
     auto const id = _nextImageId++;
-    return make_shared<Image>(id, format, std::move(data), size, _onImageRemove);
+    auto image = make_shared<Image>(id, format, std::move(data), size, _onImageRemove);
+    _images.emplace_back(Entry { contentHash, image });
+    return image;
+}
+
+size_t ImagePool::memoryUsage() const noexcept
+{
+    auto bytes = size_t { 0 };
+    for (auto const& entry: _images)
+        if (auto const image = entry.image.lock())
+            if (auto const data = image->data())
+                bytes += data->size();
+    return bytes;
+}
+
+size_t ImagePool::evict(std::vector<Image const*> const& pinned)
+{
+    auto usage = memoryUsage();
+    auto count = size_t { 0 };
+    for (auto const& entry: _images)
+    {
+        if (usage <= _memoryBudget)
+            break;
+
+        auto const image = entry.image.lock();
+        auto const data = image ? image->data() : nullptr;
+        if (!data || std::ranges::find(pinned, image.get()) != pinned.end())
+            continue;
+
+        usage -= data->size();
+        image->evict();
+        ++count;
+
+        // Lets the renderer release its copies of the pixel data as well.
+        _onImageRemove(image.get());
+    }
+    return count;
 }
 
 shared_ptr<RasterizedImage> rasterize(shared_ptr<Image const> image,
@@ -156,12 +251,14 @@ void ImagePool::unlink(string const& name)
 void ImagePool::clear()
 {
     _imageNameToImageCache.clear();
+    _images.clear();
 }
 
 void ImagePool::inspect(ostream& os) const
 {
     os << "Image pool:\n";
     os << fmt::format("global image stats: {}\n", ImageStats::get());
+    os << fmt::format("memory usage: {} of {} bytes\n", memoryUsage(), _memoryBudget);
     _imageNameToImageCache.inspect(os);
 }
 
@@ -9,6 +9,7 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <cstdint>
 #include <functional>
 #include <memory>
@@ -34,11 +35,14 @@ namespace detail { struct ImageId {}; }
 using ImageId = boxed::boxed<uint32_t, detail::ImageId>; // unique numerical image identifier
 // clang-format on
 
+/// Counts of the image objects alive, which are created, evicted and destroyed across threads.
 struct ImageStats
 {
-    uint32_t instances = 0;
-    uint32_t rasterized = 0;
-    uint32_t fragments = 0;
+    std::atomic<uint32_t> instances = 0;
+    std::atomic<uint32_t> rasterized = 0;
+    std::atomic<uint32_t> fragments = 0;
+    std::atomic<uint32_t> evicted = 0;
+    std::atomic<uint64_t> bytes = 0; //!< pixel data held by all image instances
 
     static ImageStats& get();
 };
@@ -55,14 +59,15 @@ class Image: public std::enable_shared_from_this<Image>
     ///
     /// @param data      RGBA buffer data
     /// @param pixelSize image dimensionss in pixels
-    Image(ImageId id, ImageFormat format, Data data, ImageSize pixelSize, OnImageRemove remover) noexcept:
+    Image(ImageId id, ImageFormat format, Data data, ImageSize pixelSize, OnImageRemove remover):
         _id { id },
         _format { format },
-        _data { std::move(data) },
+        _data { std::make_shared<Data const>(std::move(data)) },
         _size { pixelSize },
         _onImageRemove { std::move(remover) }
     {
         ++ImageStats::get().instances;
+        ImageStats::get().bytes += _data->size();
     }
 
     ~Image();
@@ -74,15 +79,27 @@ class Image: public std::enable_shared_from_this<Image>
 
     constexpr ImageId id() const noexcept { return _id; }
     constexpr ImageFormat format() const noexcept { return _format; }
-    Data const& data() const noexcept { return _data; }
+    /// @returns the pixel data, or nullptr if it has been evicted.
+    ///
+    /// The data returned stays valid while in use, even if the image is evicted meanwhile.
+    std::shared_ptr<Data const> data() const noexcept { return std::atomic_load(&_data); }
     constexpr ImageSize size() const noexcept { return _size; }
     constexpr Width width() const noexcept { return _size.width; }
     constexpr Height height() const noexcept { return _size.height; }
 
+    /// Tests if the pixel data has been released to save memory, such that only a placeholder
+    /// can be rendered in place of this image.
+    bool evicted() const noexcept { return !data(); }
+
+    /// Releases the pixel data, keeping the image's identity and size.
+    void evict() noexcept;
+
   private:
     ImageId _id;
     ImageFormat _format;
-    Data _data;
+    // Accessed atomically, as images are evicted while fragments of them are being rendered.
+    // Not a std::atomic<std::shared_ptr>, which libc++ does not provide.
+    std::shared_ptr<Data const> _data;
     ImageSize _size;
     OnImageRemove _onImageRemove;
 };
@@ -151,7 +168,8 @@ class RasterizedImage: public std::enable_shared_from_this<RasterizedImage>
     GridSize cellSpan() const noexcept { return _cellSpan; }
     ImageSize cellSize() const noexcept { return _cellSize; }
 
-    /// @returns an RGBA buffer for a grid cell at given coordinate @p pos of the rasterized image.
+    /// @returns an RGBA buffer for a grid cell at given coordinate @p pos of the rasterized image,
+    ///          or a placeholder pattern if the image has been evicted.
     Image::Data fragment(CellLocation pos) const;
 
   private:
@@ -224,17 +242,40 @@ inline bool operator<(ImageFragment const& a, ImageFragment const& b) noexcept
 /// Highlevel Image Storage Pool.
 ///
 /// Stores RGBA images in host memory, also taking care of eviction.
+///
+/// Images with identical pixel data share a single instance, and the pixel data of all images
+/// is kept within a memory budget by evicting the least recently created ones on request.
 class ImagePool
 {
   public:
     using OnImageRemove = std::function<void(Image const*)>;
 
+    /// Default upper limit of the pixel data of all images in the pool, in bytes.
+    static constexpr size_t DefaultMemoryBudget = 256 * 1024 * 1024;
+
     ImagePool(
-        OnImageRemove onImageRemove = [](auto) {}, ImageId nextImageId = ImageId(1));
+        OnImageRemove onImageRemove = [](auto) {},
+        ImageId nextImageId = ImageId(1),
+        size_t memoryBudget = DefaultMemoryBudget);
 
-    /// Creates an RGBA image of given size in pixels.
+    /// Creates an RGBA image of given size in pixels,
+    /// or returns an image with the very same pixel data if that is still in use.
     std::shared_ptr<Image const> create(ImageFormat format, ImageSize pixelSize, Image::Data&& data);
 
+    [[nodiscard]] size_t memoryBudget() const noexcept { return _memoryBudget; }
+    void setMemoryBudget(size_t bytes) noexcept { _memoryBudget = bytes; }
+
+    /// Number of bytes of pixel data held by the images in use that have not been evicted.
+    [[nodiscard]] size_t memoryUsage() const noexcept;
+
+    [[nodiscard]] bool overBudget() const noexcept { return memoryUsage() > _memoryBudget; }
+
+    /// Evicts the pixel data of the least recently created images until the pool fits into its
+    /// memory budget again, skipping the images in @p pinned.
+    ///
+    /// @returns the number of images evicted.
+    size_t evict(std::vector<Image const*> const& pinned);
+
     // named image access
     //
     void link(std::string const& name, std::shared_ptr<Image const> imageRef);
@@ -250,11 +291,19 @@ class ImagePool
 
     using NameToImageIdCache = crispy::strong_lru_cache<std::string, std::shared_ptr<Image const>>;
 
+    struct Entry
+    {
+        size_t contentHash;
+        std::weak_ptr<Image> image;
+    };
+
     // data members
     //
     ImageId _nextImageId;                      //!< ID for next image to be put into the pool
     NameToImageIdCache _imageNameToImageCache; //!< keeps mapping from name to raw image
     OnImageRemove _onImageRemove;              //!< Callback to be invoked when image gets removed from pool.
+    std::vector<Entry> _images;                //!< images created, from least to most recently created
+    size_t _memoryBudget;                      //!< upper limit of the pixel data of all images in bytes
 };
 
 } // namespace vtbackend
@@ -278,11 +327,15 @@ struct fmt::formatter<vtbackend::ImageFormat>: formatter<std::string_view>
 template <>
 struct fmt::formatter<vtbackend::ImageStats>: formatter<std::string>
 {
-    auto format(vtbackend::ImageStats stats, format_context& ctx) -> format_context::iterator
+    auto format(vtbackend::ImageStats const& stats, format_context& ctx) -> format_context::iterator
     {
         return formatter<std::string>::format(
-            fmt::format(
-                "{} instances, {} raster, {} fragments", stats.instances, stats.rasterized, stats.fragments),
+            fmt::format("{} instances, {} raster, {} fragments, {} evicted, {} bytes",
+                        stats.instances.load(),
+                        stats.rasterized.load(),
+                        stats.fragments.load(),
+                        stats.evicted.load(),
+                        stats.bytes.load()),
             ctx);
     }
 };
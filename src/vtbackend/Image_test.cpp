@@ -0,0 +1,88 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/Image.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <vector>
+
+using namespace vtbackend;
+
+namespace
+{
+
+auto constexpr ImageSize2x2 = ImageSize { Width(2), Height(2) };
+
+Image::Data pixels(uint8_t value)
+{
+    return Image::Data(ImageSize2x2.area() * 4, value);
+}
+
+} // namespace
+
+TEST_CASE("ImagePool.deduplicate", "[image]")
+{
+    auto pool = ImagePool {};
+
+    auto const a = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(1));
+    auto const b = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(1));
+    auto const c = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(2));
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(a->id() != c->id());
+    CHECK(pool.memoryUsage() == 2 * pixels(0).size());
+
+    // Same pixel data, but a different shape.
+    auto const d = pool.create(ImageFormat::RGBA, ImageSize { Width(4), Height(1) }, pixels(1));
+    CHECK(d != a);
+}
+
+TEST_CASE("ImagePool.evict", "[image]")
+{
+    auto removed = std::vector<ImageId> {};
+    auto pool = ImagePool { [&](Image const* image) { removed.push_back(image->id()); } };
+    pool.setMemoryBudget(2 * pixels(0).size());
+
+    auto const first = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(1));
+    auto const second = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(2));
+    CHECK(!pool.overBudget());
+
+    auto const third = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(3));
+    REQUIRE(pool.overBudget());
+
+    // The least recently created image that is not pinned goes first.
+    CHECK(pool.evict({ first.get(), third.get() }) == 1);
+    CHECK(!pool.overBudget());
+    CHECK(!first->evicted());
+    CHECK(second->evicted());
+    CHECK(!second->data());
+    CHECK(second->size() == ImageSize2x2);
+    CHECK(removed == std::vector { second->id() });
+
+    // Evicted images are not handed out again.
+    auto const again = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(2));
+    CHECK(again != second);
+    CHECK(!again->evicted());
+}
+
+TEST_CASE("RasterizedImage.placeholder", "[image]")
+{
+    auto constexpr DefaultColor = RGBAColor { 0x10, 0x20, 0x30, 0xFF };
+    auto pool = ImagePool {};
+    pool.setMemoryBudget(0);
+
+    auto const image = pool.create(ImageFormat::RGBA, ImageSize2x2, pixels(0xFF));
+    auto const rasterized = RasterizedImage(
+        image, ImageAlignment::TopStart, ImageResize::NoResize, DefaultColor, GridSize {}, ImageSize2x2);
+    CHECK(rasterized.fragment(CellLocation {}) == pixels(0xFF));
+
+    // Pixel data still in use outlives the eviction.
+    auto const data = image->data();
+    pool.evict({});
+    REQUIRE(image->evicted());
+    CHECK(*data == pixels(0xFF));
+    auto const placeholder = rasterized.fragment(CellLocation {});
+    REQUIRE(placeholder.size() == ImageSize2x2.area() * 4);
+    CHECK(placeholder != pixels(0xFF));
+    CHECK(RGBAColor { placeholder[4], placeholder[5], placeholder[6], placeholder[7] } == DefaultColor);
+}
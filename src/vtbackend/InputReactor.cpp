@@ -0,0 +1,267 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputReactor.h>
+#include <vtbackend/logging.h>
+
+#include <gsl/span>
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#if defined(__linux__)
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+
+    #include <unistd.h>
+#endif
+
+using std::function;
+using std::lock_guard;
+using std::make_shared;
+using std::shared_ptr;
+using std::unique_lock;
+
+namespace vtbackend
+{
+
+namespace
+{
+    /// Event data that identifies the wakeup event, rather than a terminal.
+    constexpr uint64_t WakeupId = 0;
+} // namespace
+
+InputReactor::InputReactor(size_t workerCount)
+{
+#if defined(__linux__)
+    _epollFd = crispy::file_descriptor::from_native(epoll_create1(EPOLL_CLOEXEC));
+    _eventFd = crispy::file_descriptor::from_native(eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK));
+    if (!_epollFd.is_open() || !_eventFd.is_open())
+        throw std::system_error(errno, std::system_category(), "Failed to create input reactor");
+
+    auto event = epoll_event {};
+    event.events = EPOLLIN;
+    event.data.u64 = WakeupId;
+    epoll_ctl(_epollFd.get(), EPOLL_CTL_ADD, _eventFd.get(), &event);
+
+    _poller = std::thread([this]() { poll(); });
+#endif
+
+    _workers.reserve(std::max(workerCount, size_t { 1 }));
+    for (size_t i = 0; i < _workers.capacity(); ++i)
+        _workers.emplace_back([this]() { work(); });
+}
+
+InputReactor::~InputReactor()
+{
+    {
+        auto const _ = lock_guard { _mutex };
+        _stopping = true;
+    }
+    _queueChanged.notify_all();
+
+#if defined(__linux__)
+    uint64_t const value = 1;
+    [[maybe_unused]] auto const rv = ::write(_eventFd.get(), &value, sizeof(value));
+    if (_poller.joinable())
+        _poller.join();
+#endif
+
+    for (auto& worker: _workers)
+        worker.join();
+}
+
+bool InputReactor::supported() noexcept
+{
+#if defined(__linux__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+void InputReactor::add(Terminal& terminal, function<void()> onClosed)
+{
+    auto const _ = lock_guard { _mutex };
+
+    auto entry = make_shared<Entry>();
+    entry->id = _nextId++;
+    entry->terminal = &terminal;
+    entry->onClosed = std::move(onClosed);
+    entry->readinessHandle = terminal.device().readinessHandle();
+    _entries.emplace(entry->id, entry);
+
+#if defined(__linux__)
+    if (entry->readinessHandle)
+    {
+        auto event = epoll_event {};
+        event.events = EPOLLIN | EPOLLONESHOT;
+        event.data.u64 = entry->id;
+        if (epoll_ctl(_epollFd.get(), EPOLL_CTL_ADD, *entry->readinessHandle, &event) < 0)
+            errorLog()("Failed to watch PTY for input. {}", strerror(errno));
+    }
+#endif
+
+    // Process whatever the PTY has got already.
+    enqueue(entry);
+}
+
+void InputReactor::remove(Terminal& terminal)
+{
+    auto lock = unique_lock { _mutex };
+
+    auto const i = std::find_if(
+        _entries.begin(), _entries.end(), [&](auto const& item) { return item.second->terminal == &terminal; });
+    if (i == _entries.end())
+        return;
+
+    auto const entry = i->second;
+    _entries.erase(i);
+    entry->removed = true;
+    unregister(*entry);
+
+    _turnFinished.wait(lock, [&]() { return !entry->running; });
+}
+
+void InputReactor::schedule(Terminal& terminal)
+{
+    auto const _ = lock_guard { _mutex };
+    for (auto const& [id, entry]: _entries)
+        if (entry->terminal == &terminal)
+            enqueue(entry);
+}
+
+size_t InputReactor::terminalCount() const
+{
+    auto const _ = lock_guard { _mutex };
+    return static_cast<size_t>(
+        std::count_if(_entries.begin(), _entries.end(), [](auto const& item) { return !item.second->removed; }));
+}
+
+void InputReactor::enqueue(shared_ptr<Entry> const& entry)
+{
+    if (entry->removed || entry->queued)
+        return;
+
+    if (entry->running)
+    {
+        entry->rerun = true;
+        return;
+    }
+
+    entry->queued = true;
+    _queue.push_back(entry);
+    _queueChanged.notify_one();
+}
+
+void InputReactor::rearm(Entry const& entry) const
+{
+#if defined(__linux__)
+    if (!entry.readinessHandle)
+        return;
+
+    auto event = epoll_event {};
+    event.events = EPOLLIN | EPOLLONESHOT;
+    event.data.u64 = entry.id;
+    if (epoll_ctl(_epollFd.get(), EPOLL_CTL_MOD, *entry.readinessHandle, &event) < 0)
+        errorLog()("Failed to watch PTY for input. {}", strerror(errno));
+#else
+    (void) entry;
+#endif
+}
+
+void InputReactor::unregister(Entry const& entry) const
+{
+#if defined(__linux__)
+    if (entry.readinessHandle)
+        epoll_ctl(_epollFd.get(), EPOLL_CTL_DEL, *entry.readinessHandle, nullptr);
+#else
+    (void) entry;
+#endif
+}
+
+void InputReactor::poll()
+{
+#if defined(__linux__)
+    auto events = std::array<epoll_event, 64> {};
+    for (;;)
+    {
+        auto const count = epoll_wait(_epollFd.get(), events.data(), static_cast<int>(events.size()), -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            errorLog()("Failed to wait for PTY input. {}", strerror(errno));
+            return;
+        }
+
+        auto const _ = lock_guard { _mutex };
+        if (_stopping)
+            return;
+
+        for (auto const& event: gsl::span(events.data(), static_cast<size_t>(count)))
+            if (auto const i = _entries.find(event.data.u64); i != _entries.end())
+                enqueue(i->second);
+    }
+#endif
+}
+
+void InputReactor::work()
+{
+    auto lock = unique_lock { _mutex };
+    for (;;)
+    {
+        _queueChanged.wait(lock, [this]() { return _stopping || !_queue.empty(); });
+        if (_stopping)
+            return;
+
+        auto const entry = std::move(_queue.front());
+        _queue.pop_front();
+        entry->queued = false;
+        if (entry->removed)
+            continue;
+
+        entry->running = true;
+        entry->rerun = false;
+        lock.unlock();
+
+        auto status = Terminal::InputStatus::Idle;
+        try
+        {
+            status = entry->terminal->processAvailableInput(ReadsPerTurn);
+        }
+        catch (std::exception const& e)
+        {
+            errorLog()("Failed to process terminal input. {}", e.what());
+        }
+
+        lock.lock();
+
+        if (status == Terminal::InputStatus::Closed && !entry->removed)
+        {
+            // The turn lasts until onClosed() has returned, so that remove() waits for it.
+            entry->removed = true;
+            unregister(*entry);
+            lock.unlock();
+            if (entry->onClosed)
+                entry->onClosed();
+            lock.lock();
+            _entries.erase(entry->id);
+        }
+
+        entry->running = false;
+        if (entry->removed)
+        {
+            _turnFinished.notify_all();
+            continue;
+        }
+
+        if (status == Terminal::InputStatus::Pending || entry->rerun)
+            enqueue(entry);
+        else
+            rearm(*entry);
+    }
+}
+
+} // namespace vtbackend
@@ -0,0 +1,97 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Terminal.h>
+
+#include <crispy/file_descriptor.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace vtbackend
+{
+
+/// Processes the input of many terminals on a small, shared pool of threads,
+/// rather than on a thread per terminal.
+///
+/// A poller thread waits for the PTYs of all terminals to become readable (see Pty::readinessHandle())
+/// and hands them over to the worker threads, which process the input that is available.
+/// A terminal is processed by one worker at a time, so that its input is processed in order.
+/// A terminal that has more input than it may process in one turn is queued again behind the others.
+class InputReactor
+{
+  public:
+    /// Number of PTY reads a terminal may do before other terminals get their turn.
+    static constexpr size_t ReadsPerTurn = 16;
+
+    explicit InputReactor(size_t workerCount);
+    ~InputReactor();
+
+    InputReactor(InputReactor const&) = delete;
+    InputReactor(InputReactor&&) = delete;
+    InputReactor& operator=(InputReactor const&) = delete;
+    InputReactor& operator=(InputReactor&&) = delete;
+
+    /// Tests whether the PTYs can be waited on by the reactor on this platform.
+    [[nodiscard]] static bool supported() noexcept;
+
+    /// Starts processing the input of the given terminal, until its PTY is closed or remove() is called.
+    ///
+    /// @param onClosed invoked from a worker thread once the PTY has been closed.
+    void add(Terminal& terminal, std::function<void()> onClosed);
+
+    /// Stops processing the input of the given terminal, waiting for a turn in progress to finish.
+    ///
+    /// Must not be called from within the terminal's own turn.
+    void remove(Terminal& terminal);
+
+    /// Queues the given terminal for processing its input, as if its PTY had become readable.
+    ///
+    /// This is how PTYs without a readiness handle, such as mock PTYs, get their input processed.
+    void schedule(Terminal& terminal);
+
+    [[nodiscard]] size_t workerCount() const noexcept { return _workers.size(); }
+    [[nodiscard]] size_t terminalCount() const;
+
+  private:
+    struct Entry
+    {
+        uint64_t id;
+        Terminal* terminal;
+        std::function<void()> onClosed;
+        std::optional<int> readinessHandle;
+        bool queued = false;  // Whether the entry is in the run queue.
+        bool running = false; // Whether a worker is processing the terminal's input.
+        bool rerun = false;   // Whether the terminal got ready again while being processed.
+        bool removed = false;
+    };
+
+    void enqueue(std::shared_ptr<Entry> const& entry);
+    void rearm(Entry const& entry) const;
+    void unregister(Entry const& entry) const;
+    void poll();
+    void work();
+
+    mutable std::mutex _mutex;
+    std::condition_variable _queueChanged;
+    std::condition_variable _turnFinished;
+    std::unordered_map<uint64_t, std::shared_ptr<Entry>> _entries;
+    std::deque<std::shared_ptr<Entry>> _queue;
+    uint64_t _nextId = 1;
+    bool _stopping = false;
+
+    crispy::file_descriptor _epollFd;
+    crispy::file_descriptor _eventFd;
+    std::thread _poller;
+    std::vector<std::thread> _workers;
+};
+
+} // namespace vtbackend
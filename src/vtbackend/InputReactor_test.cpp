@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/InputReactor.h>
+#include <vtbackend/MockTerm.h>
+
+#include <vtpty/MockPty.h>
+#include <vtpty/Pty.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <chrono>
+#include <future>
+#include <string>
+
+using namespace std;
+using namespace std::chrono_literals;
+using namespace vtbackend;
+
+namespace
+{
+bool waitFor(future<void>& closed)
+{
+    return closed.wait_for(5s) == future_status::ready;
+}
+} // namespace
+
+TEST_CASE("InputReactor.mock", "[reactor]")
+{
+    auto reactor = InputReactor { 2 };
+    auto mock = MockTerm { ColumnCount(10), LineCount(2) };
+    mock.mockPty().appendStdOutBuffer("Hello\r\nWorld");
+    mock.mockPty().close();
+
+    auto closedPromise = promise<void> {};
+    auto closed = closedPromise.get_future();
+    reactor.add(mock.terminal, [&]() { closedPromise.set_value(); });
+    REQUIRE(waitFor(closed));
+
+    CHECK(reactor.terminalCount() == 0);
+    CHECK(mock.terminal.primaryScreen().renderMainPageText() == "Hello     \nWorld     \n");
+}
+
+TEST_CASE("InputReactor.remove", "[reactor]")
+{
+    auto reactor = InputReactor { 1 };
+    auto mock = MockTerm { ColumnCount(10), LineCount(2) };
+
+    reactor.add(mock.terminal, []() { FAIL("Terminal must not be reported as closed."); });
+    CHECK(reactor.terminalCount() == 1);
+    reactor.remove(mock.terminal);
+    CHECK(reactor.terminalCount() == 0);
+
+    // Scheduling a removed terminal is a no-op.
+    mock.mockPty().close();
+    reactor.schedule(mock.terminal);
+}
+
+#if defined(__linux__)
+TEST_CASE("InputReactor.pty", "[reactor]")
+{
+    REQUIRE(InputReactor::supported());
+
+    auto const pageSize = PageSize { LineCount(2), ColumnCount(10) };
+    auto settings = Settings {};
+    settings.pageSize = pageSize;
+    auto events = Terminal::NullEvents {};
+    auto terminal = Terminal { events, vtpty::createPty(pageSize, nullopt), settings, {} };
+    terminal.device().start();
+    REQUIRE(terminal.device().readinessHandle().has_value());
+
+    auto reactor = InputReactor { 2 };
+    auto closedPromise = promise<void> {};
+    auto closed = closedPromise.get_future();
+    reactor.add(terminal, [&]() { closedPromise.set_value(); });
+
+    REQUIRE(terminal.device().slave().write("Hello") == 5);
+    terminal.device().slave().close();
+    REQUIRE(waitFor(closed));
+
+    CHECK(reactor.terminalCount() == 0);
+    CHECK(terminal.primaryScreen().renderMainPageText() == "Hello     \n          \n");
+}
+#endif
@@ -7,6 +7,11 @@
 #include <libunicode/utf8.h>
 #include <libunicode/width.h>
 
+#include <atomic>
+#include <iterator>
+#include <limits>
+#include <string_view>
+
 using std::get;
 using std::holds_alternative;
 using std::min;
@@ -27,6 +32,17 @@ typename Line<Cell>::InflatedBuffer Line<Cell>::reflow(ColumnCount newColumnCoun
             case comparison::Less:;
         }
     }
+    else if (isPackedBuffer() && newColumnCount >= packedBuffer().usedColumns)
+    {
+        // All columns that would be cut off are blank fill columns.
+        packedBuffer().displayWidth = newColumnCount;
+        return {};
+    }
+    else if (isSpanBuffer() && newColumnCount >= size())
+    {
+        spanBuffer().resize(newColumnCount);
+        return {};
+    }
     auto& buffer = inflatedBuffer();
     // TODO: Efficiently handle TrivialBuffer-case.
     switch (crispy::strongCompare(newColumnCount, size()))
@@ -91,6 +107,16 @@ inline void Line<Cell>::resize(ColumnCount count)
             buffer.displayWidth = count;
             return;
         }
+        if (isPackedBuffer() && count >= packedBuffer().usedColumns)
+        {
+            packedBuffer().displayWidth = count;
+            return;
+        }
+        if (isSpanBuffer())
+        {
+            spanBuffer().resize(count);
+            return;
+        }
     }
     inflatedBuffer().resize(unbox<size_t>(count));
 }
@@ -119,6 +145,12 @@ std::string Line<Cell>::toUtf8() const
         return str;
     }
 
+    if (isPackedBuffer())
+        return packedBuffer().toUtf8();
+
+    if (isSpanBuffer())
+        return spanBuffer().toUtf8();
+
     std::string str;
     for (Cell const& cell: inflatedBuffer())
     {
@@ -130,6 +162,48 @@ std::string Line<Cell>::toUtf8() const
     return str;
 }
 
+template <typename Cell>
+bool Line<Cell>::pack()
+{
+    if (isPackedBuffer())
+        return true;
+
+    if (isSpanBuffer())
+    {
+        _storage = vtbackend::pack(spanBuffer());
+        _revision = 0;
+        return true;
+    }
+
+    if (!isInflatedBuffer())
+        return false;
+
+    auto packed = vtbackend::pack<Cell>(std::get<InflatedBuffer>(_storage));
+    if (!packed)
+        return false;
+
+    _storage = std::move(*packed);
+    _revision = 0;
+    return true;
+}
+
+template <typename Cell>
+SpanLineBuffer* Line<Cell>::useSpanBuffer()
+{
+    if (auto const* trivial = std::get_if<TrivialBuffer>(&_storage))
+    {
+        auto spans = spanLineBuffer(*trivial);
+        if (!spans)
+            return nullptr;
+        _storage = std::move(*spans);
+    }
+
+    auto* spans = std::get_if<SpanBuffer>(&_storage);
+    if (spans)
+        _revision = 0;
+    return spans;
+}
+
 template <typename Cell>
 std::string Line<Cell>::toUtf8Trimmed() const
 {
@@ -223,10 +297,651 @@ InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input)
 
     return columns;
 }
+
+uint32_t nextLineRevision() noexcept
+{
+    static std::atomic<uint32_t> counter = 0;
+
+    // Skip 0 on wrap-around, as it denotes a line that has not been stamped yet.
+    auto revision = ++counter;
+    while (revision == 0)
+        revision = ++counter;
+    return revision;
+}
+
+// {{{ PackedLineBuffer
+namespace
+{
+    // Returns the offset into PackedLineBuffer::text of the given column's grapheme cluster.
+    size_t packedTextOffset(PackedLineBuffer const& buffer, size_t column) noexcept
+    {
+        auto offset = size_t { 0 };
+        for (size_t i = 0; i < column; ++i)
+            offset += buffer.columns[i].byteCount;
+        return offset;
+    }
+
+    // Tests whether the given UTF-8 encoded grapheme cluster begins the given text,
+    // with the same semantics as CellUtil::beginsWith() for cells.
+    bool packedColumnBeginsWith(std::u32string_view text, std::string_view utf8) noexcept
+    {
+        if (utf8.empty())
+            return false;
+
+        auto utf8DecoderState = unicode::utf8_decoder_state {};
+        auto i = size_t { 0 };
+        for (auto const ch: utf8)
+        {
+            auto const r = unicode::from_utf8(utf8DecoderState, static_cast<uint8_t>(ch));
+            if (!holds_alternative<unicode::Success>(r))
+                continue;
+            if (i == text.size() || text[i] != get<unicode::Success>(r).value)
+                return false;
+            ++i;
+        }
+        return true;
+    }
+} // namespace
+
+bool PackedLineBuffer::empty() const noexcept
+{
+    // Same semantics as CellUtil::empty(): a cell starting with a space is considered empty.
+    auto offset = size_t { 0 };
+    for (Column const& column: columns)
+    {
+        if (column.byteCount != 0 && text[offset] != ' ')
+            return false;
+        offset += column.byteCount;
+    }
+    return true;
+}
+
+bool PackedLineBuffer::cellEmptyAt(ColumnOffset column) const noexcept
+{
+    auto const i = unbox<size_t>(column);
+    if (i >= columns.size() || columns[i].byteCount == 0)
+        return true;
+    return text[packedTextOffset(*this, i)] == ' ';
+}
+
+uint8_t PackedLineBuffer::cellWidthAt(ColumnOffset column) const noexcept
+{
+    auto const i = unbox<size_t>(column);
+    if (i >= columns.size() || columns[i].byteCount == 0)
+        return 1;
+    return columns[i].width;
+}
+
+HyperlinkId PackedLineBuffer::hyperlinkAt(ColumnOffset column) const noexcept
+{
+    auto remaining = unbox<size_t>(column);
+    for (AttributeRun const& run: runs)
+    {
+        if (remaining < run.columnCount)
+            return run.hyperlink;
+        remaining -= run.columnCount;
+    }
+    return HyperlinkId {};
+}
+
+std::string PackedLineBuffer::toUtf8() const
+{
+    auto str = std::string {};
+    str.reserve(text.size() + unbox<size_t>(displayWidth));
+    auto offset = size_t { 0 };
+    for (Column const& column: columns)
+    {
+        if (column.byteCount == 0)
+            str += ' ';
+        else
+            str.append(text, offset, column.byteCount);
+        offset += column.byteCount;
+    }
+    for (auto i = usedColumns; i < displayWidth; ++i)
+        str += ' ';
+    return str;
+}
+
+bool PackedLineBuffer::matchTextAt(std::u32string_view text,
+                                   size_t column,
+                                   size_t textOffset) const noexcept
+{
+    for (size_t i = 0; i < text.size(); ++i, ++column)
+    {
+        // Columns past the used ones are blank fill and thus never match.
+        if (column >= columns.size())
+            return false;
+        auto const byteCount = columns[column].byteCount;
+        if (!packedColumnBeginsWith(text.substr(i), std::string_view(this->text).substr(textOffset, byteCount)))
+            return false;
+        textOffset += byteCount;
+    }
+    return true;
+}
+
+bool PackedLineBuffer::matchTextAt(std::u32string_view text, ColumnOffset startColumn) const noexcept
+{
+    if (text.size() > unbox<size_t>(displayWidth) - unbox<size_t>(startColumn))
+        return false;
+    auto const column = unbox<size_t>(startColumn);
+    return matchTextAt(text, column, packedTextOffset(*this, std::min(column, columns.size())));
+}
+
+std::optional<SearchResult> PackedLineBuffer::search(std::u32string_view text,
+                                                     ColumnOffset startColumn) const noexcept
+{
+    auto const lineSize = unbox<size_t>(displayWidth);
+    if (lineSize < text.size())
+        return std::nullopt; // not found: line is smaller than search term
+
+    auto column = unbox<size_t>(startColumn);
+    auto textOffset = packedTextOffset(*this, std::min(column, columns.size()));
+    for (; column < lineSize; ++column)
+    {
+        if (lineSize - column < text.size())
+        {
+            // Partial match at the right end of the line.
+            text.remove_suffix(text.size() - (lineSize - column));
+            if (matchTextAt(text, column, textOffset))
+                return SearchResult { startColumn, text.size() };
+        }
+        else if (matchTextAt(text, column, textOffset))
+            return SearchResult { ColumnOffset::cast_from(column) };
+
+        if (column < columns.size())
+            textOffset += columns[column].byteCount;
+    }
+
+    return std::nullopt;
+}
+
+std::optional<SearchResult> PackedLineBuffer::searchReverse(std::u32string_view text,
+                                                            ColumnOffset startColumn) const noexcept
+{
+    auto const lineSize = unbox<size_t>(displayWidth);
+    if (lineSize < text.size())
+        return std::nullopt; // not found: line is smaller than search term
+
+    // reverse search from right@column to left until match is complete.
+    auto const firstColumn = std::min(startColumn, ColumnOffset::cast_from(lineSize - text.size()));
+    if (firstColumn >= ColumnOffset(0))
+    {
+        auto column = unbox<size_t>(firstColumn);
+        auto textOffset = packedTextOffset(*this, std::min(column, columns.size()));
+        while (true)
+        {
+            if (matchTextAt(text, column, textOffset))
+                return SearchResult { ColumnOffset::cast_from(column) };
+            if (column == 0)
+                break;
+            --column;
+            if (column < columns.size())
+                textOffset -= columns[column].byteCount;
+        }
+    }
+
+    // Partial match at the left end of the line.
+    for (; !text.empty(); text.remove_prefix(1))
+        if (matchTextAt(text, 0, 0))
+            return SearchResult { startColumn, text.size() };
+
+    return std::nullopt;
+}
+
+template <typename Cell>
+InflatedLineBuffer<Cell> inflate(PackedLineBuffer const& input)
+{
+    auto columns = InflatedLineBuffer<Cell> {};
+    columns.reserve(unbox<size_t>(input.displayWidth));
+    forEachPackedCell<Cell>(input, [&](Cell const& cell) { columns.emplace_back(cell); });
+    return columns;
+}
+
+template <typename Cell>
+std::optional<PackedLineBuffer> pack(InflatedLineBuffer<Cell> const& input)
+{
+    auto const isBlank = [](Cell const& cell) {
+        return cell.codepointCount() == 0 && cell.width() == 1 && !cell.imageFragment();
+    };
+    auto const attributesOf = [](Cell const& cell) {
+        return GraphicsAttributes { cell.foregroundColor(), cell.backgroundColor(), cell.underlineColor(),
+                                    cell.flags() };
+    };
+
+    auto output = PackedLineBuffer {};
+    output.displayWidth = ColumnCount::cast_from(input.size());
+
+    // Trailing blank cells that all share the same attributes are stored as fill.
+    auto usedColumns = input.size();
+    if (!input.empty() && isBlank(input.back()) && !input.back().hyperlink())
+    {
+        output.fillAttributes = attributesOf(input.back());
+        while (usedColumns > 0 && isBlank(input[usedColumns - 1]) && !input[usedColumns - 1].hyperlink()
+               && attributesOf(input[usedColumns - 1]) == output.fillAttributes)
+            --usedColumns;
+    }
+    output.usedColumns = ColumnCount::cast_from(usedColumns);
+    output.columns.reserve(usedColumns);
+    output.text.reserve(usedColumns);
+
+    auto encoder = unicode::encoder<char> {};
+
+    for (size_t i = 0; i < usedColumns; ++i)
+    {
+        Cell const& cell = input[i];
+        if (cell.imageFragment())
+            return std::nullopt;
+
+        auto attributes = attributesOf(cell);
+        auto entry = PackedLineBuffer::Column {};
+        if (cell.codepointCount() != 0)
+        {
+            // Encodes straight into the packed text, rather than via a temporary string per cell.
+            auto const textSize = output.text.size();
+            for (size_t k = 0; k < cell.codepointCount(); ++k)
+                (void) encoder(cell.codepoint(k), std::back_inserter(output.text));
+            auto const byteCount = output.text.size() - textSize;
+            if (byteCount > std::numeric_limits<uint8_t>::max())
+                return std::nullopt;
+            entry.byteCount = static_cast<uint8_t>(byteCount);
+            entry.width = static_cast<uint8_t>(cell.width());
+        }
+        else if (cell.width() != 1)
+            return std::nullopt;
+        else if ((attributes.flags & CellFlag::WideCharContinuation) && !output.runs.empty()
+                 && output.runs.back().hyperlink == cell.hyperlink()
+                 && !(output.runs.back().attributes.flags & CellFlag::WideCharContinuation)
+                 && output.runs.back().attributes.with(CellFlag::WideCharContinuation) == attributes)
+        {
+            // Continuation of a wide character that shares the attributes of the current run.
+            entry.width = 0;
+            attributes = output.runs.back().attributes;
+        }
+        output.columns.emplace_back(entry);
+
+        if (output.runs.empty() || output.runs.back().attributes != attributes
+            || output.runs.back().hyperlink != cell.hyperlink()
+            || output.runs.back().columnCount == std::numeric_limits<uint16_t>::max())
+            output.runs.emplace_back(PackedLineBuffer::AttributeRun { 0, cell.hyperlink(), attributes });
+        ++output.runs.back().columnCount;
+    }
+
+    output.text.shrink_to_fit();
+    output.runs.shrink_to_fit();
+    return output;
+}
+// }}}
+
+// {{{ SpanLineBuffer
+namespace
+{
+    bool sameRendition(SpanLineBuffer::Span const& a, SpanLineBuffer::Span const& b) noexcept
+    {
+        return a.hyperlink == b.hyperlink && a.attributes == b.attributes;
+    }
+
+    bool isBlank(SpanLineBuffer::Column const& column) noexcept
+    {
+        return column.codepoint == 0 && column.width == 1;
+    }
+} // namespace
+
+bool SpanLineBuffer::empty() const noexcept
+{
+    // Same semantics as CellUtil::empty(): a cell starting with a space is considered empty.
+    return std::all_of(columns.begin(), columns.end(), [](Column const& column) {
+        return column.codepoint == 0 || column.codepoint == ' ';
+    });
+}
+
+bool SpanLineBuffer::cellEmptyAt(ColumnOffset column) const noexcept
+{
+    auto const codepoint = columns[unbox<size_t>(column)].codepoint;
+    return codepoint == 0 || codepoint == ' ';
+}
+
+uint8_t SpanLineBuffer::cellWidthAt(ColumnOffset column) const noexcept
+{
+    // A wide character continuation is a cell of width 1, just like in an inflated line.
+    return std::max(columns[unbox<size_t>(column)].width, uint8_t { 1 });
+}
+
+HyperlinkId SpanLineBuffer::hyperlinkAt(ColumnOffset column) const noexcept
+{
+    auto remaining = unbox<size_t>(column);
+    for (Span const& span: spans)
+    {
+        if (remaining < span.columnCount)
+            return span.hyperlink;
+        remaining -= span.columnCount;
+    }
+    return HyperlinkId {};
+}
+
+std::string SpanLineBuffer::toUtf8() const
+{
+    auto str = std::string {};
+    str.reserve(columns.size());
+    auto encoder = unicode::encoder<char> {};
+    for (Column const& column: columns)
+    {
+        if (column.codepoint == 0)
+            str += ' ';
+        else
+            (void) encoder(column.codepoint, std::back_inserter(str));
+    }
+    return str;
+}
+
+bool SpanLineBuffer::matchTextAt(std::u32string_view text, ColumnOffset startColumn) const noexcept
+{
+    auto const start = unbox<size_t>(startColumn);
+    if (text.size() > columns.size() - start)
+        return false;
+    for (size_t i = 0; i < text.size(); ++i)
+        if (columns[start + i].codepoint == 0 || columns[start + i].codepoint != text[i])
+            return false;
+    return true;
+}
+
+void SpanLineBuffer::write(ColumnOffset column,
+                           Column value,
+                           GraphicsAttributes attributes,
+                           HyperlinkId hyperlink)
+{
+    auto const i = unbox<size_t>(column);
+    Require(i < columns.size());
+    columns[i] = value;
+
+    auto const written = Span { 1, hyperlink, attributes };
+    auto start = size_t { 0 };
+    for (size_t k = 0; k < spans.size(); start += spans[k++].columnCount)
+    {
+        auto& span = spans[k];
+        if (i >= start + span.columnCount)
+            continue;
+
+        if (sameRendition(span, written))
+            return;
+
+        // Text written after an SGR change keeps extending the span of the previously written column.
+        if (i == start && k > 0 && sameRendition(spans[k - 1], written))
+        {
+            ++spans[k - 1].columnCount;
+            if (--span.columnCount == 0)
+            {
+                spans.erase(spans.begin() + k);
+                mergeSpanWithPrevious(k);
+            }
+            return;
+        }
+        break;
+    }
+
+    eraseSpans(i, 1);
+    insertSpan(i, written);
+}
+
+void SpanLineBuffer::fill(ColumnOffset start,
+                          ColumnCount count,
+                          Column value,
+                          GraphicsAttributes attributes,
+                          HyperlinkId hyperlink)
+{
+    auto const first = unbox<size_t>(start);
+    auto const n = unbox<size_t>(count);
+    Require(first + n <= columns.size());
+    if (n == 0)
+        return;
+
+    std::fill_n(columns.data() + first, n, value);
+    eraseSpans(first, n);
+    insertSpan(first, Span { static_cast<uint32_t>(n), hyperlink, attributes });
+}
+
+void SpanLineBuffer::insertColumns(
+    ColumnOffset start, ColumnCount count, ColumnOffset end, Column value, GraphicsAttributes attributes)
+{
+    auto const first = unbox<size_t>(start);
+    auto const last = unbox<size_t>(end);
+    Require(first <= last && last <= columns.size());
+    auto const n = std::min(unbox<size_t>(count), last - first);
+    if (n == 0)
+        return;
+
+    auto* const data = columns.data();
+    std::copy_backward(data + first, data + last - n, data + last);
+    std::fill_n(data + first, n, value);
+
+    eraseSpans(last - n, n);
+    insertSpan(first, Span { static_cast<uint32_t>(n), HyperlinkId {}, attributes });
+}
+
+void SpanLineBuffer::deleteColumns(
+    ColumnOffset start, ColumnCount count, ColumnOffset end, Column value, GraphicsAttributes attributes)
+{
+    auto const first = unbox<size_t>(start);
+    auto const last = unbox<size_t>(end);
+    Require(first <= last && last <= columns.size());
+    auto const n = std::min(unbox<size_t>(count), last - first);
+    if (n == 0)
+        return;
+
+    auto* const data = columns.data();
+    std::copy(data + first + n, data + last, data + first);
+    std::fill_n(data + last - n, n, value);
+
+    eraseSpans(first, n);
+    insertSpan(last - n, Span { static_cast<uint32_t>(n), HyperlinkId {}, attributes });
+}
+
+void SpanLineBuffer::copyColumns(SpanLineBuffer const& source, ColumnOffset start, ColumnCount count)
+{
+    auto const first = unbox<size_t>(start);
+    auto const last = first + unbox<size_t>(count);
+    Require(&source != this);
+    Require(last <= columns.size() && last <= source.columns.size());
+    if (first == last)
+        return;
+
+    std::copy(source.columns.data() + first, source.columns.data() + last, columns.data() + first);
+
+    eraseSpans(first, last - first);
+    auto column = first;
+    auto sourceStart = size_t { 0 };
+    for (Span const& span: source.spans)
+    {
+        auto const sourceEnd = sourceStart + span.columnCount;
+        auto const from = std::max(sourceStart, first);
+        auto const to = std::min(sourceEnd, last);
+        if (from < to)
+        {
+            insertSpan(column, Span { static_cast<uint32_t>(to - from), span.hyperlink, span.attributes });
+            column += to - from;
+        }
+        if (sourceEnd >= last)
+            break;
+        sourceStart = sourceEnd;
+    }
+}
+
+void SpanLineBuffer::resize(ColumnCount count)
+{
+    auto const oldSize = columns.size();
+    auto const newSize = unbox<size_t>(count);
+    if (newSize > oldSize)
+        insertSpan(oldSize, Span { static_cast<uint32_t>(newSize - oldSize), HyperlinkId {}, {} });
+    else if (newSize < oldSize)
+        eraseSpans(newSize, oldSize - newSize);
+    columns.resize(newSize);
+}
+
+size_t SpanLineBuffer::splitSpansAt(size_t column)
+{
+    auto start = size_t { 0 };
+    for (size_t i = 0; i < spans.size(); ++i)
+    {
+        if (column == start)
+            return i;
+        auto const end = start + spans[i].columnCount;
+        if (column < end)
+        {
+            auto tail = spans[i];
+            tail.columnCount = static_cast<uint32_t>(end - column);
+            spans[i].columnCount = static_cast<uint32_t>(column - start);
+            spans.insert(spans.begin() + i + 1, tail);
+            return i + 1;
+        }
+        start = end;
+    }
+    return spans.size();
+}
+
+void SpanLineBuffer::eraseSpans(size_t start, size_t count)
+{
+    auto const first = splitSpansAt(start);
+    auto const last = splitSpansAt(start + count);
+    spans.erase(spans.begin() + first, spans.begin() + last);
+    mergeSpanWithPrevious(first);
+}
+
+void SpanLineBuffer::insertSpan(size_t column, Span span)
+{
+    auto const index = splitSpansAt(column);
+    spans.insert(spans.begin() + index, span);
+    mergeSpanWithPrevious(index + 1);
+    mergeSpanWithPrevious(index);
+}
+
+void SpanLineBuffer::mergeSpanWithPrevious(size_t index)
+{
+    if (index == 0 || index >= spans.size() || !sameRendition(spans[index - 1], spans[index]))
+        return;
+    spans[index - 1].columnCount += spans[index].columnCount;
+    spans.erase(spans.begin() + index);
+}
+
+std::optional<SpanLineBuffer> spanLineBuffer(TrivialLineBuffer const& input)
+{
+    static constexpr char32_t ReplacementCharacter { 0xFFFD };
+
+    auto output = SpanLineBuffer {};
+    output.columns.reserve(unbox<size_t>(input.displayWidth));
+
+    auto lastChar = char32_t { 0 };
+    auto utf8DecoderState = unicode::utf8_decoder_state {};
+    for (char const ch: input.text.view())
+    {
+        unicode::ConvertResult const r = unicode::from_utf8(utf8DecoderState, static_cast<uint8_t>(ch));
+        if (holds_alternative<unicode::Incomplete>(r))
+            continue;
+
+        auto const nextChar =
+            holds_alternative<unicode::Success>(r) ? get<unicode::Success>(r).value : ReplacementCharacter;
+        auto const width = unicode::width(nextChar);
+        if (!unicode::grapheme_segmenter::breakable(lastChar, nextChar) || width < 1 || width > 2)
+            return std::nullopt;
+
+        output.columns.emplace_back(SpanLineBuffer::Column { nextChar, static_cast<uint8_t>(width) });
+        if (width == 2)
+            output.columns.emplace_back(SpanLineBuffer::Column { 0, 0 });
+        lastChar = nextChar;
+    }
+
+    auto const usedColumns = output.columns.size();
+    if (usedColumns != unbox<size_t>(input.usedColumns) || usedColumns > unbox<size_t>(input.displayWidth))
+        return std::nullopt;
+
+    output.columns.resize(unbox<size_t>(input.displayWidth));
+    if (usedColumns != 0)
+        output.spans.emplace_back(SpanLineBuffer::Span {
+            static_cast<uint32_t>(usedColumns), input.hyperlink, input.textAttributes });
+    if (auto const fillColumns = output.columns.size() - usedColumns; fillColumns != 0)
+    {
+        auto const fill =
+            SpanLineBuffer::Span { static_cast<uint32_t>(fillColumns), HyperlinkId {}, input.fillAttributes };
+        if (!output.spans.empty() && sameRendition(output.spans.back(), fill))
+            output.spans.back().columnCount += fill.columnCount;
+        else
+            output.spans.emplace_back(fill);
+    }
+    return output;
+}
+
+template <typename Cell>
+InflatedLineBuffer<Cell> inflate(SpanLineBuffer const& input)
+{
+    auto columns = InflatedLineBuffer<Cell> {};
+    columns.reserve(input.columns.size());
+    forEachSpanCell<Cell>(input, [&](Cell const& cell) { columns.emplace_back(cell); });
+    return columns;
+}
+
+PackedLineBuffer pack(SpanLineBuffer const& input)
+{
+    auto output = PackedLineBuffer {};
+    output.displayWidth = input.displayWidth();
+
+    // Trailing blank columns of the last span are stored as fill, unless they carry a hyperlink.
+    auto usedColumns = input.columns.size();
+    if (!input.spans.empty() && !input.spans.back().hyperlink && usedColumns != 0
+        && isBlank(input.columns.back()))
+    {
+        auto const fillStart = usedColumns - input.spans.back().columnCount;
+        output.fillAttributes = input.spans.back().attributes;
+        while (usedColumns > fillStart && isBlank(input.columns[usedColumns - 1]))
+            --usedColumns;
+    }
+    output.usedColumns = ColumnCount::cast_from(usedColumns);
+    output.columns.reserve(usedColumns);
+    output.text.reserve(usedColumns);
+
+    auto encoder = unicode::encoder<char> {};
+
+    auto column = size_t { 0 };
+    for (SpanLineBuffer::Span const& span: input.spans)
+    {
+        for (auto const end = std::min(column + span.columnCount, usedColumns); column < end; ++column)
+        {
+            auto const& entry = input.columns[column];
+            auto packed = PackedLineBuffer::Column { 0, entry.width };
+            if (entry.codepoint != 0)
+            {
+                auto const textSize = output.text.size();
+                (void) encoder(entry.codepoint, std::back_inserter(output.text));
+                packed.byteCount = static_cast<uint8_t>(output.text.size() - textSize);
+            }
+            output.columns.emplace_back(packed);
+
+            if (output.runs.empty() || output.runs.back().attributes != span.attributes
+                || output.runs.back().hyperlink != span.hyperlink
+                || output.runs.back().columnCount == std::numeric_limits<uint16_t>::max())
+                output.runs.emplace_back(
+                    PackedLineBuffer::AttributeRun { 0, span.hyperlink, span.attributes });
+            ++output.runs.back().columnCount;
+        }
+        if (column == usedColumns)
+            break;
+    }
+
+    output.text.shrink_to_fit();
+    output.runs.shrink_to_fit();
+    return output;
+}
+// }}}
+
 } // end namespace vtbackend
 
 #include <vtbackend/cell/CompactCell.h>
 template class vtbackend::Line<vtbackend::CompactCell>;
+template vtbackend::InflatedLineBuffer<vtbackend::CompactCell> vtbackend::inflate<vtbackend::CompactCell>(
+    vtbackend::PackedLineBuffer const&);
+template vtbackend::InflatedLineBuffer<vtbackend::CompactCell> vtbackend::inflate<vtbackend::CompactCell>(
+    vtbackend::SpanLineBuffer const&);
 
 #include <vtbackend/cell/SimpleCell.h>
 template class vtbackend::Line<vtbackend::SimpleCell>;
+template vtbackend::InflatedLineBuffer<vtbackend::SimpleCell> vtbackend::inflate<vtbackend::SimpleCell>(
+    vtbackend::PackedLineBuffer const&);
+template vtbackend::InflatedLineBuffer<vtbackend::SimpleCell> vtbackend::inflate<vtbackend::SimpleCell>(
+    vtbackend::SpanLineBuffer const&);
@@ -12,11 +12,17 @@
 #include <crispy/flags.h>
 
 #include <libunicode/convert.h>
+#include <libunicode/utf8.h>
 
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <algorithm>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 #include <variant>
 #include <vector>
 
@@ -64,6 +70,138 @@ struct TrivialLineBuffer
     }
 };
 
+/**
+ * Compact line storage for arbitrary Unicode text with any number of SGR changes.
+ *
+ * Each used column is described by a 2-byte entry, the text of all non-blank columns
+ * is stored as one UTF-8 string, and the graphics rendition is stored as a list of
+ * runs of columns sharing the same attributes and hyperlink.
+ *
+ * This is the storage used for lines that have been scrolled into the history,
+ * where the lines are read (rendered, searched, copied) but rarely ever mutated.
+ */
+struct PackedLineBuffer
+{
+    struct Column
+    {
+        // Number of UTF-8 bytes of this column's grapheme cluster, or 0 if the column is blank.
+        uint8_t byteCount = 0;
+        // Display width of the grapheme cluster, or 0 if this column is a wide character continuation.
+        uint8_t width = 1;
+    };
+
+    struct AttributeRun
+    {
+        uint16_t columnCount = 0;
+        HyperlinkId hyperlink {};
+        GraphicsAttributes attributes {};
+    };
+
+    ColumnCount displayWidth;
+    GraphicsAttributes fillAttributes {};
+    ColumnCount usedColumns {};
+
+    std::string text {};
+    std::vector<Column> columns {};
+    std::vector<AttributeRun> runs {};
+
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool cellEmptyAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] uint8_t cellWidthAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] HyperlinkId hyperlinkAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] std::string toUtf8() const;
+
+    // Text matching directly on the packed text, with the same semantics as Line<Cell>'s
+    // matchTextAt(), search() and searchReverse() on inflated lines.
+    [[nodiscard]] bool matchTextAt(std::u32string_view text, ColumnOffset startColumn) const noexcept;
+    [[nodiscard]] std::optional<SearchResult> search(std::u32string_view text,
+                                                     ColumnOffset startColumn) const noexcept;
+    [[nodiscard]] std::optional<SearchResult> searchReverse(std::u32string_view text,
+                                                            ColumnOffset startColumn) const noexcept;
+
+  private:
+    [[nodiscard]] bool matchTextAt(std::u32string_view text, size_t column, size_t textOffset) const noexcept;
+};
+
+/**
+ * Mutable line storage for single-codepoint text with any number of SGR changes.
+ *
+ * Each column is a plain, trivially copyable entry of codepoint and display width,
+ * and the graphics rendition is stored as spans of columns sharing the same attributes
+ * and hyperlink, covering the whole line.
+ *
+ * Unlike PackedLineBuffer, this storage is meant to be written to: text is written, inserted,
+ * deleted and copied between lines by moving plain column entries and adjusting the spans,
+ * rather than inflating the line into one Cell per column on the first SGR change.
+ * Lines only stay in this form as long as they hold nothing else, such as grapheme clusters
+ * of more than one codepoint or image fragments.
+ *
+ * @see UseSpanLineBuffers
+ */
+struct SpanLineBuffer
+{
+    struct Column
+    {
+        // The column's codepoint, or 0 if the column is blank.
+        char32_t codepoint = 0;
+        // Display width of the codepoint, or 0 if this column is a wide character continuation.
+        uint8_t width = 1;
+    };
+
+    struct Span
+    {
+        uint32_t columnCount = 0;
+        HyperlinkId hyperlink {};
+        GraphicsAttributes attributes {};
+    };
+
+    std::vector<Column> columns {};
+    std::vector<Span> spans {};
+
+    [[nodiscard]] ColumnCount displayWidth() const noexcept { return ColumnCount::cast_from(columns.size()); }
+    [[nodiscard]] bool empty() const noexcept;
+    [[nodiscard]] bool cellEmptyAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] uint8_t cellWidthAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] HyperlinkId hyperlinkAt(ColumnOffset column) const noexcept;
+    [[nodiscard]] std::string toUtf8() const;
+    [[nodiscard]] bool matchTextAt(std::u32string_view text, ColumnOffset startColumn) const noexcept;
+
+    /// Writes a single column along with its rendition.
+    void write(ColumnOffset column, Column value, GraphicsAttributes attributes, HyperlinkId hyperlink);
+
+    /// Fills @p count columns starting at @p start with the given value and rendition.
+    void fill(ColumnOffset start,
+              ColumnCount count,
+              Column value,
+              GraphicsAttributes attributes,
+              HyperlinkId hyperlink);
+
+    /// Inserts @p count columns of @p value at @p start, shifting the columns up to @p end (exclusive)
+    /// to the right and discarding those shifted beyond @p end.
+    void insertColumns(
+        ColumnOffset start, ColumnCount count, ColumnOffset end, Column value, GraphicsAttributes attributes);
+
+    /// Deletes @p count columns at @p start, shifting the columns up to @p end (exclusive) to the left
+    /// and filling the columns left free in front of @p end with @p value.
+    void deleteColumns(
+        ColumnOffset start, ColumnCount count, ColumnOffset end, Column value, GraphicsAttributes attributes);
+
+    /// Copies @p count columns starting at @p start from @p source into the same columns of this line.
+    void copyColumns(SpanLineBuffer const& source, ColumnOffset start, ColumnCount count);
+
+    /// Resizes the line, with new columns being blank and of default rendition.
+    void resize(ColumnCount count);
+
+  private:
+    // Returns the index of the span starting at the given column, splitting the span containing it.
+    size_t splitSpansAt(size_t column);
+    void eraseSpans(size_t start, size_t count);
+    void insertSpan(size_t column, Span span);
+    void mergeSpanWithPrevious(size_t index);
+};
+
+static_assert(std::is_trivially_copyable_v<SpanLineBuffer::Column>);
+
 template <typename Cell>
 using InflatedLineBuffer = std::vector<Cell>;
 
@@ -71,8 +209,117 @@ using InflatedLineBuffer = std::vector<Cell>;
 template <typename Cell>
 InflatedLineBuffer<Cell> inflate(TrivialLineBuffer const& input);
 
+/// Unpacks a PackedLineBuffer into an InflatedLineBuffer<Cell>.
+template <typename Cell>
+InflatedLineBuffer<Cell> inflate(PackedLineBuffer const& input);
+
+/// Unpacks a SpanLineBuffer into an InflatedLineBuffer<Cell>.
+template <typename Cell>
+InflatedLineBuffer<Cell> inflate(SpanLineBuffer const& input);
+
+/// Packs an InflatedLineBuffer<Cell> into a PackedLineBuffer.
+///
+/// @returns std::nullopt if the cells hold information that cannot be represented
+///          in packed form, such as image fragments.
+template <typename Cell>
+std::optional<PackedLineBuffer> pack(InflatedLineBuffer<Cell> const& input);
+
+/// Packs a SpanLineBuffer into a PackedLineBuffer.
+PackedLineBuffer pack(SpanLineBuffer const& input);
+
+/// Converts a TrivialLineBuffer into a SpanLineBuffer.
+///
+/// @returns std::nullopt if the text holds grapheme clusters of more than one codepoint.
+std::optional<SpanLineBuffer> spanLineBuffer(TrivialLineBuffer const& input);
+
+/// Returns a new, non-zero line revision that has not been handed out before.
+///
+/// @see Line::revision()
+[[nodiscard]] uint32_t nextLineRevision() noexcept;
+
+/// Invokes @p visitor for each cell of the given packed line, without inflating it.
+template <typename Cell, typename Visitor>
+void forEachPackedCell(PackedLineBuffer const& input, Visitor&& visitor)
+{
+    auto column = size_t { 0 };
+    auto textOffset = size_t { 0 };
+    for (PackedLineBuffer::AttributeRun const& run: input.runs)
+    {
+        for (auto const end = column + run.columnCount; column != end; ++column)
+        {
+            auto const& entry = input.columns[column];
+            if (entry.width == 0)
+            {
+                auto const cell = Cell { run.attributes.with(CellFlag::WideCharContinuation), run.hyperlink };
+                visitor(cell);
+                continue;
+            }
+            if (entry.byteCount == 0)
+            {
+                auto const cell = Cell { run.attributes, run.hyperlink };
+                visitor(cell);
+                continue;
+            }
+
+            auto cell = Cell {};
+            auto utf8DecoderState = unicode::utf8_decoder_state {};
+            auto codepointCount = 0;
+            for (auto const ch: std::string_view(input.text).substr(textOffset, entry.byteCount))
+            {
+                auto const r = unicode::from_utf8(utf8DecoderState, static_cast<uint8_t>(ch));
+                if (!std::holds_alternative<unicode::Success>(r))
+                    continue;
+                auto const codepoint = std::get<unicode::Success>(r).value;
+                if (codepointCount++ == 0)
+                    cell.write(run.attributes, codepoint, entry.width, run.hyperlink);
+                else
+                    (void) cell.appendCharacter(codepoint);
+            }
+            cell.setWidth(entry.width);
+            textOffset += entry.byteCount;
+            visitor(std::as_const(cell));
+        }
+    }
+
+    auto const fillCell = Cell { input.fillAttributes };
+    for (; column < unbox<size_t>(input.displayWidth); ++column)
+        visitor(fillCell);
+}
+
+/// Invokes @p visitor for each cell of the given span line, without inflating it.
+template <typename Cell, typename Visitor>
+void forEachSpanCell(SpanLineBuffer const& input, Visitor&& visitor)
+{
+    auto column = size_t { 0 };
+    for (SpanLineBuffer::Span const& span: input.spans)
+    {
+        for (auto const end = column + span.columnCount; column != end; ++column)
+        {
+            auto const& entry = input.columns[column];
+            if (entry.width == 0)
+            {
+                auto const attributes = span.attributes.with(CellFlag::WideCharContinuation);
+                auto const cell = Cell { attributes, span.hyperlink };
+                visitor(cell);
+            }
+            else if (entry.codepoint == 0)
+            {
+                auto const cell = Cell { span.attributes, span.hyperlink };
+                visitor(cell);
+            }
+            else
+            {
+                auto cell = Cell {};
+                cell.write(span.attributes, entry.codepoint, entry.width, span.hyperlink);
+                visitor(std::as_const(cell));
+            }
+        }
+    }
+}
+
 template <typename Cell>
-using LineStorage = std::variant<TrivialLineBuffer, InflatedLineBuffer<Cell>>;
+using LineStorage =
+    std::variant<TrivialLineBuffer, PackedLineBuffer, SpanLineBuffer, InflatedLineBuffer<Cell>>;
 
 /**
  * Line<Cell> API.
@@ -91,6 +338,8 @@ class Line
     Line& operator=(Line&&) noexcept = default;
 
     using TrivialBuffer = TrivialLineBuffer;
+    using PackedBuffer = PackedLineBuffer;
+    using SpanBuffer = SpanLineBuffer;
     using InflatedBuffer = InflatedLineBuffer<Cell>;
     using Storage = LineStorage<Cell>;
     using value_type = Cell;
@@ -100,6 +349,10 @@ class Line
 
     Line(LineFlags flags, TrivialBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
 
+    Line(LineFlags flags, PackedBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
+
+    Line(LineFlags flags, SpanBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
+
     Line(LineFlags flags, InflatedBuffer buffer): _storage { std::move(buffer) }, _flags { flags } {}
 
     void reset(LineFlags flags, GraphicsAttributes attributes) noexcept
@@ -108,7 +361,7 @@ class Line
         if (isTrivialBuffer())
             trivialBuffer().reset(attributes);
         else
-            setBuffer(TrivialBuffer { ColumnCount::cast_from(inflatedBuffer().size()), attributes });
+            setBuffer(TrivialBuffer { size(), attributes });
     }
 
     void reset(LineFlags flags, GraphicsAttributes attributes, ColumnCount count) noexcept
@@ -141,6 +394,12 @@ class Line
         if (isTrivialBuffer())
             return trivialBuffer().text.empty();
 
+        if (isPackedBuffer())
+            return packedBuffer().empty();
+
+        if (isSpanBuffer())
+            return spanBuffer().empty();
+
         for (auto const& cell: inflatedBuffer())
             if (!cell.empty())
                 return false;
@@ -177,6 +436,10 @@ class Line
     {
         if (isTrivialBuffer())
             return trivialBuffer().displayWidth;
+        else if (isPackedBuffer())
+            return packedBuffer().displayWidth;
+        else if (isSpanBuffer())
+            return spanBuffer().displayWidth();
         else
             return ColumnCount::cast_from(inflatedBuffer().size());
     }
@@ -214,6 +477,18 @@ class Line
             return unbox<size_t>(column) >= trivialBuffer().text.size()
                    || trivialBuffer().text[column.as<size_t>()] == 0x20;
         }
+        if (isPackedBuffer())
+        {
+            Require(ColumnOffset(0) <= column);
+            Require(column < ColumnOffset::cast_from(size()));
+            return packedBuffer().cellEmptyAt(column);
+        }
+        if (isSpanBuffer())
+        {
+            Require(ColumnOffset(0) <= column);
+            Require(column < ColumnOffset::cast_from(size()));
+            return spanBuffer().cellEmptyAt(column);
+        }
         return inflatedBuffer().at(unbox<size_t>(column)).empty();
     }
 
@@ -227,6 +502,18 @@ class Line
             return 1; // TODO: When trivial line is to support Unicode, this should be adapted here.
         }
 #endif
+        if (isPackedBuffer())
+        {
+            Require(ColumnOffset(0) <= column);
+            Require(column < ColumnOffset::cast_from(size()));
+            return packedBuffer().cellWidthAt(column);
+        }
+        if (isSpanBuffer())
+        {
+            Require(ColumnOffset(0) <= column);
+            Require(column < ColumnOffset::cast_from(size()));
+            return spanBuffer().cellWidthAt(column);
+        }
         return inflatedBuffer().at(unbox<size_t>(column)).width();
     }
 
@@ -282,7 +569,87 @@ class Line
     [[nodiscard]] InflatedBuffer& inflatedBuffer();
     [[nodiscard]] InflatedBuffer const& inflatedBuffer() const;
 
-    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept { return std::get<TrivialBuffer>(_storage); }
+    // Attempts to store this line in packed form.
+    //
+    // @returns true if the line is now stored as PackedBuffer, false otherwise.
+    bool pack();
+
+    // Returns a reference to this line's span buffer for writing to it.
+    //
+    // A trivial line is converted into a span line first, if its text can be represented as such.
+    //
+    // @returns nullptr if the line is neither stored as SpanBuffer nor could be converted into one.
+    [[nodiscard]] SpanBuffer* useSpanBuffer();
+
+    // Invokes the given visitor for each cell of this line.
+    //
+    // Unlike cells(), this does not inflate a packed or span line.
+    template <typename Visitor>
+    void visitCells(Visitor&& visitor) const
+    {
+        if (isPackedBuffer())
+            forEachPackedCell<Cell>(packedBuffer(), std::forward<Visitor>(visitor));
+        else if (isSpanBuffer())
+            forEachSpanCell<Cell>(spanBuffer(), std::forward<Visitor>(visitor));
+        else
+            for (Cell const& cell: inflatedBuffer())
+                visitor(cell);
+    }
+
+    // Invokes visitor(column, codepoint, width) for each codepoint of each non-blank cell of this line.
+    //
+    // Unlike cells(), this does not inflate a packed or span line.
+    template <typename Visitor>
+    void visitText(Visitor&& visitor) const
+    {
+        if (isPackedBuffer())
+        {
+            auto const& buffer = packedBuffer();
+            auto const* text = buffer.text.data();
+            for (size_t column = 0; column < buffer.columns.size(); ++column)
+            {
+                auto const& entry = buffer.columns[column];
+                auto utf8DecoderState = unicode::utf8_decoder_state {};
+                for (auto const ch: std::string_view(text, entry.byteCount))
+                    if (auto const r = unicode::from_utf8(utf8DecoderState, static_cast<uint8_t>(ch));
+                        std::holds_alternative<unicode::Success>(r))
+                        visitor(column, std::get<unicode::Success>(r).value, entry.width);
+                text += entry.byteCount;
+            }
+        }
+        else if (isSpanBuffer())
+        {
+            auto const& columns = spanBuffer().columns;
+            for (size_t column = 0; column < columns.size(); ++column)
+                if (columns[column].codepoint)
+                    visitor(column, columns[column].codepoint, columns[column].width);
+        }
+        else if (isTrivialBuffer())
+        {
+            auto const text = trivialBuffer().text.view();
+            if (std::any_of(text.begin(), text.end(), [](char ch) { return static_cast<uint8_t>(ch) >= 0x80; }))
+            {
+                Line(_flags, inflate<Cell>(trivialBuffer())).visitText(std::forward<Visitor>(visitor));
+                return;
+            }
+            for (size_t column = 0; column < text.size(); ++column)
+                if (text[column] != ' ')
+                    visitor(column, static_cast<char32_t>(text[column]), uint8_t { 1 });
+        }
+        else
+        {
+            auto const& cells = inflatedBuffer();
+            for (size_t column = 0; column < cells.size(); ++column)
+                for (size_t i = 0; i < cells[column].codepointCount(); ++i)
+                    visitor(column, cells[column].codepoint(i), static_cast<uint8_t>(cells[column].width()));
+        }
+    }
+
+    [[nodiscard]] TrivialBuffer& trivialBuffer() noexcept
+    {
+        _revision = 0;
+        return std::get<TrivialBuffer>(_storage);
+    }
     [[nodiscard]] TrivialBuffer const& trivialBuffer() const noexcept
     {
         return std::get<TrivialBuffer>(_storage);
@@ -292,14 +659,66 @@ class Line
     {
         return std::holds_alternative<TrivialBuffer>(_storage);
     }
-    [[nodiscard]] bool isInflatedBuffer() const noexcept { return !isTrivialBuffer(); }
+    [[nodiscard]] PackedBuffer& packedBuffer() noexcept
+    {
+        _revision = 0;
+        return std::get<PackedBuffer>(_storage);
+    }
+    [[nodiscard]] PackedBuffer const& packedBuffer() const noexcept
+    {
+        return std::get<PackedBuffer>(_storage);
+    }
+
+    [[nodiscard]] bool isPackedBuffer() const noexcept
+    {
+        return std::holds_alternative<PackedBuffer>(_storage);
+    }
+    [[nodiscard]] SpanBuffer& spanBuffer() noexcept
+    {
+        _revision = 0;
+        return std::get<SpanBuffer>(_storage);
+    }
+    [[nodiscard]] SpanBuffer const& spanBuffer() const noexcept { return std::get<SpanBuffer>(_storage); }
+
+    [[nodiscard]] bool isSpanBuffer() const noexcept { return std::holds_alternative<SpanBuffer>(_storage); }
+    [[nodiscard]] bool isInflatedBuffer() const noexcept
+    {
+        return std::holds_alternative<InflatedBuffer>(_storage);
+    }
+
+    void setBuffer(Storage buffer) noexcept
+    {
+        _storage = std::move(buffer);
+        _revision = 0;
+    }
+
+    // Identifies the current contents of this line for incremental rendering.
+    //
+    // Any mutable access to the line's buffer resets the revision to 0, meaning
+    // the line has been (potentially) modified since it was last rendered.
+    // The renderer then assigns a new revision that is unique across all lines,
+    // such that two lines with the same non-zero revision are guaranteed to have the same contents.
+    //
+    // @see Grid::render()
+    [[nodiscard]] uint32_t revision() const noexcept { return _revision; }
 
-    void setBuffer(Storage buffer) noexcept { _storage = std::move(buffer); }
+    // Assigns a new unique revision to this line, if it has been modified since it was last rendered.
+    //
+    // This is render bookkeeping only and thus does not count as a modification of the line.
+    void updateRevision() const noexcept
+    {
+        if (!_revision)
+            _revision = nextLineRevision();
+    }
 
     // Tests if the given text can be matched in this line at the exact given start column.
     [[nodiscard]] bool matchTextAt(std::u32string_view text, ColumnOffset startColumn) const noexcept
     {
-        if (isTrivialBuffer())
+        if (isPackedBuffer())
+            return packedBuffer().matchTextAt(text, startColumn);
+        else if (isSpanBuffer())
+            return spanBuffer().matchTextAt(text, startColumn);
+        else if (isTrivialBuffer())
         {
             auto const u8Text = unicode::convert_to<char>(text);
             TrivialBuffer const& buffer = trivialBuffer();
@@ -338,7 +757,9 @@ class Line
     [[nodiscard]] std::optional<SearchResult> search(std::u32string_view text,
                                                      ColumnOffset startColumn) const noexcept
     {
-        if (isTrivialBuffer())
+        if (isPackedBuffer())
+            return packedBuffer().search(text, startColumn);
+        else if (isTrivialBuffer())
         {
             auto const u8Text = unicode::convert_to<char>(text);
             TrivialBuffer const& buffer = trivialBuffer();
@@ -353,15 +774,16 @@ class Line
         }
         else
         {
-            InflatedBuffer const& buffer = inflatedBuffer();
-            if (buffer.size() < text.size())
+            // Inflated and span lines, which are both matched column by column by matchTextAt().
+            auto const lineSize = unbox<size_t>(size());
+            if (lineSize < text.size())
                 return std::nullopt; // not found: line is smaller than search term
 
             auto baseColumn = startColumn;
-            auto rightMostSearchPosition = ColumnOffset::cast_from(buffer.size());
+            auto rightMostSearchPosition = ColumnOffset::cast_from(lineSize);
             while (baseColumn < rightMostSearchPosition)
             {
-                if (buffer.size() - unbox<size_t>(baseColumn) < text.size())
+                if (lineSize - unbox<size_t>(baseColumn) < text.size())
                 {
                     text.remove_suffix(text.size() - (unbox<size_t>(size()) - unbox<size_t>(baseColumn)));
                     if (matchTextAt(text, baseColumn))
@@ -383,7 +805,9 @@ class Line
     [[nodiscard]] std::optional<SearchResult> searchReverse(std::u32string_view text,
                                                             ColumnOffset startColumn) const noexcept
     {
-        if (isTrivialBuffer())
+        if (isPackedBuffer())
+            return packedBuffer().searchReverse(text, startColumn);
+        else if (isTrivialBuffer())
         {
             auto const u8Text = unicode::convert_to<char>(text);
             TrivialBuffer const& buffer = trivialBuffer();
@@ -399,12 +823,13 @@ class Line
         }
         else
         {
-            InflatedBuffer const& buffer = inflatedBuffer();
-            if (buffer.size() < text.size())
+            // Inflated and span lines, which are both matched column by column by matchTextAt().
+            auto const lineSize = unbox<size_t>(size());
+            if (lineSize < text.size())
                 return std::nullopt; // not found: line is smaller than search term
 
             // reverse search from right@column to left until match is complete.
-            auto baseColumn = std::min(startColumn, ColumnOffset::cast_from(buffer.size() - text.size()));
+            auto baseColumn = std::min(startColumn, ColumnOffset::cast_from(lineSize - text.size()));
             while (baseColumn >= ColumnOffset(0))
             {
                 if (matchTextAt(text, baseColumn))
@@ -424,22 +849,38 @@ class Line
     }
 
   private:
+    // Converts the storage into InflatedBuffer, if not already.
+    [[nodiscard]] InflatedBuffer& inflatedStorage();
+
     Storage _storage;
     LineFlags _flags;
+    mutable uint32_t _revision = 0;
 };
 
 template <typename Cell>
-inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedBuffer()
+inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedStorage()
 {
     if (auto trivialbuffer = std::get_if<TrivialBuffer>(&_storage))
         _storage = inflate<Cell>(*trivialbuffer);
+    else if (auto packedBuffer = std::get_if<PackedBuffer>(&_storage))
+        _storage = inflate<Cell>(*packedBuffer);
+    else if (auto spanBuffer = std::get_if<SpanBuffer>(&_storage))
+        _storage = inflate<Cell>(*spanBuffer);
     return std::get<InflatedBuffer>(_storage);
 }
 
+template <typename Cell>
+inline typename Line<Cell>::InflatedBuffer& Line<Cell>::inflatedBuffer()
+{
+    _revision = 0;
+    return inflatedStorage();
+}
+
 template <typename Cell>
 inline typename Line<Cell>::InflatedBuffer const& Line<Cell>::inflatedBuffer() const
 {
-    return const_cast<Line<Cell>*>(this)->inflatedBuffer();
+    // Changing the representation does not change the contents, so the revision stays valid.
+    return const_cast<Line<Cell>*>(this)->inflatedStorage();
 }
 
 } // namespace vtbackend
@@ -4,6 +4,9 @@
 
 #include <crispy/escape.h>
 
+#include <libunicode/grapheme_segmenter.h>
+#include <libunicode/width.h>
+
 #include <catch2/catch_test_macros.hpp>
 
 using namespace std;
@@ -215,3 +218,390 @@ TEST_CASE("Line.inflate.Unicode.FamilyEmoji", "[Line]")
     REQUIRE(cell.backgroundColor() == fillSGR.backgroundColor);
     REQUIRE(cell.underlineColor() == fillSGR.underlineColor);
 }
+
+namespace
+{
+
+// Builds an inflated line of the given width from UTF-32 text, using one grapheme cluster per
+// cell and continuation cells for wide characters, similar to how Screen writes text.
+InflatedLineBuffer<Cell> makeInflatedLine(ColumnCount width,
+                                          u32string_view text,
+                                          GraphicsAttributes sgr,
+                                          HyperlinkId hyperlink = {})
+{
+    auto cells = InflatedLineBuffer<Cell>(unbox<size_t>(width), Cell { GraphicsAttributes {} });
+    size_t column = 0;
+    auto lastChar = char32_t { 0 };
+    for (auto const codepoint: text)
+    {
+        if (column > 0 && !unicode::grapheme_segmenter::breakable(lastChar, codepoint))
+        {
+            (void) cells[column - 1].appendCharacter(codepoint);
+            continue;
+        }
+        auto const charWidth = static_cast<uint8_t>(unicode::width(codepoint));
+        cells[column].write(sgr, codepoint, charWidth, hyperlink);
+        for (size_t i = 1; i < charWidth; ++i)
+            cells[column + i].reset(sgr.with(CellFlag::WideCharContinuation), hyperlink);
+        column += charWidth;
+        lastChar = codepoint;
+    }
+    return cells;
+}
+
+void requireSameCells(InflatedLineBuffer<Cell> const& expected, InflatedLineBuffer<Cell> const& actual)
+{
+    REQUIRE(expected.size() == actual.size());
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        INFO(fmt::format("column {}", i));
+        CHECK(expected[i].codepoints() == actual[i].codepoints());
+        CHECK(expected[i].width() == actual[i].width());
+        CHECK(expected[i].flags() == actual[i].flags());
+        CHECK(expected[i].foregroundColor() == actual[i].foregroundColor());
+        CHECK(expected[i].backgroundColor() == actual[i].backgroundColor());
+        CHECK(expected[i].underlineColor() == actual[i].underlineColor());
+        CHECK(expected[i].hyperlink() == actual[i].hyperlink());
+    }
+}
+
+} // namespace
+
+TEST_CASE("Line.pack.roundtrip", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(16);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    sgr.flags |= CellFlag::Bold;
+
+    // Accented latin, CJK (wide), a combining character, and an arrow.
+    auto cells = makeInflatedLine(DisplayWidth, U"Ren\u00E9 \u65E5\u672C e\u0301\u2192x", sgr);
+
+    // Second SGR run with a hyperlink.
+    auto sgr2 = GraphicsAttributes {};
+    sgr2.backgroundColor = Color::Indexed(IndexedColor::Yellow);
+    sgr2.underlineColor = Color::Indexed(IndexedColor::Red);
+    sgr2.flags |= CellFlag::CurlyUnderlined;
+    cells[14].write(sgr2, U'!', 1, HyperlinkId(3));
+
+    auto const packed = pack<Cell>(cells);
+    REQUIRE(packed.has_value());
+    CHECK(packed->displayWidth == DisplayWidth);
+    CHECK(packed->usedColumns == ColumnCount(15));
+    CHECK(packed->runs.size() == 3);
+
+    requireSameCells(cells, inflate<Cell>(*packed));
+}
+
+TEST_CASE("Line.pack.image", "[Line]")
+{
+    auto cells = makeInflatedLine(ColumnCount(4), U"ab", GraphicsAttributes {});
+    cells[2].setImageFragment(nullptr, CellLocation {});
+    CHECK(!pack<Cell>(cells).has_value());
+}
+
+TEST_CASE("Line.pack.semantics", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(10);
+    auto const cells =
+        makeInflatedLine(DisplayWidth, U"a\u65E5 e\u0301", GraphicsAttributes {}, HyperlinkId(2));
+
+    auto inflatedLine = Line<Cell>(LineFlag::None, cells);
+    auto packedLine = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(packedLine.pack());
+    REQUIRE(packedLine.isPackedBuffer());
+
+    CHECK(packedLine.size() == inflatedLine.size());
+    CHECK(packedLine.empty() == inflatedLine.empty());
+    CHECK(packedLine.toUtf8() == inflatedLine.toUtf8());
+    for (auto column = ColumnOffset(0); column < boxed_cast<ColumnOffset>(DisplayWidth); ++column)
+    {
+        INFO(fmt::format("column {}", column.value));
+        CHECK(packedLine.cellEmptyAt(column) == inflatedLine.cellEmptyAt(column));
+        CHECK(packedLine.cellWidthAt(column) == inflatedLine.cellWidthAt(column));
+        CHECK(packedLine.packedBuffer().hyperlinkAt(column)
+              == inflatedLine.cells()[column.as<size_t>()].hyperlink());
+    }
+
+    auto const searchResult = packedLine.search(U"\u65E5", ColumnOffset(0));
+    REQUIRE(searchResult.has_value());
+    CHECK(searchResult->column == ColumnOffset(1));
+
+    auto const reverseSearchResult = packedLine.searchReverse(U"a", ColumnOffset(9));
+    REQUIRE(reverseSearchResult.has_value());
+    CHECK(reverseSearchResult->column == ColumnOffset(0));
+
+    CHECK(packedLine.matchTextAt(U"\u65E5", ColumnOffset(1)));
+
+    // Read-only access does not inflate the line.
+    CHECK(packedLine.isPackedBuffer());
+
+    // Resizing within the used columns keeps the line packed.
+    packedLine.resize(ColumnCount(20));
+    CHECK(packedLine.isPackedBuffer());
+    CHECK(packedLine.size() == ColumnCount(20));
+    (void) packedLine.reflow(ColumnCount(6));
+    CHECK(packedLine.isPackedBuffer());
+
+    // Cell mutation inflates the line.
+    packedLine.useCellAt(ColumnOffset(0)).setCharacter(U'b');
+    CHECK(packedLine.isInflatedBuffer());
+    CHECK(packedLine.toUtf8() == unicode::convert_to<char>(U"b\u65E5  e\u0301 "sv));
+}
+
+TEST_CASE("Line.pack.search", "[Line]")
+{
+    // Packed lines are searched on their UTF-8 text, which must yield the same results as on cells.
+    auto constexpr DisplayWidth = ColumnCount(12);
+    auto const cells = makeInflatedLine(DisplayWidth, U"abc\u65E5 abcab\u00E9", GraphicsAttributes {});
+
+    auto const inflatedLine = Line<Cell>(LineFlag::None, cells);
+    auto packedLine = Line<Cell>(LineFlag::None, cells);
+    REQUIRE(packedLine.pack());
+
+    auto const sameResult = [](std::optional<SearchResult> const& a, std::optional<SearchResult> const& b) {
+        return a.has_value() == b.has_value()
+               && (!a || (a->column == b->column && a->partialMatchLength == b->partialMatchLength));
+    };
+
+    for (auto const needle: { U"abc"sv, U"ab\u00E9"sv, U"\u65E5"sv, U"cab"sv, U"\u00E9xyz"sv, U"zabc"sv })
+    {
+        for (auto column = ColumnOffset(0); column < boxed_cast<ColumnOffset>(DisplayWidth); ++column)
+        {
+            INFO(fmt::format("needle \"{}\" at column {}", unicode::convert_to<char>(needle), column.value));
+            CHECK(packedLine.matchTextAt(needle, column) == inflatedLine.matchTextAt(needle, column));
+            CHECK(sameResult(packedLine.search(needle, column), inflatedLine.search(needle, column)));
+            CHECK(sameResult(packedLine.searchReverse(needle, column),
+                             inflatedLine.searchReverse(needle, column)));
+        }
+    }
+
+    CHECK(packedLine.isPackedBuffer());
+}
+
+TEST_CASE("Line.pack.empty", "[Line]")
+{
+    auto sgr = GraphicsAttributes {};
+    sgr.backgroundColor = Color::Indexed(IndexedColor::Blue);
+    auto const cells = InflatedLineBuffer<Cell>(8, Cell { sgr });
+
+    auto const packed = pack<Cell>(cells);
+    REQUIRE(packed.has_value());
+    CHECK(packed->usedColumns == ColumnCount(0));
+    CHECK(packed->fillAttributes == sgr);
+    CHECK(packed->empty());
+    requireSameCells(cells, inflate<Cell>(*packed));
+}
+
+namespace
+{
+
+// Writes text into a span line and an inflated line alike, one codepoint per cell,
+// similar to how Screen writes text into either of them.
+void writeSpanText(SpanLineBuffer& spans,
+                   InflatedLineBuffer<Cell>& cells,
+                   size_t column,
+                   u32string_view text,
+                   GraphicsAttributes sgr,
+                   HyperlinkId hyperlink = {})
+{
+    for (auto const codepoint: text)
+    {
+        auto const charWidth = static_cast<uint8_t>(unicode::width(codepoint));
+        spans.write(ColumnOffset::cast_from(column), { codepoint, charWidth }, sgr, hyperlink);
+        cells[column].write(sgr, codepoint, charWidth, hyperlink);
+        for (size_t i = 1; i < charWidth; ++i)
+        {
+            spans.write(ColumnOffset::cast_from(column + i), { 0, 0 }, sgr, hyperlink);
+            cells[column + i].reset(sgr.with(CellFlag::WideCharContinuation), hyperlink);
+        }
+        column += charWidth;
+    }
+}
+
+} // namespace
+
+TEST_CASE("Line.span.write", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(12);
+
+    auto spans = SpanLineBuffer {};
+    spans.resize(DisplayWidth);
+    auto cells = InflatedLineBuffer<Cell>(unbox<size_t>(DisplayWidth), Cell { GraphicsAttributes {} });
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    sgr.flags |= CellFlag::Bold;
+    auto sgr2 = GraphicsAttributes {};
+    sgr2.backgroundColor = Color::Indexed(IndexedColor::Yellow);
+
+    writeSpanText(spans, cells, 0, U"ab\u65E5", sgr);
+    writeSpanText(spans, cells, 4, U"cd", sgr2, HyperlinkId(3));
+    CHECK(spans.spans.size() == 3);
+    requireSameCells(cells, inflate<Cell>(spans));
+
+    // Overwriting a column with the rendition of the preceding span extends that span.
+    writeSpanText(spans, cells, 4, U"x", sgr);
+    CHECK(spans.spans.size() == 3);
+    CHECK(spans.spans[0].columnCount == 5);
+    requireSameCells(cells, inflate<Cell>(spans));
+
+    // Writing into the middle of a span splits it.
+    writeSpanText(spans, cells, 1, U"y", sgr2);
+    CHECK(spans.spans.size() == 5);
+    requireSameCells(cells, inflate<Cell>(spans));
+}
+
+TEST_CASE("Line.span.editing", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(10);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    auto fillSgr = GraphicsAttributes {};
+    fillSgr.backgroundColor = Color::Indexed(IndexedColor::Blue);
+
+    auto spans = SpanLineBuffer {};
+    spans.resize(DisplayWidth);
+    auto cells = InflatedLineBuffer<Cell>(unbox<size_t>(DisplayWidth), Cell { GraphicsAttributes {} });
+    writeSpanText(spans, cells, 0, U"abcdefgh", sgr, HyperlinkId(2));
+
+    SECTION("insertColumns")
+    {
+        spans.insertColumns(ColumnOffset(2), ColumnCount(3), ColumnOffset(8), { U' ', 1 }, fillSgr);
+        std::rotate(cells.begin() + 2, cells.begin() + 5, cells.begin() + 8);
+        for (size_t i = 2; i < 5; ++i)
+            cells[i].write(fillSgr, U' ', 1, HyperlinkId {});
+        requireSameCells(cells, inflate<Cell>(spans));
+    }
+
+    SECTION("deleteColumns")
+    {
+        spans.deleteColumns(ColumnOffset(1), ColumnCount(2), ColumnOffset(9), { U' ', 1 }, fillSgr);
+        std::rotate(cells.begin() + 1, cells.begin() + 3, cells.begin() + 9);
+        for (size_t i = 7; i < 9; ++i)
+            cells[i].write(fillSgr, U' ', 1, HyperlinkId {});
+        requireSameCells(cells, inflate<Cell>(spans));
+    }
+
+    SECTION("copyColumns")
+    {
+        auto source = SpanLineBuffer {};
+        source.resize(DisplayWidth);
+        auto sourceCells = InflatedLineBuffer<Cell>(unbox<size_t>(DisplayWidth), Cell { fillSgr });
+        source.fill(ColumnOffset(0), DisplayWidth, {}, fillSgr, {});
+        writeSpanText(source, sourceCells, 3, U"\u65E5z", sgr);
+
+        spans.copyColumns(source, ColumnOffset(2), ColumnCount(5));
+        // Copy-assigning a cell keeps its hyperlink if the source has none, hence the temporaries.
+        for (size_t i = 2; i < 7; ++i)
+            cells[i] = Cell(sourceCells[i]);
+        requireSameCells(cells, inflate<Cell>(spans));
+    }
+
+    SECTION("resize")
+    {
+        spans.resize(ColumnCount(5));
+        cells.resize(5);
+        requireSameCells(cells, inflate<Cell>(spans));
+
+        spans.resize(ColumnCount(7));
+        cells.resize(7, Cell { GraphicsAttributes {} });
+        requireSameCells(cells, inflate<Cell>(spans));
+    }
+
+    SECTION("pack")
+    {
+        spans.fill(ColumnOffset(8), ColumnCount(2), {}, fillSgr, {});
+        auto const packed = pack(spans);
+        CHECK(packed.usedColumns == ColumnCount(8));
+        CHECK(packed.fillAttributes == fillSgr);
+        requireSameCells(inflate<Cell>(spans), inflate<Cell>(packed));
+    }
+}
+
+TEST_CASE("Line.span.trivial", "[Line]")
+{
+    auto constexpr TestText = "ab\xE6\x97\xA5x"sv; // "ab", a wide character, and "x"
+    auto pool = buffer_object_pool<char>(16);
+    auto bufferObject = pool.allocateBufferObject();
+    bufferObject->writeAtEnd(TestText);
+
+    auto sgr = GraphicsAttributes {};
+    sgr.foregroundColor = RGBColor(0x123456);
+    auto fillSgr = GraphicsAttributes {};
+    fillSgr.backgroundColor = Color::Indexed(IndexedColor::Blue);
+    auto const trivial = TrivialLineBuffer {
+        ColumnCount(8), sgr, fillSgr, HyperlinkId(1), ColumnCount(5), bufferObject->ref(0, TestText.size())
+    };
+
+    auto const spans = spanLineBuffer(trivial);
+    REQUIRE(spans.has_value());
+    CHECK(spans->spans.size() == 2);
+    requireSameCells(inflate<Cell>(trivial), inflate<Cell>(*spans));
+
+    // Grapheme clusters of more than one codepoint cannot be represented by a span line.
+    auto constexpr CombiningText = "e\xCC\x81"sv; // "e" followed by a combining acute accent
+    auto combiningBufferObject = pool.allocateBufferObject();
+    combiningBufferObject->writeAtEnd(CombiningText);
+    auto const combining = TrivialLineBuffer { ColumnCount(8),
+                                               sgr,
+                                               fillSgr,
+                                               HyperlinkId {},
+                                               ColumnCount(1),
+                                               combiningBufferObject->ref(0, CombiningText.size()) };
+    CHECK(!spanLineBuffer(combining).has_value());
+
+    auto line = Line<Cell>(LineFlag::None, combining);
+    CHECK(line.useSpanBuffer() == nullptr);
+    CHECK(line.isTrivialBuffer());
+}
+
+TEST_CASE("Line.span.semantics", "[Line]")
+{
+    auto constexpr DisplayWidth = ColumnCount(12);
+
+    auto spans = SpanLineBuffer {};
+    spans.resize(DisplayWidth);
+    auto cells = InflatedLineBuffer<Cell>(unbox<size_t>(DisplayWidth), Cell { GraphicsAttributes {} });
+    auto sgr = GraphicsAttributes {};
+    sgr.flags |= CellFlag::Italic;
+    writeSpanText(spans, cells, 0, U"abc\u65E5 abcab", sgr, HyperlinkId(2));
+
+    auto const inflatedLine = Line<Cell>(LineFlag::None, cells);
+    auto spanLine = Line<Cell>(LineFlag::None, spans);
+
+    CHECK(spanLine.size() == inflatedLine.size());
+    CHECK(spanLine.empty() == inflatedLine.empty());
+    CHECK(spanLine.toUtf8() == inflatedLine.toUtf8());
+
+    auto const sameResult = [](std::optional<SearchResult> const& a, std::optional<SearchResult> const& b) {
+        return a.has_value() == b.has_value()
+               && (!a || (a->column == b->column && a->partialMatchLength == b->partialMatchLength));
+    };
+
+    for (auto column = ColumnOffset(0); column < boxed_cast<ColumnOffset>(DisplayWidth); ++column)
+    {
+        INFO(fmt::format("column {}", column.value));
+        CHECK(spanLine.cellEmptyAt(column) == inflatedLine.cellEmptyAt(column));
+        CHECK(spanLine.cellWidthAt(column) == inflatedLine.cellWidthAt(column));
+        CHECK(spanLine.spanBuffer().hyperlinkAt(column)
+              == inflatedLine.cells()[column.as<size_t>()].hyperlink());
+        for (auto const needle: { U"abc"sv, U"\u65E5"sv, U"cab"sv, U"zabc"sv })
+        {
+            CHECK(spanLine.matchTextAt(needle, column) == inflatedLine.matchTextAt(needle, column));
+            CHECK(sameResult(spanLine.search(needle, column), inflatedLine.search(needle, column)));
+            CHECK(sameResult(spanLine.searchReverse(needle, column),
+                             inflatedLine.searchReverse(needle, column)));
+        }
+    }
+
+    // Read-only access does not inflate the line.
+    CHECK(spanLine.isSpanBuffer());
+
+    // Lines scrolled into the history are packed.
+    REQUIRE(spanLine.pack());
+    CHECK(spanLine.isPackedBuffer());
+    CHECK(spanLine.toUtf8() == inflatedLine.toUtf8());
+}
@@ -92,6 +92,8 @@ class MockTerm: public Terminal::NullEvents
     {
         terminal.primaryScreen().captureBuffer(lines, logical);
     }
+
+    void requestMetrics(MetricsRequest request) override { terminal.executeMetricsRequest(request); }
 };
 
 template <typename PtyDevice>
@@ -0,0 +1,110 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtbackend/Grid.h>
+#include <vtbackend/Line.h>
+#include <vtbackend/primitives.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Copy of the lines visible on a grid's page.
+ *
+ * The snapshot is taken while holding the terminal lock, and can then be rendered
+ * after the lock has been released, while the grid keeps being mutated.
+ *
+ * Lines are retained across updates and only copied again if their revision changed,
+ * so that taking a snapshot costs as much as copying the lines that changed since the last one.
+ *
+ * @see Line::revision()
+ */
+template <typename Cell>
+class PageSnapshot
+{
+  public:
+    /// Updates the snapshot to the lines visible on the given grid at the given scroll offset.
+    void update(Grid<Cell> const& grid, ScrollOffset scrollOffset);
+
+    /// Renders the snapshot's lines, just like Grid::render() would have rendered them at update time.
+    template <typename RendererT>
+    [[nodiscard]] RenderPassHints render(RendererT&& render) const;
+
+    [[nodiscard]] std::vector<Line<Cell>> const& lines() const noexcept { return _lines; }
+
+  private:
+    [[nodiscard]] Line<Cell>* takePrevious(uint32_t revision) noexcept;
+
+    std::vector<Line<Cell>> _lines;
+
+    // Lines of the previous snapshot while updating, and their revisions (0 once taken).
+    std::vector<Line<Cell>> _previousLines;
+    std::vector<uint32_t> _previousRevisions;
+    size_t _previousHint = 0;
+};
+
+template <typename Cell>
+void PageSnapshot<Cell>::update(Grid<Cell> const& grid, ScrollOffset scrollOffset)
+{
+    std::swap(_lines, _previousLines);
+    _lines.clear();
+
+    _previousRevisions.clear();
+    for (auto const& line: _previousLines)
+        _previousRevisions.push_back(line.revision());
+    _previousHint = 0;
+
+    auto const top = -boxed_cast<LineOffset>(scrollOffset);
+    auto const bottom = top + boxed_cast<LineOffset>(grid.pageSize().lines);
+    for (auto y = top; y < bottom; ++y)
+    {
+        auto const& line = grid.lineAt(y);
+        line.updateRevision();
+        if (auto* previous = takePrevious(line.revision()))
+            _lines.emplace_back(std::move(*previous));
+        else
+            _lines.emplace_back(line);
+    }
+
+    _previousLines.clear();
+}
+
+template <typename Cell>
+Line<Cell>* PageSnapshot<Cell>::takePrevious(uint32_t revision) noexcept
+{
+    auto const take = [&](size_t i) {
+        _previousRevisions[i] = 0;
+        _previousHint = i + 1;
+        return &_previousLines[i];
+    };
+
+    // When the page scrolls, consecutive lines are found at consecutive positions of the previous snapshot.
+    if (_previousHint < _previousRevisions.size() && _previousRevisions[_previousHint] == revision)
+        return take(_previousHint);
+
+    for (size_t i = 0; i < _previousRevisions.size(); ++i)
+        if (_previousRevisions[i] == revision)
+            return take(i);
+
+    return nullptr;
+}
+
+template <typename Cell>
+template <typename RendererT>
+RenderPassHints PageSnapshot<Cell>::render(RendererT&& render) const // NOLINT(*-missing-std-forward)
+{
+    auto hints = RenderPassHints {};
+    auto y = LineOffset(0);
+    for (auto const& line: _lines)
+    {
+        Grid<Cell>::renderLine(render, line, y, HighlightSearchMatches::No, hints);
+        ++y;
+    }
+    render.finish();
+    return hints;
+}
+
+} // namespace vtbackend
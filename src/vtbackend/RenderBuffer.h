@@ -3,6 +3,7 @@
 
 #include <vtbackend/CellFlags.h>
 #include <vtbackend/Color.h>
+#include <vtbackend/ColorPalette.h>
 #include <vtbackend/Grid.h>
 #include <vtbackend/Image.h>
 #include <vtbackend/primitives.h>
@@ -13,8 +14,11 @@
 
 #include <atomic>
 #include <chrono>
+#include <limits>
 #include <mutex>
 #include <optional>
+#include <string>
+#include <string_view>
 #include <vector>
 
 namespace vtbackend
@@ -31,11 +35,21 @@ struct RenderAttributes
 /**
  * Renderable representation of a grid cell with color-altering pre-applied and
  * additional information for cell ranges that can be text-shaped together.
+ *
+ * The cell's grapheme cluster and image fragment are owned by the RenderBuffer
+ * the cell belongs to, so that a RenderCell itself never allocates.
+ *
+ * @see RenderBuffer::codepointsOf()
+ * @see RenderBuffer::imageOf()
  */
 struct RenderCell
 {
-    std::u32string codepoints;
-    std::shared_ptr<ImageFragment> image;
+    // NOLINTNEXTLINE(readability-identifier-naming)
+    static constexpr uint32_t NoImage = std::numeric_limits<uint32_t>::max();
+
+    uint32_t codepointOffset = 0;  ///< Offset of the grapheme cluster in RenderBuffer::codepoints.
+    uint32_t codepointCount = 0;   ///< Number of codepoints of the grapheme cluster.
+    uint32_t imageIndex = NoImage; ///< Index into RenderBuffer::images, or NoImage.
     CellLocation position;
     RenderAttributes attributes;
     uint8_t width = 1;
@@ -57,6 +71,57 @@ struct RenderLine
     RenderAttributes fillAttributes;
 };
 
+/**
+ * Bookkeeping of a single main display line within a RenderBuffer.
+ *
+ * Records the ranges of the RenderBuffer that have been produced for the given
+ * screen line, such that the next frame can copy them over if the grid line did
+ * not change in between.
+ *
+ * @see Line::revision()
+ */
+struct RenderRow
+{
+    uint32_t revision = 0;    ///< Revision of the grid line this row has been rendered from.
+    LineOffset lineOffset {}; ///< Screen line offset, relative to the main display.
+    uint32_t cellsBegin = 0;
+    uint32_t cellsEnd = 0;
+    uint32_t linesBegin = 0;
+    uint32_t linesEnd = 0;
+    uint32_t codepointsBegin = 0;
+    uint32_t codepointsEnd = 0;
+    uint32_t imagesBegin = 0;
+    uint32_t imagesEnd = 0;
+    bool reusable = true;         ///< False if the row depends on more than the line's contents.
+    bool reused = false;          ///< Whether the row has been copied from the previous frame.
+    bool blinking = false;        ///< Whether or not the row contains blinking cells.
+    bool blinkState = false;      ///< Slow blink state the row has been rendered with.
+    bool rapidBlinkState = false; ///< Rapid blink state the row has been rendered with.
+};
+
+/**
+ * Terminal state that affects the rendering of every line on the main display.
+ *
+ * Rows of a previous frame can only be reused if this state did not change in between.
+ */
+struct RenderPageState
+{
+    uint64_t redrawGeneration = 0;
+    bool primaryScreen = true;
+    PageSize pageSize {};
+    LineOffset baseLine {};
+    bool reverseVideo = false;
+    ColorPalette::Palette palette {};
+    RGBColor defaultForeground {};
+    RGBColor defaultForegroundBright {};
+    RGBColor defaultForegroundDimmed {};
+    RGBColor defaultBackground {};
+    RGBColor hyperlinkDecoration {};
+    bool useBrightColors = false;
+
+    bool operator==(RenderPageState const&) const noexcept = default;
+};
+
 struct RenderCursor
 {
     CellLocation position;
@@ -71,11 +136,99 @@ struct RenderBuffer
     std::optional<RenderCursor> cursor {};
     uint64_t frameID {};
 
+    /// Codepoints of all grapheme clusters of this frame, referenced by RenderCell.
+    std::u32string codepoints {};
+
+    /// Image fragments of this frame, referenced by RenderCell::imageIndex.
+    std::vector<std::shared_ptr<ImageFragment>> images {};
+
+    /// Main display lines of this frame, in screen order.
+    std::vector<RenderRow> rows {};
+
+    /// State the rows of this frame have been rendered with,
+    /// or std::nullopt if they must not be reused by the next frame.
+    std::optional<RenderPageState> pageState {};
+
+    /// Contents of a previously rendered frame.
+    struct Frame
+    {
+        std::vector<RenderCell> cells {};
+        std::vector<RenderLine> lines {};
+        std::u32string codepoints {};
+        std::vector<std::shared_ptr<ImageFragment>> images {};
+        std::vector<RenderRow> rows {};
+
+        void clear()
+        {
+            cells.clear();
+            lines.clear();
+            codepoints.clear();
+            images.clear();
+            rows.clear();
+        }
+    };
+
+    /// The frame previously held by this buffer while it is being refreshed incrementally.
+    ///
+    /// @see clearForReuse()
+    Frame previous {};
+
+    [[nodiscard]] std::u32string_view codepointsOf(RenderCell const& cell) const noexcept
+    {
+        return std::u32string_view(codepoints.data() + cell.codepointOffset, cell.codepointCount);
+    }
+
+    [[nodiscard]] ImageFragment const* imageOf(RenderCell const& cell) const noexcept
+    {
+        if (cell.imageIndex == RenderCell::NoImage)
+            return nullptr;
+        return images[cell.imageIndex].get();
+    }
+
+    /// Assigns the given grapheme cluster to the given cell.
+    void setCodepoints(RenderCell& cell, std::u32string_view graphemeCluster)
+    {
+        cell.codepointOffset = static_cast<uint32_t>(codepoints.size());
+        cell.codepointCount = static_cast<uint32_t>(graphemeCluster.size());
+        codepoints.append(graphemeCluster);
+    }
+
+    /// Assigns the given image fragment to the given cell.
+    void setImage(RenderCell& cell, std::shared_ptr<ImageFragment> image)
+    {
+        cell.imageIndex = static_cast<uint32_t>(images.size());
+        images.emplace_back(std::move(image));
+    }
+
+    /// Resets the buffer for the next frame, retaining all allocated capacity.
     void clear()
     {
         cells.clear();
         lines.clear();
+        codepoints.clear();
+        images.clear();
+        rows.clear();
+        cursor.reset();
+        pageState.reset();
+        previous.clear();
+    }
+
+    /// Resets the buffer for the next frame, moving the current frame's contents into previous,
+    /// such that rows of unchanged lines can be copied over rather than being rendered again.
+    void clearForReuse()
+    {
+        std::swap(cells, previous.cells);
+        std::swap(lines, previous.lines);
+        std::swap(codepoints, previous.codepoints);
+        std::swap(images, previous.images);
+        std::swap(rows, previous.rows);
+        cells.clear();
+        lines.clear();
+        codepoints.clear();
+        images.clear();
+        rows.clear();
         cursor.reset();
+        pageState.reset();
     }
 };
 
@@ -120,6 +273,7 @@ constexpr std::string_view to_string(RenderBufferState state) noexcept
 struct RenderDoubleBuffer
 {
     std::mutex mutable readerLock;
+    std::mutex writerLock; // Serializes refreshing the back buffer.
     std::atomic<size_t> currentBackBufferIndex = 0;
     std::array<RenderBuffer, 2> buffers {};
     std::atomic<RenderBufferState> state = RenderBufferState::WaitingForRefresh;
@@ -10,6 +10,8 @@
 #include <libunicode/convert.h>
 #include <libunicode/utf8_grapheme_segmenter.h>
 
+#include <algorithm>
+
 using namespace std;
 
 namespace vtbackend
@@ -110,7 +112,8 @@ RenderBufferBuilder<Cell>::RenderBufferBuilder(Terminal const& terminal,
                                                HighlightSearchMatches highlightSearchMatches,
                                                InputMethodData inputMethodData,
                                                optional<CellLocation> theCursorPosition,
-                                               bool includeSelection):
+                                               bool includeSelection,
+                                               bool trackRows):
     _output { &output },
     _terminal { &terminal },
     _cursorPosition { theCursorPosition },
@@ -118,14 +121,52 @@ RenderBufferBuilder<Cell>::RenderBufferBuilder(Terminal const& terminal,
     _reverseVideo { theReverseVideo },
     _highlightSearchMatches { highlightSearchMatches },
     _inputMethodData { std::move(inputMethodData) },
-    _includeSelection { includeSelection }
+    _includeSelection { includeSelection },
+    _trackRows { trackRows },
+    _colorPalette { terminal.colorPalette() },
+    _pageSize { terminal.pageSize() },
+    _scrollOffset { terminal.viewport().scrollOffset() },
+    _screenCursorLine { terminal.currentScreen().cursor().position.line },
+    _blinkState { terminal.blinkState() },
+    _rapidBlinkState { terminal.rapidBlinkState() }
 {
     output.frameID = terminal.lastFrameID();
 
+    if (_cursorPosition && terminal.inputHandler().mode() != ViMode::Insert)
+        _viCursorLine = terminal.viewport().translateGridToScreenCoordinate(_cursorPosition->line);
+
     if (_cursorPosition)
         output.cursor = renderCursor();
 }
 
+template <typename Cell>
+void RenderBufferBuilder<Cell>::detach()
+{
+    _hyperlinks.clear();
+    for (auto const& href: _terminal->state().hyperlinks.cache)
+        _hyperlinks.push_back(href.key);
+    std::sort(_hyperlinks.begin(), _hyperlinks.end());
+    _detached = true;
+}
+
+template <typename Cell>
+optional<HyperlinkState> RenderBufferBuilder<Cell>::hyperlinkStateOf(HyperlinkId id) const noexcept
+{
+    if (!id)
+        return nullopt;
+
+    if (_detached)
+    {
+        if (std::binary_search(_hyperlinks.begin(), _hyperlinks.end(), id))
+            return HyperlinkState::Inactive;
+        return nullopt;
+    }
+
+    if (auto href = _terminal->state().hyperlinks.hyperlinkById(id))
+        return href->state;
+    return nullopt;
+}
+
 template <typename Cell>
 optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor() const
 {
@@ -149,8 +190,9 @@ optional<RenderCursor> RenderBufferBuilder<Cell>::renderCursor() const
 }
 
 template <typename Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                             u32string graphemeCluster,
+RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(RenderBuffer& output,
+                                                             ColorPalette const& colorPalette,
+                                                             u32string_view graphemeCluster,
                                                              ColumnCount width,
                                                              CellFlags flags,
                                                              RGBColor fg,
@@ -167,12 +209,13 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const&
     renderCell.position.line = line;
     renderCell.position.column = column;
     renderCell.width = unbox<uint8_t>(width);
-    renderCell.codepoints = std::move(graphemeCluster);
+    output.setCodepoints(renderCell, graphemeCluster);
     return renderCell;
 }
 
 template <typename Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const& colorPalette,
+RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(RenderBuffer& output,
+                                                             ColorPalette const& colorPalette,
                                                              char32_t codepoint,
                                                              CellFlags flags,
                                                              RGBColor fg,
@@ -190,13 +233,14 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCellExplicit(ColorPalette const&
     renderCell.position.column = column;
     renderCell.width = 1;
     if (codepoint)
-        renderCell.codepoints.push_back(codepoint);
+        output.setCodepoints(renderCell, u32string_view(&codepoint, 1));
     return renderCell;
 }
 
 template <typename Cell>
-RenderCell RenderBufferBuilder<Cell>::makeRenderCell(ColorPalette const& colorPalette,
-                                                     HyperlinkStorage const& hyperlinks,
+RenderCell RenderBufferBuilder<Cell>::makeRenderCell(RenderBuffer& output,
+                                                     ColorPalette const& colorPalette,
+                                                     optional<HyperlinkState> hyperlinkState,
                                                      Cell const& screenCell,
                                                      RGBColor fg,
                                                      RGBColor bg,
@@ -212,28 +256,39 @@ RenderCell RenderBufferBuilder<Cell>::makeRenderCell(ColorPalette const& colorPa
     renderCell.position.column = column;
     renderCell.width = screenCell.width();
 
-    if (screenCell.codepointCount() != 0)
+    if (auto const codepointCount = screenCell.codepointCount(); codepointCount != 0)
     {
-        for (size_t i = 0; i < screenCell.codepointCount(); ++i)
-            renderCell.codepoints.push_back(screenCell.codepoint(i));
+        renderCell.codepointOffset = static_cast<uint32_t>(output.codepoints.size());
+        renderCell.codepointCount = static_cast<uint32_t>(codepointCount);
+        for (size_t i = 0; i < codepointCount; ++i)
+            output.codepoints.push_back(screenCell.codepoint(i));
     }
 
-    renderCell.image = screenCell.imageFragment();
+    if (auto image = screenCell.imageFragment())
+        output.setImage(renderCell, std::move(image));
+
+    decorateHyperlink(renderCell, colorPalette, hyperlinkState);
+
+    return renderCell;
+}
 
-    if (auto href = hyperlinks.hyperlinkById(screenCell.hyperlink()))
+template <typename Cell>
+void RenderBufferBuilder<Cell>::decorateHyperlink(RenderCell& renderCell,
+                                                  ColorPalette const& colorPalette,
+                                                  optional<HyperlinkState> hyperlinkState) noexcept
+{
+    if (hyperlinkState)
     {
-        auto const& color = href->state == HyperlinkState::Hover ? colorPalette.hyperlinkDecoration.hover
-                                                                 : colorPalette.hyperlinkDecoration.normal;
+        auto const& color = *hyperlinkState == HyperlinkState::Hover ? colorPalette.hyperlinkDecoration.hover
+                                                                     : colorPalette.hyperlinkDecoration.normal;
         // TODO(decoration): Move property into Terminal.
         auto const decoration =
-            href->state == HyperlinkState::Hover
+            *hyperlinkState == HyperlinkState::Hover
                 ? CellFlag::Underline              // TODO: decorationRenderer_.hyperlinkHover()
                 : CellFlag::DottedUnderline;       // TODO: decorationRenderer_.hyperlinkNormal();
         renderCell.attributes.flags |= decoration; // toCellStyle(decoration);
         renderCell.attributes.decorationColor = color;
     }
-
-    return renderCell;
 }
 
 template <typename Cell>
@@ -254,11 +309,9 @@ RGBColorPair RenderBufferBuilder<Cell>::makeColorsForCell(CellLocation gridPosit
     auto const selected =
         _includeSelection && _terminal->isSelected(CellLocation { gridPosition.line, gridPosition.column });
     auto const highlighted =
-        _terminal->isHighlighted(CellLocation { gridPosition.line, gridPosition.column });
-    auto const blink = _terminal->blinkState();
-    auto const rapidBlink = _terminal->rapidBlinkState();
+        !_detached && _terminal->isHighlighted(CellLocation { gridPosition.line, gridPosition.column });
 
-    return makeColors(_terminal->colorPalette(),
+    return makeColors(_colorPalette,
                       cellFlags,
                       _reverseVideo,
                       foregroundColor,
@@ -267,8 +320,8 @@ RGBColorPair RenderBufferBuilder<Cell>::makeColorsForCell(CellLocation gridPosit
                       paintCursor,
                       _useCursorlineColoring,
                       highlighted,
-                      blink,
-                      rapidBlink);
+                      _blinkState,
+                      _rapidBlinkState);
 }
 
 template <typename Cell>
@@ -283,7 +336,7 @@ RenderAttributes RenderBufferBuilder<Cell>::createRenderAttributes(
     renderAttributes.foregroundColor = fg;
     renderAttributes.backgroundColor = bg;
     renderAttributes.decorationColor = CellUtil::makeUnderlineColor(
-        _terminal->colorPalette(), fg, graphicsAttributes.underlineColor, graphicsAttributes.flags);
+        _colorPalette, fg, graphicsAttributes.underlineColor, graphicsAttributes.flags);
     renderAttributes.flags = graphicsAttributes.flags;
     return renderAttributes;
 }
@@ -293,11 +346,11 @@ RenderLine RenderBufferBuilder<Cell>::createRenderLine(TrivialLineBuffer const&
                                                        LineOffset lineOffset) const
 {
     auto const pos = CellLocation { lineOffset, ColumnOffset(0) };
-    auto const gridPosition = _terminal->viewport().translateScreenToGridCoordinate(pos);
+    auto const gridPosition = translateScreenToGridCoordinate(pos);
     auto renderLine = RenderLine {};
     renderLine.lineOffset = lineOffset;
     renderLine.usedColumns = lineBuffer.usedColumns;
-    renderLine.displayWidth = _terminal->pageSize().columns;
+    renderLine.displayWidth = _pageSize.columns;
     renderLine.text = lineBuffer.text.view();
     renderLine.textAttributes = createRenderAttributes(gridPosition, lineBuffer.textAttributes);
     renderLine.fillAttributes = createRenderAttributes(gridPosition, lineBuffer.fillAttributes);
@@ -308,17 +361,128 @@ RenderLine RenderBufferBuilder<Cell>::createRenderLine(TrivialLineBuffer const&
 template <typename Cell>
 bool RenderBufferBuilder<Cell>::gridLineContainsCursor(LineOffset lineOffset) const noexcept
 {
-    if (_terminal->currentScreen().cursor().position.line == lineOffset)
-        return true;
+    return _screenCursorLine == lineOffset || _viCursorLine == lineOffset;
+}
+
+template <typename Cell>
+bool RenderBufferBuilder<Cell>::reuseLine(Line<Cell> const& line, LineOffset lineOffset, RenderPassHints& hints)
+{
+    if (!_trackRows)
+        return false;
+
+    closeRow();
+
+    auto& row = _output->rows.emplace_back();
+    row.revision = line.revision();
+    row.lineOffset = lineOffset;
+    row.cellsBegin = static_cast<uint32_t>(_output->cells.size());
+    row.linesBegin = static_cast<uint32_t>(_output->lines.size());
+    row.codepointsBegin = static_cast<uint32_t>(_output->codepoints.size());
+    row.imagesBegin = static_cast<uint32_t>(_output->images.size());
+    row.blinkState = _blinkState;
+    row.rapidBlinkState = _rapidBlinkState;
+
+    // Lines showing a cursor are colored by more than just their contents.
+    row.reusable = !gridLineContainsCursor(lineOffset) && !isCursorLine(lineOffset);
+    if (!row.reusable)
+        return false;
+
+    auto const* source = findPreviousRow(row.revision);
+    if (!source)
+        return false;
+
+    if (source->blinking
+        && (source->blinkState != row.blinkState || source->rapidBlinkState != row.rapidBlinkState))
+        return false;
+
+    // Trivial lines are referenced by text, which requires the line to still be stored in trivial form.
+    if (source->linesBegin != source->linesEnd && !line.isTrivialBuffer())
+        return false;
+
+    copyRow(*source, line);
+    hints.containsBlinkingCells = hints.containsBlinkingCells || source->blinking;
+    return true;
+}
+
+template <typename Cell>
+RenderRow const* RenderBufferBuilder<Cell>::findPreviousRow(uint32_t revision) noexcept
+{
+    auto const& rows = _output->previous.rows;
+
+    // When the screen scrolls, consecutive lines are found at consecutive rows of the previous frame.
+    if (_previousRowHint < rows.size() && rows[_previousRowHint].revision == revision
+        && rows[_previousRowHint].reusable)
+        return &rows[_previousRowHint++];
+
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        if (rows[i].revision == revision && rows[i].reusable)
+        {
+            _previousRowHint = i + 1;
+            return &rows[i];
+        }
+    }
+
+    return nullptr;
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::copyRow(RenderRow const& source, Line<Cell> const& line)
+{
+    auto const& previous = _output->previous;
+    auto& row = _output->rows.back();
+
+    // Offsets are rebased using modular arithmetic, which is well defined for unsigned integers.
+    auto const lineDelta = row.lineOffset - source.lineOffset;
+    auto const codepointsDelta = row.codepointsBegin - source.codepointsBegin;
+    auto const imagesDelta = row.imagesBegin - source.imagesBegin;
 
-    if (_cursorPosition && _terminal->state().inputHandler.mode() != ViMode::Insert)
+    for (auto i = source.cellsBegin; i != source.cellsEnd; ++i)
     {
-        auto const viCursor = _terminal->viewport().translateGridToScreenCoordinate(_cursorPosition->line);
-        if (viCursor == lineOffset)
-            return true;
+        auto& cell = _output->cells.emplace_back(previous.cells[i]);
+        cell.position.line += lineDelta;
+        cell.codepointOffset += codepointsDelta;
+        if (cell.imageIndex != RenderCell::NoImage)
+            cell.imageIndex += imagesDelta;
     }
 
-    return false;
+    for (auto i = source.linesBegin; i != source.linesEnd; ++i)
+    {
+        auto& renderLine = _output->lines.emplace_back(previous.lines[i]);
+        renderLine.lineOffset = row.lineOffset;
+        renderLine.text = line.trivialBuffer().text.view();
+    }
+
+    _output->codepoints.append(
+        previous.codepoints, source.codepointsBegin, source.codepointsEnd - source.codepointsBegin);
+    _output->images.insert(_output->images.end(),
+                           previous.images.begin() + source.imagesBegin,
+                           previous.images.begin() + source.imagesEnd);
+
+    row.blinking = source.blinking;
+    row.reused = true;
+    closeRow();
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::closeRow() noexcept
+{
+    if (!_trackRows || _output->rows.empty())
+        return;
+
+    auto& row = _output->rows.back();
+    row.cellsEnd = static_cast<uint32_t>(_output->cells.size());
+    row.linesEnd = static_cast<uint32_t>(_output->lines.size());
+    row.codepointsEnd = static_cast<uint32_t>(_output->codepoints.size());
+    row.imagesEnd = static_cast<uint32_t>(_output->images.size());
+}
+
+template <typename Cell>
+void RenderBufferBuilder<Cell>::trackBlinking(CellFlags flags) noexcept
+{
+    if (_trackRows && !_output->rows.empty()
+        && ((flags & CellFlag::Blinking) || (flags & CellFlag::RapidBlinking)))
+        _output->rows.back().blinking = true;
 }
 
 template <typename Cell>
@@ -335,6 +499,9 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
     // No need to call isCursorLine(lineOffset) because lines containing a cursor are always inflated.
     _useCursorlineColoring = false;
 
+    trackBlinking(lineBuffer.textAttributes.flags);
+    trackBlinking(lineBuffer.fillAttributes.flags);
+
     auto const frontIndex = _output->cells.size();
 
     // Visual selection can alter colors for some columns in this line.
@@ -346,7 +513,7 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
     // We're not testing for cursor shape (which should be done in order to be 100% correct)
     // because it's not really draining performance.
     bool const canRenderViaSimpleLine =
-        (!_terminal->isSelected(lineOffset) || !_includeSelection) && !gridLineContainsCursor(lineOffset);
+        (!_includeSelection || !_terminal->isSelected(lineOffset)) && !gridLineContainsCursor(lineOffset);
 
     if (canRenderViaSimpleLine)
     {
@@ -357,12 +524,11 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
         return;
     }
 
-    auto const textMargin = min(boxed_cast<ColumnOffset>(_terminal->pageSize().columns),
-                                ColumnOffset::cast_from(lineBuffer.usedColumns));
-    auto const pageColumnsEnd = boxed_cast<ColumnOffset>(_terminal->pageSize().columns);
+    auto const textMargin =
+        min(boxed_cast<ColumnOffset>(_pageSize.columns), ColumnOffset::cast_from(lineBuffer.usedColumns));
+    auto const pageColumnsEnd = boxed_cast<ColumnOffset>(_pageSize.columns);
 
     // render text
-    _searchPatternOffset = 0;
     renderUtf8Text(CellLocation { lineOffset, ColumnOffset(0) },
                    lineBuffer.textAttributes,
                    lineBuffer.text.view(),
@@ -372,10 +538,11 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
     for (auto columnOffset = textMargin; columnOffset < pageColumnsEnd; ++columnOffset)
     {
         auto const pos = CellLocation { lineOffset, columnOffset };
-        auto const gridPosition = _terminal->viewport().translateScreenToGridCoordinate(pos);
+        auto const gridPosition = translateScreenToGridCoordinate(pos);
         auto renderAttributes = createRenderAttributes(gridPosition, lineBuffer.fillAttributes);
 
-        _output->cells.emplace_back(makeRenderCellExplicit(_terminal->colorPalette(),
+        _output->cells.emplace_back(makeRenderCellExplicit(*_output,
+                                                           _colorPalette,
                                                            char32_t { 0 },
                                                            lineBuffer.fillAttributes.flags,
                                                            renderAttributes.foregroundColor,
@@ -393,87 +560,115 @@ void RenderBufferBuilder<Cell>::renderTrivialLine(TrivialLineBuffer const& lineB
 }
 
 template <typename Cell>
-template <typename T>
-void RenderBufferBuilder<Cell>::matchSearchPattern(T const& cellText)
+void RenderBufferBuilder<Cell>::renderSpanLine(SpanLineBuffer const& lineBuffer, LineOffset lineOffset)
 {
-    if (_highlightSearchMatches == HighlightSearchMatches::No)
-        return;
+    // The cursor and the selection color individual columns, in which case the colors of a span
+    // cannot be shared by all of its columns.
+    bool const perColumnColors = (_includeSelection && _terminal->isSelected(lineOffset))
+                                 || gridLineContainsCursor(lineOffset) || isCursorLine(lineOffset);
 
-    auto const& searchMode = _terminal->state().searchMode;
-    if (searchMode.pattern.empty())
-        return;
+    startLine(lineOffset);
 
-    auto const isFullMatch = [&]() -> bool {
-        if constexpr (std::is_same_v<Cell, T>)
-        {
-            return !CellUtil::beginsWith(u32string_view(searchMode.pattern.data() + _searchPatternOffset,
-                                                        searchMode.pattern.size() - _searchPatternOffset),
-                                         cellText);
-        }
-        else
+    auto const frontIndex = _output->cells.size();
+    auto column = ColumnOffset(0);
+    for (SpanLineBuffer::Span const& span: lineBuffer.spans)
+    {
+        if (span.columnCount == 0)
+            continue;
+
+        auto const& attributes = span.attributes;
+        auto const colorsAt = [&](CellLocation gridPosition) {
+            return makeColorsForCell(
+                gridPosition, attributes.flags, attributes.foregroundColor, attributes.backgroundColor);
+        };
+        auto const hyperlinkState = hyperlinkStateOf(span.hyperlink);
+        auto const spanStart = translateScreenToGridCoordinate(CellLocation { lineOffset, column });
+        auto const spanHighlighted = !_detached && _terminal->isHighlighted(spanStart);
+        auto const spanColors = perColumnColors ? RGBColorPair {} : colorsAt(spanStart);
+
+        trackBlinking(attributes.flags);
+
+        for (auto const end = column + ColumnOffset::cast_from(span.columnCount); column != end; ++column)
         {
-            return crispy::beginsWith(u32string_view(searchMode.pattern.data() + _searchPatternOffset,
-                                                     searchMode.pattern.size() - _searchPatternOffset),
-                                      cellText);
+            auto const& entry = lineBuffer.columns[unbox<size_t>(column)];
+            auto const screenPosition = CellLocation { lineOffset, column };
+            auto const gridPosition = translateScreenToGridCoordinate(screenPosition);
+
+            if (perColumnColors && tryRenderInputMethodEditor(screenPosition, gridPosition))
+                continue;
+
+            auto const highlighted = !_detached && _terminal->isHighlighted(gridPosition);
+            auto const [fg, bg] =
+                perColumnColors || highlighted != spanHighlighted ? colorsAt(gridPosition) : spanColors;
+
+            auto const width = std::max(entry.width, uint8_t { 1 });
+            if (perColumnColors)
+            {
+                _prevWidth = width;
+                _prevHasCursor = _cursorPosition && gridPosition == *_cursorPosition;
+            }
+
+            auto const flags =
+                entry.width == 0 ? attributes.flags | CellFlag::WideCharContinuation : attributes.flags;
+            auto& cell = _output->cells.emplace_back(makeRenderCellExplicit(*_output,
+                                                                            _colorPalette,
+                                                                            entry.codepoint,
+                                                                            flags,
+                                                                            fg,
+                                                                            bg,
+                                                                            attributes.underlineColor,
+                                                                            _baseLine + lineOffset,
+                                                                            column));
+            cell.width = width;
+            decorateHyperlink(cell, _colorPalette, hyperlinkState);
+            highlightSearchMatch(gridPosition);
         }
-    }();
-
-    if (isFullMatch)
-    {
-        // match fail
-        _searchPatternOffset = 0;
-        return;
     }
 
-    if constexpr (std::is_same_v<Cell, T>)
-        _searchPatternOffset += cellText.codepointCount();
-    else
-        _searchPatternOffset += cellText.size();
-
-    if (_searchPatternOffset < searchMode.pattern.size())
-        return; // match incomplete
+    if (_output->cells.size() != frontIndex)
+        _output->cells[frontIndex].groupStart = true;
+    endLine();
+}
 
-    // match complete
+template <typename Cell>
+void RenderBufferBuilder<Cell>::highlightSearchMatch(CellLocation gridPosition)
+{
+    if (_highlightSearchMatches == HighlightSearchMatches::No || _detached)
+        return;
 
-    auto const offsetIntoFront = _output->cells.size() - _searchPatternOffset;
+    // Cells are rendered from top to bottom and left to right, and the matches are sorted likewise.
+    auto const& matches = _terminal->visibleSearchMatches();
+    while (_searchMatchIndex < matches.size() && matches[_searchMatchIndex].second < gridPosition)
+        ++_searchMatchIndex;
+    if (_searchMatchIndex == matches.size() || gridPosition < matches[_searchMatchIndex].first)
+        return;
 
     auto const isFocusedMatch =
-        CellLocationRange {
-            _output->cells[offsetIntoFront].position,
-            _output->cells.back().position,
-        }
-            .contains(_terminal->viewport().translateGridToScreenCoordinate(
-                _terminal->state().viCommands.cursorPosition));
+        matches[_searchMatchIndex].contains(_terminal->state().viCommands.cursorPosition);
 
     auto highlightColors = [&]() -> CellRGBColorAndAlphaPair {
-        // Oh yeah, this can be optimized :)
         if (isFocusedMatch)
         {
             if (_terminal->state().searchMode.initiatedByDoubleClick)
-                return _terminal->colorPalette().wordHighlightCurrent;
+                return _colorPalette.wordHighlightCurrent;
             else
-                return _terminal->colorPalette().searchHighlightFocused;
+                return _colorPalette.searchHighlightFocused;
         }
         else
         {
             if (_terminal->state().searchMode.initiatedByDoubleClick)
-                return _terminal->colorPalette().wordHighlight;
+                return _colorPalette.wordHighlight;
             else
-                return _terminal->colorPalette().searchHighlight;
+                return _colorPalette.searchHighlight;
         }
     }();
 
-    for (size_t i = offsetIntoFront; i < _output->cells.size(); ++i)
-    {
-        auto& cellAttributes = _output->cells[i].attributes;
-        auto const actualColors =
-            RGBColorPair { cellAttributes.foregroundColor, cellAttributes.backgroundColor };
-        auto const searchMatchColors = makeRGBColorPair(actualColors, highlightColors);
+    auto& cellAttributes = _output->cells.back().attributes;
+    auto const actualColors = RGBColorPair { cellAttributes.foregroundColor, cellAttributes.backgroundColor };
+    auto const searchMatchColors = makeRGBColorPair(actualColors, highlightColors);
 
-        cellAttributes.backgroundColor = searchMatchColors.background;
-        cellAttributes.foregroundColor = searchMatchColors.foreground;
-    }
-    _searchPatternOffset = 0;
+    cellAttributes.backgroundColor = searchMatchColors.background;
+    cellAttributes.foregroundColor = searchMatchColors.foreground;
 }
 
 template <typename Cell>
@@ -489,11 +684,7 @@ void RenderBufferBuilder<Cell>::startLine(LineOffset line) noexcept
 template <typename Cell>
 bool RenderBufferBuilder<Cell>::isCursorLine(LineOffset line) const noexcept
 {
-    return _terminal->inputHandler().mode() != ViMode::Insert && _cursorPosition
-           && line
-                  == _terminal->viewport()
-                         .translateGridToScreenCoordinate(CellLocation { _cursorPosition->line, {} })
-                         .line;
+    return _viCursorLine == line;
 }
 
 template <typename Cell>
@@ -516,8 +707,8 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
     auto graphemeClusterSegmenter = unicode::utf8_grapheme_segmenter(text);
     for (u32string const& graphemeCluster: graphemeClusterSegmenter)
     {
-        auto const gridPosition = _terminal->viewport().translateScreenToGridCoordinate(
-            screenPosition + ColumnOffset::cast_from(columnCountRendered));
+        auto const gridPosition =
+            translateScreenToGridCoordinate(screenPosition + ColumnOffset::cast_from(columnCountRendered));
         auto const [fg, bg] = makeColorsForCell(gridPosition,
                                                 textAttributes.flags,
                                                 textAttributes.foregroundColor,
@@ -530,7 +721,8 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
         //            unicode::convert_to<char>(u32string_view(graphemeCluster)));
 
         _output->cells.emplace_back(
-            makeRenderCellExplicit(_terminal->colorPalette(),
+            makeRenderCellExplicit(*_output,
+                                   _colorPalette,
                                    graphemeCluster,
                                    width,
                                    textAttributes.flags,
@@ -539,12 +731,15 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
                                    textAttributes.underlineColor,
                                    _baseLine + screenPosition.line,
                                    screenPosition.column + ColumnOffset::cast_from(columnCountRendered)));
+        if (allowMatchSearchPattern)
+            highlightSearchMatch(gridPosition);
 
         // Span filling cells for preciding wide glyphs to get the background color properly painted.
         for (auto i = ColumnCount(1); i < width; ++i)
         {
             _output->cells.emplace_back(makeRenderCellExplicit(
-                _terminal->colorPalette(),
+                *_output,
+                _colorPalette,
                 U" ", // {}
                 ColumnCount(1),
                 textAttributes.flags,
@@ -553,15 +748,14 @@ ColumnCount RenderBufferBuilder<Cell>::renderUtf8Text(CellLocation screenPositio
                 textAttributes.underlineColor,
                 _baseLine + screenPosition.line,
                 screenPosition.column + ColumnOffset::cast_from(columnCountRendered + i)));
+            if (allowMatchSearchPattern)
+                highlightSearchMatch(gridPosition + ColumnOffset::cast_from(i));
         }
 
         columnCountRendered += ColumnCount::cast_from(width);
         _lineNr = screenPosition.line;
         _prevWidth = 0;
         _prevHasCursor = false;
-
-        if (allowMatchSearchPattern)
-            matchSearchPattern(u32string_view(graphemeCluster));
     }
     return columnCountRendered;
 }
@@ -573,7 +767,7 @@ bool RenderBufferBuilder<Cell>::tryRenderInputMethodEditor(CellLocation screenPo
     // Render IME preeditString if available and screen position matches cursor position.
     if (_cursorPosition && gridPosition == *_cursorPosition && !_inputMethodData.preeditString.empty())
     {
-        auto const inputMethodEditorStyles = _terminal->colorPalette().inputMethodEditor;
+        auto const inputMethodEditorStyles = _colorPalette.inputMethodEditor;
         auto textAttributes = GraphicsAttributes {};
         textAttributes.foregroundColor = inputMethodEditorStyles.foreground;
         textAttributes.backgroundColor = inputMethodEditorStyles.background;
@@ -605,7 +799,7 @@ template <typename Cell>
 void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset line, ColumnOffset column)
 {
     auto const screenPosition = CellLocation { line, column };
-    auto const gridPosition = _terminal->viewport().translateScreenToGridCoordinate(screenPosition);
+    auto const gridPosition = translateScreenToGridCoordinate(screenPosition);
 
     if (tryRenderInputMethodEditor(screenPosition, gridPosition))
         return;
@@ -616,8 +810,11 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset li
     _prevWidth = screenCell.width();
     _prevHasCursor = _cursorPosition && gridPosition == *_cursorPosition;
 
-    _output->cells.emplace_back(makeRenderCell(_terminal->colorPalette(),
-                                               _terminal->state().hyperlinks,
+    trackBlinking(screenCell.flags());
+
+    _output->cells.emplace_back(makeRenderCell(*_output,
+                                               _colorPalette,
+                                               hyperlinkStateOf(screenCell.hyperlink()),
                                                screenCell,
                                                fg,
                                                bg,
@@ -627,7 +824,7 @@ void RenderBufferBuilder<Cell>::renderCell(Cell const& screenCell, LineOffset li
     if (column == ColumnOffset(0))
         _output->cells.back().groupStart = true;
 
-    matchSearchPattern(screenCell);
+    highlightSearchMatch(gridPosition);
 }
 
 } // namespace vtbackend
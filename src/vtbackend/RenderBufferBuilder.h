@@ -27,15 +27,17 @@ class RenderBufferBuilder
                         HighlightSearchMatches highlightSearchMatches,
                         InputMethodData inputMethodData,
                         std::optional<CellLocation> theCursorPosition,
-                        bool includeSelection);
+                        bool includeSelection,
+                        bool trackRows = false);
 
     /// Renders a single grid cell.
     /// This call is guaranteed to be invoked sequencially, from top line
     /// to the bottom line and from left page margin to the right page margin,
     /// for every non-trivial line.
-    /// A trivial line is rendered using renderTrivialLine().
+    /// A trivial line is rendered using renderTrivialLine(), and a span line using renderSpanLine().
     ///
     /// @see renderTrivialLine
+    /// @see renderSpanLine
     void renderCell(Cell const& cell, LineOffset line, ColumnOffset column);
     void startLine(LineOffset line) noexcept;
     void endLine() noexcept;
@@ -50,16 +52,44 @@ class RenderBufferBuilder
     /// @see renderCell
     void renderTrivialLine(TrivialLineBuffer const& lineBuffer, LineOffset lineOffset);
 
+    /// Renders a span line.
+    ///
+    /// The colors of each span are computed once for all of its columns, unless the line
+    /// shows the cursor or a selection, in which case they are computed column by column.
+    ///
+    /// @see renderCell
+    void renderSpanLine(SpanLineBuffer const& lineBuffer, LineOffset lineOffset);
+
+    /// Attempts to reuse the rendered contents of the given line from the previous frame.
+    ///
+    /// This call is invoked for every line, before the line is rendered via renderCell()
+    /// or renderTrivialLine(), and only has an effect if row tracking is enabled.
+    ///
+    /// @returns true if the line's contents have been copied over from RenderBuffer::previous,
+    ///          in which case the line must not be rendered again, false otherwise.
+    [[nodiscard]] bool reuseLine(Line<Cell> const& line, LineOffset lineOffset, RenderPassHints& hints);
+
     /// This call is guaranteed to be invoked when the the full page has been rendered.
-    void finish() noexcept {}
+    void finish() noexcept { closeRow(); }
+
+    /// Captures the remaining terminal state needed for rendering, such that the lines can be
+    /// rendered after the terminal lock has been released.
+    ///
+    /// This must be invoked while still holding the terminal lock, and may only be used if the page
+    /// is not decorated by a selection, search matches, highlights, or a hovered hyperlink,
+    /// as these are looked up in the terminal while rendering.
+    ///
+    /// @see PageSnapshot
+    void detach();
 
   private:
     [[nodiscard]] bool isCursorLine(LineOffset line) const noexcept;
 
     [[nodiscard]] std::optional<RenderCursor> renderCursor() const;
 
-    [[nodiscard]] static RenderCell makeRenderCellExplicit(ColorPalette const& colorPalette,
-                                                           std::u32string graphemeCluster,
+    [[nodiscard]] static RenderCell makeRenderCellExplicit(RenderBuffer& output,
+                                                           ColorPalette const& colorPalette,
+                                                           std::u32string_view graphemeCluster,
                                                            ColumnCount width,
                                                            CellFlags flags,
                                                            RGBColor fg,
@@ -68,7 +98,8 @@ class RenderBufferBuilder
                                                            LineOffset line,
                                                            ColumnOffset column);
 
-    [[nodiscard]] static RenderCell makeRenderCellExplicit(ColorPalette const& colorPalette,
+    [[nodiscard]] static RenderCell makeRenderCellExplicit(RenderBuffer& output,
+                                                           ColorPalette const& colorPalette,
                                                            char32_t codepoint,
                                                            CellFlags flags,
                                                            RGBColor fg,
@@ -78,14 +109,20 @@ class RenderBufferBuilder
                                                            ColumnOffset column);
 
     /// Constructs a RenderCell for the given screen Cell.
-    [[nodiscard]] static RenderCell makeRenderCell(ColorPalette const& colorPalette,
-                                                   HyperlinkStorage const& hyperlinks,
+    [[nodiscard]] static RenderCell makeRenderCell(RenderBuffer& output,
+                                                   ColorPalette const& colorPalette,
+                                                   std::optional<HyperlinkState> hyperlinkState,
                                                    Cell const& cell,
                                                    RGBColor fg,
                                                    RGBColor bg,
                                                    LineOffset line,
                                                    ColumnOffset column);
 
+    /// Decorates the given render cell according to the state of the hyperlink it belongs to.
+    static void decorateHyperlink(RenderCell& renderCell,
+                                  ColorPalette const& colorPalette,
+                                  std::optional<HyperlinkState> hyperlinkState) noexcept;
+
     /// Constructs the final foreground/background colors to be displayed on the screen.
     ///
     /// This call takes cursor-position, hyperlink-states, selection, and reverse-video mode into account.
@@ -100,6 +137,15 @@ class RenderBufferBuilder
     [[nodiscard]] RenderAttributes createRenderAttributes(
         CellLocation gridPosition, GraphicsAttributes graphicsAttributes) const noexcept;
 
+    /// Returns the state of the given hyperlink, or std::nullopt if the cell has no (known) hyperlink.
+    [[nodiscard]] std::optional<HyperlinkState> hyperlinkStateOf(HyperlinkId id) const noexcept;
+
+    [[nodiscard]] CellLocation translateScreenToGridCoordinate(CellLocation screenPosition) const noexcept
+    {
+        return CellLocation { screenPosition.line - boxed_cast<LineOffset>(_scrollOffset),
+                              screenPosition.column };
+    }
+
     [[nodiscard]] bool tryRenderInputMethodEditor(CellLocation screenPosition, CellLocation gridPosition);
 
     ColumnCount renderUtf8Text(CellLocation screenPosition,
@@ -107,14 +153,26 @@ class RenderBufferBuilder
                                std::string_view text,
                                bool allowMatchSearchPattern);
 
-    template <typename T>
-    void matchSearchPattern(T const& cellText);
+    /// Highlights the most recently rendered cell if it is part of a visible search match.
+    void highlightSearchMatch(CellLocation gridPosition);
 
     /// Tests if the given screen line offset does contain a cursor (either ANSI cursor or vi cursor, if
     /// shown) and returns false otherwise, which guarantees that no cursor is to be rendered
     /// on the given line offset.
     [[nodiscard]] bool gridLineContainsCursor(LineOffset screenLineOffset) const noexcept;
 
+    /// Finds a reusable row of the previous frame that has been rendered from the given line revision.
+    [[nodiscard]] RenderRow const* findPreviousRow(uint32_t revision) noexcept;
+
+    /// Appends the contents of the given previous frame's row to the current row.
+    void copyRow(RenderRow const& source, Line<Cell> const& line);
+
+    /// Records the end of the current row's ranges.
+    void closeRow() noexcept;
+
+    /// Marks the current row as blinking if the given flags contain any blinking attribute.
+    void trackBlinking(CellFlags flags) noexcept;
+
     // clang-format off
     enum class State { Gap, Sequence };
     // clang-format on
@@ -127,15 +185,32 @@ class RenderBufferBuilder
     HighlightSearchMatches _highlightSearchMatches;
     InputMethodData _inputMethodData;
     bool _includeSelection;
+    bool _trackRows;
+
+    // Terminal state captured at construction time.
+    ColorPalette _colorPalette;
+    PageSize _pageSize;
+    ScrollOffset _scrollOffset;
+    LineOffset _screenCursorLine;
+    std::optional<LineOffset> _viCursorLine;
+    bool _blinkState;
+    bool _rapidBlinkState;
+
+    // Set by detach(), along with the hyperlinks known to the terminal at that time (sorted).
+    bool _detached = false;
+    std::vector<HyperlinkId> _hyperlinks;
     ColumnCount _inputMethodSkipColumns = ColumnCount(0);
 
+    // Index into the previous frame's rows where to start looking for the next line to reuse.
+    size_t _previousRowHint = 0;
+
     int _prevWidth = 0;
     bool _prevHasCursor = false;
     LineOffset _lineNr = LineOffset(0);
     bool _useCursorlineColoring = false;
 
-    // Offset into the search pattern that has been already matched.
-    size_t _searchPatternOffset = 0;
+    // Index of the first visible search match that does not end before the cell being rendered.
+    size_t _searchMatchIndex = 0;
 };
 
 } // namespace vtbackend
@@ -19,6 +19,7 @@
 #include <libunicode/convert.h>
 #include <libunicode/emoji_segmenter.h>
 #include <libunicode/grapheme_segmenter.h>
+#include <libunicode/utf8.h>
 #include <libunicode/word_segmenter.h>
 
 #include <range/v3/view/iota.hpp>
@@ -441,12 +442,7 @@ size_t Screen<Cell>::emplaceCharsIntoCurrentLine(string_view chars, size_t cellC
     }
     else
     {
-        // Transforming chars input from UTF-8 to UTF-32 even though right now it should only
-        // be containing US-ASCII, but soon it'll be any arbitrary textual Unicode codepoints.
-        for (char const ch: chars)
-        {
-            _state->parser.printUtf8Byte(ch);
-        }
+        writeTextBatched(chars);
     }
     return chars.size();
 }
@@ -490,11 +486,65 @@ void Screen<Cell>::writeText(string_view text, size_t cellCount)
         return;
 
     // Making use of the optimized code path for the input characters did NOT work, so we need to first
-    // convert UTF-8 to UTF-32 codepoints (reusing the logic in VT parser) and pass these codepoints
-    // to the grapheme cluster processor.
+    // convert UTF-8 to UTF-32 codepoints and pass these codepoints to the grapheme cluster processor.
+    writeTextBatched(text);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Screen<Cell>::writeTextBatched(string_view text)
+{
+    auto constexpr ReplacementCharacter = char32_t { 0xFFFD };
+
+    // The parser only passes complete UTF-8 sequences on as bulk text, so we can use our own decoder
+    // state here instead of going through the parser byte by byte.
+    auto decoder = unicode::utf8_decoder_state {};
+    auto preceding = precedingGraphicCharacter();
+
+    Line<Cell>* line = &currentLine();
+    auto runLine = _cursor.position.line;
+    auto runStart = _cursor.position.column;
+
+    auto const markRunDirty = [&]() {
+        auto const right = std::max(runStart, _cursor.position.column);
+        _terminal->markRegionDirty(Rect { Top(*runLine), Left(*runStart), Bottom(*runLine), Right(*right) });
+    };
 
     for (char const ch: text)
-        _state->parser.printUtf8Byte(ch);
+    {
+        auto const result = unicode::from_utf8(decoder, static_cast<uint8_t>(ch));
+        if (std::holds_alternative<unicode::Incomplete>(result))
+            continue;
+
+        auto const sourceCodepoint = std::holds_alternative<unicode::Success>(result)
+                                         ? std::get<unicode::Success>(result).value
+                                         : ReplacementCharacter;
+
+        if (_cursor.wrapPending)
+        {
+            // About to wrap into the next line (which may also scroll the page),
+            // so close the current run and start a new one.
+            markRunDirty();
+            crlfIfWrapPending();
+            line = &currentLine();
+            runLine = _cursor.position.line;
+            runStart = _cursor.position.column;
+        }
+
+        auto const codepoint = _cursor.charsets.map(sourceCodepoint);
+        if (unicode::grapheme_segmenter::breakable(preceding, codepoint))
+            writeCharToLineAndAdvance(*line, codepoint);
+        else
+        {
+            auto const extendedWidth = usePreviousCell().appendCharacter(codepoint);
+            clearAndAdvance(0, extendedWidth);
+        }
+        preceding = sourceCodepoint;
+    }
+
+    markRunDirty();
+    _state->parser.setPrecedingGraphicCharacter(preceding);
+    resetInstructionCounter();
 }
 
 template <typename Cell>
@@ -577,7 +627,40 @@ template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
 void Screen<Cell>::writeCharToCurrentAndAdvance(char32_t codepoint) noexcept
 {
-    Line<Cell>& line = currentLine();
+    writeCharToLineAndAdvance(currentLine(), codepoint);
+
+    // TODO: maybe move selector API up? So we can make this call conditional,
+    //       and only call it when something is selected?
+    //       Alternatively we could add a boolean to make this callback
+    //       conditional, something like: setReportDamage(bool);
+    //       The latter is probably the easiest.
+    _terminal->markCellDirty(_cursor.position);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Screen<Cell>::writeCharToLineAndAdvance(Line<Cell>& line, char32_t codepoint) noexcept
+{
+    if constexpr (UseSpanLineBuffers)
+    {
+        auto const width = static_cast<uint8_t>(unicode::width(codepoint));
+        if (width == 1 || width == 2)
+        {
+            if (SpanLineBuffer* spans = line.useSpanBuffer())
+            {
+                auto const column = _cursor.position.column;
+                if (spans->columns[unbox<size_t>(column)].width == 0 && column > ColumnOffset(0))
+                    // Erase the left half of the wide char.
+                    spans->write(column - 1, SpanLineBuffer::Column {}, _cursor.graphicsRendition, {});
+
+                auto const oldWidth = std::max(spans->columns[unbox<size_t>(column)].width, uint8_t { 1 });
+                spans->write(column, { codepoint, width }, _cursor.graphicsRendition, _cursor.hyperlink);
+                _lastCursorPosition = _cursor.position;
+                clearAndAdvance(oldWidth, width);
+                return;
+            }
+        }
+    }
 
     Cell& cell = line.useCellAt(_cursor.position.column);
 
@@ -604,13 +687,6 @@ void Screen<Cell>::writeCharToCurrentAndAdvance(char32_t codepoint) noexcept
     _lastCursorPosition = _cursor.position;
 
     clearAndAdvance(oldWidth, cell.width());
-
-    // TODO: maybe move selector API up? So we can make this call conditional,
-    //       and only call it when something is selected?
-    //       Alternatively we could add a boolean to make this callback
-    //       conditional, something like: setReportDamage(bool);
-    //       The latter is probably the easiest.
-    _terminal->markCellDirty(_cursor.position);
 }
 
 template <typename Cell>
@@ -625,8 +701,22 @@ void Screen<Cell>::clearAndAdvance(int oldWidth, int newWidth) noexcept
     auto const sgr = newWidth > 1 ? _cursor.graphicsRendition.with(CellFlag::WideCharContinuation)
                                   : _cursor.graphicsRendition;
     auto& line = currentLine();
-    for (int i = 1; i < min(max(oldWidth, newWidth), cellsAvailable); ++i)
-        line.useCellAt(_cursor.position.column + i).reset(sgr, _cursor.hyperlink);
+    auto const clearedColumns = min(max(oldWidth, newWidth), cellsAvailable);
+    if (line.isSpanBuffer() && clearedColumns > 1)
+    {
+        // Wide character continuations are stored with a width of 0 rather than the flag.
+        auto const value = SpanLineBuffer::Column { 0, static_cast<uint8_t>(newWidth > 1 ? 0 : 1) };
+        line.spanBuffer().fill(_cursor.position.column + 1,
+                               ColumnCount(clearedColumns - 1),
+                               value,
+                               _cursor.graphicsRendition,
+                               _cursor.hyperlink);
+    }
+    else
+    {
+        for (int i = 1; i < clearedColumns; ++i)
+            line.useCellAt(_cursor.position.column + i).reset(sgr, _cursor.hyperlink);
+    }
 
     if (newWidth == min(newWidth, cellsAvailable))
         _cursor.position.column += ColumnOffset::cast_from(newWidth);
@@ -1260,6 +1350,19 @@ void Screen<Cell>::insertChars(LineOffset lineOffset, ColumnCount columnsToInser
     auto const sanitizedN =
         min(*columnsToInsert, *margin().horizontal.to - *logicalCursorPosition().column + 1);
 
+    if constexpr (UseSpanLineBuffers)
+    {
+        if (SpanLineBuffer* spans = _grid.lineAt(lineOffset).useSpanBuffer())
+        {
+            spans->insertColumns(realCursorPosition().column,
+                                 ColumnCount::cast_from(sanitizedN),
+                                 margin().horizontal.to + 1,
+                                 SpanLineBuffer::Column { U' ', 1 },
+                                 _cursor.graphicsRendition);
+            return;
+        }
+    }
+
     auto column0 = _grid.lineAt(lineOffset).inflatedBuffer().begin() + *realCursorPosition().column;
     auto column1 =
         _grid.lineAt(lineOffset).inflatedBuffer().begin() + *margin().horizontal.to - sanitizedN + 1;
@@ -1409,10 +1512,24 @@ CRISPY_REQUIRES(CellConcept<Cell>)
 void Screen<Cell>::deleteChars(LineOffset lineOffset, ColumnOffset column, ColumnCount columnsToDelete)
 {
     auto& line = _grid.lineAt(lineOffset);
-    auto lineBuffer = line.cells();
 
-    Cell* left = const_cast<Cell*>(lineBuffer.data() + column.as<size_t>());
-    Cell* right = const_cast<Cell*>(lineBuffer.data() + *margin().horizontal.to + 1);
+    if constexpr (UseSpanLineBuffers)
+    {
+        if (SpanLineBuffer* spans = line.useSpanBuffer())
+        {
+            spans->deleteColumns(column,
+                                 columnsToDelete,
+                                 margin().horizontal.to + 1,
+                                 SpanLineBuffer::Column { U' ', 1 },
+                                 _cursor.graphicsRendition);
+            return;
+        }
+    }
+
+    auto lineBuffer = gsl::span(line.inflatedBuffer());
+
+    Cell* left = lineBuffer.data() + column.as<size_t>();
+    Cell* right = lineBuffer.data() + *margin().horizontal.to + 1;
     long const n = min(columnsToDelete.as<long>(), static_cast<long>(std::distance(left, right)));
     Cell* mid = left + n;
 
@@ -1920,7 +2037,38 @@ shared_ptr<Image const> Screen<Cell>::uploadImage(ImageFormat format,
                                                   ImageSize imageSize,
                                                   Image::Data&& pixmap)
 {
-    return _state->imagePool.create(format, imageSize, std::move(pixmap));
+    auto image = _state->imagePool.create(format, imageSize, std::move(pixmap));
+    if (_state->imagePool.overBudget())
+    {
+        // Only images that are no longer on either page are evicted, the ones that scrolled off
+        // into the history the longest ago first.
+        auto pinned = std::vector<Image const*> { image.get() };
+        _terminal->primaryScreen().collectPageImages(pinned);
+        _terminal->alternateScreen().collectPageImages(pinned);
+        auto const evictedCount = _state->imagePool.evict(pinned);
+        terminalLog()("Evicted {} images to stay within the image memory budget of {} bytes.",
+                      evictedCount,
+                      _state->imagePool.memoryBudget());
+    }
+    return image;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+void Screen<Cell>::collectPageImages(std::vector<Image const*>& images) const
+{
+    for (auto line = LineOffset(0); line < boxed_cast<LineOffset>(pageSize().lines); ++line)
+    {
+        // Packed lines cannot hold any images.
+        auto const& cells = _grid.lineAt(line);
+        if (!cells.isInflatedBuffer())
+            continue;
+        for (auto const& cell: cells.cells())
+            if (auto const fragment = cell.imageFragment())
+                if (auto const* image = &fragment->rasterizedImage().image();
+                    std::ranges::find(images, image) == images.end())
+                    images.push_back(image);
+    }
 }
 
 template <typename Cell>
@@ -3119,6 +3267,29 @@ namespace impl
             return ApplyResult::Ok;
         }
 
+        ApplyResult METRICS(Sequence const& seq, Terminal& terminal)
+        {
+            // CSI > Ps y
+            //
+            // Ps: 0 = report all performance metrics (default)
+            //     1 = start collecting performance metrics
+            //     2 = stop collecting performance metrics
+            //     3 = discard the performance metrics collected so far
+            //
+            // The metrics are those of the requesting terminal session, and the request is only carried out
+            // once the application is permitted to make it.
+
+            switch (seq.param_or(0, 0))
+            {
+                case 0: terminal.requestMetrics(MetricsRequest::Report); break;
+                case 1: terminal.requestMetrics(MetricsRequest::Enable); break;
+                case 2: terminal.requestMetrics(MetricsRequest::Disable); break;
+                case 3: terminal.requestMetrics(MetricsRequest::Reset); break;
+                default: return ApplyResult::Invalid;
+            }
+            return ApplyResult::Ok;
+        }
+
         template <typename Cell>
         ApplyResult HYPERLINK(Sequence const& seq, Screen<Cell>& screen)
         {
@@ -3390,7 +3561,7 @@ void Screen<Cell>::processSequence(Sequence const& seq)
 #if defined(LIBTERMINAL_LOG_TRACE)
     if (vtTraceSequenceLog)
     {
-        if (auto const* fd = seq.functionDefinition(_terminal->activeSequences()))
+        if (auto const* fd = seq.functionDefinition(_terminal->supportedSequences()))
         {
             vtTraceSequenceLog()("Processing {:<14} {}", fd->documentation.mnemonic, seq.text());
         }
@@ -3403,7 +3574,7 @@ void Screen<Cell>::processSequence(Sequence const& seq)
     //         seq.functionDefinition() ? seq.functionDefinition()->comment : ""sv);
 
     _terminal->state().instructionCounter++;
-    if (FunctionDefinition const* funcSpec = seq.functionDefinition(_terminal->activeSequences());
+    if (FunctionDefinition const* funcSpec = seq.functionDefinition(_terminal->supportedSequences());
         funcSpec != nullptr)
         applyAndLog(*funcSpec, seq);
     else if (vtParserLog)
@@ -3844,6 +4015,7 @@ ApplyResult Screen<Cell>::apply(FunctionDefinition const& function, Sequence con
         case SETCWD: return impl::SETCWD(seq, *this);
         case HYPERLINK: return impl::HYPERLINK(seq, *this);
         case XTCAPTURE: return impl::CAPTURE(seq, *_terminal);
+        case XTMETRICS: return impl::METRICS(seq, *_terminal);
         case COLORFG:
             return impl::setOrRequestDynamicColor(seq, *this, DynamicColorName::DefaultForegroundColor);
         case COLORBG:
@@ -3907,20 +4079,26 @@ unique_ptr<ParserExtension> Screen<Cell>::hookSixel(Sequence const& seq)
     auto const aspectHorizontal = 1;
     auto const transparentBackground = pb == 1;
 
-    _sixelImageBuilder = make_unique<SixelImageBuilder>(
-        _terminal->state().effectiveImageCanvasSize,
-        aspectVertical,
-        aspectHorizontal,
-        transparentBackground ? RGBAColor { 0, 0, 0, 0 } : _terminal->state().colorPalette.defaultBackground,
-        _terminal->state().usePrivateColorRegisters
-            ? make_shared<SixelColorPalette>(_terminal->state().maxImageRegisterCount,
-                                             clamp(_terminal->state().maxImageRegisterCount, 0u, 16384u))
-            : _terminal->state().imageColorPalette);
+    auto const canvasSize = _terminal->state().effectiveImageCanvasSize;
+    auto const backgroundColor =
+        transparentBackground ? RGBAColor { 0, 0, 0, 0 } : _terminal->state().colorPalette.defaultBackground;
+    auto colorPalette = _terminal->state().usePrivateColorRegisters
+                            ? make_shared<SixelColorPalette>(
+                                _terminal->state().maxImageRegisterCount,
+                                clamp(_terminal->state().maxImageRegisterCount, 0u, 16384u))
+                            : _terminal->state().imageColorPalette;
+
+    // The builder is reused across images, saving the allocation of its canvas for each one of them.
+    if (_sixelImageBuilder && _sixelImageBuilder->maxSize() == canvasSize)
+        _sixelImageBuilder->reset(aspectVertical, aspectHorizontal, backgroundColor, std::move(colorPalette));
+    else
+        _sixelImageBuilder = make_unique<SixelImageBuilder>(
+            canvasSize, aspectVertical, aspectHorizontal, backgroundColor, std::move(colorPalette));
 
     return make_unique<SixelParser>(*_sixelImageBuilder, [this]() {
-        {
-            sixelImage(_sixelImageBuilder->size(), std::move(_sixelImageBuilder->data()));
-        }
+        // Copies the image out, such that the builder keeps its buffer.
+        auto const& data = _sixelImageBuilder->data();
+        sixelImage(_sixelImageBuilder->size(), Image::Data(data.begin(), data.end()));
     });
 }
 
@@ -4002,50 +4180,169 @@ template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
 optional<CellLocation> Screen<Cell>::search(std::u32string_view searchText, CellLocation startPosition)
 {
-    // TODO use LogicalLines to spawn logical lines for improving the search on wrapped lines.
+    return search(SearchPattern(searchText), startPosition);
+}
 
-    if (searchText.empty())
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+optional<CellLocation> Screen<Cell>::searchReverse(std::u32string_view searchText, CellLocation startPosition)
+{
+    return searchReverse(SearchPattern(searchText), startPosition);
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+optional<CellLocation> Screen<Cell>::search(SearchPattern const& pattern, CellLocation startPosition)
+{
+    if (!pattern.valid())
         return nullopt;
 
-    // First try match at start location.
-    if (_grid.lineAt(startPosition.line).matchTextAt(searchText, startPosition.column))
-        return startPosition;
+    // Search forward until found or exhausted, skipping frozen history blocks that cannot match.
+    // History lines left unreflowed by resizing are reflowed only from the start position downwards.
+    if (startPosition.line < _grid.reflowedHistoryTop())
+        _grid.reflowHistory(startPosition.line);
 
-    // Search reverse until found or exhausted.
-    auto lines = _grid.logicalLinesFrom(startPosition.line);
-    for (auto& line: lines)
+    auto const pageBottom = boxed_cast<LineOffset>(pageSize().lines) - 1;
+    auto text = SearchText {};
+    auto top = _grid.logicalLineTop(startPosition.line);
+    auto start = optional { startPosition };
+    while (true)
     {
-        auto result = line.search(searchText, startPosition.column);
-        if (result.has_value())
-            return result; // new match found
-        startPosition.column = ColumnOffset(0);
+        if (auto const next = _grid.skipUnmatchableHistory(top, pattern.trigramHashes()); next != top)
+        {
+            top = next;
+            start.reset();
+        }
+        if (top > pageBottom)
+            return nullopt;
+
+        auto skipped = false;
+        for (auto const& line: _grid.logicalLinesFrom(top))
+        {
+            line.collectSearchText(text);
+            auto const from = start ? text.indexOf(line.columnOf(*start)) : 0;
+            if (auto const match = pattern.find(text.codepoints, from))
+                return line.locationOf(text.firstColumn(match->begin));
+
+            top = line.bottom + 1;
+            start.reset();
+            if (_grid.skipUnmatchableHistory(top, pattern.trigramHashes()) != top)
+            {
+                skipped = true;
+                break;
+            }
+        }
+        if (!skipped)
+            return nullopt;
     }
-    return nullopt;
 }
 
 template <typename Cell>
 CRISPY_REQUIRES(CellConcept<Cell>)
-optional<CellLocation> Screen<Cell>::searchReverse(std::u32string_view searchText, CellLocation startPosition)
+optional<CellLocation> Screen<Cell>::searchReverse(SearchPattern const& pattern, CellLocation startPosition)
 {
-    // TODO use LogicalLinesReverse to spawn logical lines for improving the search on wrapped lines.
-
-    if (searchText.empty())
+    if (!pattern.valid())
         return nullopt;
 
-    // First try match at start location.
-    if (_grid.lineAt(startPosition.line).matchTextAt(searchText, startPosition.column))
-        return startPosition;
+    // Search reverse until found or exhausted, skipping frozen history blocks that cannot match.
+    // History lines left unreflowed by resizing are reflowed one page ahead of the lines searched,
+    // and are not skipped before then, as reflowing renumbers them.
+    auto text = SearchText {};
+    auto bottom = _grid.logicalLineBottom(startPosition.line);
+    auto start = optional { startPosition };
+    while (true)
+    {
+        if (bottom < _grid.reflowedHistoryTop())
+            _grid.reflowHistory(bottom - boxed_cast<LineOffset>(pageSize().lines));
+        auto const reflowedTop = _grid.reflowedHistoryTop();
+        auto const historyTop = -boxed_cast<LineOffset>(_grid.historyLineCount());
+
+        if (auto const next = std::max(_grid.skipUnmatchableHistoryReverse(bottom, pattern.trigramHashes()),
+                                       std::min(bottom, reflowedTop - 1));
+            next != bottom)
+        {
+            bottom = next;
+            start.reset();
+            if (bottom < reflowedTop && bottom >= historyTop)
+                continue;
+        }
+        if (bottom < historyTop)
+            return nullopt;
 
-    // Search reverse until found or exhausted.
-    auto lines = _grid.logicalLinesReverseFrom(startPosition.line);
-    for (auto const& line: lines)
+        auto skipped = false;
+        for (auto const& line: _grid.logicalLinesReverseFrom(bottom))
+        {
+            line.collectSearchText(text);
+            auto const end = start ? text.indexOf(line.columnOf(*start) + 1) : text.size();
+            if (end != 0)
+                if (auto const match = pattern.findReverse(text.codepoints, end - 1))
+                    return line.locationOf(text.firstColumn(match->begin));
+
+            bottom = line.top - 1;
+            start.reset();
+            if (bottom < reflowedTop
+                || _grid.skipUnmatchableHistoryReverse(bottom, pattern.trigramHashes()) != bottom)
+            {
+                skipped = true;
+                break;
+            }
+        }
+        if (!skipped)
+            return nullopt;
+    }
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+std::vector<CellLocationRange> Screen<Cell>::searchAll(SearchPattern const& pattern,
+                                                       LineOffset top,
+                                                       LineOffset bottom)
+{
+    auto matches = std::vector<CellLocationRange> {};
+    if (!pattern.valid())
+        return matches;
+
+    // Matches may start above or end below the given lines, if these are wrapped.
+    auto text = SearchText {};
+    auto const lastLine = _grid.logicalLineBottom(bottom);
+    auto next = _grid.logicalLineTop(top);
+    while (true)
     {
-        auto result = line.searchReverse(searchText, startPosition.column);
-        if (result.has_value())
-            return result; // new match found
-        startPosition.column = boxed_cast<ColumnOffset>(pageSize().columns) - 1;
+        next = _grid.skipUnmatchableHistory(next, pattern.trigramHashes());
+        if (next > lastLine)
+            return matches;
+
+        auto skipped = false;
+        for (auto const& line: LogicalLines<Cell> { next, lastLine, _grid })
+        {
+            line.collectSearchText(text);
+            for (auto const& match: pattern.findAll(text.codepoints))
+            {
+                auto const range = CellLocationRange { line.locationOf(text.firstColumn(match.begin)),
+                                                       line.locationOf(text.lastColumn(match.end)) };
+                if (top <= range.second.line && range.first.line <= bottom)
+                    matches.emplace_back(range);
+            }
+
+            next = line.bottom + 1;
+            if (_grid.skipUnmatchableHistory(next, pattern.trigramHashes()) != next)
+            {
+                skipped = true;
+                break;
+            }
+        }
+        if (!skipped)
+            return matches;
     }
-    return nullopt;
+}
+
+template <typename Cell>
+CRISPY_REQUIRES(CellConcept<Cell>)
+std::vector<CellLocationRange> Screen<Cell>::searchAll(std::u32string_view searchText)
+{
+    return searchAll(SearchPattern(searchText),
+                     -boxed_cast<LineOffset>(_grid.historyLineCount()),
+                     boxed_cast<LineOffset>(pageSize().lines) - 1);
 }
 
 template <typename Cell>
@@ -77,6 +77,13 @@ class ScreenBase: public SequenceHandler
                                                              CellLocation startPosition) = 0;
     [[nodiscard]] virtual std::optional<CellLocation> searchReverse(std::u32string_view searchText,
                                                                     CellLocation startPosition) = 0;
+    [[nodiscard]] virtual std::optional<CellLocation> search(SearchPattern const& pattern,
+                                                             CellLocation startPosition) = 0;
+    [[nodiscard]] virtual std::optional<CellLocation> searchReverse(SearchPattern const& pattern,
+                                                                    CellLocation startPosition) = 0;
+    [[nodiscard]] virtual std::vector<CellLocationRange> searchAll(SearchPattern const& pattern,
+                                                                   LineOffset top,
+                                                                   LineOffset bottom) = 0;
 
   protected:
     Cursor _cursor {};
@@ -261,6 +268,9 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
 
     std::shared_ptr<Image const> uploadImage(ImageFormat format, ImageSize imageSize, Image::Data&& pixmap);
 
+    /// Appends the images shown in the main page to @p images, if not contained already.
+    void collectPageImages(std::vector<Image const*>& images) const;
+
     /**
      * Renders an image onto the screen.
      *
@@ -413,6 +423,22 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     [[nodiscard]] std::optional<CellLocation> searchReverse(std::u32string_view searchText,
                                                             CellLocation startPosition) override;
 
+    /// Returns the start of the first match of @p pattern at or after @p startPosition.
+    [[nodiscard]] std::optional<CellLocation> search(SearchPattern const& pattern,
+                                                     CellLocation startPosition) override;
+
+    /// Returns the start of the match of @p pattern at or before @p startPosition that is closest to it.
+    [[nodiscard]] std::optional<CellLocation> searchReverse(SearchPattern const& pattern,
+                                                            CellLocation startPosition) override;
+
+    /// Returns the ranges of all matches of @p pattern that cover any of the given lines, from top to bottom.
+    [[nodiscard]] std::vector<CellLocationRange> searchAll(SearchPattern const& pattern,
+                                                           LineOffset top,
+                                                           LineOffset bottom) override;
+
+    /// Returns the ranges of all matches of @p searchText, from the top most history line downwards.
+    [[nodiscard]] std::vector<CellLocationRange> searchAll(std::u32string_view searchText);
+
     [[nodiscard]] Cell& usePreviousCell() noexcept
     {
         return useCellAt(_lastCursorPosition.line, _lastCursorPosition.column);
@@ -568,6 +594,10 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
             TrivialLineBuffer const& lineBuffer = line.trivialBuffer();
             return lineBuffer.hyperlink;
         }
+        if (line.isPackedBuffer())
+            return line.packedBuffer().hyperlinkAt(position.column);
+        if (line.isSpanBuffer())
+            return line.spanBuffer().hyperlinkAt(position.column);
         return at(position).hyperlink();
     }
 
@@ -600,6 +630,10 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
   private:
     void writeTextInternal(char32_t codepoint);
 
+    /// Writes the given complete UTF-8 sequence (without control characters) to the screen,
+    /// decoding and grapheme-segmenting it in one pass, and marking each written line run dirty once.
+    void writeTextBatched(std::string_view text);
+
     /// Attempts to emplace the given character sequence into the current cursor position, assuming
     /// that the current line is either empty or trivial and the input character sequence is contiguous.
     ///
@@ -617,6 +651,7 @@ class Screen final: public ScreenBase, public capabilities::StaticDatabase
     void linefeed(ColumnOffset column);
 
     void writeCharToCurrentAndAdvance(char32_t codepoint) noexcept;
+    void writeCharToLineAndAdvance(Line<Cell>& line, char32_t codepoint) noexcept;
     void clearAndAdvance(int oldWidth, int newWidth) noexcept;
 
     void scrollUp(LineCount n, GraphicsAttributes sgr, Margin margin);
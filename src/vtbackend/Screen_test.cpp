@@ -87,7 +87,7 @@ void TextRenderBuilder::startLine(LineOffset lineOffset)
         text.clear();
 }
 
-void TextRenderBuilder::renderCell(CompactCell const& cell, LineOffset, ColumnOffset)
+void TextRenderBuilder::renderCell(PrimaryScreenCell const& cell, LineOffset, ColumnOffset)
 {
     text += cell.toUtf8();
 }
@@ -316,6 +316,22 @@ TEST_CASE("writeText.bulk.H", "[screen]")
     CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(9) });
 }
 
+// Non-trivial multi-byte text that spans two lines.
+TEST_CASE("writeText.bulk.I", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(4) }, LineCount(2) };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("ab");
+    mock.writeToScreen(SGR(1));
+    mock.writeToScreen(U"\u65E5\u672Ce\u0301x"); // "日本éx", with é being composed of 2 codepoints
+    logScreenText(screen, "final state");
+    CHECK(screen.grid().lineText(LineOffset(0)) == unicode::convert_to<char>(U"ab\u65E5"sv));
+    CHECK(screen.grid().lineText(LineOffset(1)) == unicode::convert_to<char>(U"\u672Ce\u0301x"sv));
+    CHECK(screen.grid().lineText(LineOffset(2)) == "    ");
+    CHECK(screen.cursor().position == CellLocation { LineOffset(1), ColumnOffset(3) });
+    CHECK(screen.at(LineOffset(1), ColumnOffset(2)).codepointCount() == 2);
+}
+
 // TODO: Test spanning writes over all history and then reusing old lines.
 // Verify we do not leak any old cell attribs.
 
@@ -1424,6 +1440,30 @@ TEST_CASE("DeleteColumns", "[screen]")
     }
 }
 
+TEST_CASE("InsertCharacters.SpanLines", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(1), ColumnCount(8) } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("\033[31mab\033[32mcd\033[m");
+    if constexpr (UseSpanLineBuffers)
+        REQUIRE(screen.grid().lineAt(LineOffset(0)).isSpanBuffer());
+
+    // Line::toUtf8() is used rather than renderMainPageText(), as the latter inflates the line.
+    screen.moveCursorTo(LineOffset(0), ColumnOffset(1));
+    screen.insertCharacters(ColumnCount(2));
+    CHECK(screen.grid().lineAt(LineOffset(0)).toUtf8() == "a  bcd  ");
+
+    screen.deleteCharacters(ColumnCount(3));
+    CHECK(screen.grid().lineAt(LineOffset(0)).toUtf8() == "acd     ");
+
+    if constexpr (UseSpanLineBuffers)
+        CHECK(screen.grid().lineAt(LineOffset(0)).isSpanBuffer());
+
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).foregroundColor() == IndexedColor::Red);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(1)).foregroundColor() == IndexedColor::Green);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(3)).foregroundColor() == DefaultColor());
+}
+
 TEST_CASE("DeleteCharacters", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) } };
@@ -1638,6 +1678,30 @@ TEST_CASE("ScrollUp.WithMargins", "[screen]")
     REQUIRE(screen.margin().horizontal == Margin::Horizontal { ColumnOffset(0), ColumnOffset(4) });
 }
 
+TEST_CASE("ScrollUp.WithMargins.SpanLines", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) } };
+    auto& screen = mock.terminal.primaryScreen();
+    mock.writeToScreen("\033[31m12\033[32m345\r\n6\033[33m7890\r\nAB\033[mCDE");
+
+    mock.terminal.setMode(DECMode::LeftRightMargin, true);
+    mock.terminal.setLeftRightMargin(ColumnOffset(1), ColumnOffset(3));
+    screen.scrollUp(LineCount(1));
+
+    if constexpr (UseSpanLineBuffers)
+        for (auto line = LineOffset(0); line < LineOffset(3); ++line)
+            CHECK(screen.grid().lineAt(line).isSpanBuffer());
+
+    REQUIRE("17895\n6BCD0\nA   E\n" == screen.renderMainPageText());
+
+    CHECK(screen.at(LineOffset(0), ColumnOffset(0)).foregroundColor() == IndexedColor::Red);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(1)).foregroundColor() == IndexedColor::Yellow);
+    CHECK(screen.at(LineOffset(0), ColumnOffset(4)).foregroundColor() == IndexedColor::Green);
+    CHECK(screen.at(LineOffset(1), ColumnOffset(1)).foregroundColor() == IndexedColor::Yellow);
+    CHECK(screen.at(LineOffset(1), ColumnOffset(2)).foregroundColor() == DefaultColor());
+    CHECK(screen.at(LineOffset(2), ColumnOffset(1)).foregroundColor() == DefaultColor());
+}
+
 TEST_CASE("ScrollUp", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(3) } };
@@ -2525,13 +2589,13 @@ TEST_CASE("ReportCursorPosition", "[screen]")
     screen.moveCursorTo(LineOffset { 1 }, ColumnOffset { 2 });
 
     REQUIRE("12345\n67890\nABCDE\nFGHIJ\nKLMNO\n" == screen.renderMainPageText());
-    REQUIRE(mock.terminal.peekInput().empty());
+    REQUIRE(mock.replyData().empty());
     REQUIRE(screen.logicalCursorPosition() == CellLocation { LineOffset(1), ColumnOffset(2) });
 
     SECTION("with Origin mode disabled")
     {
         screen.reportCursorPosition();
-        CHECK("\033[2;3R" == mock.terminal.peekInput());
+        CHECK("\033[2;3R" == mock.replyData());
     }
 
     SECTION("with margins and origin mode enabled")
@@ -2543,7 +2607,7 @@ TEST_CASE("ReportCursorPosition", "[screen]")
         screen.moveCursorTo(LineOffset { 2 }, ColumnOffset { 1 });
 
         screen.reportCursorPosition();
-        CHECK("\033[3;2R" == mock.terminal.peekInput());
+        CHECK("\033[3;2R" == mock.replyData());
     }
 }
 
@@ -2555,13 +2619,13 @@ TEST_CASE("ReportExtendedCursorPosition", "[screen]")
     screen.moveCursorTo(LineOffset { 1 }, ColumnOffset { 2 });
 
     REQUIRE("12345\n67890\nABCDE\nFGHIJ\nKLMNO\n" == screen.renderMainPageText());
-    REQUIRE(mock.terminal.peekInput().empty());
+    REQUIRE(mock.replyData().empty());
     REQUIRE(screen.logicalCursorPosition() == CellLocation { LineOffset(1), ColumnOffset(2) });
 
     SECTION("with Origin mode disabled")
     {
         screen.reportExtendedCursorPosition();
-        CHECK("\033[2;3;1R" == mock.terminal.peekInput());
+        CHECK("\033[2;3;1R" == mock.replyData());
     }
 
     SECTION("with margins and origin mode enabled")
@@ -2573,7 +2637,7 @@ TEST_CASE("ReportExtendedCursorPosition", "[screen]")
         screen.moveCursorTo(LineOffset { 2 }, ColumnOffset { 1 });
 
         screen.reportExtendedCursorPosition();
-        CHECK("\033[3;2;1R" == mock.terminal.peekInput());
+        CHECK("\033[3;2;1R" == mock.replyData());
     }
 }
 
@@ -2586,7 +2650,7 @@ TEST_CASE("RequestMode", "[screen]")
     {
         mock.terminal.setMode(AnsiMode::Insert, true); // IRM
         screen.requestAnsiMode((unsigned) AnsiMode::Insert);
-        REQUIRE(e(mock.terminal.peekInput())
+        REQUIRE(e(mock.replyData())
                 == e(fmt::format("\033[{};1$y", toAnsiModeNum(AnsiMode::Insert))));
     }
 
@@ -2594,7 +2658,7 @@ TEST_CASE("RequestMode", "[screen]")
     {
         mock.terminal.setMode(AnsiMode::Insert, false); // IRM
         screen.requestAnsiMode((unsigned) AnsiMode::Insert);
-        REQUIRE(e(mock.terminal.peekInput())
+        REQUIRE(e(mock.replyData())
                 == e(fmt::format("\033[{};2$y", toAnsiModeNum(AnsiMode::Insert))));
     }
 
@@ -2603,14 +2667,14 @@ TEST_CASE("RequestMode", "[screen]")
         auto const m = static_cast<AnsiMode>(1234);
         mock.terminal.setMode(m, true); // DECOM
         screen.requestAnsiMode((unsigned) m);
-        REQUIRE(e(mock.terminal.peekInput()) == e(fmt::format("\033[{};0$y", toAnsiModeNum(m))));
+        REQUIRE(e(mock.replyData()) == e(fmt::format("\033[{};0$y", toAnsiModeNum(m))));
     }
 
     SECTION("DEC modes: enabled")
     {
         mock.terminal.setMode(DECMode::Origin, true); // DECOM
         screen.requestDECMode((int) DECMode::Origin);
-        REQUIRE(e(mock.terminal.peekInput())
+        REQUIRE(e(mock.replyData())
                 == e(fmt::format("\033[?{};1$y", toDECModeNum(DECMode::Origin))));
     }
 
@@ -2618,7 +2682,7 @@ TEST_CASE("RequestMode", "[screen]")
     {
         mock.terminal.setMode(DECMode::Origin, false); // DECOM
         screen.requestDECMode((int) DECMode::Origin);
-        REQUIRE(e(mock.terminal.peekInput())
+        REQUIRE(e(mock.replyData())
                 == e(fmt::format("\033[?{};2$y", toDECModeNum(DECMode::Origin))));
     }
 
@@ -2627,7 +2691,7 @@ TEST_CASE("RequestMode", "[screen]")
         auto const m = static_cast<DECMode>(1234);
         mock.terminal.setMode(m, true); // DECOM
         screen.requestDECMode(static_cast<unsigned>(m));
-        REQUIRE(e(mock.terminal.peekInput()) == e(fmt::format("\033[?{};0$y", toDECModeNum(m))));
+        REQUIRE(e(mock.replyData()) == e(fmt::format("\033[?{};0$y", toDECModeNum(m))));
     }
 }
 
@@ -2671,50 +2735,84 @@ TEST_CASE("captureBuffer", "[screen]")
     SECTION("lines: 0")
     {
         screen.captureBuffer(LineCount(0), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput()) == e("\033^314;\033\\"));
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData()) == e("\033^314;\033\\"));
     }
     SECTION("lines: 1")
     {
         screen.captureBuffer(LineCount(1), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput()) == e("\033^314;KLMNO\n\033\\\033^314;\033\\"));
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData()) == e("\033^314;KLMNO\n\033\\\033^314;\033\\"));
     }
     SECTION("lines: 2")
     {
         screen.captureBuffer(LineCount(2), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput()) == e("\033^314;FGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData()) == e("\033^314;FGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
     }
     SECTION("lines: 3")
     {
         screen.captureBuffer(LineCount(3), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput()) == e("\033^314;ABCDE\nFGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData()) == e("\033^314;ABCDE\nFGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
     }
     SECTION("lines: 4")
     {
         screen.captureBuffer(LineCount(4), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput())
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData())
               == e("\033^314;67890\nABCDE\nFGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
     }
     SECTION("lines: 5")
     {
         screen.captureBuffer(LineCount(5), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput())
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData())
               == e("\033^314;12345\n67890\nABCDE\nFGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
     }
     SECTION("lines: 5 (+1 overflow)")
     {
         screen.captureBuffer(LineCount(6), false);
-        INFO(e(mock.terminal.peekInput()));
-        CHECK(e(mock.terminal.peekInput())
+        INFO(e(mock.replyData()));
+        CHECK(e(mock.replyData())
               == e("\033^314;12345\n67890\nABCDE\nFGHIJ\nKLMNO\n\033\\\033^314;\033\\"));
     }
 }
 
+TEST_CASE("XTMETRICS", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) } };
+    auto other = MockTerm { PageSize { LineCount(2), ColumnCount(5) } };
+
+    // Discard previously collected metrics and start collecting.
+    mock.writeToScreen("\033[>3y\033[>1y");
+    REQUIRE(mock.terminal.metrics().registry.enabled());
+    mock.terminal.refreshRenderBuffer();
+
+    mock.writeToScreen("\033[>y");
+    auto const& reply = mock.replyData();
+    INFO(e(reply));
+    CHECK(reply.starts_with("\033P>yenabled=1;"));
+    CHECK(reply.ends_with("\033\\"));
+    CHECK(reply.find(";vt.renderbuffer_fill:unit=ns,count=1,") != std::string::npos);
+
+    // Metrics are those of the requesting terminal only.
+    CHECK(!other.terminal.metrics().registry.enabled());
+    other.writeToScreen("\033[>1y");
+    other.terminal.refreshRenderBuffer();
+    CHECK(other.terminal.metrics().renderBufferFill.count() == 1);
+    other.writeToScreen("\033[>3y");
+    CHECK(other.terminal.metrics().renderBufferFill.count() == 0);
+    CHECK(mock.terminal.metrics().renderBufferFill.count() == 1);
+
+    // Stop collecting.
+    mock.resetReplyData();
+    mock.writeToScreen("\033[>2y\033[>0y");
+    CHECK(!mock.terminal.metrics().registry.enabled());
+    CHECK(other.terminal.metrics().registry.enabled());
+    CHECK(mock.replyData().starts_with("\033P>yenabled=0;"));
+}
+
 TEST_CASE("render into history", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(5) }, LineCount { 5 } };
@@ -3024,6 +3122,50 @@ TEST_CASE("searchReverse", "[screen]")
     }
 }
 
+TEST_CASE("searchAll", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    mock.writeToScreen("foo1\r\n");
+    mock.writeToScreen("bar2\r\n");
+    mock.writeToScreen("xxxfoo"); // wraps the last "o"
+
+    auto& screen = mock.terminal.primaryScreen();
+    auto const matches = screen.searchAll(U"foo");
+    REQUIRE(matches.size() == 2);
+    CHECK(matches[0].first == CellLocation { LineOffset(-1), ColumnOffset(0) });
+    CHECK(matches[0].second == CellLocation { LineOffset(-1), ColumnOffset(2) });
+    CHECK(matches[1].first == CellLocation { LineOffset(1), ColumnOffset(3) });
+    CHECK(matches[1].second == CellLocation { LineOffset(2), ColumnOffset(0) });
+
+    CHECK(screen.searchAll(U"baz").empty());
+}
+
+TEST_CASE("search.frozenHistory", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(10) }, LineCount(0) };
+    mock.terminal.setMaxHistoryLineCount(Infinite());
+    auto& screen = mock.terminal.primaryScreen();
+    screen.grid().setHotHistoryLimit(LineCount(4));
+    for (int i = 0; i < 1100; ++i)
+        mock.writeToScreen(fmt::format("\r\nline {:04}", i));
+
+    REQUIRE(screen.grid().frozenHistoryLineCount() > LineCount(1000));
+    auto const top = -boxed_cast<LineOffset>(screen.historyLineCount());
+
+    auto const found = screen.searchReverse(U"line 0007", screen.cursor().position);
+    REQUIRE(found.has_value());
+    CHECK(found->line == top + LineOffset(8));
+    CHECK(screen.grid().lineText(found->line) == "line 0007 ");
+
+    auto const foundForward = screen.search(U"line 1000", CellLocation { top, ColumnOffset(0) });
+    REQUIRE(foundForward.has_value());
+    CHECK(screen.grid().lineText(foundForward->line) == "line 1000 ");
+
+    CHECK(!screen.search(U"line 2000", CellLocation { top, ColumnOffset(0) }).has_value());
+    CHECK(!screen.searchReverse(U"line 2000", screen.cursor().position).has_value());
+    CHECK(screen.searchAll(U"line 00").size() == 100);
+}
+
 TEST_CASE("findMarkerDownwards", "[screen]")
 {
     auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(4) }, LineCount(10) };
@@ -3206,14 +3348,14 @@ TEST_CASE("DECTABSR", "[screen]")
     SECTION("default tabstops")
     {
         screen.requestTabStops();
-        CHECK(e(mock.terminal.peekInput()) == e("\033P2$u1/9/17/25/33\033\\"));
+        CHECK(e(mock.replyData()) == e("\033P2$u1/9/17/25/33\033\\"));
     }
 
     SECTION("cleared tabs")
     {
         screen.horizontalTabClear(HorizontalTabClear::AllTabs);
         screen.requestTabStops();
-        CHECK(e(mock.terminal.peekInput()) == e("\033P2$u1/9/17/25/33\033\\"));
+        CHECK(e(mock.replyData()) == e("\033P2$u1/9/17/25/33\033\\"));
     }
 
     SECTION("custom tabstops")
@@ -3233,7 +3375,7 @@ TEST_CASE("DECTABSR", "[screen]")
         screen.horizontalTabSet();
 
         screen.requestTabStops();
-        CHECK(e(mock.terminal.peekInput()) == e("\033P2$u2/4/8/16\033\\"));
+        CHECK(e(mock.replyData()) == e("\033P2$u2/4/8/16\033\\"));
     }
 }
 
@@ -3260,7 +3402,7 @@ TEST_CASE("OSC.2.Unicode")
     auto const title = unicode::convert_to<char>(u32title);
 
     mock.writeToScreen(U"\033]2;\U0001F600\033\\");
-    INFO(mock.terminal.peekInput());
+    INFO(mock.replyData());
     CHECK(e(mock.windowTitle) == e(title));
 }
 
@@ -3271,32 +3413,32 @@ TEST_CASE("OSC.4")
     SECTION("query")
     {
         mock.writeToScreen("\033]4;7;?\033\\");
-        INFO(e(mock.terminal.peekInput()));
-        REQUIRE(e(mock.terminal.peekInput()) == e("\033]4;7;rgb:c0c0/c0c0/c0c0\033\\"));
+        INFO(e(mock.replyData()));
+        REQUIRE(e(mock.replyData()) == e("\033]4;7;rgb:c0c0/c0c0/c0c0\033\\"));
     }
 
     SECTION("set color via format rgb:RR/GG/BB")
     {
         mock.writeToScreen("\033]4;7;rgb:ab/cd/ef\033\\");
         mock.writeToScreen("\033]4;7;?\033\\");
-        INFO(mock.terminal.peekInput());
-        REQUIRE(e(mock.terminal.peekInput()) == e("\033]4;7;rgb:abab/cdcd/efef\033\\"));
+        INFO(mock.replyData());
+        REQUIRE(e(mock.replyData()) == e("\033]4;7;rgb:abab/cdcd/efef\033\\"));
     }
 
     SECTION("set color via format #RRGGBB")
     {
         mock.writeToScreen("\033]4;7;#abcdef\033\\");
         mock.writeToScreen("\033]4;7;?\033\\");
-        INFO(e(mock.terminal.peekInput()));
-        REQUIRE(e(mock.terminal.peekInput()) == e("\033]4;7;rgb:abab/cdcd/efef\033\\"));
+        INFO(e(mock.replyData()));
+        REQUIRE(e(mock.replyData()) == e("\033]4;7;rgb:abab/cdcd/efef\033\\"));
     }
 
     SECTION("set color via format #RGB")
     {
         mock.writeToScreen("\033]4;7;#abc\033\\");
         mock.writeToScreen("\033]4;7;?\033\\");
-        INFO(mock.terminal.peekInput());
-        REQUIRE(e(mock.terminal.peekInput()) == e("\033]4;7;rgb:a0a0/b0b0/c0c0\033\\"));
+        INFO(mock.replyData());
+        REQUIRE(e(mock.replyData()) == e("\033]4;7;rgb:a0a0/b0b0/c0c0\033\\"));
     }
 }
 
@@ -3305,7 +3447,7 @@ TEST_CASE("XTGETTCAP")
     auto mock = MockTerm { PageSize { LineCount(2), ColumnCount(2) } };
     auto const queryStr = fmt::format("\033P+q{:02X}{:02X}{:02X}\033\\", 'R', 'G', 'B');
     mock.writeToScreen(queryStr);
-    INFO(fmt::format("Reply data: {}", mock.terminal.peekInput()));
+    INFO(fmt::format("Reply data: {}", mock.replyData()));
     // "\033P1+r8/8/8\033\\"
     // TODO: CHECK(...)
 }
@@ -3565,7 +3707,7 @@ TEST_CASE("Screen.tcap.string", "[screen, tcap]")
     using namespace vtbackend;
     auto mock = MockTerm(PageSize { LineCount(3), ColumnCount(5) }, LineCount(2));
     mock.writeToScreen("\033P+q687061\033\\"); // HPA
-    REQUIRE(e(mock.terminal.peekInput()) == e("\033P1+r687061=1B5B2569257031256447\033\\"));
+    REQUIRE(e(mock.replyData()) == e("\033P1+r687061=1B5B2569257031256447\033\\"));
 }
 
 TEST_CASE("Sixel.simple", "[screen]")
@@ -3685,6 +3827,42 @@ TEST_CASE("Sixel.status_line", "[screen]")
     }
 }
 
+TEST_CASE("Sixel.evict", "[screen]")
+{
+    auto mock = MockTerm { PageSize { LineCount(3), ColumnCount(5) }, LineCount(10) };
+    mock.terminal.setCellPixelSize(ImageSize { Width(10), Height(10) });
+
+    // A 10x6 pixel image takes 240 bytes, so that the budget fits just one of them.
+    mock.terminal.setMaxImageMemory(300);
+
+    auto const imageAt = [&](LineOffset line) {
+        auto const fragment = mock.terminal.primaryScreen().at(line, ColumnOffset(0)).imageFragment();
+        REQUIRE(fragment);
+        return fragment->rasterizedImage().imagePointer();
+    };
+
+    mock.writeToScreen("\033Pq#1;2;100;0;0#1!10~\033\\");
+    auto const first = imageAt(LineOffset(0));
+    auto const pixels = *first->data();
+
+    // Scrolls the image off into the history.
+    mock.writeToScreen("\r\n\r\n\r\n\r\n");
+    auto const fragment = mock.terminal.primaryScreen().at(LineOffset(-1), ColumnOffset(0)).imageFragment();
+    REQUIRE(fragment);
+    CHECK(fragment->rasterizedImage().imagePointer() == first);
+    CHECK(!mock.terminal.primaryScreen().at(LineOffset(0), ColumnOffset(0)).imageFragment());
+
+    mock.writeToScreen("\033Pq#1;2;0;100;0#1!10~\033\\");
+    auto const second = imageAt(LineOffset(2));
+    CHECK(second != first);
+    CHECK(!second->evicted());
+    CHECK(first->evicted());
+
+    // The cells still refer to the evicted image, which is rendered as placeholder.
+    CHECK(fragment->data().size() == 10 * 10 * 4);
+    CHECK(fragment->data() != pixels);
+}
+
 TEST_CASE("DECSTR", "[screen]")
 {
     // Create a 10x3x5 grid and render a 7x5 image causing one a line-scroll by one.
@@ -0,0 +1,957 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/SearchPattern.h>
+#include <vtbackend/TrigramFilter.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <utility>
+
+namespace vtbackend
+{
+
+namespace
+{
+    constexpr char32_t MaxCodepoint = 0x10FFFF;
+
+    // Upper bounds on the size of a compiled pattern.
+    constexpr size_t MaxNfaStates = 10000;
+    constexpr size_t MaxRepetitionCount = 1000;
+    constexpr size_t MaxCharMatchTableSize = 16 * 1024 * 1024;
+
+    // Number of deterministic states after which the state cache is flushed.
+    constexpr size_t MaxDfaStates = 4096;
+
+    // {{{ case folding
+    struct CaseRange
+    {
+        char32_t first;  // first upper case letter
+        char32_t last;   // last upper case letter
+        char32_t delta;  // offset to the corresponding lower case letter
+        char32_t stride; // 1 if all codepoints in the range are letters, 2 if upper and lower case alternate
+    };
+
+    constexpr auto CaseRanges = std::array {
+        CaseRange { 0x00C0, 0x00D6, 32, 1 }, // Latin-1 Supplement
+        CaseRange { 0x00D8, 0x00DE, 32, 1 },
+        CaseRange { 0x0100, 0x012E, 1, 2 }, // Latin Extended-A
+        CaseRange { 0x0132, 0x0136, 1, 2 },
+        CaseRange { 0x0139, 0x0147, 1, 2 },
+        CaseRange { 0x014A, 0x0176, 1, 2 },
+        CaseRange { 0x0391, 0x03A1, 32, 1 }, // Greek
+        CaseRange { 0x03A3, 0x03AB, 32, 1 },
+        CaseRange { 0x0400, 0x040F, 80, 1 }, // Cyrillic
+        CaseRange { 0x0410, 0x042F, 32, 1 },
+    };
+
+    /// Maps upper case letters of the most common alphabets to lower case.
+    constexpr char32_t foldCase(char32_t codepoint) noexcept
+    {
+        if (codepoint < 0xC0)
+            return codepoint >= U'A' && codepoint <= U'Z' ? codepoint + 32 : codepoint;
+        for (auto const& range: CaseRanges)
+            if (range.first <= codepoint && codepoint <= range.last
+                && (codepoint - range.first) % range.stride == 0)
+                return codepoint + range.delta;
+        return codepoint;
+    }
+    // }}}
+
+    // {{{ CharSet
+    using CodepointRange = std::pair<char32_t, char32_t>; // inclusive
+
+    class CharSet
+    {
+      public:
+        CharSet() = default;
+        CharSet(char32_t first, char32_t last) { add(first, last); }
+
+        void add(char32_t first, char32_t last) { _ranges.emplace_back(first, last); }
+
+        void add(CharSet const& other)
+        {
+            _ranges.insert(_ranges.end(), other._ranges.begin(), other._ranges.end());
+        }
+
+        /// Adds the lower case letters of all upper case letters in this set.
+        void addFoldedCase()
+        {
+            auto const ranges = _ranges;
+            addShifted(CharSet('A', 'Z').intersected(ranges), 32, 1, 'A');
+            for (auto const& caseRange: CaseRanges)
+                addShifted(CharSet(caseRange.first, caseRange.last).intersected(ranges),
+                           caseRange.delta,
+                           caseRange.stride,
+                           caseRange.first);
+        }
+
+        void negate()
+        {
+            auto const ranges = normalized();
+            _ranges.clear();
+            auto next = char32_t { 0 };
+            for (auto const& [first, last]: ranges)
+            {
+                if (next < first)
+                    add(next, first - 1);
+                next = last + 1;
+            }
+            if (next <= MaxCodepoint)
+                add(next, MaxCodepoint);
+        }
+
+        /// Returns the ranges of this set, sorted and merged.
+        [[nodiscard]] std::vector<CodepointRange> normalized() const
+        {
+            auto ranges = _ranges;
+            std::sort(ranges.begin(), ranges.end());
+            auto result = std::vector<CodepointRange> {};
+            for (auto const& range: ranges)
+            {
+                if (!result.empty() && range.first <= result.back().second + 1)
+                    result.back().second = std::max(result.back().second, range.second);
+                else
+                    result.push_back(range);
+            }
+            return result;
+        }
+
+      private:
+        [[nodiscard]] std::vector<CodepointRange> intersected(std::vector<CodepointRange> const& ranges) const
+        {
+            auto result = std::vector<CodepointRange> {};
+            for (auto const& [first, last]: _ranges)
+                for (auto const& [otherFirst, otherLast]: ranges)
+                    if (std::max(first, otherFirst) <= std::min(last, otherLast))
+                        result.emplace_back(std::max(first, otherFirst), std::min(last, otherLast));
+            return result;
+        }
+
+        void addShifted(std::vector<CodepointRange> const& ranges,
+                        char32_t delta,
+                        char32_t stride,
+                        char32_t strideBase)
+        {
+            for (auto const& [first, last]: ranges)
+            {
+                if (stride == 1)
+                    add(first + delta, last + delta);
+                else
+                    for (auto codepoint = first; codepoint <= last; ++codepoint)
+                        if ((codepoint - strideBase) % stride == 0)
+                            add(codepoint + delta, codepoint + delta);
+            }
+        }
+
+        std::vector<CodepointRange> _ranges;
+    };
+
+    CharSet digitCharSet()
+    {
+        return CharSet('0', '9');
+    }
+
+    CharSet wordCharSet()
+    {
+        auto set = CharSet('0', '9');
+        set.add('A', 'Z');
+        set.add('a', 'z');
+        set.add('_', '_');
+        return set;
+    }
+
+    CharSet spaceCharSet()
+    {
+        auto set = CharSet(' ', ' ');
+        set.add('\t', '\t');
+        return set;
+    }
+
+    /// Set of distinct character sets referenced by a pattern, identified by their index.
+    class CharSetTable
+    {
+      public:
+        uint32_t add(CharSet const& set)
+        {
+            auto ranges = set.normalized();
+            if (auto const i = _indices.find(ranges); i != _indices.end())
+                return i->second;
+            auto const index = static_cast<uint32_t>(_sets.size());
+            _sets.push_back(ranges);
+            _indices.emplace(std::move(ranges), index);
+            return index;
+        }
+
+        [[nodiscard]] std::vector<std::vector<CodepointRange>> const& sets() const noexcept { return _sets; }
+
+      private:
+        std::vector<std::vector<CodepointRange>> _sets;
+        std::map<std::vector<CodepointRange>, uint32_t> _indices;
+    };
+    // }}}
+
+    // {{{ syntax tree
+    struct SyntaxError
+    {
+        std::string message;
+    };
+
+    struct Node
+    {
+        enum class Kind : uint8_t
+        {
+            Empty,
+            Set,
+            Concat,
+            Alternate,
+            Repeat,
+            LineBegin,
+            LineEnd,
+        };
+
+        Kind kind = Kind::Empty;
+        uint32_t set = 0;     // Set
+        size_t min = 0;       // Repeat
+        size_t max = 0;       // Repeat, or Unbounded
+        std::vector<Node> children {};
+
+        static constexpr size_t Unbounded = size_t(-1);
+    };
+
+    class Parser
+    {
+      public:
+        Parser(std::u32string_view pattern, bool ignoreCase, CharSetTable& sets):
+            _pattern { pattern }, _ignoreCase { ignoreCase }, _sets { sets }
+        {
+        }
+
+        Node parse()
+        {
+            auto node = parseAlternation();
+            if (!atEnd())
+                throw SyntaxError { "Unmatched )" };
+            return node;
+        }
+
+      private:
+        [[nodiscard]] bool atEnd() const noexcept { return _position == _pattern.size(); }
+        [[nodiscard]] char32_t peek() const noexcept { return _pattern[_position]; }
+        char32_t next() noexcept { return _pattern[_position++]; }
+
+        bool consume(char32_t expected) noexcept
+        {
+            if (atEnd() || peek() != expected)
+                return false;
+            ++_position;
+            return true;
+        }
+
+        Node setNode(CharSet set)
+        {
+            if (_ignoreCase)
+                set.addFoldedCase();
+            return Node { Node::Kind::Set, _sets.add(set) };
+        }
+
+        Node parseAlternation()
+        {
+            auto alternatives = std::vector<Node> {};
+            alternatives.emplace_back(parseConcatenation());
+            while (consume('|'))
+                alternatives.emplace_back(parseConcatenation());
+            if (alternatives.size() == 1)
+                return std::move(alternatives.front());
+            return Node { Node::Kind::Alternate, 0, 0, 0, std::move(alternatives) };
+        }
+
+        Node parseConcatenation()
+        {
+            auto node = Node { Node::Kind::Concat };
+            while (!atEnd() && peek() != '|' && peek() != ')')
+                node.children.emplace_back(parseRepetition());
+            return node;
+        }
+
+        Node parseRepetition()
+        {
+            auto node = parseAtom();
+            while (!atEnd())
+            {
+                auto min = size_t { 0 };
+                auto max = size_t { 0 };
+                if (consume('*'))
+                    max = Node::Unbounded;
+                else if (consume('+'))
+                {
+                    min = 1;
+                    max = Node::Unbounded;
+                }
+                else if (consume('?'))
+                    max = 1;
+                else if (!parseBounds(min, max))
+                    break;
+
+                auto children = std::vector<Node> {};
+                children.emplace_back(std::move(node));
+                node = Node { Node::Kind::Repeat, 0, min, max, std::move(children) };
+            }
+            return node;
+        }
+
+        // Parses {n}, {n,} or {n,m}, or leaves the input untouched if there is none.
+        bool parseBounds(size_t& min, size_t& max)
+        {
+            auto const start = _position;
+            auto const parseNumber = [&]() -> std::optional<size_t> {
+                auto value = std::optional<size_t> {};
+                while (!atEnd() && peek() >= '0' && peek() <= '9')
+                    value = std::min(value.value_or(0) * 10 + (next() - '0'), MaxRepetitionCount + 1);
+                return value;
+            };
+
+            if (consume('{'))
+            {
+                if (auto const first = parseNumber())
+                {
+                    min = max = *first;
+                    if (consume(','))
+                        max = parseNumber().value_or(Node::Unbounded);
+                    if (consume('}'))
+                    {
+                        if (min > MaxRepetitionCount || (max != Node::Unbounded && max > MaxRepetitionCount))
+                            throw SyntaxError { "Repetition count too large" };
+                        if (max < min)
+                            throw SyntaxError { "Invalid repetition bounds" };
+                        return true;
+                    }
+                }
+            }
+            _position = start;
+            return false;
+        }
+
+        Node parseAtom()
+        {
+            auto const ch = next();
+            switch (ch)
+            {
+                case '(': {
+                    auto node = parseAlternation();
+                    if (!consume(')'))
+                        throw SyntaxError { "Missing )" };
+                    return node;
+                }
+                case '*':
+                case '+':
+                case '?': throw SyntaxError { "Nothing to repeat" };
+                case '[':
+                    // Bracket expressions are case folded before being negated, and must not be folded again.
+                    return Node { Node::Kind::Set, _sets.add(parseBracketExpression()) };
+                case '.': return setNode(CharSet(0, MaxCodepoint));
+                case '^': return Node { Node::Kind::LineBegin };
+                case '$': return Node { Node::Kind::LineEnd };
+                case '\\': return setNode(parseEscape());
+                default: return setNode(CharSet(ch, ch));
+            }
+        }
+
+        CharSet parseEscape()
+        {
+            if (atEnd())
+                throw SyntaxError { "Trailing backslash" };
+
+            auto set = CharSet {};
+            switch (auto const ch = next())
+            {
+                case 'd': return digitCharSet();
+                case 'w': return wordCharSet();
+                case 's': return spaceCharSet();
+                case 'D': set = digitCharSet(); break;
+                case 'W': set = wordCharSet(); break;
+                case 'S': set = spaceCharSet(); break;
+                case 't': return CharSet('\t', '\t');
+                default: return CharSet(ch, ch);
+            }
+            set.negate();
+            return set;
+        }
+
+        CharSet parseBracketExpression()
+        {
+            auto const negated = consume('^');
+            auto set = CharSet {};
+            for (auto first = true;; first = false)
+            {
+                if (atEnd())
+                    throw SyntaxError { "Missing ]" };
+
+                auto ch = next();
+                if (ch == ']' && !first)
+                    break;
+                if (ch == '\\')
+                {
+                    auto const escaped = parseEscape();
+                    auto const ranges = escaped.normalized();
+                    if (ranges.size() != 1 || ranges.front().first != ranges.front().second)
+                    {
+                        set.add(escaped);
+                        continue;
+                    }
+                    ch = ranges.front().first;
+                }
+
+                auto last = ch;
+                if (_position + 1 < _pattern.size() && peek() == '-' && _pattern[_position + 1] != ']')
+                {
+                    ++_position;
+                    last = next();
+                    if (last == '\\')
+                        last = atEnd() ? last : next();
+                    if (last < ch)
+                        throw SyntaxError { "Invalid range" };
+                }
+                set.add(ch, last);
+            }
+
+            if (_ignoreCase)
+                set.addFoldedCase();
+            if (negated)
+                set.negate();
+            return set;
+        }
+
+        std::u32string_view _pattern;
+        bool _ignoreCase;
+        CharSetTable& _sets;
+        size_t _position = 0;
+    };
+
+    Node literalNode(std::u32string_view text, bool ignoreCase, CharSetTable& sets)
+    {
+        auto node = Node { Node::Kind::Concat };
+        for (auto const ch: text)
+        {
+            auto const folded = ignoreCase ? foldCase(ch) : ch;
+            node.children.emplace_back(Node { Node::Kind::Set, sets.add(CharSet(folded, folded)) });
+        }
+        return node;
+    }
+    // }}}
+
+    // {{{ NFA
+    struct NfaState
+    {
+        enum class Kind : uint8_t
+        {
+            Char,
+            Epsilon,
+            Split,
+            LineBegin,
+            LineEnd,
+            Match,
+        };
+
+        Kind kind = Kind::Epsilon;
+        uint32_t set = 0;  // Char
+        uint32_t out = 0;  // successor
+        uint32_t out1 = 0; // alternative successor of Split
+    };
+
+    /// Compiles a syntax tree into a Thompson NFA.
+    class NfaCompiler
+    {
+      public:
+        explicit NfaCompiler(std::vector<NfaState>& states): _states { states } {}
+
+        uint32_t compile(Node const& root)
+        {
+            auto fragment = compileNode(root);
+            patch(fragment.outs, add(NfaState { NfaState::Kind::Match }));
+            return fragment.start;
+        }
+
+      private:
+        struct Fragment
+        {
+            uint32_t start = 0;
+            std::vector<std::pair<uint32_t, bool>> outs {}; // dangling successors: state and whether out1
+        };
+
+        uint32_t add(NfaState state)
+        {
+            if (_states.size() >= MaxNfaStates)
+                throw SyntaxError { "Pattern too complex" };
+            _states.push_back(state);
+            return static_cast<uint32_t>(_states.size() - 1);
+        }
+
+        void patch(std::vector<std::pair<uint32_t, bool>> const& outs, uint32_t target)
+        {
+            for (auto const& [state, alternative]: outs)
+                (alternative ? _states[state].out1 : _states[state].out) = target;
+        }
+
+        Fragment single(NfaState state)
+        {
+            auto const index = add(state);
+            return Fragment { index, { { index, false } } };
+        }
+
+        void append(std::optional<Fragment>& sequence, Fragment fragment)
+        {
+            if (!sequence)
+                sequence = std::move(fragment);
+            else
+            {
+                patch(sequence->outs, fragment.start);
+                sequence->outs = std::move(fragment.outs);
+            }
+        }
+
+        Fragment compileNode(Node const& node)
+        {
+            switch (node.kind)
+            {
+                case Node::Kind::Empty: return single(NfaState { NfaState::Kind::Epsilon });
+                case Node::Kind::Set: return single(NfaState { NfaState::Kind::Char, node.set });
+                case Node::Kind::LineBegin: return single(NfaState { NfaState::Kind::LineBegin });
+                case Node::Kind::LineEnd: return single(NfaState { NfaState::Kind::LineEnd });
+                case Node::Kind::Concat: {
+                    auto sequence = std::optional<Fragment> {};
+                    for (auto const& child: node.children)
+                        append(sequence, compileNode(child));
+                    return sequence ? std::move(*sequence) : single(NfaState { NfaState::Kind::Epsilon });
+                }
+                case Node::Kind::Alternate: {
+                    auto result = compileNode(node.children.back());
+                    for (auto i = node.children.size() - 1; i-- > 0;)
+                    {
+                        auto alternative = compileNode(node.children[i]);
+                        auto const split =
+                            add(NfaState { NfaState::Kind::Split, 0, alternative.start, result.start });
+                        alternative.outs.insert(alternative.outs.end(), result.outs.begin(), result.outs.end());
+                        result = Fragment { split, std::move(alternative.outs) };
+                    }
+                    return result;
+                }
+                case Node::Kind::Repeat: {
+                    auto const& child = node.children.front();
+                    auto sequence = std::optional<Fragment> {};
+                    for (size_t i = 0; i < node.min; ++i)
+                        append(sequence, compileNode(child));
+                    if (node.max == Node::Unbounded)
+                    {
+                        auto body = compileNode(child);
+                        auto const split = add(NfaState { NfaState::Kind::Split, 0, body.start });
+                        patch(body.outs, split);
+                        append(sequence, Fragment { split, { { split, true } } });
+                    }
+                    else
+                    {
+                        for (auto i = node.min; i < node.max; ++i)
+                        {
+                            auto body = compileNode(child);
+                            auto const split = add(NfaState { NfaState::Kind::Split, 0, body.start });
+                            body.outs.emplace_back(split, true);
+                            append(sequence, Fragment { split, std::move(body.outs) });
+                        }
+                    }
+                    return sequence ? std::move(*sequence) : single(NfaState { NfaState::Kind::Epsilon });
+                }
+            }
+            return single(NfaState { NfaState::Kind::Epsilon });
+        }
+
+        std::vector<NfaState>& _states;
+    };
+    // }}}
+
+    std::vector<uint16_t> literalTrigramHashes(std::u32string_view text)
+    {
+        // The trigram index only sees the first codepoint of each column, and blank columns break trigrams,
+        // so only trigrams of runs of printable ASCII characters are guaranteed to be indexed.
+        auto hashes = std::vector<uint16_t> {};
+        auto runStart = size_t { 0 };
+        for (size_t i = 0; i <= text.size(); ++i)
+        {
+            if (i < text.size() && text[i] > U' ' && text[i] < 0x7F)
+                continue;
+            auto const runHashes = TrigramFilter::hashes(text.substr(runStart, i - runStart));
+            hashes.insert(hashes.end(), runHashes.begin(), runHashes.end());
+            runStart = i + 1;
+        }
+        return hashes;
+    }
+} // namespace
+
+// {{{ Program
+struct SearchPattern::Program
+{
+    static constexpr int32_t Dead = -1;
+    static constexpr int32_t Unknown = -2;
+
+    enum StateFlags : uint8_t
+    {
+        Accepting = 0x01,      // a match ends right here
+        AcceptingAtEnd = 0x02, // a match ends here if this is the end of the line
+    };
+
+    // Lazily built deterministic automaton, whose states are sets of NFA states.
+    struct Dfa
+    {
+        bool unanchored = false;
+        std::vector<std::vector<uint32_t>> sets {};
+        std::map<std::vector<uint32_t>, int32_t> ids {};
+        std::vector<int32_t> transitions {}; // [state * classCount + class]
+        std::vector<uint8_t> flags {};
+        int32_t startAtLineBegin = Unknown;
+        int32_t startInsideLine = Unknown;
+        size_t flushCount = 0;
+    };
+
+    Program(Node const& root, CharSetTable const& charSets, bool ignoreCase): ignoreCase { ignoreCase }
+    {
+        start = NfaCompiler(states).compile(root);
+        marks.resize(states.size());
+
+        // Partition the codepoints into classes that no character set tells apart.
+        for (auto const& ranges: charSets.sets())
+            for (auto const& [first, last]: ranges)
+            {
+                boundaries.push_back(first);
+                if (last < MaxCodepoint)
+                    boundaries.push_back(last + 1);
+            }
+        std::sort(boundaries.begin(), boundaries.end());
+        boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
+        classCount = boundaries.size() + 1;
+
+        if (charSets.sets().size() * classCount > MaxCharMatchTableSize)
+            throw SyntaxError { "Pattern too complex" };
+
+        for (auto const& ranges: charSets.sets())
+            for (size_t i = 0; i < classCount; ++i)
+            {
+                auto const representative = i == 0 ? char32_t { 0 } : boundaries[i - 1];
+                charMatches.push_back(std::any_of(ranges.begin(), ranges.end(), [&](auto const& range) {
+                    return range.first <= representative && representative <= range.second;
+                }));
+            }
+
+        for (char32_t ch = 0; ch < asciiClasses.size(); ++ch)
+            asciiClasses[ch] = classOfSlow(ch);
+
+        unanchored.unanchored = true;
+    }
+
+    [[nodiscard]] bool matchesEmptyText()
+    {
+        auto set = beginSet();
+        addClosure(set, start, true, true);
+        return std::any_of(set.begin(), set.end(), [&](auto s) { return isMatch(s); });
+    }
+
+    [[nodiscard]] uint32_t classOfSlow(char32_t codepoint) const noexcept
+    {
+        return static_cast<uint32_t>(std::upper_bound(boundaries.begin(), boundaries.end(), codepoint)
+                                     - boundaries.begin());
+    }
+
+    [[nodiscard]] uint32_t classOf(char32_t codepoint) const noexcept
+    {
+        if (ignoreCase)
+            codepoint = foldCase(codepoint);
+        if (codepoint < asciiClasses.size())
+            return asciiClasses[codepoint];
+        return classOfSlow(codepoint);
+    }
+
+    [[nodiscard]] bool isMatch(uint32_t state) const noexcept
+    {
+        return states[state].kind == NfaState::Kind::Match;
+    }
+
+    std::vector<uint32_t> beginSet()
+    {
+        if (++generation == 0)
+        {
+            std::fill(marks.begin(), marks.end(), 0);
+            generation = 1;
+        }
+        return {};
+    }
+
+    // Adds the given state and all states reachable from it without consuming a codepoint.
+    void addClosure(std::vector<uint32_t>& set, uint32_t state, bool atLineBegin, bool atLineEnd)
+    {
+        stack.push_back(state);
+        while (!stack.empty())
+        {
+            auto const current = stack.back();
+            stack.pop_back();
+            if (marks[current] == generation)
+                continue;
+            marks[current] = generation;
+
+            auto const& nfaState = states[current];
+            switch (nfaState.kind)
+            {
+                case NfaState::Kind::Char:
+                case NfaState::Kind::Match: set.push_back(current); break;
+                case NfaState::Kind::Epsilon: stack.push_back(nfaState.out); break;
+                case NfaState::Kind::Split:
+                    stack.push_back(nfaState.out1);
+                    stack.push_back(nfaState.out);
+                    break;
+                case NfaState::Kind::LineBegin:
+                    if (atLineBegin)
+                        stack.push_back(nfaState.out);
+                    break;
+                case NfaState::Kind::LineEnd:
+                    if (atLineEnd)
+                        stack.push_back(nfaState.out);
+                    else
+                        set.push_back(current); // may still be passed at the end of the line
+                    break;
+            }
+        }
+    }
+
+    int32_t intern(Dfa& dfa, std::vector<uint32_t> set)
+    {
+        if (set.empty())
+            return Dead;
+
+        std::sort(set.begin(), set.end());
+        if (auto const i = dfa.ids.find(set); i != dfa.ids.end())
+            return i->second;
+
+        if (dfa.sets.size() >= MaxDfaStates)
+            flush(dfa);
+
+        auto flags = uint8_t { 0 };
+        for (auto const state: set)
+        {
+            if (isMatch(state))
+                flags |= Accepting | AcceptingAtEnd;
+            else if (states[state].kind == NfaState::Kind::LineEnd && !(flags & AcceptingAtEnd))
+            {
+                auto closure = beginSet();
+                addClosure(closure, states[state].out, false, true);
+                if (std::any_of(closure.begin(), closure.end(), [&](auto s) { return isMatch(s); }))
+                    flags |= AcceptingAtEnd;
+            }
+        }
+
+        auto const id = static_cast<int32_t>(dfa.sets.size());
+        dfa.sets.push_back(set);
+        dfa.ids.emplace(std::move(set), id);
+        dfa.flags.push_back(flags);
+        dfa.transitions.resize(dfa.transitions.size() + classCount, Unknown);
+        return id;
+    }
+
+    static void flush(Dfa& dfa)
+    {
+        dfa.sets.clear();
+        dfa.ids.clear();
+        dfa.transitions.clear();
+        dfa.flags.clear();
+        dfa.startAtLineBegin = Unknown;
+        dfa.startInsideLine = Unknown;
+        ++dfa.flushCount;
+    }
+
+    int32_t startState(Dfa& dfa, bool atLineBegin)
+    {
+        auto& cached = atLineBegin ? dfa.startAtLineBegin : dfa.startInsideLine;
+        if (cached != Unknown)
+            return cached;
+
+        auto set = beginSet();
+        addClosure(set, start, atLineBegin, false);
+        auto const id = intern(dfa, std::move(set));
+        (atLineBegin ? dfa.startAtLineBegin : dfa.startInsideLine) = id;
+        return id;
+    }
+
+    int32_t nextState(Dfa& dfa, int32_t state, uint32_t codepointClass)
+    {
+        if (auto const cached = dfa.transitions[static_cast<size_t>(state) * classCount + codepointClass];
+            cached != Unknown)
+            return cached;
+
+        auto set = beginSet();
+        for (auto const nfaState: dfa.sets[static_cast<size_t>(state)])
+            if (states[nfaState].kind == NfaState::Kind::Char
+                && charMatches[states[nfaState].set * classCount + codepointClass])
+                addClosure(set, states[nfaState].out, false, false);
+        if (dfa.unanchored)
+            addClosure(set, start, false, false);
+
+        auto const flushCount = dfa.flushCount;
+        auto const next = intern(dfa, std::move(set));
+        if (dfa.flushCount == flushCount)
+            dfa.transitions[static_cast<size_t>(state) * classCount + codepointClass] = next;
+        return next;
+    }
+
+    // Scans for the end of the first match that begins at or after @p from.
+    std::optional<size_t> firstMatchEnd(gsl::span<char32_t const> text, size_t from)
+    {
+        auto state = startState(unanchored, from == 0);
+        for (auto i = from; i < text.size() && state != Dead; ++i)
+        {
+            state = nextState(unanchored, state, classOf(text[i]));
+            if (state != Dead && (unanchored.flags[static_cast<size_t>(state)] & Accepting))
+                return i + 1;
+        }
+        if (state != Dead && (unanchored.flags[static_cast<size_t>(state)] & AcceptingAtEnd))
+            return text.size();
+        return std::nullopt;
+    }
+
+    // Returns the end of the longest match that begins exactly at @p begin.
+    std::optional<size_t> longestMatchAt(gsl::span<char32_t const> text, size_t begin)
+    {
+        auto state = startState(anchored, begin == 0);
+        auto end = std::optional<size_t> {};
+        for (auto i = begin; i < text.size() && state != Dead; ++i)
+        {
+            state = nextState(anchored, state, classOf(text[i]));
+            if (state != Dead && (anchored.flags[static_cast<size_t>(state)] & Accepting))
+                end = i + 1;
+        }
+        if (state != Dead && (anchored.flags[static_cast<size_t>(state)] & AcceptingAtEnd))
+            end = text.size();
+        return end;
+    }
+
+    bool ignoreCase;
+    std::vector<NfaState> states;
+    uint32_t start = 0;
+
+    std::vector<char32_t> boundaries;     // first codepoint of each codepoint class but the first
+    std::array<uint32_t, 128> asciiClasses {};
+    size_t classCount = 0;
+    std::vector<uint8_t> charMatches; // [set * classCount + class]
+
+    Dfa anchored;
+    Dfa unanchored;
+
+    // Scratch space for computing closures.
+    std::vector<uint32_t> stack;
+    std::vector<uint32_t> marks;
+    uint32_t generation = 0;
+};
+// }}}
+
+SearchPattern::SearchPattern(): _error { "Empty search term" }
+{
+}
+
+SearchPattern::SearchPattern(std::u32string_view pattern, SearchOptions options):
+    _source { pattern }, _options { options }
+{
+    if (pattern.empty())
+    {
+        _error = "Empty search term";
+        return;
+    }
+
+    try
+    {
+        auto charSets = CharSetTable {};
+        auto const root = options.regex ? Parser(pattern, options.ignoreCase, charSets).parse()
+                                        : literalNode(pattern, options.ignoreCase, charSets);
+        auto program = std::make_unique<Program>(root, charSets, options.ignoreCase);
+        if (program->matchesEmptyText())
+        {
+            _error = "Pattern matches empty text";
+            return;
+        }
+        _program = std::move(program);
+    }
+    catch (SyntaxError const& e)
+    {
+        _error = e.message;
+        return;
+    }
+
+    if (!options.regex && !options.ignoreCase)
+        _trigramHashes = literalTrigramHashes(pattern);
+}
+
+SearchPattern SearchPattern::fromSearchTerm(std::u32string_view term)
+{
+    auto options = SearchOptions {};
+    auto pattern = std::u32string {};
+    for (size_t i = 0; i < term.size(); ++i)
+    {
+        if (term[i] == '\\' && i + 1 < term.size())
+        {
+            switch (term[++i])
+            {
+                case 'c': options.ignoreCase = true; continue;
+                case 'C': options.ignoreCase = false; continue;
+                case 'v': options.regex = true; continue;
+                case 'V': options.regex = false; continue;
+                default: pattern += '\\'; break;
+            }
+        }
+        pattern += term[i];
+    }
+
+    auto result = SearchPattern(pattern, options);
+    result._source = term;
+    return result;
+}
+
+SearchPattern::~SearchPattern() = default;
+SearchPattern::SearchPattern(SearchPattern&&) noexcept = default;
+SearchPattern& SearchPattern::operator=(SearchPattern&&) noexcept = default;
+
+std::optional<SearchPattern::Match> SearchPattern::find(gsl::span<char32_t const> text, size_t from) const
+{
+    if (!_program || from >= text.size())
+        return std::nullopt;
+
+    auto const end = _program->firstMatchEnd(text, from);
+    if (!end)
+        return std::nullopt;
+
+    // The leftmost match cannot begin after the match that ends first.
+    for (auto begin = from; begin < *end; ++begin)
+        if (auto const matchEnd = _program->longestMatchAt(text, begin))
+            return Match { begin, *matchEnd };
+
+    return std::nullopt;
+}
+
+std::optional<SearchPattern::Match> SearchPattern::findReverse(gsl::span<char32_t const> text,
+                                                               size_t last) const
+{
+    if (!_program || text.empty() || !_program->firstMatchEnd(text, 0))
+        return std::nullopt;
+
+    for (auto begin = std::min(last, text.size() - 1) + 1; begin-- > 0;)
+        if (auto const matchEnd = _program->longestMatchAt(text, begin))
+            return Match { begin, *matchEnd };
+
+    return std::nullopt;
+}
+
+std::vector<SearchPattern::Match> SearchPattern::findAll(gsl::span<char32_t const> text) const
+{
+    auto matches = std::vector<Match> {};
+    auto from = size_t { 0 };
+    while (auto const match = find(text, from))
+    {
+        matches.push_back(*match);
+        from = match->end;
+    }
+    return matches;
+}
+
+} // namespace vtbackend
@@ -0,0 +1,173 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <gsl/span>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+struct SearchOptions
+{
+    // Interprets the pattern as regular expression rather than as literal text.
+    bool regex = false;
+
+    // Matches letters regardless of their case.
+    bool ignoreCase = false;
+};
+
+/**
+ * The text of a logical line as seen by SearchPattern.
+ *
+ * Holds one entry per codepoint, along with the column of the grapheme cluster it belongs to.
+ * Blank columns and spaces in between text read as spaces, whereas trailing ones are not part of the text.
+ */
+class SearchText
+{
+  public:
+    void clear() noexcept
+    {
+        codepoints.clear();
+        columns.clear();
+        widths.clear();
+        _nextColumn = 0;
+    }
+
+    /// Appends a codepoint of the grapheme cluster at the given column.
+    ///
+    /// Columns must be passed in ascending order, with all codepoints of a grapheme cluster
+    /// being passed with the same column.
+    void append(size_t column, char32_t codepoint, uint8_t width)
+    {
+        if (codepoint == U' ')
+            return;
+        for (; _nextColumn < column; ++_nextColumn)
+            push(_nextColumn, U' ', 1);
+        push(column, codepoint, width);
+        _nextColumn = column + std::max<size_t>(width, 1);
+    }
+
+    [[nodiscard]] size_t size() const noexcept { return codepoints.size(); }
+
+    /// Returns the index of the first codepoint at or after the given column.
+    [[nodiscard]] size_t indexOf(size_t column) const noexcept
+    {
+        return static_cast<size_t>(std::lower_bound(columns.begin(), columns.end(), column) - columns.begin());
+    }
+
+    /// Returns the column of the codepoint at @p begin.
+    [[nodiscard]] size_t firstColumn(size_t begin) const noexcept { return columns[begin]; }
+
+    /// Returns the last column covered by the codepoints up to (excluding) @p end.
+    [[nodiscard]] size_t lastColumn(size_t end) const noexcept
+    {
+        return columns[end - 1] + std::max<size_t>(widths[end - 1], 1) - 1;
+    }
+
+    std::vector<char32_t> codepoints;
+    std::vector<uint32_t> columns;
+    std::vector<uint8_t> widths;
+
+  private:
+    void push(size_t column, char32_t codepoint, uint8_t width)
+    {
+        codepoints.push_back(codepoint);
+        columns.push_back(static_cast<uint32_t>(column));
+        widths.push_back(width);
+    }
+
+    size_t _nextColumn = 0;
+};
+
+/**
+ * Compiled search term that can be matched against the text of logical lines.
+ *
+ * Literal text as well as regular expressions are compiled into a non-deterministic automaton,
+ * which is lazily turned into a deterministic one while matching, such that each codepoint
+ * is only looked at a constant number of times when scanning for a match.
+ *
+ * The supported regular expression syntax is: literal characters, `.`, bracket expressions
+ * such as `[a-z_]` and `[^0-9]`, the classes `\d`, `\w`, `\s` and their negations,
+ * grouping with `(...)`, alternation with `|`, the quantifiers `*`, `+`, `?`, `{n}`, `{n,}` and `{n,m}`,
+ * as well as the anchors `^` and `$` for the beginning and end of a logical line.
+ *
+ * Matches are leftmost-longest, and never empty. A pattern that could match empty text,
+ * as well as a pattern that fails to compile, does not match anything.
+ *
+ * Matching caches automaton states inside the pattern, and thus must not be done
+ * concurrently on the same instance.
+ */
+class SearchPattern
+{
+  public:
+    struct Match
+    {
+        size_t begin = 0; // Index of the first matching codepoint.
+        size_t end = 0;   // Index past the last matching codepoint.
+    };
+
+    /// Constructs a pattern that does not match anything.
+    SearchPattern();
+
+    SearchPattern(std::u32string_view pattern, SearchOptions options);
+
+    /// Constructs a pattern matching the given text literally.
+    explicit SearchPattern(std::u32string_view text): SearchPattern(text, SearchOptions {}) {}
+
+    /// Compiles a search term as entered by the user.
+    ///
+    /// Similar to Vim, the term is matched literally unless it contains `\v`, which turns it into
+    /// a regular expression, and is matched case-insensitively if it contains `\c`.
+    /// The flags themselves are not part of the pattern.
+    [[nodiscard]] static SearchPattern fromSearchTerm(std::u32string_view term);
+
+    ~SearchPattern();
+    SearchPattern(SearchPattern&&) noexcept;
+    SearchPattern& operator=(SearchPattern&&) noexcept;
+    SearchPattern(SearchPattern const&) = delete;
+    SearchPattern& operator=(SearchPattern const&) = delete;
+
+    /// The pattern as it was passed in, including search term flags if created by fromSearchTerm().
+    [[nodiscard]] std::u32string const& source() const noexcept { return _source; }
+    [[nodiscard]] SearchOptions options() const noexcept { return _options; }
+
+    /// Tests if the pattern can match anything at all.
+    [[nodiscard]] bool valid() const noexcept { return _program != nullptr; }
+
+    /// Describes why the pattern does not match anything, or is empty if it is valid.
+    [[nodiscard]] std::string const& error() const noexcept { return _error; }
+
+    /// Hashes of the trigrams every match is guaranteed to contain.
+    ///
+    /// This is only known for case-sensitive literal patterns, and empty otherwise.
+    ///
+    /// @see TrigramFilter
+    [[nodiscard]] std::vector<uint16_t> const& trigramHashes() const noexcept { return _trigramHashes; }
+
+    /// Finds the leftmost-longest match that begins at or after @p from.
+    [[nodiscard]] std::optional<Match> find(gsl::span<char32_t const> text, size_t from = 0) const;
+
+    /// Finds the longest match that begins at or before @p last, and as close to it as possible.
+    [[nodiscard]] std::optional<Match> findReverse(gsl::span<char32_t const> text, size_t last) const;
+
+    /// Finds all non-overlapping matches, from left to right.
+    [[nodiscard]] std::vector<Match> findAll(gsl::span<char32_t const> text) const;
+
+  private:
+    struct Program;
+
+    std::u32string _source;
+    SearchOptions _options;
+    std::string _error;
+    std::vector<uint16_t> _trigramHashes;
+    std::unique_ptr<Program> _program;
+};
+
+} // namespace vtbackend
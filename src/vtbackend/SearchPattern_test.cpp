@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/SearchPattern.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <optional>
+#include <string_view>
+
+using namespace std;
+using namespace vtbackend;
+
+namespace
+{
+optional<u32string_view> findIn(SearchPattern const& pattern, u32string_view text, size_t from = 0)
+{
+    auto const match = pattern.find(gsl::span(text.data(), text.size()), from);
+    if (!match)
+        return nullopt;
+    return text.substr(match->begin, match->end - match->begin);
+}
+
+SearchPattern regex(u32string_view pattern, bool ignoreCase = false)
+{
+    return SearchPattern(pattern, SearchOptions { true, ignoreCase });
+}
+} // namespace
+
+TEST_CASE("SearchPattern.literal", "[search]")
+{
+    auto const pattern = SearchPattern(U"a.c");
+    REQUIRE(pattern.valid());
+    CHECK(findIn(pattern, U"abc a.c") == U"a.c");
+    CHECK(!findIn(pattern, U"abc"));
+    CHECK(!findIn(pattern, U"a.c", 1));
+    CHECK(!findIn(pattern, U"A.C"));
+    CHECK(!pattern.trigramHashes().empty());
+}
+
+TEST_CASE("SearchPattern.ignoreCase", "[search]")
+{
+    auto const pattern = SearchPattern(U"Straße ÄÖ", SearchOptions { false, true });
+    CHECK(findIn(pattern, U"-- STRAßE äö --") == U"STRAßE äö");
+    CHECK(findIn(pattern, U"straße äÖ") == U"straße äÖ");
+    CHECK(pattern.trigramHashes().empty());
+
+    CHECK(findIn(regex(U"[a-c]+", true), U"xxAbCd") == U"AbC");
+    CHECK(findIn(regex(U"[^A-Z]+", true), U"ABc123") == U"123");
+
+    // Negated bracket expressions exclude both cases of their letters.
+    CHECK(!findIn(regex(U"[^a]", true), U"aA"));
+    CHECK(findIn(regex(U"[^a-z]+", true), U"hello WORLD 42") == U" ");
+    CHECK(!findIn(regex(U"[^0-9]", true), U"0123456789"));
+    CHECK(findIn(regex(U"[^0-9]", true), U"Z") == U"Z");
+}
+
+TEST_CASE("SearchPattern.regex", "[search]")
+{
+    CHECK(findIn(regex(U"fo+"), U"f fooo") == U"fooo");
+    CHECK(findIn(regex(U"colou?r"), U"the color") == U"color");
+    CHECK(findIn(regex(U"(ab|cd)+e"), U"xxabcdabe") == U"abcdabe");
+    CHECK(findIn(regex(U"\\d{2,3}"), U"a1b22c4444") == U"22");
+    CHECK(findIn(regex(U"\\d{3}"), U"a1b22c4444") == U"444");
+    CHECK(findIn(regex(U"[]a]+"), U"x]a]") == U"]a]");
+    CHECK(findIn(regex(U"\\w+\\s\\S"), U"-- error: x y") == U"x y");
+    CHECK(findIn(regex(U"a.c"), U"abc") == U"abc");
+    CHECK(findIn(regex(U"a\\.c"), U"abc a.c") == U"a.c");
+    CHECK(findIn(regex(U"x{"), U"x{") == U"x{");
+}
+
+TEST_CASE("SearchPattern.leftmostLongest", "[search]")
+{
+    // The leftmost match wins even though another one ends earlier.
+    CHECK(findIn(regex(U"abcd|bc"), U"abcd") == U"abcd");
+    CHECK(findIn(regex(U"a|ab|abc"), U"xabcx") == U"abc");
+}
+
+TEST_CASE("SearchPattern.anchors", "[search]")
+{
+    auto const begin = regex(U"^ab");
+    CHECK(findIn(begin, U"abab") == U"ab");
+    CHECK(!findIn(begin, U"abab", 1));
+    CHECK(!findIn(begin, U"xab"));
+
+    auto const end = regex(U"ab$");
+    auto const text = u32string_view(U"abab");
+    auto const match = end.find(gsl::span(text.data(), text.size()));
+    REQUIRE(match.has_value());
+    CHECK(match->begin == 2);
+    CHECK(!findIn(end, U"abx"));
+}
+
+TEST_CASE("SearchPattern.findReverse", "[search]")
+{
+    auto const pattern = regex(U"a+");
+    auto const text = u32string_view(U"aa-aaa-a");
+    auto const span = gsl::span(text.data(), text.size());
+
+    auto const last = pattern.findReverse(span, text.size() - 1);
+    REQUIRE(last.has_value());
+    CHECK(last->begin == 7);
+
+    auto const middle = pattern.findReverse(span, 5);
+    REQUIRE(middle.has_value());
+    CHECK(middle->begin == 5);
+    CHECK(middle->end == 6);
+
+    CHECK(!regex(U"b").findReverse(span, 7));
+}
+
+TEST_CASE("SearchPattern.findAll", "[search]")
+{
+    auto const text = u32string_view(U"a1 b22 c333");
+    auto const matches = regex(U"[a-z]\\d+").findAll(gsl::span(text.data(), text.size()));
+    REQUIRE(matches.size() == 3);
+    CHECK(matches[0].begin == 0);
+    CHECK(matches[0].end == 2);
+    CHECK(matches[1].begin == 3);
+    CHECK(matches[2].end == text.size());
+}
+
+TEST_CASE("SearchPattern.invalid", "[search]")
+{
+    CHECK(!SearchPattern().valid());
+    CHECK(!SearchPattern(U"").valid());
+    CHECK(!regex(U"(ab").valid());
+    CHECK(!regex(U"ab)").valid());
+    CHECK(!regex(U"[ab").valid());
+    CHECK(!regex(U"*a").valid());
+    CHECK(!regex(U"a\\").valid());
+    CHECK(!regex(U"a{3,2}").valid());
+    CHECK(!regex(U"a*").valid()); // would match empty text
+    CHECK(!regex(U"^").valid());
+    CHECK(!regex(U"(ab").error().empty());
+    CHECK(!findIn(regex(U"(ab"), U"ab"));
+}
+
+TEST_CASE("SearchPattern.fromSearchTerm", "[search]")
+{
+    auto const literal = SearchPattern::fromSearchTerm(U"a.c");
+    CHECK(!literal.options().regex);
+    CHECK(!findIn(literal, U"abc"));
+
+    auto const regexTerm = SearchPattern::fromSearchTerm(U"\\va.c");
+    CHECK(regexTerm.options().regex);
+    CHECK(regexTerm.source() == U"\\va.c");
+    CHECK(findIn(regexTerm, U"abc") == U"abc");
+
+    auto const ignoreCase = SearchPattern::fromSearchTerm(U"abc\\c");
+    CHECK(ignoreCase.options().ignoreCase);
+    CHECK(findIn(ignoreCase, U"ABC") == U"ABC");
+
+    auto const negated = SearchPattern::fromSearchTerm(U"\\c\\v[^a-z]+");
+    CHECK(negated.options().ignoreCase);
+    CHECK(!findIn(negated, U"hello"));
+    CHECK(!findIn(negated, U"HELLO"));
+    CHECK(findIn(negated, U"HELLO, world") == U", ");
+
+    // An escaped backslash is not taken as a flag.
+    auto const escaped = SearchPattern::fromSearchTerm(U"\\v\\\\c");
+    CHECK(!escaped.options().ignoreCase);
+    CHECK(findIn(escaped, U"a\\c") == U"\\c");
+}
+
+TEST_CASE("SearchText", "[search]")
+{
+    auto text = SearchText {};
+    text.append(1, U'a', 1);
+    text.append(2, U' ', 1);
+    text.append(4, U'日', 2);
+    text.append(7, U' ', 1);
+
+    // Leading and inner blanks read as spaces, trailing ones are dropped.
+    CHECK(u32string_view(text.codepoints.data(), text.size()) == U" a  日");
+    CHECK(text.indexOf(4) == 4);
+    CHECK(text.indexOf(5) == 5);
+    CHECK(text.firstColumn(4) == 4);
+    CHECK(text.lastColumn(5) == 5);
+}
@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <vtbackend/CellUtil.h>
 #include <vtbackend/Screen.h>
 #include <vtbackend/Sequencer.h>
 #include <vtbackend/SixelParser.h>
@@ -6,6 +7,7 @@
 #include <vtbackend/logging.h>
 #include <vtbackend/primitives.h>
 
+#include <optional>
 #include <string_view>
 
 using std::get;
@@ -17,6 +19,178 @@ using namespace std::string_view_literals;
 namespace vtbackend
 {
 
+namespace
+{
+    /// Reads the color following SGR 38, 48, or 58 at parameter @p i, in one of the forms
+    /// "5:P", "2:R:G:B", "2::R:G:B", "5;P", or "2;R;G;B", and advances @p i to its last parameter.
+    ///
+    /// @return the color, or std::nullopt for any other form.
+    std::optional<Color> readColor(SequenceParameters const& parameters, size_t& i) noexcept
+    {
+        auto const count = parameters.count();
+        auto const rgb = [&](size_t first) -> std::optional<Color> {
+            auto const r = parameters.at(first);
+            auto const g = parameters.at(first + 1);
+            auto const b = parameters.at(first + 2);
+            if (r > 255 || g > 255 || b > 255)
+                return std::nullopt;
+            return RGBColor { static_cast<uint8_t>(r), static_cast<uint8_t>(g), static_cast<uint8_t>(b) };
+        };
+
+        if (auto const len = parameters.subParameterCount(i); len != 0)
+        {
+            auto color = std::optional<Color> {};
+            if (parameters.at(i + 1) == 2 && (len == 4 || len == 5))
+                color = rgb(i + len - 2);
+            else if (parameters.at(i + 1) == 5 && len == 2 && parameters.at(i + 2) <= 255)
+                color = static_cast<IndexedColor>(parameters.at(i + 2));
+            if (color)
+                i += len;
+            return color;
+        }
+
+        if (i + 2 < count && parameters.at(i + 1) == 5 && !parameters.isSubParameter(i + 2)
+            && parameters.at(i + 2) <= 255)
+        {
+            i += 2;
+            return static_cast<IndexedColor>(parameters.at(i));
+        }
+
+        if (i + 4 < count && parameters.at(i + 1) == 2 && parameters.subParameterCount(i + 1) == 0
+            && parameters.subParameterCount(i + 2) == 0 && parameters.subParameterCount(i + 3) == 0)
+        {
+            auto const color = rgb(i + 2);
+            if (color)
+                i += 4;
+            return color;
+        }
+
+        return std::nullopt;
+    }
+
+    GraphicsRendition underlineStyle(uint16_t value) noexcept
+    {
+        switch (value)
+        {
+            case 0: return GraphicsRendition::NoUnderline;
+            case 2: return GraphicsRendition::DoublyUnderlined;
+            case 3: return GraphicsRendition::CurlyUnderlined;
+            case 4: return GraphicsRendition::DottedUnderline;
+            case 5: return GraphicsRendition::DashedUnderline;
+            default: return GraphicsRendition::Underline;
+        }
+    }
+
+    /// Applies the parameters of an SGR sequence to @p sgr.
+    ///
+    /// This is equivalent to what Screen does for SGR, but works on the parameters directly.
+    ///
+    /// @return false if the parameters contain less common forms, such as CMY colors or
+    ///         sub-parameters on other attributes than underline and colors, which are left
+    ///         to the generic implementation. @p sgr is then left in an unspecified state.
+    bool applySGR(SequenceParameters const& parameters, GraphicsAttributes& sgr) noexcept
+    {
+        auto const count = parameters.count();
+        if (count == 0)
+        {
+            sgr = {};
+            return true;
+        }
+
+        auto const set = [&](GraphicsRendition rendition) {
+            sgr.flags = CellUtil::makeCellFlags(rendition, sgr.flags);
+        };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            auto const value = parameters.at(i);
+            auto const subParameterCount = parameters.subParameterCount(i);
+            switch (value)
+            {
+                case 0: sgr = {}; break;
+                case 1: set(GraphicsRendition::Bold); break;
+                case 2: set(GraphicsRendition::Faint); break;
+                case 3: set(GraphicsRendition::Italic); break;
+                case 4:
+                    if (subParameterCount > 1)
+                        return false;
+                    set(subParameterCount ? underlineStyle(parameters.at(++i))
+                                          : GraphicsRendition::Underline);
+                    continue;
+                case 5: set(GraphicsRendition::Blinking); break;
+                case 6: set(GraphicsRendition::RapidBlinking); break;
+                case 7: set(GraphicsRendition::Inverse); break;
+                case 8: set(GraphicsRendition::Hidden); break;
+                case 9: set(GraphicsRendition::CrossedOut); break;
+                case 21: set(GraphicsRendition::DoublyUnderlined); break;
+                case 22: set(GraphicsRendition::Normal); break;
+                case 23: set(GraphicsRendition::NoItalic); break;
+                case 24: set(GraphicsRendition::NoUnderline); break;
+                case 25: set(GraphicsRendition::NoBlinking); break;
+                case 27: set(GraphicsRendition::NoInverse); break;
+                case 28: set(GraphicsRendition::NoHidden); break;
+                case 29: set(GraphicsRendition::NoCrossedOut); break;
+                case 30:
+                case 31:
+                case 32:
+                case 33:
+                case 34:
+                case 35:
+                case 36:
+                case 37: sgr.foregroundColor = static_cast<IndexedColor>(value - 30); break;
+                case 39: sgr.foregroundColor = DefaultColor(); break;
+                case 40:
+                case 41:
+                case 42:
+                case 43:
+                case 44:
+                case 45:
+                case 46:
+                case 47: sgr.backgroundColor = static_cast<IndexedColor>(value - 40); break;
+                case 49: sgr.backgroundColor = DefaultColor(); break;
+                case 38:
+                case 48:
+                case 58:
+                    if (auto const color = readColor(parameters, i))
+                    {
+                        switch (value)
+                        {
+                            case 38: sgr.foregroundColor = *color; break;
+                            case 48: sgr.backgroundColor = *color; break;
+                            default: sgr.underlineColor = *color; break;
+                        }
+                        continue;
+                    }
+                    return false;
+                case 51: set(GraphicsRendition::Framed); break;
+                case 53: set(GraphicsRendition::Overline); break;
+                case 54: set(GraphicsRendition::NoFramed); break;
+                case 55: set(GraphicsRendition::NoOverline); break;
+                case 90:
+                case 91:
+                case 92:
+                case 93:
+                case 94:
+                case 95:
+                case 96:
+                case 97: sgr.foregroundColor = static_cast<BrightColor>(value - 90); break;
+                case 100:
+                case 101:
+                case 102:
+                case 103:
+                case 104:
+                case 105:
+                case 106:
+                case 107: sgr.backgroundColor = static_cast<BrightColor>(value - 100); break;
+                default: break;
+            }
+            if (subParameterCount != 0)
+                return false;
+        }
+        return true;
+    }
+} // namespace
+
 Sequencer::Sequencer(Terminal& terminal): _terminal { terminal }, _parameterBuilder { _sequence.parameters() }
 {
 }
@@ -96,7 +270,9 @@ void Sequencer::dispatchCSI(char finalChar)
 {
     _sequence.setCategory(FunctionCategory::CSI);
     _sequence.setFinalChar(finalChar);
-    handleSequence();
+    _parameterBuilder.fixiate();
+    if (finalChar != 'm' || !applyGraphicsRendition())
+        _terminal.sequenceHandler().processSequence(_sequence);
 }
 
 void Sequencer::startOSC()
@@ -134,6 +310,12 @@ void Sequencer::put(char ch)
         _hookedParser->pass(ch);
 }
 
+void Sequencer::put(string_view chars)
+{
+    if (_hookedParser)
+        _hookedParser->pass(chars);
+}
+
 void Sequencer::unhook()
 {
     if (_hookedParser)
@@ -148,7 +330,9 @@ size_t Sequencer::maxBulkTextSequenceWidth() const noexcept
     if (!_terminal.isPrimaryScreen())
         return 0;
 
-    if (!_terminal.primaryScreen().currentLine().isTrivialBuffer())
+    // Span lines are written to in bulk, too, while inflated lines take the character-wise path.
+    auto const& currentLine = _terminal.primaryScreen().currentLine();
+    if (!currentLine.isTrivialBuffer() && !currentLine.isSpanBuffer())
         return 0;
 
     assert(_terminal.state().mainScreenMargin.horizontal.to
@@ -164,4 +348,30 @@ void Sequencer::handleSequence()
     _terminal.sequenceHandler().processSequence(_sequence);
 }
 
+bool Sequencer::applyGraphicsRendition()
+{
+    // SGR is by far the most frequent sequence, and thus applied right away, unless it has to be seen
+    // by the trace handler, or is not a plain SGR.
+    static constexpr auto SGRIndex = FunctionDispatchTable::indexOf(SGR);
+
+    if (_sequence.leaderSymbol() || !_sequence.intermediateCharacters().empty()
+        || _terminal.state().executionMode.load() != ExecutionMode::Normal
+        || !_terminal.supportedSequences().isActive(SGRIndex))
+        return false;
+
+#if defined(LIBTERMINAL_LOG_TRACE)
+    if (vtTraceSequenceLog)
+        return false;
+#endif
+
+    auto& cursor = _terminal.currentScreen().cursor();
+    auto sgr = cursor.graphicsRendition;
+    if (!applySGR(_sequence.parameters(), sgr))
+        return false;
+
+    cursor.graphicsRendition = sgr;
+    _terminal.state().instructionCounter++;
+    return true;
+}
+
 } // namespace vtbackend
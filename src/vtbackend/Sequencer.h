@@ -145,6 +145,7 @@ class Sequencer
     void dispatchOSC();
     void hook(char finalChar);
     void put(char ch);
+    void put(std::string_view chars);
     void unhook();
     void startAPC() {}
     void putAPC(char) {}
@@ -162,6 +163,7 @@ class Sequencer
 
   private:
     void handleSequence();
+    [[nodiscard]] bool applyGraphicsRendition();
 
     // private data
     //
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <vtbackend/ColorPalette.h>
+#include <vtbackend/Image.h>
 #include <vtbackend/InputGenerator.h> // Modifier
 #include <vtbackend/VTType.h>
 #include <vtbackend/primitives.h>
 
 #include <chrono>
 #include <map>
+#include <optional>
 
 namespace vtbackend
 {
@@ -38,7 +40,9 @@ struct Settings
     PageSize pageSize = PageSize { LineCount(25), ColumnCount(80) };
 
     MaxHistoryLineCount maxHistoryLineCount;
+    std::optional<LineCount> historySpillThreshold; // Lines kept in memory with infinite history.
     ImageSize maxImageSize { Width(800), Height(600) };
+    size_t maxImageMemory = ImagePool::DefaultMemoryBudget; // Budget for the pixel data of all images.
     unsigned maxImageRegisterCount = 256;
     StatusDisplayType statusDisplayType = StatusDisplayType::None;
     StatusDisplayPosition statusDisplayPosition = StatusDisplayPosition::Bottom;
@@ -59,6 +63,8 @@ struct Settings
     //
     // Defaults to 1 MB, that's roughly 10k lines when column count is 100.
     size_t ptyBufferObjectSize = 1024lu * 1024lu;
+    // Whether PTY Buffer Objects are to be backed by transparent huge pages, where supported.
+    bool ptyBufferHugePages = false;
     // Configures the size of the PTY read buffer.
     // Changing this value may result in better or worse throughput performance.
     //
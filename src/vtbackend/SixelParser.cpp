@@ -2,6 +2,7 @@
 #include <vtbackend/SixelParser.h>
 
 #include <algorithm>
+#include <cstring>
 
 using std::clamp;
 using std::fill;
@@ -158,9 +159,7 @@ void SixelParser::parse(char value)
                 paramShiftAndAddDigit(toDigit(value));
             else if (isSixel(value))
             {
-                auto const sixel = toSixel(value);
-                for (unsigned i = 0; i < _params[0]; ++i)
-                    _events.render(sixel);
+                _events.renderRepeated(toSixel(value), _params[0]);
                 transitionTo(State::Ground);
             }
             else
@@ -197,6 +196,22 @@ void SixelParser::parse(char value)
     }
 }
 
+void SixelParser::parseFragment(iterator begin, iterator end)
+{
+    auto input = begin;
+    while (input != end)
+    {
+        if (_state == State::Ground && isSixel(*input))
+        {
+            auto const runEnd = std::find_if_not(input, end, isSixel);
+            _events.renderRun(std::string_view(input, static_cast<size_t>(runEnd - input)));
+            input = runEnd;
+        }
+        else
+            parse(*input++);
+    }
+}
+
 void SixelParser::fallback(char value)
 {
     if (value == '#')
@@ -341,6 +356,11 @@ void SixelParser::pass(char ch)
     parse(ch);
 }
 
+void SixelParser::pass(std::string_view chars)
+{
+    parseFragment(chars);
+}
+
 void SixelParser::finalize()
 {
     done();
@@ -353,15 +373,24 @@ SixelImageBuilder::SixelImageBuilder(ImageSize maxSize,
                                      int aspectHorizontal,
                                      RGBAColor backgroundColor,
                                      std::shared_ptr<SixelColorPalette> colorPalette):
-    _maxSize { maxSize },
-    _colors { std::move(colorPalette) },
-    _size { ImageSize { Width { 1 }, Height { 1 } } },
-    _buffer(_maxSize.area() * 4),
-    _sixelCursor {},
-    _aspectRatio(static_cast<unsigned int>(
-        std::ceil(static_cast<float>(aspectVertical) / static_cast<float>(aspectHorizontal)))),
-    _sixelBandHeight(6 * _aspectRatio)
+    _maxSize { maxSize }
+{
+    reset(aspectVertical, aspectHorizontal, backgroundColor, std::move(colorPalette));
+}
+
+void SixelImageBuilder::reset(int aspectVertical,
+                              int aspectHorizontal,
+                              RGBAColor backgroundColor,
+                              std::shared_ptr<SixelColorPalette> colorPalette)
 {
+    _colors = std::move(colorPalette);
+    _size = ImageSize { Width { 1 }, Height { 1 } };
+    _buffer.resize(_maxSize.area() * 4);
+    _currentColor = 0;
+    _explicitSize = false;
+    _aspectRatio = static_cast<unsigned int>(
+        std::ceil(static_cast<float>(aspectVertical) / static_cast<float>(aspectHorizontal)));
+    _sixelBandHeight = 6 * _aspectRatio;
     clear(backgroundColor);
 }
 
@@ -389,32 +418,6 @@ RGBAColor SixelImageBuilder::at(CellLocation coord) const noexcept
     return RGBAColor { color[0], color[1], color[2], color[3] };
 }
 
-void SixelImageBuilder::write(CellLocation const& coord, RGBColor const& value) noexcept
-{
-    if (unbox(coord.line) >= 0 && unbox(coord.line) < unbox<int>(_maxSize.height) && unbox(coord.column) >= 0
-        && unbox(coord.column) < unbox<int>(_maxSize.width))
-    {
-        if (!_explicitSize)
-        {
-            if (unbox(coord.line) >= unbox<int>(_size.height))
-                _size.height = Height::cast_from(coord.line.as<unsigned int>() + _aspectRatio);
-            if (unbox(coord.column) >= unbox<int>(_size.width))
-                _size.width = Width::cast_from(coord.column + 1);
-        }
-
-        for (unsigned int i = 0; i < _aspectRatio; ++i)
-        {
-            auto const base = (coord.line.as<unsigned int>() + i)
-                                  * unbox((_explicitSize ? _size.width : _maxSize.width)) * 4u
-                              + unbox<unsigned int>(coord.column) * 4u;
-            _buffer[base + 0] = value.red;
-            _buffer[base + 1] = value.green;
-            _buffer[base + 2] = value.blue;
-            _buffer[base + 3] = 0xFF;
-        }
-    }
-}
-
 void SixelImageBuilder::setColor(unsigned index, RGBColor const& color)
 {
     _colors->setColor(index, color);
@@ -454,23 +457,118 @@ void SixelImageBuilder::setRaster(unsigned int pan, unsigned int pad, optional<I
     }
 }
 
+uint32_t SixelImageBuilder::currentPixel() const noexcept
+{
+    auto const color = currentColor();
+    auto const rgba = std::array<uint8_t, 4> { color.red, color.green, color.blue, 0xFF };
+    auto pixel = uint32_t {};
+    std::memcpy(&pixel, rgba.data(), sizeof(pixel));
+    return pixel;
+}
+
+int8_t SixelImageBuilder::visiblePins() const noexcept
+{
+    auto const line = unbox<unsigned>(_sixelCursor.line);
+    auto const height = canvasHeight();
+    auto pins = int8_t { 0 };
+    for (unsigned pin = 0; pin < 6 && line + pin * _aspectRatio < height; ++pin)
+        pins = static_cast<int8_t>(pins | (1 << pin));
+    return pins;
+}
+
+template <typename PaintRow>
+void SixelImageBuilder::forEachPixelRow(unsigned pin, unsigned column, PaintRow paintRow)
+{
+    auto const top = unbox<unsigned>(_sixelCursor.line) + pin * _aspectRatio;
+    auto const bottom = min(top + _aspectRatio, canvasHeight());
+    for (auto y = top; y < bottom; ++y)
+        paintRow(_buffer.data() + (static_cast<size_t>(y) * stride() + column) * 4);
+}
+
+void SixelImageBuilder::grow(int8_t pins, unsigned columnEnd) noexcept
+{
+    if (_explicitSize || pins == 0)
+        return;
+
+    auto lastPin = 5u;
+    while (!(pins & (1 << lastPin)))
+        --lastPin;
+
+    auto const bottom = min(unbox<unsigned>(_sixelCursor.line) + (lastPin + 1) * _aspectRatio,
+                            unbox(_maxSize.height));
+    _size.width = max(_size.width, Width(columnEnd));
+    _size.height = max(_size.height, Height(bottom));
+}
+
 void SixelImageBuilder::render(int8_t sixel)
 {
-    // TODO: respect aspect ratio!
-    auto const x = _sixelCursor.column;
-    if (unbox(x) < unbox<int>((_explicitSize ? _size.width : _maxSize.width)))
+    renderRepeated(sixel, 1);
+}
+
+void SixelImageBuilder::renderRepeated(int8_t sixel, unsigned count)
+{
+    auto const x = unbox<unsigned>(_sixelCursor.column);
+    if (x >= stride())
+        return;
+
+    count = min(count, stride() - x);
+    auto const pins = static_cast<int8_t>(sixel & visiblePins());
+    auto const pixel = currentPixel();
+    for (unsigned pin = 0; pin < 6; ++pin)
     {
-        for (unsigned int i = 0; i < 6; ++i)
+        if (!(pins & (1 << pin)))
+            continue;
+        forEachPixelRow(pin, x, [&](uint8_t* row) {
+            for (unsigned i = 0; i < count; ++i)
+                std::memcpy(row + i * 4, &pixel, sizeof(pixel));
+        });
+    }
+    grow(pins, x + count);
+    _sixelCursor.column = ColumnOffset::cast_from(x + count);
+}
+
+void SixelImageBuilder::renderRun(std::string_view sixels)
+{
+    auto const x = unbox<unsigned>(_sixelCursor.column);
+    if (x >= stride())
+        return;
+
+    auto const count = min(static_cast<unsigned>(sixels.size()), stride() - x);
+    auto const visible = visiblePins();
+
+    // Determines the pins in use and the extent of the run up front, such that pixel rows without any
+    // pinned sixel are skipped, and the image size is updated only once.
+    auto pins = int8_t { 0 };
+    auto extent = 0u;
+    for (unsigned i = 0; i < count; ++i)
+    {
+        if (auto const sixel = static_cast<int8_t>(toSixel(sixels[i]) & visible); sixel != 0)
         {
-            auto const y = _sixelCursor.line + static_cast<int>(i * _aspectRatio);
-            auto const pos = CellLocation { y, x };
-            auto const pin = 1 << i;
-            auto const pinned = (sixel & pin) != 0;
-            if (pinned)
-                write(pos, currentColor());
+            pins = static_cast<int8_t>(pins | sixel);
+            extent = i + 1;
         }
-        _sixelCursor.column++;
     }
+
+    // The band is written one pixel row at a time rather than sixel by sixel, which keeps the writes
+    // sequential and leaves the inner loop free of branches, so that the compiler can vectorize it.
+    auto const pixel = currentPixel();
+    for (unsigned pin = 0; pin < 6; ++pin)
+    {
+        if (!(pins & (1 << pin)))
+            continue;
+        forEachPixelRow(pin, x, [&](uint8_t* row) {
+            for (unsigned i = 0; i < extent; ++i)
+            {
+                auto const pinned = (toSixel(sixels[i]) >> pin) & 1;
+                auto current = uint32_t {};
+                std::memcpy(&current, row + i * 4, sizeof(current));
+                current = pinned ? pixel : current;
+                std::memcpy(row + i * 4, &current, sizeof(current));
+            }
+        });
+    }
+    grow(pins, x + extent);
+    _sixelCursor.column = ColumnOffset::cast_from(x + count);
 }
 
 void SixelImageBuilder::finalize()
@@ -483,18 +581,12 @@ void SixelImageBuilder::finalize()
     }
     if (!_explicitSize)
     {
-        Buffer tempBuffer(static_cast<size_t>(_size.height.value * _size.width.value) * 4);
-        for (auto i = 0u; i < unbox(_size.height); ++i)
-        {
-            for (auto j = 0u; j < unbox(_size.width); ++j)
-            {
-                std::copy_n(_buffer.begin() + i * unbox<long>(_maxSize.width) * 4,
-                            _size.width.value * 4,
-                            tempBuffer.begin() + i * unbox<long>(_size.width) * 4);
-            }
-        }
-        _buffer.swap(tempBuffer);
-        _explicitSize = false;
+        // Compacts the pixel rows in place, such that the buffer keeps its capacity for reuse.
+        auto const rowSize = unbox<size_t>(_size.width) * 4;
+        auto const canvasRowSize = unbox<size_t>(_maxSize.width) * 4;
+        for (size_t i = 1; i < unbox<size_t>(_size.height); ++i)
+            std::memmove(_buffer.data() + i * rowSize, _buffer.data() + i * canvasRowSize, rowSize);
+        _buffer.resize(_size.area() * 4);
     }
 }
 
@@ -6,9 +6,8 @@
 
 #include <vtparser/ParserExtension.h>
 
-#include <crispy/range.h>
-
 #include <array>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
@@ -66,6 +65,21 @@ class SixelParser: public ParserExtension
         /// renders a given sixel at the current sixel-cursor position.
         virtual void render(int8_t sixel) = 0;
 
+        /// Renders a run of sixels, given in their encoded form ('?' to '~'),
+        /// starting at the current sixel-cursor position.
+        virtual void renderRun(std::string_view sixels)
+        {
+            for (auto const ch: sixels)
+                render(static_cast<int8_t>(ch - '?'));
+        }
+
+        /// Renders the given sixel @p count times, as introduced by '!'.
+        virtual void renderRepeated(int8_t sixel, unsigned count)
+        {
+            for (unsigned i = 0; i < count; ++i)
+                render(sixel);
+        }
+
         /// Finalizes the image by optimizing the underlying storage to its minimal dimension in storage.
         virtual void finalize() = 0;
     };
@@ -75,11 +89,8 @@ class SixelParser: public ParserExtension
 
     using iterator = char const*;
 
-    void parseFragment(iterator begin, iterator end)
-    {
-        for (auto const ch: crispy::range(begin, end))
-            parse(ch);
-    }
+    /// Parses the given fragment, passing runs of sixel data on to the event handler at once.
+    void parseFragment(iterator begin, iterator end);
 
     void parseFragment(std::string_view range) { parseFragment(range.data(), range.data() + range.size()); }
 
@@ -95,6 +106,7 @@ class SixelParser: public ParserExtension
 
     // ParserExtension overrides
     void pass(char ch) override;
+    void pass(std::string_view chars) override;
     void finalize() override;
 
   private:
@@ -147,6 +159,12 @@ class SixelImageBuilder: public SixelParser::Events
                       RGBAColor backgroundColor,
                       std::shared_ptr<SixelColorPalette> colorPalette);
 
+    /// Prepares the builder for a new image of the same maximum size, reusing the underlying buffer.
+    void reset(int aspectVertical,
+               int aspectHorizontal,
+               RGBAColor backgroundColor,
+               std::shared_ptr<SixelColorPalette> colorPalette);
+
     [[nodiscard]] ImageSize maxSize() const noexcept { return _maxSize; }
     [[nodiscard]] ImageSize size() const noexcept { return _size; }
     [[nodiscard]] unsigned int aspectRatio() const noexcept { return _aspectRatio; }
@@ -165,12 +183,37 @@ class SixelImageBuilder: public SixelParser::Events
     void newline() override;
     void setRaster(unsigned int pan, unsigned int pad, std::optional<ImageSize> imageSize) override;
     void render(int8_t sixel) override;
+    void renderRun(std::string_view sixels) override;
+    void renderRepeated(int8_t sixel, unsigned count) override;
     void finalize() override;
 
     [[nodiscard]] CellLocation const& sixelCursor() const noexcept { return _sixelCursor; }
 
   private:
-    void write(CellLocation const& coord, RGBColor const& value) noexcept;
+    /// Width of the pixel rows in the buffer, as well as the width of the drawable area.
+    [[nodiscard]] unsigned stride() const noexcept
+    {
+        return unbox(_explicitSize ? _size.width : _maxSize.width);
+    }
+
+    /// Height of the drawable area.
+    [[nodiscard]] unsigned canvasHeight() const noexcept
+    {
+        return unbox(_explicitSize ? _size.height : _maxSize.height);
+    }
+
+    /// Returns the pins of a sixel at the current sixel-cursor position that are within the canvas.
+    [[nodiscard]] int8_t visiblePins() const noexcept;
+
+    /// Invokes @p paintRow with the start of each pixel row covered by the given pin,
+    /// at the given column.
+    template <typename PaintRow>
+    void forEachPixelRow(unsigned pin, unsigned column, PaintRow paintRow);
+
+    /// Grows the image to include the pixels painted by the given pins, up to the given column.
+    void grow(int8_t pins, unsigned columnEnd) noexcept;
+
+    [[nodiscard]] uint32_t currentPixel() const noexcept;
 
   private:
     ImageSize const _maxSize;
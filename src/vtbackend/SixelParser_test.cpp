@@ -362,3 +362,58 @@ TEST_CASE("SixelParser.vertical_cursor_advance", "[sixel]")
     REQUIRE(ib.size() == vtbackend::ImageSize { Width(1), Height(24) });
     REQUIRE(ib.sixelCursor() == CellLocation { LineOffset(24), ColumnOffset { 0 } });
 }
+
+TEST_CASE("SixelParser.batch", "[sixel]")
+{
+    // Parsing whole fragments renders runs of sixels at once, which must not make a difference
+    // to parsing them one by one, including sixels exceeding the canvas.
+    auto constexpr DefaultColor = RGBAColor { 0, 0, 0, 0xFF };
+    auto constexpr Stream = std::string_view("#1;2;100;0;0#2;2;0;100;0"
+                                             "#1~~@@vv@@~~@@~~$#2??}}GG}}??}}?\?-"
+                                             "!14@#1!3~A_o!20N$-"
+                                             "#2~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~-"
+                                             "#1?_O!7G~");
+
+    auto const decode = [&](bool batched) {
+        auto ib = SixelImageBuilder(ImageSize { Width(32), Height(30) },
+                                    2,
+                                    1,
+                                    DefaultColor,
+                                    std::make_shared<SixelColorPalette>(16, 256));
+        auto sp = SixelParser { ib };
+        if (batched)
+            sp.parseFragment(Stream);
+        else
+            for (auto const ch: Stream)
+                sp.parse(ch);
+        sp.done();
+        return std::pair { ib.size(), ib.data() };
+    };
+
+    auto const [size, data] = decode(true);
+    CHECK(size == ImageSize { Width(32), Height(30) });
+    CHECK(data.size() == size.area() * 4);
+    CHECK(decode(false) == std::pair { size, data });
+}
+
+TEST_CASE("SixelImageBuilder.reset", "[sixel]")
+{
+    auto constexpr DefaultColor = RGBAColor { 0x10, 0x20, 0x30, 0xFF };
+    auto constexpr MaxSize = ImageSize { Width(16), Height(16) };
+    auto const palette = std::make_shared<SixelColorPalette>(16, 256);
+
+    auto ib = SixelImageBuilder(MaxSize, 1, 1, DefaultColor, palette);
+    SixelParser::parse("\"1;1;16;16#3!16~-!16~", ib);
+    REQUIRE(ib.size() == MaxSize);
+
+    // A reused builder starts out just like a new one.
+    ib.reset(2, 1, DefaultColor, palette);
+    SixelParser::parse("#2~~NN", ib);
+
+    auto fresh = SixelImageBuilder(MaxSize, 2, 1, DefaultColor, palette);
+    SixelParser::parse("#2~~NN", fresh);
+
+    CHECK(ib.size() == ImageSize { Width(4), Height(12) });
+    CHECK(ib.size() == fresh.size());
+    CHECK(ib.data() == fresh.data());
+}
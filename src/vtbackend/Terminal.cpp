@@ -13,6 +13,7 @@
 
 #include <crispy/assert.h>
 #include <crispy/escape.h>
+#include <crispy/metrics.h>
 #include <crispy/utils.h>
 
 #include <libunicode/convert.h>
@@ -80,7 +81,6 @@ namespace // {{{ helpers
         return text;
     }
 
-#if defined(CONTOUR_PERF_STATS)
     void logRenderBufferSwap(bool success, uint64_t frameID)
     {
         if (!renderBufferLog)
@@ -91,7 +91,6 @@ namespace // {{{ helpers
         else
             renderBufferLog()("Render buffer {} swapping failed.", frameID);
     }
-#endif
 
     int makeSelectionTypeId(Selection const& selection) noexcept
     {
@@ -129,7 +128,9 @@ Terminal::Terminal(Events& eventListener,
     _settings { _factorySettings },
     _state { *this },
     _currentTime { now },
-    _ptyBufferPool { crispy::nextPowerOfTwo(_settings.ptyBufferObjectSize) },
+    _ptyBufferPool { crispy::nextPowerOfTwo(_settings.ptyBufferObjectSize),
+                     _settings.ptyBufferHugePages ? crispy::buffer_object_memory::HugePages
+                                                  : crispy::buffer_object_memory::Mapped },
     _currentPtyBuffer { _ptyBufferPool.allocateBufferObject() },
     _ptyReadBufferSize { crispy::nextPowerOfTwo(_settings.ptyReadBufferSize) },
     _pty { std::move(pty) },
@@ -171,6 +172,8 @@ Terminal::Terminal(Events& eventListener,
     setMode(DECMode::VisibleCursor, true);
     setMode(DECMode::LeftRightMargin, false);
 
+    setHistorySpillThreshold(_settings.historySpillThreshold);
+
     for (auto const& [mode, frozen]: _settings.frozenModes)
         freezeMode(mode, frozen);
 }
@@ -180,6 +183,7 @@ void Terminal::onViewportChanged()
     if (_state.inputHandler.mode() != ViMode::Insert)
         _state.viCommands.cursorPosition = _viewport.clampCellLocation(_state.viCommands.cursorPosition);
 
+    _historyReflowPending = true;
     _eventListener.onScrollOffsetChanged(_viewport.scrollOffset());
     breakLoopAndRefreshRenderBuffer();
 }
@@ -195,17 +199,19 @@ void Terminal::setLastMarkRangeOffset(LineOffset value) noexcept
     _settings.copyLastMarkRangeOffset = value;
 }
 
-vtpty::Pty::ReadResult Terminal::readFromPty()
+std::optional<std::chrono::milliseconds> Terminal::ptyReadTimeout() const noexcept
 {
-    auto const timeout =
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
-        (_renderBuffer.state == RenderBufferState::WaitingForRefresh && !_screenDirty)
-            ? std::optional { _refreshInterval.value }
-            : std::chrono::milliseconds(0);
+    return (_renderBuffer.state == RenderBufferState::WaitingForRefresh && !_screenDirty)
+               ? std::optional { _refreshInterval.value }
+               : std::chrono::milliseconds(0);
 #else
-        std::optional<std::chrono::milliseconds> { std::nullopt };
+    return std::nullopt;
 #endif
+}
 
+vtpty::Pty::ReadResult Terminal::readFromPty(std::optional<std::chrono::milliseconds> timeout)
+{
     // Request a new Buffer Object if the current one cannot sufficiently
     // store a single text line.
     if (_currentPtyBuffer->bytesAvailable() < unbox<size_t>(_settings.pageSize.columns))
@@ -227,7 +233,37 @@ void Terminal::setExecutionMode(ExecutionMode mode)
     _pty->wakeupReader();
 }
 
+void Terminal::lockContended() const
+{
+    auto const _ = crispy::metrics::scoped_timer { _metrics.lockWait };
+    _outerLock.lock();
+}
+
+void Terminal::executeMetricsRequest(MetricsRequest request)
+{
+    switch (request)
+    {
+        case MetricsRequest::Report: reply("\033P>y{}\033\\", _metrics.registry.report()); break;
+        case MetricsRequest::Enable: _metrics.registry.enable(); break;
+        case MetricsRequest::Disable: _metrics.registry.enable(false); break;
+        case MetricsRequest::Reset: _metrics.registry.reset(); break;
+    }
+}
+
 bool Terminal::processInputOnce()
+{
+    return processInput(ptyReadTimeout()) != InputStatus::Closed;
+}
+
+Terminal::InputStatus Terminal::processAvailableInput(size_t maxReads)
+{
+    for (size_t i = 0; i < maxReads; ++i)
+        if (auto const status = processInput(std::chrono::milliseconds(0)); status != InputStatus::Pending)
+            return status;
+    return InputStatus::Pending;
+}
+
+Terminal::InputStatus Terminal::processInput(std::optional<std::chrono::milliseconds> timeout)
 {
     // clang-format off
     switch (_state.executionMode.load())
@@ -240,14 +276,14 @@ bool Terminal::processInputOnce()
             {
                 auto const _ = std::lock_guard { *this };
                 _traceHandler.flushAllPending();
-                return true;
+                return InputStatus::Pending;
             }
             break;
         case ExecutionMode::Waiting:
         {
             auto lock = std::unique_lock(_state.breakMutex);
             _state.breakCondition.wait(lock, [this]() { return _state.executionMode != ExecutionMode::Waiting; });
-            return true;
+            return InputStatus::Pending;
         }
         case ExecutionMode::SingleStep:
             if (!_traceHandler.pendingSequences().empty())
@@ -255,22 +291,22 @@ bool Terminal::processInputOnce()
                 auto const _ = std::lock_guard { *this };
                 _state.executionMode = ExecutionMode::Waiting;
                 _traceHandler.flushOne();
-                return true;
+                return InputStatus::Pending;
             }
             break;
     }
     // clang-format on
 
-    auto const readResult = readFromPty();
+    auto const readResult = readFromPty(timeout);
 
     if (!readResult)
     {
-        terminalLog()("PTY read failed. {}", strerror(errno));
         if (errno == EINTR || errno == EAGAIN)
-            return true;
+            return InputStatus::Idle;
 
+        terminalLog()("PTY read failed. {}", strerror(errno));
         _pty->close();
-        return false;
+        return InputStatus::Closed;
     }
     string_view const buf = std::get<0>(*readResult);
     _state.usingStdoutFastPipe = std::get<1>(*readResult);
@@ -279,11 +315,14 @@ bool Terminal::processInputOnce()
     {
         terminalLog()("PTY read returned with zero bytes. Closing PTY.");
         _pty->close();
-        return false;
+        return InputStatus::Closed;
     }
 
+    _metrics.ptyReadSize.record(buf.size());
+
     {
         auto const _ = std::lock_guard { *this };
+        auto const parseTimer = crispy::metrics::scoped_timer { _metrics.parseTime };
         _state.parser.parseFragment(buf);
     }
 
@@ -294,7 +333,7 @@ bool Terminal::processInputOnce()
     ensureFreshRenderBuffer();
 #endif
 
-    return true;
+    return InputStatus::Pending;
 }
 
 // {{{ RenderBuffer synchronization
@@ -328,6 +367,18 @@ bool Terminal::ensureFreshRenderBuffer(bool locked)
     auto const elapsed = _currentTime - _renderBuffer.lastUpdate;
     auto const avoidRefresh = elapsed < _refreshInterval.value;
 
+    // The back buffer may be filled without holding the terminal lock, so writers are serialized,
+    // from taking the back buffer until it has been swapped to the front.
+    // A caller holding the terminal lock must not block on another writer waiting for that lock;
+    // that writer has yet to take its snapshot and will thus pick up the caller's changes.
+    auto writerLock = std::unique_lock { _renderBuffer.writerLock, std::defer_lock };
+    auto const acquireWriterLock = [&]() {
+        if (locked)
+            return writerLock.try_lock();
+        writerLock.lock();
+        return true;
+    };
+
     switch (_renderBuffer.state.load())
     {
         case RenderBufferState::WaitingForRefresh:
@@ -336,12 +387,18 @@ bool Terminal::ensureFreshRenderBuffer(bool locked)
             _renderBuffer.state = RenderBufferState::RefreshBuffersAndTrySwap;
             [[fallthrough]];
         case RenderBufferState::RefreshBuffersAndTrySwap: {
+            if (!acquireWriterLock())
+                break;
+
             auto& backBuffer = _renderBuffer.backBuffer();
             auto const lastCursorPos = backBuffer.cursor;
-            if (!locked)
-                fillRenderBuffer(_renderBuffer.backBuffer(), true);
-            else
-                fillRenderBufferInternal(_renderBuffer.backBuffer(), true);
+            {
+                auto const fillTimer = crispy::metrics::scoped_timer { _metrics.renderBufferFill };
+                if (!locked)
+                    fillRenderBuffer(_renderBuffer.backBuffer(), true);
+                else
+                    fillRenderBufferInternal(_renderBuffer.backBuffer(), true);
+            }
             auto const cursorChanged =
                 lastCursorPos.has_value() != backBuffer.cursor.has_value()
                 || (backBuffer.cursor.has_value() && backBuffer.cursor->position != lastCursorPos->position);
@@ -351,11 +408,18 @@ bool Terminal::ensureFreshRenderBuffer(bool locked)
             [[fallthrough]];
         }
         case RenderBufferState::TrySwapBuffers: {
-            [[maybe_unused]] auto const success = _renderBuffer.swapBuffers(_currentTime);
+            if (!writerLock.owns_lock())
+            {
+                if (!acquireWriterLock())
+                    break;
+                // Another writer may have swapped the buffers while we were waiting for the lock.
+                if (_renderBuffer.state != RenderBufferState::TrySwapBuffers)
+                    break;
+            }
 
-#if defined(CONTOUR_PERF_STATS)
+            auto const success = _renderBuffer.swapBuffers(_currentTime);
+            writerLock.unlock();
             logRenderBufferSwap(success, _lastFrameID);
-#endif
 
 #if defined(LIBTERMINAL_PASSIVE_RENDER_BUFFER_UPDATE)
             // Passively invoked by the terminal thread -> do inform render thread about updates.
@@ -432,24 +496,171 @@ void Terminal::updateInputMethodPreeditString(std::string preeditString)
 
 void Terminal::fillRenderBuffer(RenderBuffer& output, bool includeSelection)
 {
-    auto const _ = std::lock_guard { *this };
-    fillRenderBufferInternal(output, includeSelection);
+    auto lock = std::unique_lock { *this };
+
+    if (isPageDecorated(includeSelection))
+    {
+        fillRenderBufferInternal(output, includeSelection);
+        return;
+    }
+
+    if (isPrimaryScreen())
+        fillRenderBufferDetached(output, _primaryScreen, _primaryPageSnapshot, lock);
+    else
+        fillRenderBufferDetached(output, _alternateScreen, _alternatePageSnapshot, lock);
 }
 
-void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelection)
+template <typename Cell>
+void Terminal::fillRenderBufferDetached(RenderBuffer& output,
+                                       Screen<Cell> const& mainScreen,
+                                       PageSnapshot<Cell>& mainPageSnapshot,
+                                       std::unique_lock<Terminal>& lock)
 {
     verifyState();
 
-    output.clear();
+    auto const pageState = startRenderBufferFill(output, false);
+    auto const mainDisplayReverseVideo = isModeEnabled(vtbackend::DECMode::ReverseVideo);
+
+    // Snapshot the visible lines and set up the builders while still holding the lock.
+    auto statusLineBuilder = std::optional<RenderBufferBuilder<StatusDisplayCell>> {};
+    if (auto const* statusLine = statusLineToRender())
+    {
+        _statusLinePageSnapshot.update(statusLine->grid(), ScrollOffset(0));
+        statusLineBuilder.emplace(*this,
+                                  output,
+                                  _settings.statusDisplayPosition == StatusDisplayPosition::Top
+                                      ? LineOffset(0)
+                                      : pageSize().lines.as<LineOffset>(),
+                                  !mainDisplayReverseVideo,
+                                  HighlightSearchMatches::No,
+                                  InputMethodData {},
+                                  nullopt,
+                                  false);
+        statusLineBuilder->detach();
+    }
+
+    mainPageSnapshot.update(mainScreen.grid(), _viewport.scrollOffset());
+    auto mainBuilder = RenderBufferBuilder<Cell> { *this,
+                                                   output,
+                                                   pageState.baseLine,
+                                                   mainDisplayReverseVideo,
+                                                   HighlightSearchMatches::No,
+                                                   _inputMethodData,
+                                                   renderCursorPosition(),
+                                                   false,
+                                                   true };
+    mainBuilder.detach();
+
+    // Let the terminal continue processing input while rendering.
+    lock.unlock();
+
+    if (statusLineBuilder && _settings.statusDisplayPosition == StatusDisplayPosition::Top)
+        (void) _statusLinePageSnapshot.render(*statusLineBuilder);
+
+    auto const hints = mainPageSnapshot.render(mainBuilder);
+
+    if (statusLineBuilder && _settings.statusDisplayPosition == StatusDisplayPosition::Bottom)
+        (void) _statusLinePageSnapshot.render(*statusLineBuilder);
+
+    finishRenderBufferFill(output, pageState, false);
+
+    lock.lock();
+    _lastRenderPassHints = hints;
+}
+
+bool Terminal::isPageDecorated(bool includeSelection) const noexcept
+{
+    return (includeSelection && selectionAvailable()) || !_state.searchMode.pattern.empty()
+           || _highlightRange.has_value() || !_inputMethodData.preeditString.empty()
+           || tryGetHoveringHyperlink() != nullptr;
+}
+
+RenderPageState Terminal::renderPageState(LineOffset baseLine) const
+{
+    auto const& colors = colorPalette();
+    auto state = RenderPageState {};
+    state.redrawGeneration = _redrawGeneration;
+    state.primaryScreen = isPrimaryScreen();
+    state.pageSize = pageSize();
+    state.baseLine = baseLine;
+    state.reverseVideo = isModeEnabled(vtbackend::DECMode::ReverseVideo);
+    state.palette = colors.palette;
+    state.defaultForeground = colors.defaultForeground;
+    state.defaultForegroundBright = colors.defaultForegroundBright;
+    state.defaultForegroundDimmed = colors.defaultForegroundDimmed;
+    state.defaultBackground = colors.defaultBackground;
+    state.hyperlinkDecoration = colors.hyperlinkDecoration.normal;
+    state.useBrightColors = colors.useBrightColors;
+    return state;
+}
+
+RenderPageState Terminal::startRenderBufferFill(RenderBuffer& output, bool pageDecorated)
+{
+    if (_historyReflowPending.exchange(false))
+        reflowVisibleHistory();
+
+    // Lines that did not change since this buffer's previous frame are copied over rather than
+    // being rendered again, unless the page is decorated by anything not tracked per line.
+    auto const pageState =
+        renderPageState(_settings.statusDisplayPosition == StatusDisplayPosition::Top
+                            ? statusLineHeight().as<LineOffset>()
+                            : LineOffset(0));
+    if (!pageDecorated && output.pageState == pageState)
+        output.clearForReuse();
+    else
+        output.clear();
 
     _changes.store(0);
     _screenDirty = false;
     ++_lastFrameID;
 
-#if defined(CONTOUR_PERF_STATS)
-    if (terminalLog)
-        terminalLog()("{}: Refreshing render buffer.\n", _lastFrameID.load());
-#endif
+    if (renderBufferLog)
+        renderBufferLog()("{}: Refreshing render buffer.", _lastFrameID.load());
+
+    return pageState;
+}
+
+void Terminal::reflowVisibleHistory()
+{
+    // History lines left unreflowed by resizing are reflowed once they are scrolled into view,
+    // after the viewport or the page size changed.
+    if (!isPrimaryScreen() || !_viewport.scrolled())
+        return;
+
+    auto& grid = _primaryScreen.grid();
+    auto const top = -boxed_cast<LineOffset>(_viewport.scrollOffset());
+    if (top < grid.reflowedHistoryTop())
+        grid.reflowHistory(top);
+
+    // Reflowing into fewer lines may have shrunk the history below the scroll offset.
+    if (_viewport.scrollOffset() > boxed_cast<ScrollOffset>(grid.historyLineCount()))
+        _viewport.scrollToTop();
+}
+
+void Terminal::finishRenderBufferFill(RenderBuffer& output, RenderPageState const& pageState, bool pageDecorated)
+{
+    output.previous.clear();
+    if (!pageDecorated)
+        output.pageState = pageState;
+}
+
+optional<CellLocation> Terminal::renderCursorPosition() const
+{
+    if (inputHandler().mode() != ViMode::Insert)
+        return state().viCommands.cursorPosition;
+
+    if (isModeEnabled(DECMode::VisibleCursor))
+        return currentScreen().cursor().position;
+
+    return nullopt;
+}
+
+void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelection)
+{
+    verifyState();
+
+    auto const pageDecorated = isPageDecorated(includeSelection);
+    auto const pageState = startRenderBufferFill(output, pageDecorated);
 
     auto baseLine = LineOffset(0);
 
@@ -461,12 +672,16 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
     auto const highlightSearchMatches =
         _state.searchMode.pattern.empty() ? HighlightSearchMatches::No : HighlightSearchMatches::Yes;
 
-    auto const theCursorPosition =
-        optional<CellLocation> { inputHandler().mode() == ViMode::Insert
-                                     ? (isModeEnabled(DECMode::VisibleCursor)
-                                            ? optional<CellLocation> { currentScreen().cursor().position }
-                                            : nullopt)
-                                     : state().viCommands.cursorPosition };
+    if (highlightSearchMatches == HighlightSearchMatches::Yes)
+    {
+        auto const top = -boxed_cast<LineOffset>(_viewport.scrollOffset());
+        _visibleSearchMatches =
+            currentScreen().searchAll(searchPattern(), top, top + pageSize().lines.as<LineOffset>() - 1);
+    }
+    else
+        _visibleSearchMatches.clear();
+
+    auto const theCursorPosition = renderCursorPosition();
 
     if (isPrimaryScreen())
         _lastRenderPassHints =
@@ -477,7 +692,8 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
                                                                            HighlightSearchMatches::Yes,
                                                                            _inputMethodData,
                                                                            theCursorPosition,
-                                                                           includeSelection },
+                                                                           includeSelection,
+                                                                           true },
                                   _viewport.scrollOffset(),
                                   highlightSearchMatches);
     else
@@ -489,7 +705,8 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
                                                                                HighlightSearchMatches::Yes,
                                                                                _inputMethodData,
                                                                                theCursorPosition,
-                                                                               includeSelection },
+                                                                               includeSelection,
+                                                                               true },
                                     _viewport.scrollOffset(),
                                     highlightSearchMatches);
 
@@ -498,43 +715,39 @@ void Terminal::fillRenderBufferInternal(RenderBuffer& output, bool includeSelect
         baseLine += pageSize().lines.as<LineOffset>();
         fillRenderBufferStatusLine(output, includeSelection, baseLine);
     }
+
+    finishRenderBufferFill(output, pageState, pageDecorated);
 }
 
-LineCount Terminal::fillRenderBufferStatusLine(RenderBuffer& output, bool includeSelection, LineOffset base)
+Screen<StatusDisplayCell> const* Terminal::statusLineToRender()
 {
-    auto const mainDisplayReverseVideo = isModeEnabled(vtbackend::DECMode::ReverseVideo);
     switch (_state.statusDisplayType)
     {
-        case StatusDisplayType::None:
-            //.
-            return LineCount(0);
-        case StatusDisplayType::Indicator:
-            updateIndicatorStatusLine();
-            _indicatorStatusScreen.render(RenderBufferBuilder<StatusDisplayCell> { *this,
-                                                                                   output,
-                                                                                   base,
-                                                                                   !mainDisplayReverseVideo,
-                                                                                   HighlightSearchMatches::No,
-                                                                                   InputMethodData {},
-                                                                                   nullopt,
-                                                                                   includeSelection },
-                                          ScrollOffset(0));
-            return _indicatorStatusScreen.pageSize().lines;
-        case StatusDisplayType::HostWritable:
-            _hostWritableStatusLineScreen.render(
-                RenderBufferBuilder<StatusDisplayCell> { *this,
-                                                         output,
-                                                         base,
-                                                         !mainDisplayReverseVideo,
-                                                         HighlightSearchMatches::No,
-                                                         InputMethodData {},
-                                                         nullopt,
-                                                         includeSelection },
-                ScrollOffset(0));
-            return _hostWritableStatusLineScreen.pageSize().lines;
+        case StatusDisplayType::None: return nullptr;
+        case StatusDisplayType::Indicator: updateIndicatorStatusLine(); return &_indicatorStatusScreen;
+        case StatusDisplayType::HostWritable: return &_hostWritableStatusLineScreen;
     }
     crispy::unreachable();
 }
+
+LineCount Terminal::fillRenderBufferStatusLine(RenderBuffer& output, bool includeSelection, LineOffset base)
+{
+    auto const* statusLine = statusLineToRender();
+    if (!statusLine)
+        return LineCount(0);
+
+    auto const mainDisplayReverseVideo = isModeEnabled(vtbackend::DECMode::ReverseVideo);
+    statusLine->render(RenderBufferBuilder<StatusDisplayCell> { *this,
+                                                               output,
+                                                               base,
+                                                               !mainDisplayReverseVideo,
+                                                               HighlightSearchMatches::No,
+                                                               InputMethodData {},
+                                                               nullopt,
+                                                               includeSelection },
+                       ScrollOffset(0));
+    return statusLine->pageSize().lines;
+}
 // }}}
 
 void Terminal::updateIndicatorStatusLine()
@@ -973,6 +1186,9 @@ void Terminal::sendPaste(string_view text)
 
     _state.inputGenerator.generatePaste(text);
     flushInput();
+
+    if (auto const pending = _pty->pendingWriteBytes(); pending != 0)
+        inputLog()("Paste is being streamed, {} bytes are yet to be read by the application.", pending);
 }
 
 void Terminal::sendRawInput(string_view text)
@@ -1137,6 +1353,8 @@ void Terminal::resizeScreen(PageSize totalPageSize, optional<ImageSize> pixels)
 
     auto const oldMainDisplayPageSize = _settings.pageSize;
 
+    ++_redrawGeneration;
+
     _factorySettings.pageSize = totalPageSize;
     _settings.pageSize = totalPageSize;
     _currentMousePosition = clampToScreen(_currentMousePosition);
@@ -1304,6 +1522,11 @@ void Terminal::requestCaptureBuffer(LineCount lines, bool logical)
     return _eventListener.requestCaptureBuffer(lines, logical);
 }
 
+void Terminal::requestMetrics(MetricsRequest request)
+{
+    _eventListener.requestMetrics(request);
+}
+
 void Terminal::requestShowHostWritableStatusLine()
 {
     _eventListener.requestShowHostWritableStatusLine();
@@ -1335,7 +1558,7 @@ void Terminal::screenUpdated()
 
     if (_renderBuffer.state == RenderBufferState::TrySwapBuffers)
     {
-        _renderBuffer.swapBuffers(_renderBuffer.lastUpdate);
+        trySwapPendingRenderBuffer();
         return;
     }
 
@@ -1343,6 +1566,14 @@ void Terminal::screenUpdated()
     _eventListener.screenUpdated();
 }
 
+void Terminal::trySwapPendingRenderBuffer()
+{
+    // Called with the terminal lock held, so we must not wait for a writer that may be waiting for it.
+    auto const writerLock = std::unique_lock { _renderBuffer.writerLock, std::try_to_lock };
+    if (writerLock.owns_lock() && _renderBuffer.state == RenderBufferState::TrySwapBuffers)
+        _renderBuffer.swapBuffers(_renderBuffer.lastUpdate);
+}
+
 void Terminal::renderBufferUpdated()
 {
     if (!_renderBufferUpdateEnabled)
@@ -1350,7 +1581,7 @@ void Terminal::renderBufferUpdated()
 
     if (_renderBuffer.state == RenderBufferState::TrySwapBuffers)
     {
-        _renderBuffer.swapBuffers(_renderBuffer.lastUpdate);
+        trySwapPendingRenderBuffer();
         return;
     }
 
@@ -1390,16 +1621,12 @@ void Terminal::notify(string_view title, string_view body)
 
 void Terminal::reply(string_view text)
 {
-    // this is invoked from within the terminal thread.
-    // most likely that's not the main thread, which will however write
-    // the actual input events.
-    // TODO: introduce new mutex to guard terminal writes.
-    _state.inputGenerator.generateRaw(text);
-
-    auto const* syncReply = getenv("CONTOUR_SYNC_PTY_OUTPUT");
-
-    if (syncReply && *syncReply != '0')
-        flushInput();
+    // This is invoked from within the terminal thread, whereas input events are generated on the
+    // main thread. Replies are therefore not passed through the input generator, but written right
+    // away. The PTY does not wait for the application to read them, and does not interleave them
+    // with the input written by another thread.
+    if (_pty->write(text) < 0)
+        terminalLog()("Failed to write reply of {} bytes. {}", text.size(), strerror(errno));
 }
 
 void Terminal::requestWindowResize(PageSize size)
@@ -1879,6 +2106,7 @@ void Terminal::setScreen(ScreenType type)
 void Terminal::applyPageSizeToCurrentBuffer()
 {
     applyPageSizeToMainDisplay(screenType());
+    _historyReflowPending = true;
 }
 
 void Terminal::applyPageSizeToMainDisplay(ScreenType screenType)
@@ -1995,6 +2223,11 @@ LineCount Terminal::maxHistoryLineCount() const noexcept
     return _primaryScreen.grid().maxHistoryLineCount();
 }
 
+void Terminal::setHistorySpillThreshold(std::optional<LineCount> threshold)
+{
+    _primaryScreen.grid().setHistorySpillThreshold(threshold);
+}
+
 void Terminal::setTerminalId(VTType id) noexcept
 {
     _state.terminalId = id;
@@ -2103,8 +2336,7 @@ optional<CellLocation> Terminal::search(std::u32string text,
 
 optional<CellLocation> Terminal::search(CellLocation searchPosition)
 {
-    auto const searchText = u32string_view(_state.searchMode.pattern);
-    auto const matchLocation = currentScreen().search(searchText, searchPosition);
+    auto const matchLocation = currentScreen().search(searchPattern(), searchPosition);
 
     if (matchLocation)
         viewport().makeVisibleWithinSafeArea(matchLocation.value().line);
@@ -2119,6 +2351,18 @@ void Terminal::clearSearch()
     _state.searchMode.initiatedByDoubleClick = false;
 }
 
+SearchPattern const& Terminal::searchPattern()
+{
+    // The search term is edited in place while typing, so it is compiled lazily.
+    if (_searchPattern.source() != _state.searchMode.pattern)
+    {
+        _searchPattern = SearchPattern::fromSearchTerm(_state.searchMode.pattern);
+        if (!_searchPattern.valid() && !_state.searchMode.pattern.empty())
+            terminalLog()("Search term does not match anything. {}", _searchPattern.error());
+    }
+    return _searchPattern;
+}
+
 bool Terminal::wordDelimited(CellLocation position) const noexcept
 {
     // Word selection may be off by one
@@ -2149,8 +2393,7 @@ std::tuple<std::u32string, CellLocationRange> Terminal::extractWordUnderCursor(
 
 optional<CellLocation> Terminal::searchReverse(CellLocation searchPosition)
 {
-    auto const searchText = u32string_view(_state.searchMode.pattern);
-    auto const matchLocation = currentScreen().searchReverse(searchText, searchPosition);
+    auto const matchLocation = currentScreen().searchReverse(searchPattern(), searchPosition);
 
     if (matchLocation)
         viewport().makeVisibleWithinSafeArea(matchLocation.value().line);
@@ -2334,7 +2577,7 @@ void TraceHandler::flushOne(PendingSequence const& pendingSequence)
 {
     if (auto const* seq = std::get_if<Sequence>(&pendingSequence))
     {
-        if (auto const* functionDefinition = seq->functionDefinition(_terminal->activeSequences()))
+        if (auto const* functionDefinition = seq->functionDefinition(_terminal->supportedSequences()))
             fmt::print("\t{:<20} ; {:<18} ; {}\n",
                        seq->text(),
                        functionDefinition->documentation.mnemonic,
@@ -3,8 +3,10 @@
 
 #include <vtbackend/InputGenerator.h>
 #include <vtbackend/InputHandler.h>
+#include <vtbackend/PageSnapshot.h>
 #include <vtbackend/RenderBuffer.h>
 #include <vtbackend/ScreenEvents.h>
+#include <vtbackend/SearchPattern.h>
 #include <vtbackend/Selector.h>
 #include <vtbackend/Sequence.h>
 #include <vtbackend/Settings.h>
@@ -20,6 +22,7 @@
 #include <crispy/BufferObject.h>
 #include <crispy/assert.h>
 #include <crispy/defines.h>
+#include <crispy/metrics.h>
 
 #include <fmt/format.h>
 
@@ -48,6 +51,60 @@ struct InputMethodData
     std::string preeditString;
 };
 
+/// Requests to a terminal's performance metrics, as made by XTMETRICS.
+enum class MetricsRequest
+{
+    Report,  //!< Replies with a report of all metrics.
+    Enable,  //!< Starts collecting metrics.
+    Disable, //!< Stops collecting metrics, keeping the values collected so far.
+    Reset,   //!< Discards the metrics collected so far.
+};
+
+/// Performance metrics of a single terminal session.
+///
+/// Next to the terminal's own input and render buffer pipeline, this also holds the renderer's metrics,
+/// which the renderer attributes to the terminal it renders a frame of.
+struct TerminalMetrics
+{
+    crispy::metrics::registry registry;
+
+    crispy::metrics::histogram ptyReadSize {
+        registry, "pty.read_size", "Bytes read from the PTY at once.", "bytes"
+    };
+    crispy::metrics::histogram parseTime {
+        registry, "vt.parse_time", "Time to parse and process a PTY read.", "ns"
+    };
+    crispy::metrics::histogram lockWait {
+        registry,
+        "vt.lock_wait",
+        "Time spent waiting for the terminal lock, unless it was free right away.",
+        "ns"
+    };
+    crispy::metrics::histogram renderBufferFill {
+        registry,
+        "vt.renderbuffer_fill",
+        "Time to fill a render buffer, including waiting for the terminal lock.",
+        "ns"
+    };
+    crispy::metrics::histogram frameSubmit {
+        registry,
+        "vt.renderer.frame_submit",
+        "Time to submit a frame's render commands to the render target.",
+        "ns"
+    };
+    crispy::metrics::counter atlasUploads {
+        registry, "vt.renderer.atlas_uploads", "Tiles uploaded into the texture atlas."
+    };
+    crispy::metrics::counter atlasEvictions {
+        registry,
+        "vt.renderer.atlas_evictions",
+        "Tiles evicted from the texture atlas to make room for new ones."
+    };
+    crispy::metrics::hit_rate shapingCache {
+        registry, "vt.renderer.shaping_cache", "Lookups in the text shaping cache."
+    };
+};
+
 // Implements Trace mode handling for the given controls.
 //
 // It either directly forwards the sequences to the actually current main display,
@@ -101,6 +158,7 @@ class Terminal
         virtual ~Events() = default;
 
         virtual void requestCaptureBuffer(LineCount /*lines*/, bool /*logical*/) {}
+        virtual void requestMetrics(MetricsRequest /*request*/) {}
         virtual void bell() {}
         virtual void bufferChanged(ScreenType) {}
         virtual void renderBufferUpdated() {}
@@ -131,6 +189,7 @@ class Terminal
     {
       public:
         void requestCaptureBuffer(LineCount /*lines*/, bool /*logical*/) override {}
+        void requestMetrics(MetricsRequest /*request*/) override {}
         void bell() override {}
         void bufferChanged(ScreenType) override {}
         void renderBufferUpdated() override {}
@@ -171,6 +230,8 @@ class Terminal
     void setMaxHistoryLineCount(MaxHistoryLineCount maxHistoryLineCount);
     LineCount maxHistoryLineCount() const noexcept;
 
+    void setHistorySpillThreshold(std::optional<LineCount> threshold);
+
     void setTerminalId(VTType id) noexcept;
 
     void setMaxImageSize(ImageSize size) noexcept { _state.effectiveImageCanvasSize = size; }
@@ -181,6 +242,12 @@ class Terminal
         _settings.maxImageSize = limit;
     }
 
+    void setMaxImageMemory(size_t bytes) noexcept
+    {
+        _settings.maxImageMemory = bytes;
+        _state.imagePool.setMemoryBudget(bytes);
+    }
+
     bool isModeEnabled(AnsiMode m) const noexcept { return _state.modes.enabled(m); }
     bool isModeEnabled(DECMode m) const noexcept { return _state.modes.enabled(m); }
     void setMode(AnsiMode mode, bool enable);
@@ -391,7 +458,11 @@ class Terminal
     void updateInputMethodPreeditString(std::string preeditString);
     // }}}
 
-    void lock() const { _outerLock.lock(); }
+    void lock() const
+    {
+        if (!_outerLock.try_lock())
+            lockContended();
+    }
 
     void unlock() const { _outerLock.unlock(); }
 
@@ -596,13 +667,37 @@ class Terminal
 
     bool processInputOnce();
 
+    /// Outcome of processing the input that is available without waiting for more.
+    enum class InputStatus : uint8_t
+    {
+        Idle,    ///< All available input has been processed.
+        Pending, ///< There may be more input to be processed right away.
+        Closed,  ///< The PTY has been closed.
+    };
+
+    /// Processes the input that is available, reading at most @p maxReads times, without waiting
+    /// for the PTY to become readable.
+    ///
+    /// This drives the terminal from a shared InputReactor, rather than calling processInputOnce()
+    /// in a loop on a thread of its own.
+    InputStatus processAvailableInput(size_t maxReads);
+
     void markScreenDirty() noexcept { _screenDirty = true; }
 
     [[nodiscard]] uint64_t lastFrameID() const noexcept { return _lastFrameID.load(); }
 
+    /// Performance metrics of this terminal, including those of rendering it.
+    [[nodiscard]] TerminalMetrics& metrics() noexcept { return _metrics; }
+
+    /// Carries out an XTMETRICS request, once the requesting application is permitted to make it.
+    ///
+    /// @see requestMetrics()
+    void executeMetricsRequest(MetricsRequest request);
+
     // Screen's EventListener implementation
     //
     void requestCaptureBuffer(LineCount lines, bool logical);
+    void requestMetrics(MetricsRequest request);
     void requestShowHostWritableStatusLine();
     void bell();
     void bufferChanged(ScreenType);
@@ -722,6 +817,15 @@ class Terminal
     bool setNewSearchTerm(std::u32string text, bool initiatedByDoubleClick);
     void clearSearch();
 
+    // Returns the current search term, compiled for matching.
+    [[nodiscard]] SearchPattern const& searchPattern();
+
+    // Returns the search matches covering the lines that were visible in the last render pass.
+    [[nodiscard]] std::vector<CellLocationRange> const& visibleSearchMatches() const noexcept
+    {
+        return _visibleSearchMatches;
+    }
+
     // Tests if the grid cell at the given location does contain a word delimiter.
     [[nodiscard]] bool wordDelimited(CellLocation position) const noexcept;
 
@@ -744,10 +848,34 @@ class Terminal
         return _supportedVTSequences.activeSequences();
     }
 
+    [[nodiscard]] SupportedSequences const& supportedSequences() const noexcept
+    {
+        return _supportedVTSequences;
+    }
+
   private:
     void mainLoop();
+
+    /// Waits for the terminal lock after it was not available right away, measuring the time spent waiting.
+    void lockContended() const;
+
+    /// Swaps in an already filled back buffer, unless another writer is currently busy with it.
+    void trySwapPendingRenderBuffer();
+
     void fillRenderBufferInternal(RenderBuffer& output, bool includeSelection);
+    template <typename Cell>
+    void fillRenderBufferDetached(RenderBuffer& output,
+                                  Screen<Cell> const& mainScreen,
+                                  PageSnapshot<Cell>& mainPageSnapshot,
+                                  std::unique_lock<Terminal>& lock);
     LineCount fillRenderBufferStatusLine(RenderBuffer& output, bool includeSelection, LineOffset base);
+    [[nodiscard]] Screen<StatusDisplayCell> const* statusLineToRender();
+    [[nodiscard]] bool isPageDecorated(bool includeSelection) const noexcept;
+    [[nodiscard]] RenderPageState renderPageState(LineOffset baseLine) const;
+    RenderPageState startRenderBufferFill(RenderBuffer& output, bool pageDecorated);
+    void reflowVisibleHistory();
+    static void finishRenderBufferFill(RenderBuffer& output, RenderPageState const& pageState, bool pageDecorated);
+    [[nodiscard]] std::optional<CellLocation> renderCursorPosition() const;
     void updateIndicatorStatusLine();
     void updateCursorVisibilityState() const noexcept;
     void updateHoveringHyperlinkState();
@@ -785,7 +913,9 @@ class Terminal
     }
 
     // Reads from PTY.
-    [[nodiscard]] vtpty::Pty::ReadResult readFromPty();
+    [[nodiscard]] std::optional<std::chrono::milliseconds> ptyReadTimeout() const noexcept;
+    [[nodiscard]] vtpty::Pty::ReadResult readFromPty(std::optional<std::chrono::milliseconds> timeout);
+    InputStatus processInput(std::optional<std::chrono::milliseconds> timeout);
 
     // Writes partially or all input data to the PTY buffer object and returns a string view to it.
     [[nodiscard]] std::string_view lockedWriteToPtyBuffer(std::string_view data);
@@ -800,6 +930,9 @@ class Terminal
     Settings _settings;
     TerminalState _state;
 
+    // performance metrics, reported and controlled via XTMETRICS
+    mutable TerminalMetrics _metrics;
+
     // synchronization
     std::mutex mutable _outerLock;
 
@@ -867,16 +1000,25 @@ class Terminal
     /// Boolean, indicating whether the terminal's screen buffer contains updates to be rendered.
     mutable std::atomic<uint64_t> _changes { 0 };
     bool _screenDirty = false; // TODO: just inc _changes and delete this instead.
+    std::atomic<bool> _historyReflowPending = false; // viewport or page size changed since last frame
     RefreshInterval _refreshInterval;
     RenderDoubleBuffer _renderBuffer {};
     std::atomic<uint64_t> _lastFrameID = 0;
     RenderPassHints _lastRenderPassHints {};
+    uint64_t _redrawGeneration = 0; // Bumped whenever the render buffer must be fully rebuilt.
+
+    // Lines visible at the last render buffer refresh, rendered after the terminal lock is released.
+    PageSnapshot<PrimaryScreenCell> _primaryPageSnapshot;
+    PageSnapshot<AlternateScreenCell> _alternatePageSnapshot;
+    PageSnapshot<StatusDisplayCell> _statusLinePageSnapshot;
     // }}}
 
     InputMethodData _inputMethodData {};
     std::atomic<HyperlinkId> _hoveringHyperlinkId = HyperlinkId {};
     std::atomic<bool> _renderBufferUpdateEnabled = true; // for "Synchronized Updates" feature
     std::optional<HighlightRange> _highlightRange = std::nullopt;
+    SearchPattern _searchPattern; // compiled from _state.searchMode.pattern on demand
+    std::vector<CellLocationRange> _visibleSearchMatches;
     SupportedSequences _supportedVTSequences;
 };
 
@@ -20,9 +20,9 @@ TerminalState::TerminalState(Terminal& terminal):
                                    {}, settings.pageSize.columns.as<ColumnOffset>() - ColumnOffset(1) } },
     effectiveImageCanvasSize { settings.maxImageSize },
     imageColorPalette { std::make_shared<SixelColorPalette>(maxImageColorRegisters, maxImageColorRegisters) },
-    imagePool { [te = &terminal](Image const* image) {
-        te->discardImage(*image);
-    } },
+    imagePool { [te = &terminal](Image const* image) { te->discardImage(*image); },
+                ImageId(1),
+                settings.maxImageMemory },
     hyperlinks { HyperlinkCache { 1024 } },
     sequencer { terminal },
     parser { std::ref(sequencer) },
@@ -13,7 +13,10 @@
 
 #include <catch2/catch_test_macros.hpp>
 
+#include <array>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 using namespace std;
@@ -364,6 +367,64 @@ TEST_CASE("Terminal.CurlyUnderline", "[terminal]")
     CHECK(!screen.at(LineOffset(0), ColumnOffset(3)).isFlagEnabled(CellFlag::Italic));
 }
 
+TEST_CASE("Terminal.SGR", "[terminal]")
+{
+    using vtbackend::BrightColor;
+    using vtbackend::Color;
+    using vtbackend::DefaultColor;
+    using vtbackend::IndexedColor;
+    using vtbackend::RGBColor;
+
+    auto mc = MockTerm { ColumnCount(20), LineCount(1) };
+    auto const& sgr = mc.terminal.currentScreen().cursor().graphicsRendition;
+
+    SECTION("true color and indexed colors")
+    {
+        mc.writeToScreen("\033[1;38;2;10;20;30;48;5;100;58:2::40:50:60m");
+        CHECK(sgr.flags & CellFlag::Bold);
+        CHECK(sgr.foregroundColor == Color(RGBColor { 10, 20, 30 }));
+        CHECK(sgr.backgroundColor == Color(static_cast<IndexedColor>(100)));
+        CHECK(sgr.underlineColor == Color(RGBColor { 40, 50, 60 }));
+
+        mc.writeToScreen("\033[38:5:7;48:2:1:2:3;4:3m");
+        CHECK(sgr.foregroundColor == Color(IndexedColor::White));
+        CHECK(sgr.backgroundColor == Color(RGBColor { 1, 2, 3 }));
+        CHECK(sgr.flags & CellFlag::CurlyUnderlined);
+    }
+
+    SECTION("reset")
+    {
+        mc.writeToScreen("\033[1;31;0;7;92;101m");
+        CHECK(sgr.flags == CellFlag::Inverse);
+        CHECK(sgr.foregroundColor == Color(BrightColor::Green));
+        CHECK(sgr.backgroundColor == Color(BrightColor::Red));
+
+        mc.writeToScreen("\033[m");
+        CHECK(sgr == vtbackend::GraphicsAttributes {});
+    }
+
+    SECTION("same as generic SGR")
+    {
+        // DECCARA applies its SGR parameters the generic way, which SGR itself must not deviate from.
+        auto const sgrs = std::array {
+            "1;38;2;10;20;30;48;5;100", "38:2::40:50:60;4:5", "38;2;300;0;0;1", "48:3:0:1:2:3;3",
+            "38:2:1:2", "4:3:1;9",      "1:2;7",              "58;5;300;1",     "0;21;22;53;107",
+        };
+        for (auto const* text: sgrs)
+        {
+            INFO(text);
+            auto mock = MockTerm { ColumnCount(2), LineCount(1) };
+            mock.writeToScreen(fmt::format("A\033[1;1;1;1;{}$r\033[{}mB", text, text));
+            auto const& expected = mock.terminal.primaryScreen().at(LineOffset(0), ColumnOffset(0));
+            auto const& actual = mock.terminal.primaryScreen().at(LineOffset(0), ColumnOffset(1));
+            CHECK(actual.flags() == expected.flags());
+            CHECK(actual.foregroundColor() == expected.foregroundColor());
+            CHECK(actual.backgroundColor() == expected.backgroundColor());
+            CHECK(actual.underlineColor() == expected.underlineColor());
+        }
+    }
+}
+
 TEST_CASE("Terminal.TextSelection", "[terminal]")
 {
     // Create empty TE
@@ -422,3 +483,127 @@ TEST_CASE("Terminal.TextSelection", "[terminal]")
     mock.terminal.sendMouseReleaseEvent(Modifier::None, MouseButton::Left, PixelCoordinate, UiHandledHint);
     CHECK(mock.terminal.extractSelectionText().empty());
 }
+
+TEST_CASE("Terminal.RenderBuffer.Codepoints", "[terminal]")
+{
+    auto const now = chrono::steady_clock::now();
+    auto mc = MockTerm { ColumnCount(10), LineCount(1) };
+
+    // Mixed SGR attributes force the line to be rendered cell by cell.
+    mc.writeToScreen("A\033[1mB\033[me\xCC\x81" "C");
+    mc.terminal.tick(now);
+    mc.terminal.ensureFreshRenderBuffer();
+    CHECK("ABe\xCC\x81" "C" == trimmedTextScreenshot(mc));
+
+    auto const renderBuffer = mc.terminal.renderBuffer();
+    auto const& buffer = renderBuffer.get();
+    REQUIRE(buffer.cells.size() == 10);
+    CHECK(buffer.codepointsOf(buffer.cells[0]) == U"A"sv);
+    CHECK(buffer.codepointsOf(buffer.cells[1]) == U"B"sv);
+    CHECK(buffer.codepointsOf(buffer.cells[2]) == U"e\u0301"sv);
+    CHECK(buffer.codepointsOf(buffer.cells[3]) == U"C"sv);
+    CHECK(buffer.codepointsOf(buffer.cells[4]).empty());
+    CHECK(buffer.imageOf(buffer.cells[0]) == nullptr);
+}
+
+TEST_CASE("Terminal.RenderBuffer.Incremental", "[terminal]")
+{
+    auto mc = MockTerm { ColumnCount(6), LineCount(3) };
+    auto const refresh = [&]() {
+        mc.terminal.refreshRenderBuffer();
+        return trimmedTextScreenshot(mc);
+    };
+    auto const revisions = [&]() {
+        auto result = std::vector<uint32_t> {};
+        for (auto const& row: mc.terminal.renderBuffer().get().rows)
+            result.push_back(row.revision);
+        return result;
+    };
+    auto const reusedRows = [&]() {
+        auto result = std::vector<bool> {};
+        for (auto const& row: mc.terminal.renderBuffer().get().rows)
+            result.push_back(row.reused);
+        return result;
+    };
+
+    mc.writeToScreen("\033[1mA\033[mBC\r\nDEF\r\nGHI");
+    CHECK("ABC\nDEF\nGHI" == refresh());
+    CHECK("ABC\nDEF\nGHI" == refresh());
+    auto const initialRevisions = revisions();
+    REQUIRE(initialRevisions.size() == 3);
+
+    // Nothing changed, so neither did the lines' revisions.
+    // All rows but the cursor's are copied from the previous frame.
+    CHECK("ABC\nDEF\nGHI" == refresh());
+    CHECK(revisions() == initialRevisions);
+    CHECK(reusedRows() == std::vector { true, true, false });
+
+    // Scrolling moves the unchanged lines up by one row.
+    mc.writeToScreen("\r\nJKL");
+    CHECK("DEF\nGHI\nJKL" == refresh());
+    CHECK(revisions()[0] == initialRevisions[1]);
+    CHECK(revisions()[1] == initialRevisions[2]);
+    CHECK("DEF\nGHI\nJKL" == refresh());
+
+    // Each of the double buffer's buffers reuses the frame it held before,
+    // which showed the cursor on another row two frames ago.
+    CHECK("DEF\nGHI\nJKL" == refresh());
+    CHECK(reusedRows() == std::vector { true, true, false });
+
+    // Modifying a line only changes that line's revision.
+    auto const scrolledRevisions = revisions();
+    mc.writeToScreen("\033[2;1Hx\033[3;4H");
+    CHECK("DEF\nxHI\nJKL" == refresh());
+    CHECK(revisions()[0] == scrolledRevisions[0]);
+    CHECK(revisions()[1] != scrolledRevisions[1]);
+    CHECK(reusedRows() == std::vector { true, false, false });
+    CHECK("DEF\nxHI\nJKL" == refresh());
+    CHECK("DEF\nxHI\nJKL" == refresh());
+
+    // Rows copied from a previous frame are rebased onto their new screen line.
+    auto const renderBuffer = mc.terminal.renderBuffer();
+    auto const& buffer = renderBuffer.get();
+    for (auto const& row: buffer.rows)
+    {
+        for (auto i = row.cellsBegin; i != row.cellsEnd; ++i)
+            CHECK(buffer.cells[i].position.line == row.lineOffset);
+        for (auto i = row.linesBegin; i != row.linesEnd; ++i)
+            CHECK(buffer.lines[i].lineOffset == row.lineOffset);
+    }
+}
+
+TEST_CASE("Terminal.RenderBuffer.Concurrent", "[terminal]")
+{
+    auto mc = MockTerm { ColumnCount(8), LineCount(3) };
+
+    // The render buffer is filled outside the terminal lock while the screen keeps changing.
+    auto done = std::atomic<bool> { false };
+    auto renderThread = std::thread { [&]() {
+        while (!done)
+            mc.terminal.refreshRenderBuffer();
+    } };
+    for (auto const i: crispy::times(500))
+        mc.writeToScreen(fmt::format("\r\nline {}", i));
+    done = true;
+    renderThread.join();
+
+    mc.terminal.refreshRenderBuffer();
+    CHECK("line 497\nline 498\nline 499" == trimmedTextScreenshot(mc));
+}
+
+TEST_CASE("Terminal.RenderBuffer.clear", "[terminal]")
+{
+    auto buffer = vtbackend::RenderBuffer {};
+    auto& cell = buffer.cells.emplace_back();
+    buffer.setCodepoints(cell, U"Hello"sv);
+    CHECK(buffer.codepointsOf(cell) == U"Hello"sv);
+
+    auto const cellCapacity = buffer.cells.capacity();
+    auto const codepointCapacity = buffer.codepoints.capacity();
+    buffer.clear();
+
+    CHECK(buffer.cells.empty());
+    CHECK(buffer.codepoints.empty());
+    CHECK(buffer.cells.capacity() == cellCapacity);
+    CHECK(buffer.codepoints.capacity() == codepointCapacity);
+}
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <gsl/span>
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace vtbackend
+{
+
+/**
+ * Bloom filter over the trigrams of a text, i.e. over each three consecutive codepoints.
+ *
+ * Used to rule out that a block of history lines contains a search term, without decompressing it.
+ * A text that does not contain all trigrams of a search term cannot contain the search term.
+ */
+class TrigramFilter
+{
+  public:
+    static constexpr size_t BitCount = 8192;
+
+    void add(char32_t a, char32_t b, char32_t c) noexcept
+    {
+        auto const bit = hash(a, b, c);
+        _bits[bit / 64] |= uint64_t { 1 } << (bit % 64);
+    }
+
+    void clear() noexcept { _bits = {}; }
+
+    /// Returns the hashes of all trigrams of @p text, to be passed to mayContain().
+    [[nodiscard]] static std::vector<uint16_t> hashes(std::u32string_view text)
+    {
+        auto result = std::vector<uint16_t> {};
+        for (size_t i = 2; i < text.size(); ++i)
+            result.push_back(hash(text[i - 2], text[i - 1], text[i]));
+        return result;
+    }
+
+    /// Tests if the filtered text may contain a text with the given trigram hashes.
+    [[nodiscard]] bool mayContain(gsl::span<uint16_t const> trigramHashes) const noexcept
+    {
+        for (auto const bit: trigramHashes)
+            if (!(_bits[bit / 64] & (uint64_t { 1 } << (bit % 64))))
+                return false;
+        return true;
+    }
+
+  private:
+    [[nodiscard]] static uint16_t hash(char32_t a, char32_t b, char32_t c) noexcept
+    {
+        auto value = (uint32_t(a) * 0x9E3779B1u) ^ (uint32_t(b) * 0x85EBCA77u) ^ (uint32_t(c) * 0xC2B2AE3Du);
+        value ^= value >> 15;
+        return static_cast<uint16_t>(value % BitCount);
+    }
+
+    std::array<uint64_t, BitCount / 64> _bits {};
+};
+
+} // namespace vtbackend
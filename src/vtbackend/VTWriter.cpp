@@ -201,8 +201,7 @@ void VTWriter::write(Line<Cell> const& line)
     }
     else
     {
-        for (Cell const& cell: line.inflatedBuffer())
-        {
+        line.visitCells([&](Cell const& cell) {
             if (cell.flags() & CellFlag::Bold)
                 sgrAdd(GraphicsRendition::Bold);
             else
@@ -216,7 +215,7 @@ void VTWriter::write(Line<Cell> const& line)
                 write(' ');
             else
                 write(cell.toUtf8());
-        }
+        });
     }
 
     sgrAdd(GraphicsRendition::Reset);
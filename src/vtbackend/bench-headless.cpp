@@ -1,10 +1,22 @@
 // SPDX-License-Identifier: Apache-2.0
 #include <vtbackend/MockTerm.h>
+#include <vtbackend/SixelParser.h>
 #include <vtbackend/Terminal.h>
 #include <vtbackend/cell/CellConfig.h>
 #include <vtbackend/logging.h>
 
+#include <vtparser/BulkTextScanner.h>
+
+#include <vtrasterizer/Renderer.h>
+#include <vtrasterizer/SoftwareRenderer.h>
+#include <vtrasterizer/TextClusterGrouper.h>
+
 #include <vtpty/MockViewPty.h>
+#if !defined(_WIN32)
+    #include <vtpty/UnixPty.h>
+#endif
+
+#include <text_shaper/mock_shaper.h>
 
 #include <crispy/App.h>
 #include <crispy/BufferObject.h>
@@ -12,8 +24,16 @@
 #include <crispy/utils.h>
 
 #include <fmt/format.h>
+#include <fmt/ranges.h>
 
+#include <libunicode/convert.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <optional>
 #include <thread>
 
@@ -36,6 +56,338 @@ std::string createText(size_t bytes)
     return text;
 }
 
+std::string createSixelStream(unsigned width, unsigned height)
+{
+    // Each sixel band is painted in a few colors, each one made of short runs of arbitrary sixels,
+    // as well as of repeated sixels for areas of a single color.
+    auto stream = fmt::format("\"1;1;{};{}", width, height);
+    for (unsigned color = 0; color < 16; ++color)
+        stream += fmt::format("#{};2;{};{};{}", color, color * 6, 100 - color * 6, color * 3);
+    for (unsigned band = 0; band < (height + 5) / 6; ++band)
+    {
+        for (unsigned color = 0; color < 4; ++color)
+        {
+            stream += fmt::format("#{}", (band + color) % 16);
+            for (unsigned x = 0; x < width;)
+            {
+                auto const runLength = std::min(1u + static_cast<unsigned>(rand() % 24), width - x);
+                if (rand() % 3 == 0)
+                    stream += fmt::format("!{}{}", runLength, static_cast<char>('?' + rand() % 64));
+                else
+                    for (unsigned i = 0; i < runLength; ++i)
+                        stream += static_cast<char>('?' + rand() % 64);
+                x += runLength;
+            }
+            stream += '$';
+        }
+        stream += '-';
+    }
+    return stream;
+}
+
+// {{{ frame benchmark scenes
+// Each scene fills the whole page with fixed content, resembling what a popular application would display.
+
+std::string vimScene(vtbackend::PageSize pageSize, vtbackend::ImageSize /*cellSize*/)
+{
+    // Syntax highlighted source code with line numbers, and the status line at the bottom.
+    auto constexpr Source = std::array<std::string_view, 12> {
+        "// Copies the visible lines into the render buffer.",
+        "struct RenderBufferFiller",
+        "{",
+        "    std::vector<std::string> lines;",
+        "    int count = 42;",
+        "",
+        "    auto fill(int first, int last) const -> bool",
+        "    {",
+        "        for (auto i = first; i < last; ++i)",
+        "            if (lines[i].empty()) return false; // nothing to do",
+        "        return count > 0 && \"done\" != lines[0];",
+        "    }",
+    };
+    auto constexpr Keywords =
+        std::array<std::string_view, 8> { "struct", "auto", "int", "const", "bool", "for", "if", "return" };
+    auto const isWordChar = [](char ch) {
+        return ('a' <= ch && ch <= 'z') || ('A' <= ch && ch <= 'Z') || ('0' <= ch && ch <= '9') || ch == '_';
+    };
+
+    auto const lines = *pageSize.lines;
+    auto output = std::string { "\033[H\033[2J" };
+    for (int line = 0; line < lines - 1; ++line)
+    {
+        auto const source = Source[static_cast<size_t>(line) % Source.size()];
+        output += fmt::format("\033[{}H\033[38;5;130m{:>4} \033[m", line + 1, line + 1);
+        for (size_t i = 0; i < source.size();)
+        {
+            auto const ch = source[i];
+            auto end = i + 1;
+            auto sgr = std::string_view {};
+            if (source.substr(i, 2) == "//")
+            {
+                end = source.size();
+                sgr = "3;38;5;244";
+            }
+            else if (ch == '"')
+            {
+                end = std::min(source.find('"', i + 1), source.size() - 1) + 1;
+                sgr = "38;5;113";
+            }
+            else if (isWordChar(ch))
+            {
+                while (end < source.size() && isWordChar(source[end]))
+                    ++end;
+                auto const word = source.substr(i, end - i);
+                if ('0' <= ch && ch <= '9')
+                    sgr = "38;5;175";
+                else if (std::find(Keywords.begin(), Keywords.end(), word) != Keywords.end())
+                    sgr = "1;38;5;214";
+            }
+            if (sgr.empty())
+                output += source.substr(i, end - i);
+            else
+                output += fmt::format("\033[{}m{}\033[m", sgr, source.substr(i, end - i));
+            i = end;
+        }
+    }
+    output += fmt::format("\033[{}H\033[7m{:<{}}\033[m",
+                          lines,
+                          " RenderBufferFiller.cpp [+]                                  12,5   Top",
+                          *pageSize.columns);
+    return output;
+}
+
+std::string htopScene(vtbackend::PageSize pageSize, vtbackend::ImageSize /*cellSize*/)
+{
+    // Meters at the top, the process tree below, and the function key bar at the bottom.
+    auto const lines = *pageSize.lines;
+    auto const columns = *pageSize.columns;
+    auto output = std::string { "\033[H\033[2J" };
+    for (int cpu = 0; cpu < 4; ++cpu)
+    {
+        auto const usage = (cpu * 37 + 11) % 100;
+        auto const bars = usage * 30 / 100;
+        output += fmt::format("\033[{}H  \033[36m{}\033[1;39m[\033[0;32m{}\033[31m{}\033[m{:>{}}"
+                              "\033[1;39m]\033[m",
+                              cpu + 1,
+                              cpu + 1,
+                              std::string(static_cast<size_t>(bars * 2 / 3), '|'),
+                              std::string(static_cast<size_t>(bars - bars * 2 / 3), '|'),
+                              fmt::format("{}.{}%", usage, cpu),
+                              36 - bars);
+    }
+    output += "\033[5H  \033[36mMem\033[1;39m[\033[0;32m|||||||||||||\033[34m||||\033[33m|||||"
+              "\033[m        5.21G/15.5G\033[1;39m]\033[m";
+    output += "\033[6H  \033[36mTasks: \033[1;39m142\033[0;36m, \033[32m613\033[36m thr; "
+              "\033[1;32m2\033[0;36m running\033[m";
+    auto const header = fmt::format("{:>7} {:<9} {:>3} {:>5} {:>5} {} {:>5} {:>4} {:>8} {}",
+                                    "PID",
+                                    "USER",
+                                    "PRI",
+                                    "VIRT",
+                                    "RES",
+                                    "S",
+                                    "CPU%",
+                                    "MEM%",
+                                    "TIME+",
+                                    "Command");
+    output += fmt::format("\033[7H\033[30;42m{:<{}}\033[m", header, columns);
+
+    auto constexpr Commands = std::array<std::string_view, 6> {
+        "/sbin/init", "contour", "zsh", "vim Renderer.cpp", "htop", "cmake --build"
+    };
+    for (int row = 0; row + 8 < lines; ++row)
+    {
+        auto const depth = row % 3;
+        auto const tree =
+            depth == 0 ? std::string {} : std::string(static_cast<size_t>(depth - 1) * 3, ' ') + "├─ ";
+        // The selected process is highlighted.
+        output += fmt::format("\033[{}H{}{:>7} {:<9} {:>3} {:>5} {:>5} {} {:>5.1f} {:>4.1f} "
+                              "{:>2}:{:02}.{:02} \033[32m{}{}\033[m",
+                              row + 8,
+                              row == 3 ? "\033[30;46m" : "",
+                              1000 + row * 17,
+                              row % 4 ? "christian" : "root",
+                              20,
+                              fmt::format("{}M", 100 + row * 13),
+                              fmt::format("{}M", 10 + row * 7),
+                              row % 5 ? 'S' : 'R',
+                              (row * 7 % 100) / 10.0,
+                              (row * 3 % 50) / 10.0,
+                              row % 60,
+                              row * 7 % 60,
+                              row * 13 % 100,
+                              tree,
+                              Commands[static_cast<size_t>(row) % Commands.size()]);
+    }
+
+    auto constexpr Keys = std::array<std::pair<std::string_view, std::string_view>, 10> {
+        std::pair { "F1", "Help  " }, std::pair { "F2", "Setup " }, std::pair { "F3", "Search" },
+        std::pair { "F4", "Filter" }, std::pair { "F5", "Tree  " }, std::pair { "F6", "SortBy" },
+        std::pair { "F7", "Nice -" }, std::pair { "F8", "Nice +" }, std::pair { "F9", "Kill  " },
+        std::pair { "F10", "Quit " },
+    };
+    output += fmt::format("\033[{}H", lines);
+    for (auto const& [key, label]: Keys)
+        output += fmt::format("\033[m{}\033[30;46m{}", key, label);
+    output += "\033[m";
+    return output;
+}
+
+std::string powerlineScene(vtbackend::PageSize pageSize, vtbackend::ImageSize /*cellSize*/)
+{
+    // Powerline prompts, each one followed by the output of a command drawing a table.
+    auto const lines = *pageSize.lines;
+    auto output = std::string { "\033[H\033[2J" };
+    for (int line = 0; line < lines; ++line)
+    {
+        output += fmt::format("\033[{}H", line + 1);
+        switch (line % 6)
+        {
+            case 0:
+                output += "\033[38;5;231;48;5;31m  ~/projects/contour \033[38;5;31;48;5;236m\033[38;5;250m"
+                          "  master ✚ \033[38;5;236;48;5;28m\033[38;5;231m ✔ \033[38;5;28;49m"
+                          "\033[m cmake --build build --target test";
+                break;
+            case 1: output += "┌────────────────────┬──────────┬──────────┐"; break;
+            case 2:
+                output += "│ \033[1mtest\033[m               │ \033[1mresult\033[m   │ "
+                          "\033[1mtime\033[m     │";
+                break;
+            case 3: output += "├────────────────────┼──────────┼──────────┤"; break;
+            case 4:
+                output += fmt::format("│ vtbackend_test {:<4}│ \033[32mpassed\033[m   │ {:>5} ms │",
+                                      line,
+                                      line * 17);
+                break;
+            case 5: output += "└────────────────────┴──────────┴──────────┘"; break;
+            default: break;
+        }
+    }
+    return output;
+}
+
+std::string cjkScene(vtbackend::PageSize pageSize, vtbackend::ImageSize /*cellSize*/)
+{
+    // Lines of double width CJK ideographs, mixed with some kana and ASCII.
+    auto const lines = *pageSize.lines;
+    auto const columns = *pageSize.columns;
+    auto output = std::string { "\033[H\033[2J" };
+    for (int line = 0; line < lines; ++line)
+    {
+        auto text = std::u32string {};
+        for (int column = 0; column + 1 < columns; column += 2)
+        {
+            auto const i = static_cast<char32_t>(line * columns + column);
+            if (column % 16 == 14)
+                text += static_cast<char32_t>(0x3042 + i % 80); // Hiragana
+            else
+                text += static_cast<char32_t>(0x4E00 + i * 7 % 20000);
+        }
+        output += fmt::format("\033[{}H{}", line + 1, unicode::convert_to<char>(std::u32string_view(text)));
+    }
+    return output;
+}
+
+std::string emojiScene(vtbackend::PageSize pageSize, vtbackend::ImageSize /*cellSize*/)
+{
+    // A grid of double width emoji, including some made of a sequence of codepoints.
+    auto const lines = *pageSize.lines;
+    auto const columns = *pageSize.columns;
+    auto output = std::string { "\033[H\033[2J" };
+    for (int line = 0; line < lines; ++line)
+    {
+        auto text = std::u32string {};
+        for (int column = 0; column + 1 < columns; column += 2)
+        {
+            auto const i = static_cast<char32_t>(line * columns + column) / 2;
+            if (column % 20 == 8)
+                text += U"👩‍💻";
+            else if (i % 2)
+                text += static_cast<char32_t>(0x1F600 + i % 80); // Emoticons
+            else
+                text += static_cast<char32_t>(0x1F910 + i % 0x40); // Supplemental symbols and pictographs
+        }
+        output += fmt::format("\033[{}H{}", line + 1, unicode::convert_to<char>(std::u32string_view(text)));
+    }
+    return output;
+}
+
+std::string sixelScene(vtbackend::PageSize pageSize, vtbackend::ImageSize cellSize)
+{
+    // A single image covering the whole page.
+    auto const imageSize = cellSize * pageSize;
+    auto const stream = createSixelStream(*imageSize.width, *imageSize.height);
+    return fmt::format("\033[H\033[2J\033Pq{}\033\\", stream);
+}
+// }}}
+
+/// Render target that discards all render commands, only counting them,
+/// so that merely the cost of producing them is measured.
+class NullRenderTarget final: public vtrasterizer::RenderTarget, public vtrasterizer::atlas::AtlasBackend
+{
+  public:
+    void setRenderSize(vtbackend::ImageSize /*size*/) override {}
+    void setMargin(vtrasterizer::PageMargin /*margin*/) override {}
+    vtrasterizer::atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int /*x*/, int /*y*/, Width, Height, RGBAColor /*color*/) override { ++rectangles; }
+    void scheduleScreenshot(ScreenshotCallback /*callback*/) override {}
+    void execute(std::chrono::steady_clock::time_point /*now*/) override {}
+    void clearCache() override {}
+    std::optional<vtrasterizer::AtlasTextureScreenshot> readAtlas() override { return std::nullopt; }
+    void inspect(std::ostream& /*output*/) const override {}
+
+    [[nodiscard]] vtbackend::ImageSize atlasSize() const noexcept override { return _atlasSize; }
+    void configureAtlas(vtrasterizer::atlas::ConfigureAtlas atlas) override { _atlasSize = atlas.size; }
+    void uploadTile(vtrasterizer::atlas::UploadTile /*tile*/) override { ++tileUploads; }
+    void renderTile(vtrasterizer::atlas::RenderTile /*tile*/) override { ++tiles; }
+
+    uint64_t rectangles = 0;
+    uint64_t tiles = 0;
+    uint64_t tileUploads = 0;
+
+  private:
+    vtbackend::ImageSize _atlasSize {};
+};
+
+/// Counts the text groups produced by the TextClusterGrouper.
+struct TextGroupCounter: public vtrasterizer::TextClusterGrouper::Events
+{
+    void renderTextGroup(std::u32string_view /*codepoints*/,
+                         gsl::span<unsigned> /*clusters*/,
+                         vtbackend::CellLocation /*initialPenPosition*/,
+                         vtrasterizer::TextStyle /*style*/,
+                         vtbackend::RGBColor /*color*/) override
+    {
+        ++textGroups;
+    }
+
+    bool renderBoxDrawingCell(vtbackend::CellLocation /*position*/,
+                              char32_t codepoint,
+                              vtbackend::RGBColor /*foregroundColor*/) override
+    {
+        if (!vtrasterizer::BoxDrawingRenderer::renderable(codepoint))
+            return false;
+        ++boxDrawingCells;
+        return true;
+    }
+
+    uint64_t textGroups = 0;
+    uint64_t boxDrawingCells = 0;
+};
+
+vtrasterizer::TextStyle textStyleOf(vtbackend::CellFlags flags) noexcept
+{
+    auto const bold = flags & vtbackend::CellFlag::Bold;
+    auto const italic = flags & vtbackend::CellFlag::Italic;
+    if (bold && italic)
+        return vtrasterizer::TextStyle::BoldItalic;
+    if (bold)
+        return vtrasterizer::TextStyle::Bold;
+    if (italic)
+        return vtrasterizer::TextStyle::Italic;
+    return vtrasterizer::TextStyle::Regular;
+}
+
 } // namespace
 
 struct BenchOptions
@@ -45,8 +397,44 @@ struct BenchOptions
     bool longLines = false;
     bool sgr = false;
     bool binary = false;
+    bool trace = false;
+    bool traceSync = false;
 };
 
+/// Prints the memory held by the packed lines of the (not yet frozen) history,
+/// compared to the memory the very same lines take up as a vector of cells.
+template <typename Cell>
+void printPackedHistoryMemory(vtbackend::Grid<Cell> const& grid)
+{
+    using vtbackend::LineOffset;
+    using vtbackend::PackedLineBuffer;
+
+    auto lineCount = size_t { 0 };
+    auto packedBytes = size_t { 0 };
+    auto inflatedBytes = size_t { 0 };
+    for (auto y = LineOffset(-1); y >= -boxed_cast<LineOffset>(grid.hotHistoryLineCount()); --y)
+    {
+        auto const& line = grid.lineAt(y);
+        if (!line.isPackedBuffer())
+            continue;
+        auto const& buffer = line.packedBuffer();
+        ++lineCount;
+        packedBytes += buffer.text.capacity() + buffer.columns.capacity() * sizeof(PackedLineBuffer::Column)
+                       + buffer.runs.capacity() * sizeof(PackedLineBuffer::AttributeRun);
+        inflatedBytes += unbox<size_t>(line.size()) * sizeof(Cell);
+    }
+
+    if (!lineCount)
+        return;
+
+    cout << fmt::format("{:>12}: {} lines, {} instead of {} inflated ({:.1f}%)\n",
+                        "packed lines",
+                        lineCount,
+                        crispy::humanReadableBytes(packedBytes),
+                        crispy::humanReadableBytes(inflatedBytes),
+                        100.0 * static_cast<double>(packedBytes) / static_cast<double>(inflatedBytes));
+}
+
 template <typename Writer>
 int baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
 {
@@ -85,8 +473,36 @@ int baseBenchmark(Writer&& writer, BenchOptions options, string_view title)
     if (options.binary)
         tbp.add(contour::termbench::tests::binary());
 
+    // Traces every VT sequence into the null device, to measure what logging costs the hot path.
+    auto traceSink = std::optional<logstore::sink> {};
+    // The category only exists in builds with LIBTERMINAL_LOG_TRACE enabled.
+    auto* const traceLog = logstore::get("vt.trace.sequence");
+    if (options.trace && !traceLog)
+        cout << "Tracing is not available in this build.\n";
+    else if (options.trace)
+    {
+#if defined(_WIN32)
+        auto constexpr NullDevice = "NUL";
+#else
+        auto constexpr NullDevice = "/dev/null";
+#endif
+        traceSink.emplace(true, std::make_shared<std::ofstream>(NullDevice));
+        traceSink->set_async(!options.traceSync);
+        traceLog->set_sink(*traceSink);
+        traceLog->enable();
+        cout << fmt::format("Tracing VT sequences {}.\n",
+                            options.traceSync ? "synchronously" : "asynchronously");
+    }
+
     tbp.runAll();
 
+    if (traceSink)
+    {
+        traceLog->disable();
+        traceLog->set_sink(logstore::sink::console());
+        traceSink.reset();
+    }
+
     cout << '\n';
     cout << "Results\n";
     cout << "-------\n";
@@ -115,7 +531,13 @@ class ContourHeadlessBench: public crispy::app
             Project { "fmt", "MIT", "https://github.com/fmtlib/fmt" });
         link("bench-headless.parser", bind(&ContourHeadlessBench::benchParserOnly, this));
         link("bench-headless.grid", bind(&ContourHeadlessBench::benchGrid, this));
-        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY));
+        link("bench-headless.concurrent", bind(&ContourHeadlessBench::benchConcurrent, this));
+        link("bench-headless.pty", bind(&ContourHeadlessBench::benchPTY, this));
+        link("bench-headless.search", bind(&ContourHeadlessBench::benchSearch, this));
+        link("bench-headless.dispatch", bind(&ContourHeadlessBench::benchDispatch, this));
+        link("bench-headless.sixel", bind(&ContourHeadlessBench::benchSixel, this));
+        link("bench-headless.render", bind(&ContourHeadlessBench::benchRender, this));
+        link("bench-headless.frame", bind(&ContourHeadlessBench::benchFrame, this));
         link("bench-headless.meta", bind(&ContourHeadlessBench::showMetaInfo));
 
         char const* logFilterString = getenv("LOG");
@@ -134,8 +556,32 @@ class ContourHeadlessBench: public crispy::app
             CLI::option { "long", CLI::value { false }, "Enable long-line ASCII stream test." },
             CLI::option { "sgr", CLI::value { false }, "Enable SGR stream test." },
             CLI::option { "binary", CLI::value { false }, "Enable binary stream test." },
+            CLI::option { "trace", CLI::value { false }, "Trace every VT sequence into the null device." },
+            CLI::option { "trace-sync",
+                          CLI::value { false },
+                          "Write the trace synchronously rather than on a background thread." },
         };
 
+        auto concurrentOptions = perfOptions;
+        concurrentOptions.emplace_back(
+            CLI::option { "locked",
+                          CLI::value { false },
+                          "Fill the render buffer entirely under the terminal lock, for comparison." });
+
+        auto renderOptions = perfOptions;
+        renderOptions.emplace_back(CLI::option { "threads",
+                                                 CLI::value { 1u },
+                                                 "Number of threads to rasterize each frame with.",
+                                                 "COUNT" });
+        renderOptions.emplace_back(CLI::option { "frame-bytes",
+                                                 CLI::value { 65536u },
+                                                 "Number of bytes to process in between two frames.",
+                                                 "BYTES" });
+        renderOptions.emplace_back(
+            CLI::option { "font", CLI::value { "monospace"s }, "Font family to render with.", "FAMILY" });
+        renderOptions.emplace_back(
+            CLI::option { "font-size", CLI::value { 12.0 }, "Font size to render with.", "POINTS" });
+
         return CLI::command {
             "bench-headless",
             "Contour Terminal Emulator " CONTOUR_VERSION_STRING
@@ -150,11 +596,75 @@ class ContourHeadlessBench: public crispy::app
                 CLI::command { "grid",
                                "Performs performance tests utilizing the full grid including VT parser.",
                                perfOptions },
+                CLI::command { "concurrent",
+                               "Performs the grid performance tests while continuously refreshing the "
+                               "render buffer from another thread.",
+                               concurrentOptions },
                 CLI::command {
                     "parser", "Performs performance tests utilizing the VT parser only.", perfOptions },
+                CLI::command { "render",
+                               "Performs the grid performance tests while rendering frames in between "
+                               "into a software framebuffer, i.e. without requiring a GPU.",
+                               renderOptions },
+                CLI::command {
+                    "frame",
+                    "Performs render pipeline tests on fixed-content scenes, from refreshing the render "
+                    "buffer up to the render commands, using a mock text shaper and a null render target. "
+                    "Prints the time per grid cell of each stage as JSON.",
+                    CLI::option_list {
+                        CLI::option { "iterations",
+                                      CLI::value { 100u },
+                                      "Number of times to run each stage per scene.",
+                                      "COUNT" },
+                        CLI::option { "scene",
+                                      CLI::value { "all"s },
+                                      "Scene to run: vim, htop, powerline, cjk, emoji, sixel, or all.",
+                                      "NAME" },
+                    } },
                 CLI::command {
                     "pty",
-                    "Performs performance tests utilizing the underlying operating system's PTY only." },
+                    "Performs performance tests utilizing the underlying operating system's PTY only.",
+                    CLI::option_list {
+                        CLI::option { "time", CLI::value { 10u }, "Number of seconds to run the test.", "SECONDS" },
+                        CLI::option {
+                            "write-size", CLI::value { 4096u }, "Number of bytes per write.", "BYTES" },
+                        CLI::option { "read-size",
+                                      CLI::value { 4096u },
+                                      "Number of bytes to read at most per read call.",
+                                      "BYTES" },
+                        CLI::option { "fastpipe",
+                                      CLI::value { false },
+                                      "Write to the stdout fast pipe instead of the PTY slave." },
+                    } },
+                CLI::command {
+                    "search",
+                    "Performs search tests on a terminal with infinite history filled with log-like lines.",
+                    CLI::option_list {
+                        CLI::option { "lines",
+                                      CLI::value { 1'000'000u },
+                                      "Number of lines to fill the history with.",
+                                      "COUNT" },
+                    } },
+                CLI::command {
+                    "dispatch",
+                    "Performs function lookups for the control sequences of the SGR stream tests.",
+                    CLI::option_list {
+                        CLI::option { "count",
+                                      CLI::value { 10'000'000u },
+                                      "Number of lookups per strategy.",
+                                      "COUNT" },
+                    } },
+                CLI::command {
+                    "sixel",
+                    "Performs Sixel image decoding tests on photo-like images.",
+                    CLI::option_list {
+                        CLI::option { "width", CLI::value { 800u }, "Width of the image.", "PIXELS" },
+                        CLI::option { "height", CLI::value { 600u }, "Height of the image.", "PIXELS" },
+                        CLI::option { "count",
+                                      CLI::value { 100u },
+                                      "Number of images to decode per strategy.",
+                                      "COUNT" },
+                    } },
             }
         };
     }
@@ -167,6 +677,7 @@ class ContourHeadlessBench: public crispy::app
         fmt::print("CellExtra   : {} bytes\n", sizeof(vtbackend::CellExtra));
         fmt::print("CellFlags   : {} bytes\n", sizeof(vtbackend::CellFlags));
         fmt::print("Color       : {} bytes\n", sizeof(vtbackend::Color));
+        fmt::print("Text scanner: {}\n", vtparser::to_string(vtparser::bulkTextScannerKind()));
         return EXIT_SUCCESS;
     }
 
@@ -179,6 +690,8 @@ class ContourHeadlessBench: public crispy::app
         opts.longLines = parameters().boolean(prefix + "long");
         opts.sgr = parameters().boolean(prefix + "sgr");
         opts.binary = parameters().boolean(prefix + "binary");
+        opts.trace = parameters().boolean(prefix + "trace");
+        opts.traceSync = parameters().boolean(prefix + "trace-sync");
         return opts;
     }
 
@@ -206,11 +719,65 @@ class ContourHeadlessBench: public crispy::app
             benchOptionsFor("grid"),
             "terminal with screen buffer");
         if (rv == EXIT_SUCCESS)
-            cout << fmt::format("{:>12}: {}\n\n", "history size", *vt.terminal.maxHistoryLineCount());
+        {
+            cout << fmt::format("{:>12}: {}\n", "history size", *vt.terminal.maxHistoryLineCount());
+            printPackedHistoryMemory(vt.terminal.primaryScreen().grid());
+            cout << '\n';
+        }
+        return rv;
+    }
+
+    int benchConcurrent()
+    {
+        auto pageSize = vtbackend::PageSize { vtbackend::LineCount(25), vtbackend::ColumnCount(80) };
+        size_t const ptyReadBufferSize = 1'000'000;
+        auto maxHistoryLineCount = vtbackend::LineCount(4000);
+        auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, maxHistoryLineCount, ptyReadBufferSize);
+        auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
+        vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+
+        // Mimics the render thread, refreshing the render buffer as fast as it can.
+        auto const locked = parameters().boolean("bench-headless.concurrent.locked");
+        auto done = std::atomic<bool> { false };
+        auto frames = uint64_t { 0 };
+        auto renderThread = std::thread { [&]() {
+            while (!done)
+            {
+                if (locked)
+                {
+                    auto const _ = std::lock_guard { vt.terminal };
+                    vt.terminal.refreshRenderBuffer(true);
+                }
+                else
+                    vt.terminal.refreshRenderBuffer();
+                ++frames;
+            }
+        } };
+        auto stopRenderThread = crispy::finally { [&]() {
+            done = true;
+            renderThread.join();
+        } };
+
+        auto const rv = baseBenchmark(
+            [&](char const* a, size_t b) -> bool {
+                if (pty->isClosed())
+                    return false;
+                pty->setReadData({ a, b });
+                do
+                    vt.terminal.processInputOnce();
+                while (!pty->isClosed() && !pty->stdoutBuffer().empty());
+                return true;
+            },
+            benchOptionsFor("concurrent"),
+            locked ? "terminal with locked render buffer refresh" : "terminal with render buffer refresh");
+
+        stopRenderThread.run();
+        if (rv == EXIT_SUCCESS)
+            cout << fmt::format("{:>12}: {}\n\n", "frames", frames);
         return rv;
     }
 
-    static int benchPTY()
+    int benchPTY()
     {
         using std::chrono::steady_clock;
         using vtpty::ColumnCount;
@@ -220,20 +787,36 @@ class ContourHeadlessBench: public crispy::app
         using vtpty::Pty;
 
         // Benchmark configuration
-        // TODO make these values CLI configurable.
         auto constexpr WritesPerLoop = 1;
-        auto constexpr PtyWriteSize = 4096;
-        auto constexpr PtyReadSize = 4096;
-        auto const benchTime = chrono::seconds(10);
+        auto const ptyWriteSize = parameters().uint("bench-headless.pty.write-size");
+        auto const ptyReadSize = parameters().uint("bench-headless.pty.read-size");
+        auto const benchTime = chrono::seconds(parameters().uint("bench-headless.pty.time"));
+        auto const useFastPipe = parameters().boolean("bench-headless.pty.fastpipe");
 
         // Setup benchmark
-        std::string const text = createText(PtyWriteSize);
+        std::string const text = createText(ptyWriteSize);
         unique_ptr<Pty> ptyObject = createPty(PageSize { LineCount(25), ColumnCount(80) }, std::nullopt);
         auto& pty = *ptyObject;
+        pty.start();
         auto& ptySlave = pty.slave();
         (void) ptySlave.configure();
 
-        auto bufferObjectPool = crispy::buffer_object_pool<char>(4llu * 1024 * 1024);
+#if !defined(_WIN32)
+        auto* const unixPty = dynamic_cast<vtpty::UnixPty*>(&pty);
+        auto const writeText = [&]() {
+            if (useFastPipe && unixPty)
+                (void) ::write(unixPty->stdoutFastPipe().writer(), text.data(), text.size());
+            else
+                (void) ptySlave.write(text);
+        };
+#else
+        auto const writeText = [&]() {
+            (void) ptySlave.write(text);
+        };
+#endif
+
+        auto bufferObjectPool =
+            crispy::buffer_object_pool<char>(4llu * 1024 * 1024, crispy::buffer_object_memory::Mapped);
         auto bufferObject = bufferObjectPool.allocateBufferObject();
 
         auto bytesTransferred = uint64_t { 0 };
@@ -241,7 +824,7 @@ class ContourHeadlessBench: public crispy::app
         auto ptyStdoutReaderThread = std::thread { [&]() {
             while (!pty.isClosed())
             {
-                auto const readResult = pty.read(*bufferObject, std::chrono::seconds(2), PtyReadSize);
+                auto const readResult = pty.read(*bufferObject, std::chrono::seconds(2), ptyReadSize);
                 if (!readResult)
                     break;
                 auto const dataChunk = get<string_view>(readResult.value());
@@ -263,7 +846,7 @@ class ContourHeadlessBench: public crispy::app
         while (stopTime - startTime < benchTime)
         {
             for (int i = 0; i < WritesPerLoop; ++i)
-                (void) ptySlave.write(text);
+                writeText();
             stopTime = steady_clock::now();
         }
 
@@ -280,8 +863,9 @@ class ContourHeadlessBench: public crispy::app
         fmt::print("PTY stdout throughput bandwidth test\n");
         fmt::print("====================================\n\n");
         fmt::print("Writes per loop        : {}\n", WritesPerLoop);
-        fmt::print("PTY write size         : {}\n", PtyWriteSize);
-        fmt::print("PTY read size          : {}\n", PtyReadSize);
+        fmt::print("PTY write size         : {}\n", ptyWriteSize);
+        fmt::print("PTY read size          : {}\n", ptyReadSize);
+        fmt::print("Written to             : {}\n", useFastPipe ? "stdout fast pipe" : "PTY slave");
         fmt::print("Test time              : {}.{:03} seconds\n", msecs.count() / 1000, msecs.count() % 1000);
         fmt::print("Data transferred       : {}\n", crispy::humanReadableBytes(bytesTransferred));
         fmt::print("Reader loop iterations : {}\n", loopIterations);
@@ -292,6 +876,508 @@ class ContourHeadlessBench: public crispy::app
         fmt::print("Transfer speed         : {} per second\n",
                    crispy::humanReadableBytes(static_cast<uint64_t>(mbPerSecs)));
 
+#if !defined(_WIN32)
+        if (unixPty)
+        {
+            auto const& stats = unixPty->readStatistics();
+            auto const megabytes = static_cast<long double>(stats.bytes) / (1024.0L * 1024.0L);
+            fmt::print("Waits for input        : {}\n", stats.waits);
+            fmt::print("Read calls             : {}\n", stats.reads);
+            fmt::print("Syscalls per MB        : {:.1f}\n",
+                       static_cast<long double>(stats.waits + stats.reads) / megabytes);
+        }
+#endif
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchSearch()
+    {
+        using std::chrono::steady_clock;
+        using vtbackend::CellLocation;
+        using vtbackend::ColumnOffset;
+        using vtbackend::LineOffset;
+
+        auto const lineCount = parameters().uint("bench-headless.search.lines");
+        auto pageSize = vtbackend::PageSize { vtbackend::LineCount(25), vtbackend::ColumnCount(80) };
+        auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, vtbackend::LineCount(0), 1'000'000);
+        auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
+        vt.terminal.setMaxHistoryLineCount(vtbackend::Infinite());
+
+        auto const elapsedMilliseconds = [](steady_clock::time_point start) {
+            return std::chrono::duration_cast<std::chrono::microseconds>(steady_clock::now() - start).count()
+                   / 1000.0;
+        };
+
+        // Fills the history with log-like lines, the very first one containing the needle,
+        // and every 1000th line an error.
+        fmt::print("Filling history with {} lines ...\n", lineCount);
+        auto const fillStart = steady_clock::now();
+        auto chunk = std::string {};
+        for (unsigned i = 0; i < lineCount; ++i)
+        {
+            if (i == 0)
+                chunk += "needle in the haystack\r\n";
+            else
+                chunk += fmt::format(
+                    "2024-05-{:02} {:02}:{:02}:{:02} [{}] worker-{} handled request {} in {} ms\r\n",
+                    1 + i / 86400 % 28,
+                    i / 3600 % 24,
+                    i / 60 % 60,
+                    i % 60,
+                    i % 1000 == 0 ? "ERROR" : "INFO",
+                    i % 16,
+                    i,
+                    rand() % 500);
+            if (chunk.size() >= 1'000'000 || i + 1 == lineCount)
+            {
+                pty->setReadData(chunk);
+                do
+                    vt.terminal.processInputOnce();
+                while (!pty->stdoutBuffer().empty());
+                chunk.clear();
+            }
+        }
+        auto& screen = vt.terminal.primaryScreen();
+        auto& grid = screen.grid();
+        fmt::print("{:>24}: {:.1f} ms\n", "fill", elapsedMilliseconds(fillStart));
+        fmt::print("{:>24}: {} ({} frozen)\n",
+                   "history lines",
+                   *grid.historyLineCount(),
+                   *grid.frozenHistoryLineCount());
+        fmt::print("{:>24}: {}\n\n",
+                   "compressed history",
+                   crispy::humanReadableBytes(grid.frozenHistory().compressedSize()));
+
+        auto const needle = std::u32string_view(U"needle in the haystack");
+        auto const bottom = screen.cursor().position;
+
+        auto start = steady_clock::now();
+        auto const match = screen.searchReverse(needle, bottom);
+        fmt::print("{:>24}: {:.1f} ms\n", "indexed reverse search", elapsedMilliseconds(start));
+
+        // Baseline: scanning every logical line, as searching did before the history was indexed.
+        start = steady_clock::now();
+        auto scanMatch = std::optional<CellLocation> {};
+        auto const lastColumn = boxed_cast<ColumnOffset>(pageSize.columns) - 1;
+        for (auto const& line: grid.logicalLinesReverseFrom(bottom.line))
+        {
+            if ((scanMatch = line.searchReverse(needle, lastColumn)))
+                break;
+        }
+        fmt::print("{:>24}: {:.1f} ms\n", "linear reverse scan", elapsedMilliseconds(start));
+
+        auto const top = CellLocation { -boxed_cast<LineOffset>(grid.historyLineCount()), ColumnOffset(0) };
+        start = steady_clock::now();
+        auto const missing = screen.search(U"no such text", top);
+        fmt::print("{:>24}: {:.1f} ms\n", "indexed search, no match", elapsedMilliseconds(start));
+
+        start = steady_clock::now();
+        auto const errors = screen.searchAll(U"[ERROR]");
+        fmt::print("{:>24}: {:.1f} ms ({} matches)\n",
+                   "indexed search all",
+                   elapsedMilliseconds(start),
+                   errors.size());
+
+        // Case-insensitive regular expression, which cannot be narrowed down by the trigram index.
+        auto const pattern = vtbackend::SearchPattern::fromSearchTerm(U"\\v\\c\\[error\\] worker-\\d+");
+        start = steady_clock::now();
+        auto const regexErrors = screen.searchAll(pattern, top.line, bottom.line);
+        fmt::print("{:>24}: {:.1f} ms ({} matches)\n",
+                   "regex search all",
+                   elapsedMilliseconds(start),
+                   regexErrors.size());
+
+        if (!match || match != scanMatch || missing || regexErrors.size() != errors.size())
+        {
+            fmt::print("Search results mismatch.\n");
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchDispatch()
+    {
+        using std::chrono::steady_clock;
+        using vtbackend::FunctionCategory;
+        using vtbackend::FunctionDefinition;
+        using vtbackend::FunctionSelector;
+
+        auto const count = parameters().uint("bench-headless.dispatch.count");
+        auto const sequences = vtbackend::SupportedSequences {};
+
+        // The sequences the SGR stream tests are made of: true color foreground and background changes,
+        // attribute changes, resets, as well as the cursor movements and line erasures in between.
+        auto const selectors = std::array {
+            FunctionSelector { FunctionCategory::CSI, 0, 5, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 10, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 1, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 5, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 0, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 2, 0, 'H' },
+            FunctionSelector { FunctionCategory::CSI, 0, 3, 0, 'm' },
+            FunctionSelector { FunctionCategory::CSI, 0, 0, 0, 'K' },
+        };
+
+        auto const run = [&](string_view title, auto&& lookup) {
+            auto matches = uint64_t { 0 };
+            auto const start = steady_clock::now();
+            for (unsigned i = 0; i < count; ++i)
+                matches += lookup(selectors[i % selectors.size()]) != nullptr;
+            auto const elapsed = std::chrono::duration<double, std::nano>(steady_clock::now() - start);
+            fmt::print("{:>24}: {:.2f} ns per lookup\n", title, elapsed.count() / count);
+            return matches;
+        };
+
+        fmt::print("Looking up {} sequences per strategy ...\n", count);
+        auto const searched = run("binary search", [&](FunctionSelector const& selector) {
+            return vtbackend::select(selector, sequences.activeSequences());
+        });
+        auto const dispatched = run("dispatch table", [&](FunctionSelector const& selector) {
+            return sequences.select(selector);
+        });
+
+        if (searched != count || dispatched != count)
+        {
+            fmt::print("Lookup results mismatch.\n");
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchSixel()
+    {
+        using std::chrono::steady_clock;
+        using vtbackend::Height;
+        using vtbackend::ImageSize;
+        using vtbackend::RGBAColor;
+        using vtbackend::SixelColorPalette;
+        using vtbackend::SixelImageBuilder;
+        using vtbackend::SixelParser;
+        using vtbackend::Width;
+
+        auto const width = parameters().uint("bench-headless.sixel.width");
+        auto const height = parameters().uint("bench-headless.sixel.height");
+        auto const count = parameters().uint("bench-headless.sixel.count");
+        auto const imageSize = ImageSize { Width(width), Height(height) };
+        auto const backgroundColor = RGBAColor { 0, 0, 0, 0xFF };
+
+        auto const stream = createSixelStream(width, height);
+
+        auto const newBuilder = [&]() {
+            return std::make_unique<SixelImageBuilder>(
+                imageSize, 1, 1, backgroundColor, std::make_shared<SixelColorPalette>(16, 256));
+        };
+
+        auto const run = [&](string_view title, auto&& decode) {
+            auto const start = steady_clock::now();
+            auto result = SixelImageBuilder::Buffer {};
+            for (unsigned i = 0; i < count; ++i)
+                result = decode();
+            auto const elapsed = std::chrono::duration<double>(steady_clock::now() - start).count();
+            fmt::print("{:>24}: {:.2f} ms per image, {:.1f} MB/s\n",
+                       title,
+                       elapsed * 1000.0 / count,
+                       static_cast<double>(stream.size()) * count / elapsed / (1024.0 * 1024.0));
+            return result;
+        };
+
+        fmt::print("Decoding {} images of {}x{} pixels ({} per image) per strategy ...\n",
+                   count,
+                   width,
+                   height,
+                   crispy::humanReadableBytes(stream.size()));
+
+        // Baseline: passing on the data byte by byte, into a new canvas for each image.
+        auto const perByte = run("per byte", [&]() {
+            auto builder = newBuilder();
+            auto parser = SixelParser { *builder };
+            for (auto const ch: stream)
+                parser.pass(ch);
+            parser.finalize();
+            return std::move(builder->data());
+        });
+
+        auto const batched = run("batched", [&]() {
+            auto builder = newBuilder();
+            auto parser = SixelParser { *builder };
+            parser.pass(string_view(stream));
+            parser.finalize();
+            return std::move(builder->data());
+        });
+
+        auto builder = newBuilder();
+        auto const reused = run("batched, reused canvas", [&]() {
+            builder->reset(1, 1, backgroundColor, std::make_shared<SixelColorPalette>(16, 256));
+            auto parser = SixelParser { *builder };
+            parser.pass(string_view(stream));
+            parser.finalize();
+            return builder->data();
+        });
+
+        if (perByte != batched || batched != reused)
+        {
+            fmt::print("Decoded images mismatch.\n");
+            return EXIT_FAILURE;
+        }
+
+        return EXIT_SUCCESS;
+    }
+
+    int benchRender()
+    {
+        using std::chrono::steady_clock;
+
+        auto const pageSize = vtbackend::PageSize { vtbackend::LineCount(24), vtbackend::ColumnCount(80) };
+        size_t const ptyReadBufferSize = 1'000'000;
+        auto maxHistoryLineCount = vtbackend::LineCount(4000);
+        auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, maxHistoryLineCount, ptyReadBufferSize);
+        auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
+        vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+
+        auto fontDescriptions = vtrasterizer::FontDescriptions {};
+        fontDescriptions.dpi = { 96, 96 };
+        fontDescriptions.size = text::font_size { parameters().real("bench-headless.render.font-size") };
+        fontDescriptions.regular.familyName = parameters().str("bench-headless.render.font");
+        fontDescriptions.bold = fontDescriptions.regular;
+        fontDescriptions.bold.weight = text::font_weight::bold;
+        fontDescriptions.italic = fontDescriptions.regular;
+        fontDescriptions.italic.slant = text::font_slant::italic;
+        fontDescriptions.boldItalic = fontDescriptions.bold;
+        fontDescriptions.boldItalic.slant = text::font_slant::italic;
+
+        auto renderer = vtrasterizer::Renderer { pageSize,
+                                                 fontDescriptions,
+                                                 vt.terminal.colorPalette(),
+                                                 crispy::strong_hashtable_size { 4096 },
+                                                 crispy::lru_capacity { 4000 },
+                                                 true,
+                                                 vtrasterizer::Decorator::DottedUnderline,
+                                                 vtrasterizer::Decorator::Underline };
+        auto target = vtrasterizer::SoftwareRenderer { renderer.cellSize() * pageSize,
+                                                       parameters().uint("bench-headless.render.threads") };
+        renderer.setRenderTarget(target);
+
+        auto const frameBytes =
+            std::max(size_t { 1 }, size_t { parameters().uint("bench-headless.render.frame-bytes") });
+        auto renderTime = steady_clock::duration::zero();
+        auto atlasHits = uint64_t { 0 };
+        auto atlasMisses = uint64_t { 0 };
+
+        auto const rv = baseBenchmark(
+            [&](char const* a, size_t b) -> bool {
+                for (size_t offset = 0; offset < b; offset += frameBytes)
+                {
+                    pty->setReadData({ a + offset, std::min(frameBytes, b - offset) });
+                    do
+                        vt.terminal.processInputOnce();
+                    while (!pty->stdoutBuffer().empty());
+
+                    auto const start = steady_clock::now();
+                    renderer.render(vt.terminal, false);
+                    renderTime += steady_clock::now() - start;
+
+                    auto const atlasStats = renderer.fetchAndClearAtlasStats();
+                    atlasHits += atlasStats.hits;
+                    atlasMisses += atlasStats.misses;
+                }
+                return true;
+            },
+            benchOptionsFor("render"),
+            "terminal with software rendering");
+        if (rv != EXIT_SUCCESS)
+            return rv;
+
+        auto const& stats = target.statistics();
+        auto const frames = std::max(stats.frames, uint64_t { 1 });
+        auto const seconds = std::chrono::duration<double>(renderTime).count();
+        fmt::print("{:>16}: {}x{} pixels, {} thread(s)\n",
+                   "framebuffer",
+                   target.renderSize().width,
+                   target.renderSize().height,
+                   target.threadCount());
+        fmt::print("{:>16}: {}\n", "frames", stats.frames);
+        fmt::print("{:>16}: {:.1f}\n", "frames/second", static_cast<double>(stats.frames) / seconds);
+        fmt::print("{:>16}: {:.3f} ms\n", "time/frame", seconds * 1000.0 / static_cast<double>(frames));
+        fmt::print("{:>16}: {:.1f}\n",
+                   "tiles/frame",
+                   static_cast<double>(stats.tiles) / static_cast<double>(frames));
+        fmt::print("{:>16}: {:.2f} ({})\n",
+                   "uploads/frame",
+                   static_cast<double>(stats.tileUploads) / static_cast<double>(frames),
+                   crispy::humanReadableBytes(stats.uploadedBytes));
+        fmt::print("{:>16}: {:.2f}% ({} hits, {} misses)\n\n",
+                   "atlas hit rate",
+                   atlasHits + atlasMisses ? 100.0 * static_cast<double>(atlasHits)
+                                                 / static_cast<double>(atlasHits + atlasMisses)
+                                           : 100.0,
+                   atlasHits,
+                   atlasMisses);
+        return EXIT_SUCCESS;
+    }
+
+    int benchFrame()
+    {
+        using std::chrono::steady_clock;
+        using vtbackend::ColumnCount;
+        using vtbackend::LineCount;
+        using vtbackend::PageSize;
+
+        auto const iterations = std::max(1u, parameters().uint("bench-headless.frame.iterations"));
+        auto const sceneFilter = parameters().str("bench-headless.frame.scene");
+        auto const pageSize = PageSize { LineCount(24), ColumnCount(80) };
+
+        // The mock shaper and the null render target take the host's fonts and GPU out of the equation.
+        auto fontDescriptions = vtrasterizer::FontDescriptions {};
+        fontDescriptions.dpi = { 96, 96 };
+        fontDescriptions.emoji.familyName = "emoji";
+        fontDescriptions.fontLocator = vtrasterizer::FontLocatorEngine::Mock;
+
+        using SceneBuilder = std::string (*)(PageSize, vtbackend::ImageSize);
+        auto constexpr Scenes = std::array<std::pair<std::string_view, SceneBuilder>, 6> {
+            std::pair { "vim", &vimScene },     std::pair { "htop", &htopScene },
+            std::pair { "powerline", &powerlineScene }, std::pair { "cjk", &cjkScene },
+            std::pair { "emoji", &emojiScene }, std::pair { "sixel", &sixelScene },
+        };
+
+        // Scenes must be identical from run to run.
+        srand(1);
+
+        auto results = std::vector<std::string> {};
+        for (auto const& [name, buildScene]: Scenes)
+        {
+            if (sceneFilter != "all" && sceneFilter != name)
+                continue;
+
+            auto vt = vtbackend::MockTerm<vtpty::MockViewPty>(pageSize, LineCount(0), 1'000'000);
+            auto* pty = dynamic_cast<vtpty::MockViewPty*>(&vt.terminal.device());
+            vt.terminal.setMode(vtbackend::DECMode::AutoWrap, true);
+
+            auto renderer = vtrasterizer::Renderer { pageSize,
+                                                     fontDescriptions,
+                                                     vt.terminal.colorPalette(),
+                                                     crispy::strong_hashtable_size { 4096 },
+                                                     crispy::lru_capacity { 4000 },
+                                                     true,
+                                                     vtrasterizer::Decorator::DottedUnderline,
+                                                     vtrasterizer::Decorator::Underline,
+                                                     std::make_unique<text::mock_shaper>(fontDescriptions.dpi) };
+            auto target = NullRenderTarget {};
+            renderer.setRenderTarget(target);
+            vt.terminal.setCellPixelSize(renderer.cellSize());
+            vt.terminal.setMaxImageSize(renderer.cellSize() * pageSize, renderer.cellSize() * pageSize);
+
+            auto const scene = buildScene(pageSize, renderer.cellSize());
+            pty->setReadData(scene);
+            do
+                vt.terminal.processInputOnce();
+            while (!pty->stdoutBuffer().empty());
+
+            // @returns the average time of running the given stage in nanoseconds per grid cell.
+            auto const measure = [&](auto&& prepare, auto&& stage) {
+                auto elapsed = steady_clock::duration::zero();
+                for (unsigned i = 0; i < iterations; ++i)
+                {
+                    prepare();
+                    auto const start = steady_clock::now();
+                    stage();
+                    elapsed += steady_clock::now() - start;
+                }
+                return std::chrono::duration<double, std::nano>(elapsed).count() / iterations
+                       / static_cast<double>(pageSize.area());
+            };
+
+            // Filling the render buffer from the grid, i.e. the RenderBufferBuilder.
+            auto const renderBufferTime = measure([]() {}, [&]() { vt.terminal.refreshRenderBuffer(); });
+
+            // Grouping the render buffer's cells into text runs, as the TextRenderer does.
+            auto groups = TextGroupCounter {};
+            auto grouper = vtrasterizer::TextClusterGrouper { groups };
+            auto const groupingTime = measure([]() {}, [&]() {
+                auto const renderBuffer = vt.terminal.renderBuffer();
+                grouper.beginFrame();
+                for (auto const& cell: renderBuffer.get().cells)
+                {
+                    if (cell.groupStart)
+                        grouper.forceGroupStart();
+                    grouper.renderCell(cell.position,
+                                       renderBuffer.get().codepointsOf(cell),
+                                       textStyleOf(cell.attributes.flags),
+                                       cell.attributes.foregroundColor);
+                    if (cell.groupEnd)
+                        grouper.forceGroupEnd();
+                }
+                for (auto const& line: renderBuffer.get().lines)
+                    grouper.renderLine(line.text,
+                                       line.lineOffset,
+                                       line.textAttributes.foregroundColor,
+                                       textStyleOf(line.textAttributes.flags));
+                grouper.endFrame();
+            });
+
+            // Whole frames, starting with an empty texture atlas and text shaping cache,
+            // i.e. including text shaping, glyph rasterization and box drawing.
+            auto const coldFrameTime = measure(
+                [&]() {
+                    renderer.setRenderTarget(target);
+                    renderer.clearCache();
+                },
+                [&]() { renderer.render(vt.terminal, false); });
+            auto const coldAtlasStats = renderer.fetchAndClearAtlasStats();
+
+            // Whole frames, with everything cached already, as when the screen does not change.
+            target.rectangles = target.tiles = target.tileUploads = 0;
+            auto const warmFrameTime = measure([]() {}, [&]() { renderer.render(vt.terminal, false); });
+            auto const warmAtlasStats = renderer.fetchAndClearAtlasStats();
+
+            auto const hitRate = [](crispy::lru_hashtable_stats stats) {
+                auto const lookups = stats.hits + stats.misses;
+                return lookups ? static_cast<double>(stats.hits) / lookups : 1.0;
+            };
+
+            results.emplace_back(fmt::format(
+                "    {{\n"
+                "      \"name\": \"{}\",\n"
+                "      \"bytes\": {},\n"
+                "      \"ns_per_cell\": {{ \"render_buffer\": {:.2f}, \"grouping\": {:.2f}, "
+                "\"frame_cold\": {:.2f}, \"frame_warm\": {:.2f} }},\n"
+                "      \"per_frame\": {{ \"text_groups\": {}, \"box_drawing_cells\": {}, \"rectangles\": {}, "
+                "\"tiles\": {}, \"tile_uploads\": {} }},\n"
+                "      \"atlas_hit_rate\": {{ \"frame_cold\": {:.4f}, \"frame_warm\": {:.4f} }}\n"
+                "    }}",
+                name,
+                scene.size(),
+                renderBufferTime,
+                groupingTime,
+                coldFrameTime,
+                warmFrameTime,
+                groups.textGroups / iterations,
+                groups.boxDrawingCells / iterations,
+                target.rectangles / iterations,
+                target.tiles / iterations,
+                target.tileUploads / iterations,
+                hitRate(coldAtlasStats),
+                hitRate(warmAtlasStats)));
+        }
+
+        if (results.empty())
+        {
+            fmt::print(stderr, "No such scene: {}\n", sceneFilter);
+            return EXIT_FAILURE;
+        }
+
+        fmt::print("{{\n"
+                   "  \"page_size\": {{ \"columns\": {}, \"lines\": {} }},\n"
+                   "  \"iterations\": {},\n"
+                   "  \"scenes\": [\n{}\n"
+                   "  ]\n"
+                   "}}\n",
+                   pageSize.columns,
+                   pageSize.lines,
+                   iterations,
+                   fmt::join(results, ",\n"));
         return EXIT_SUCCESS;
     }
 
@@ -16,4 +16,11 @@ using AlternateScreenCell = CompactCell;
 /// The Cell to be used with the indicator (and host writable) status line.
 using StatusDisplayCell = SimpleCell;
 
+/// Whether lines keep the graphics rendition of their text as run-length spans (SpanLineBuffer)
+/// when being written to, rather than being inflated into one cell per column on the first SGR change.
+///
+/// Lines that hold anything a span line cannot represent, such as grapheme clusters of more than
+/// one codepoint or image fragments, are inflated either way.
+inline constexpr bool UseSpanLineBuffers = true;
+
 } // namespace vtbackend
@@ -0,0 +1,190 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtparser/BulkTextScanner.h>
+
+#include <bit>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <immintrin.h>
+    #define VTPARSER_SCANNER_X86_64 1
+    #if defined(__GNUC__) || defined(__clang__)
+        // AVX2 code paths are compiled via function level target attributes,
+        // so that the library itself can still be compiled for generic x86-64.
+        #define VTPARSER_SCANNER_AVX2 1
+    #endif
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define VTPARSER_SCANNER_NEON 1
+#endif
+
+namespace vtparser
+{
+
+namespace
+{
+    constexpr bool isPrintableAscii(char ch) noexcept
+    {
+        auto const value = static_cast<uint8_t>(ch);
+        return 0x20 <= value && value <= 0x7E;
+    }
+
+    size_t countPrintableAsciiScalar(char const* begin, char const* end) noexcept
+    {
+        auto const* input = begin;
+        while (input != end && isPrintableAscii(*input))
+            ++input;
+        return static_cast<size_t>(input - begin);
+    }
+
+#if defined(VTPARSER_SCANNER_X86_64)
+    size_t countPrintableAsciiSSE2(char const* begin, char const* end) noexcept
+    {
+        // Interpreted as signed bytes, all non-ASCII bytes are negative,
+        // so that a single signed range check covers both, C0/DEL and non-ASCII.
+        auto const lowerBound = _mm_set1_epi8(0x1F);
+        auto const upperBound = _mm_set1_epi8(0x7F);
+
+        auto const* input = begin;
+        while (end - input >= 16)
+        {
+            auto const batch = _mm_loadu_si128(reinterpret_cast<__m128i const*>(input));
+            auto const printable =
+                _mm_and_si128(_mm_cmpgt_epi8(batch, lowerBound), _mm_cmplt_epi8(batch, upperBound));
+            auto const mask = static_cast<uint32_t>(_mm_movemask_epi8(printable));
+            if (mask != 0xFFFF)
+                return static_cast<size_t>(input - begin) + static_cast<size_t>(std::countr_one(mask));
+            input += 16;
+        }
+        return static_cast<size_t>(input - begin) + countPrintableAsciiScalar(input, end);
+    }
+#endif
+
+#if defined(VTPARSER_SCANNER_AVX2)
+    __attribute__((target("avx2"))) size_t countPrintableAsciiAVX2(char const* begin,
+                                                                   char const* end) noexcept
+    {
+        auto const lowerBound = _mm256_set1_epi8(0x1F);
+        auto const upperBound = _mm256_set1_epi8(0x7F);
+
+        auto const* input = begin;
+        while (end - input >= 32)
+        {
+            auto const batch = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(input));
+            auto const printable = _mm256_and_si256(_mm256_cmpgt_epi8(batch, lowerBound),
+                                                    _mm256_cmpgt_epi8(upperBound, batch));
+            auto const mask = static_cast<uint32_t>(_mm256_movemask_epi8(printable));
+            if (mask != 0xFFFFFFFFu)
+                return static_cast<size_t>(input - begin) + static_cast<size_t>(std::countr_one(mask));
+            input += 32;
+        }
+        return static_cast<size_t>(input - begin) + countPrintableAsciiSSE2(input, end);
+    }
+#endif
+
+#if defined(VTPARSER_SCANNER_NEON)
+    size_t countPrintableAsciiNEON(char const* begin, char const* end) noexcept
+    {
+        auto const lowerBound = vdupq_n_u8(0x20);
+        auto const upperBound = vdupq_n_u8(0x7E);
+
+        auto const* input = begin;
+        while (end - input >= 16)
+        {
+            auto const batch = vld1q_u8(reinterpret_cast<uint8_t const*>(input));
+            auto const printable = vandq_u8(vcgeq_u8(batch, lowerBound), vcleq_u8(batch, upperBound));
+            if (vminvq_u8(printable) != 0xFF)
+                break; // The exact offset within this batch is determined by the scalar tail.
+            input += 16;
+        }
+        return static_cast<size_t>(input - begin) + countPrintableAsciiScalar(input, end);
+    }
+#endif
+
+    using ScannerFunction = size_t (*)(char const*, char const*) noexcept;
+
+    ScannerFunction scannerFor(BulkTextScannerKind kind) noexcept
+    {
+        switch (kind)
+        {
+#if defined(VTPARSER_SCANNER_X86_64)
+            case BulkTextScannerKind::SSE2: return &countPrintableAsciiSSE2;
+#endif
+#if defined(VTPARSER_SCANNER_AVX2)
+            case BulkTextScannerKind::AVX2: return &countPrintableAsciiAVX2;
+#endif
+#if defined(VTPARSER_SCANNER_NEON)
+            case BulkTextScannerKind::NEON: return &countPrintableAsciiNEON;
+#endif
+            default: return &countPrintableAsciiScalar;
+        }
+    }
+
+    BulkTextScannerKind detectScannerKind() noexcept
+    {
+        if (isSupported(BulkTextScannerKind::AVX2))
+            return BulkTextScannerKind::AVX2;
+        if (isSupported(BulkTextScannerKind::SSE2))
+            return BulkTextScannerKind::SSE2;
+        if (isSupported(BulkTextScannerKind::NEON))
+            return BulkTextScannerKind::NEON;
+        return BulkTextScannerKind::Scalar;
+    }
+
+    struct SelectedScanner
+    {
+        BulkTextScannerKind kind = detectScannerKind();
+        ScannerFunction scan = scannerFor(kind);
+    };
+
+    SelectedScanner const& selectedScanner() noexcept
+    {
+        static auto const selected = SelectedScanner {};
+        return selected;
+    }
+} // namespace
+
+bool isSupported(BulkTextScannerKind kind) noexcept
+{
+    switch (kind)
+    {
+        case BulkTextScannerKind::Scalar: return true;
+        case BulkTextScannerKind::SSE2:
+#if defined(VTPARSER_SCANNER_X86_64)
+            return true; // SSE2 is part of the x86-64 baseline.
+#else
+            return false;
+#endif
+        case BulkTextScannerKind::AVX2:
+#if defined(VTPARSER_SCANNER_AVX2)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+        case BulkTextScannerKind::NEON:
+#if defined(VTPARSER_SCANNER_NEON)
+            return true; // NEON is mandatory on AArch64.
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+BulkTextScannerKind bulkTextScannerKind() noexcept
+{
+    return selectedScanner().kind;
+}
+
+size_t countPrintableAscii(std::string_view text) noexcept
+{
+    return selectedScanner().scan(text.data(), text.data() + text.size());
+}
+
+size_t countPrintableAscii(std::string_view text, BulkTextScannerKind kind) noexcept
+{
+    return scannerFor(kind)(text.data(), text.data() + text.size());
+}
+
+} // namespace vtparser
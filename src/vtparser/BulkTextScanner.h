@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace vtparser
+{
+
+/// Instruction set used to scan for printable US-ASCII text.
+enum class BulkTextScannerKind
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+constexpr std::string_view to_string(BulkTextScannerKind kind) noexcept
+{
+    switch (kind)
+    {
+        case BulkTextScannerKind::Scalar: return "scalar";
+        case BulkTextScannerKind::SSE2: return "SSE2";
+        case BulkTextScannerKind::AVX2: return "AVX2";
+        case BulkTextScannerKind::NEON: return "NEON";
+    }
+    return "?";
+}
+
+/// @returns the best scanner implementation supported by the running CPU.
+///
+/// The result is determined once upon first use.
+[[nodiscard]] BulkTextScannerKind bulkTextScannerKind() noexcept;
+
+/// @returns whether or not the given scanner implementation can be used on the running CPU.
+[[nodiscard]] bool isSupported(BulkTextScannerKind kind) noexcept;
+
+/**
+ * Counts the number of leading printable US-ASCII bytes (0x20 to 0x7E) in @p text.
+ *
+ * Such a byte sequence can be passed on as text as-is, without running any byte through
+ * the VT parser's state machine, nor through the UTF-8 decoder or grapheme cluster segmentation.
+ *
+ * The input is scanned 16 to 32 bytes at a time using the implementation selected by
+ * bulkTextScannerKind().
+ */
+[[nodiscard]] size_t countPrintableAscii(std::string_view text) noexcept;
+
+/// Same as countPrintableAscii(std::string_view) but using the given implementation,
+/// which must be supported by the running CPU.
+///
+/// This is meant for testing and benchmarking only.
+[[nodiscard]] size_t countPrintableAscii(std::string_view text, BulkTextScannerKind kind) noexcept;
+
+} // namespace vtparser
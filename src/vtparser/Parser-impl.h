@@ -1,9 +1,11 @@
 // SPDX-License-Identifier: Apache-2.0
 #pragma once
+#include <vtparser/BulkTextScanner.h>
 #include <vtparser/Parser.h>
 
 #include <libunicode/utf8.h>
 
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <string_view>
@@ -326,7 +328,9 @@ void Parser<EventListener, TraceStateChanges>::parseFragment(gsl::span<char cons
 
     while (input != end)
     {
-        auto const [processKind, processedByteCount] = parseBulkText(input, end);
+        auto const [processKind, processedByteCount] = _state == State::DCS_PassThrough
+                                                           ? parseBulkPassThrough(input, end)
+                                                           : parseBulkText(input, end);
         switch (processKind)
         {
             case ProcessKind::ContinueBulk:
@@ -373,8 +377,36 @@ auto Parser<EventListener, TraceStateChanges>::parseBulkText(char const* begin,
     if (!maxCharCount)
         return { ProcessKind::FallbackToFSM, 0 };
 
-    _scanState.next = nullptr;
     auto const chunk = std::string_view(input, static_cast<size_t>(std::distance(input, end)));
+
+    if (_scanState.utf8.expectedLength == 0)
+    {
+        // Fast path for runs of printable US-ASCII, which make up the vast majority of
+        // `cat`-style workloads. Each byte is exactly one cell wide and always starts a new grapheme
+        // cluster, so neither UTF-8 decoding nor grapheme cluster segmentation is needed.
+        //
+        // If the run is cut short by non-ASCII text, we leave it to scan_text() below,
+        // in order to pass mixed text on in one go rather than splitting it into many small runs.
+        auto const asciiCount = std::min(countPrintableAscii(chunk), maxCharCount);
+        if (asciiCount != 0
+            && (asciiCount == maxCharCount || asciiCount == chunk.size()
+                || static_cast<uint8_t>(chunk[asciiCount]) < 0x80))
+        {
+            auto const text = chunk.substr(0, asciiCount);
+            _eventListener.print(text, asciiCount);
+            _scanState.lastCodepointHint = static_cast<char32_t>(text.back());
+            _scanState.next = input + asciiCount;
+            input += asciiCount;
+
+            // See the `(TEXT LF+)+`-case below.
+            if (input != end && *input == '\n')
+                _eventListener.execute(*input++);
+
+            return { ProcessKind::ContinueBulk, static_cast<size_t>(std::distance(begin, input)) };
+        }
+    }
+
+    _scanState.next = nullptr;
     auto const [cellCount, subStart, subEnd] = unicode::scan_text(_scanState, chunk, maxCharCount);
 
     if (_scanState.next == input)
@@ -411,6 +443,24 @@ auto Parser<EventListener, TraceStateChanges>::parseBulkText(char const* begin,
     return { ProcessKind::ContinueBulk, count };
 }
 
+template <typename EventListener, bool TraceStateChanges>
+auto Parser<EventListener, TraceStateChanges>::parseBulkPassThrough(char const* begin, char const* end)
+    -> std::tuple<ProcessKind, size_t>
+{
+    // Passes on device control string data such as Sixel images in runs rather than byte by byte.
+    // C0 controls are left to the state machine, as they are rare, and some of them leave this state.
+    auto const* input = begin;
+    while (input != end && static_cast<uint8_t>(*input) >= 0x20 && static_cast<uint8_t>(*input) <= 0x7E)
+        ++input;
+
+    if (input == begin)
+        return { ProcessKind::FallbackToFSM, 0 };
+
+    auto const count = static_cast<size_t>(std::distance(begin, input));
+    _eventListener.put(std::string_view(begin, count));
+    return { ProcessKind::ContinueBulk, count };
+}
+
 template <typename EventListener, bool TraceStateChanges>
 void Parser<EventListener, TraceStateChanges>::printUtf8Byte(char ch)
 {
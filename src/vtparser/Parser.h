@@ -533,6 +533,13 @@ class Parser
 
     [[nodiscard]] char32_t precedingGraphicCharacter() const noexcept { return _scanState.lastCodepointHint; }
 
+    /// Updates the preceding graphic character after the event listener has processed
+    /// bulk text on its own rather than via printUtf8Byte().
+    void setPrecedingGraphicCharacter(char32_t codepoint) noexcept
+    {
+        _scanState.lastCodepointHint = codepoint;
+    }
+
     void printUtf8Byte(char ch);
 
   private:
@@ -545,6 +552,7 @@ class Parser
     };
 
     std::tuple<ProcessKind, size_t> parseBulkText(char const* begin, char const* end) noexcept;
+    std::tuple<ProcessKind, size_t> parseBulkPassThrough(char const* begin, char const* end);
     void processOnceViaStateMachine(uint8_t ch);
 
     void handle(ActionClass actionClass, Action action, uint8_t codepoint);
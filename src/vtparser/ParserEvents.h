@@ -146,6 +146,16 @@ class ParserEvents
      */
     virtual void put(char value) = 0;
 
+    /**
+     * Passes a run of characters from the data string part of a device control string at once,
+     * none of which is a C0 control.
+     */
+    virtual void put(std::string_view values)
+    {
+        for (auto const value: values)
+            put(value);
+    }
+
     /**
      * When a device control string is terminated by ST, CAN, SUB or ESC, this action calls the
      * previously selected handler function with an “end of data” parameter. This allows the
@@ -187,6 +197,7 @@ class NullParserEvents: public ParserEvents
     void dispatchOSC() override {}
     void hook(char) override {}
     void put(char) override {}
+    void put(std::string_view) override {}
     void unhook() override {}
     void startAPC() override {}
     void putAPC(char) override {}
@@ -3,6 +3,7 @@
 
 #include <functional>
 #include <string>
+#include <string_view>
 
 namespace vtbackend
 {
@@ -19,6 +20,13 @@ class ParserExtension
 
     virtual void pass(char ch) = 0;
     virtual void finalize() = 0;
+
+    /// Passes a run of characters at once.
+    virtual void pass(std::string_view chars)
+    {
+        for (auto const ch: chars)
+            pass(ch);
+    }
 };
 
 class SimpleStringCollector: public ParserExtension
@@ -27,6 +35,7 @@ class SimpleStringCollector: public ParserExtension
     explicit SimpleStringCollector(std::function<void(std::string_view)> done): _done { std::move(done) } {}
 
     void pass(char ch) override { _data.push_back(ch); }
+    void pass(std::string_view chars) override { _data.append(chars); }
 
     void finalize() override
     {
@@ -1,4 +1,5 @@
 // SPDX-License-Identifier: Apache-2.0
+#include <vtparser/BulkTextScanner.h>
 #include <vtparser/Parser.h>
 #include <vtparser/ParserEvents.h>
 
@@ -14,6 +15,8 @@ class MockParserEvents final: public vtparser::NullParserEvents
     std::string text;
     std::string apc;
     std::string pm;
+    std::string dcs;
+    size_t dcsPutCount = 0;
     size_t maxCharCount = 80;
 
     void error(string_view const& msg) override { INFO(fmt::format("Parser error received. {}", msg)); }
@@ -28,6 +31,19 @@ class MockParserEvents final: public vtparser::NullParserEvents
     void putAPC(char ch) override { apc += ch; }
     void dispatchAPC() override { apc += "}"; }
 
+    void hook(char finalChar) override { dcs += fmt::format("{}{{", finalChar); }
+    void put(char ch) override
+    {
+        dcs += ch;
+        ++dcsPutCount;
+    }
+    void put(std::string_view chars) override
+    {
+        dcs += chars;
+        ++dcsPutCount;
+    }
+    void unhook() override { dcs += "}"; }
+
     void startPM() override { pm += "{"; }
     void putPM(char ch) override { pm += ch; }
     void dispatchPM() override { pm += "}"; }
@@ -65,3 +81,70 @@ TEST_CASE("Parser.APC")
     REQUIRE(listener.apc == "{Gi=1,a=q;}");
     REQUIRE(listener.text == "ABCDEF");
 }
+
+TEST_CASE("Parser.DCS")
+{
+    MockParserEvents listener;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    auto const data = "#0;2;0;0;0#1!20~$-#0~~~@@@"s;
+    p.parseFragment("ABC\033Pq"s + data + "\r\n" + data + "\033\\DEF");
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.dcs == "q{" + data + "\r\n" + data + "}");
+    CHECK(listener.text == "ABCDEF");
+
+    // The data string is passed on in runs up to the next C0 control, rather than byte by byte.
+    CHECK(listener.dcsPutCount == 4);
+}
+
+TEST_CASE("Parser.bulk_ascii")
+{
+    MockParserEvents listener;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    auto const line = std::string(100, 'x') + "\r\n";
+    auto input = std::string {};
+    for (int i = 0; i < 10; ++i)
+        input += line;
+    p.parseFragment(input);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.text == std::string(1000, 'x'));
+}
+
+TEST_CASE("Parser.bulk_ascii_mixed_with_utf8")
+{
+    MockParserEvents listener;
+    auto p = vtparser::Parser<vtparser::ParserEvents>(listener);
+    p.parseFragment("Hello, W\xC3\xB6rld! \033[1mBold\033[m\n"sv);
+    CHECK(p.state() == vtparser::State::Ground);
+    CHECK(listener.text == "Hello, W\xC3\xB6rld! Bold");
+}
+
+TEST_CASE("BulkTextScanner.countPrintableAscii")
+{
+    using vtparser::BulkTextScannerKind;
+
+    // Place a single non-printable byte at every possible offset, making sure each implementation
+    // detects it in its vectorized body as well as in its scalar tail.
+    for (auto const kind: { BulkTextScannerKind::Scalar,
+                            BulkTextScannerKind::SSE2,
+                            BulkTextScannerKind::AVX2,
+                            BulkTextScannerKind::NEON })
+    {
+        if (!vtparser::isSupported(kind))
+            continue;
+
+        INFO(fmt::format("kind: {}", vtparser::to_string(kind)));
+        for (char const stopByte: { '\0', '\033', '\n', '\x7F', '\x80', '\xC3', '\xFF' })
+        {
+            for (size_t offset = 0; offset < 70; ++offset)
+            {
+                auto text = std::string(70, 'a');
+                text[offset] = stopByte;
+                CHECK(vtparser::countPrintableAscii(text, kind) == offset);
+            }
+        }
+        CHECK(vtparser::countPrintableAscii(std::string(70, '~'), kind) == 70);
+        CHECK(vtparser::countPrintableAscii(""sv, kind) == 0);
+    }
+
+    CHECK(vtparser::isSupported(vtparser::bulkTextScannerKind()));
+}
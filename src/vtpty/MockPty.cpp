@@ -2,6 +2,8 @@
 
 #include <crispy/BufferObject.h>
 
+#include <cerrno>
+
 using namespace std::chrono;
 using std::min;
 using std::nullopt;
@@ -25,6 +27,12 @@ Pty::ReadResult MockPty::read(crispy::buffer_object<char>& storage,
                               std::optional<std::chrono::milliseconds> /*timeout*/,
                               size_t size)
 {
+    if (!_closed && !isStdoutDataAvailable())
+    {
+        errno = EAGAIN;
+        return nullopt;
+    }
+
     auto const n = min(size, min(_outputBuffer.size() - _outputReadOffset, storage.bytesAvailable()));
     auto const chunk = string_view { _outputBuffer.data() + _outputReadOffset, n };
     _outputReadOffset += n;
@@ -98,6 +98,8 @@ class [[nodiscard]] Process: public Pty
     [[nodiscard]] ReadResult read(crispy::buffer_object<char>& storage, std::optional<std::chrono::milliseconds> timeout, size_t n) override { return pty().read(storage, timeout, n); }
     void wakeupReader() override { return pty().wakeupReader(); }
     [[nodiscard]] int write(std::string_view data) override { return pty().write(data); }
+    [[nodiscard]] size_t pendingWriteBytes() const noexcept override { return pty().pendingWriteBytes(); }
+    [[nodiscard]] std::optional<int> readinessHandle() const noexcept override { return pty().readinessHandle(); }
     [[nodiscard]] PageSize pageSize() const noexcept override { return pty().pageSize(); }
     void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override { pty().resizeScreen(cells, pixels); }
     // clang-format on
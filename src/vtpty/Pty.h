@@ -77,7 +77,9 @@ class Pty
     ///
     /// @param storage Target buffer to store the read data to.
     /// @param timeout Wait only for up to given timeout before giving up the blocking read attempt.
-    /// @param size    The number of bytes to read at most, even if the storage has more bytes available.
+    /// @param size    The number of bytes to read at most per read, even if the storage has more bytes
+    ///                available. Implementations may issue further reads for data that is already
+    ///                available, for as long as the storage has room for it.
     ///
     /// @returns A view to the consumed buffer. The boolean in the ReadResult
     ///          indicates whether or not this data was coming through
@@ -96,11 +98,23 @@ class Pty
 
     /// Writes to the PTY device, so the other end can read from it.
     ///
+    /// Implementations may queue what the device does not take right away, rather than waiting
+    /// for the other end to read it, and write it from within read() as soon as the device is
+    /// writable again. Data passed to a single call is never interleaved with data of another call.
+    ///
     /// @param buf      Buffer of data to be written.
     ///
-    /// @returns Number of bytes written or -1 on error.
+    /// @returns Number of bytes written or queued, or -1 on error.
     [[nodiscard]] virtual int write(std::string_view buf) = 0;
 
+    /// Returns the number of bytes that have been passed to write() but not yet to the device,
+    /// because the other end is not reading fast enough.
+    [[nodiscard]] virtual size_t pendingWriteBytes() const noexcept { return 0; }
+
+    /// Returns a file descriptor that becomes readable whenever read() would not block,
+    /// so that many PTYs can be waited on by a single thread, or std::nullopt if there is none.
+    [[nodiscard]] virtual std::optional<int> readinessHandle() const noexcept { return std::nullopt; }
+
     /// @returns current underlying window size in characters width and height.
     [[nodiscard]] virtual PageSize pageSize() const noexcept = 0;
 
@@ -7,6 +7,7 @@
 #include <crispy/escape.h>
 #include <crispy/logstore.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
 #include <cstdlib>
@@ -254,6 +255,7 @@ void UnixPty::wakeupReader() noexcept
 optional<string_view> UnixPty::readSome(int fd, char* target, size_t n) noexcept
 {
     auto const rv = static_cast<int>(::read(fd, target, n));
+    ++_readStatistics.reads;
     if (rv < 0)
     {
         if (errno != EAGAIN && errno != EINTR)
@@ -284,53 +286,171 @@ Pty::ReadResult UnixPty::read(crispy::buffer_object<char>& storage,
 {
     assert(_readSelector.size() > 0);
 
-    if (auto const fd = _readSelector.wait_one(timeout); fd.has_value())
+    // File descriptors that have been closed in the meantime are not to be read from anymore.
+    _readyFds.erase(std::remove_if(_readyFds.begin(),
+                                   _readyFds.end(),
+                                   [this](int fd) { return fd != _masterFd && fd != _stdoutFastPipe.reader(); }),
+                    _readyFds.end());
+
+    // Writes happen on this thread, in between reads, whenever write() could not pass all of its data on.
+    flushWriteQueue();
+
+    if (_readyFds.empty())
     {
-        auto const l = scoped_lock { storage };
-        if (auto x = readSome(*fd, storage.hotEnd(), min(size, storage.bytesAvailable())))
-            return { tuple { x.value(), *fd == _stdoutFastPipe.reader() } };
+        updateWriteInterest();
+        ++_readStatistics.waits;
+        auto const& ready = _readSelector.wait_many(timeout);
+        if (!_readSelector.writable().empty())
+            flushWriteQueue();
+        if (ready.empty())
+        {
+            if (errno != EINTR)
+                errno = EAGAIN;
+            return nullopt;
+        }
+        _readyFds.assign(ready.begin(), ready.end());
     }
-    else
-        errno = EAGAIN;
-    return nullopt;
+
+    auto const fd = _readyFds.front();
+    _readyFds.pop_front();
+
+    auto const l = scoped_lock { storage };
+    auto const fromFastPipe = fd == _stdoutFastPipe.reader();
+    auto const x = readSome(fd, storage.hotEnd(), min(size, storage.bytesAvailable()));
+    if (!x || x->empty())
+        return x.has_value() ? ReadResult { tuple { x.value(), fromFastPipe } } : nullopt;
+
+    // Drain whatever else is ready to be read into the remaining storage, so that
+    // bulk output costs one wait per batch rather than one wait per read.
+    auto total = x->size();
+    while (total < storage.bytesAvailable())
+    {
+        auto const more = readSome(fd, storage.hotEnd() + total, min(size, storage.bytesAvailable() - total));
+        if (!more || more->empty())
+        {
+            // A hangup is reported along with the last of the data only, so have the next read see it.
+            if (more || (errno != EAGAIN && errno != EINTR))
+                _readyFds.push_back(fd);
+            break;
+        }
+        total += more->size();
+    }
+    _readStatistics.bytes += total;
+
+    // The selector is edge-triggered, so a file descriptor that may still have data to be read
+    // will not be reported again. Serve it again after any other ready one instead.
+    if (total == storage.bytesAvailable())
+        _readyFds.push_back(fd);
+
+    return { tuple { string_view { storage.hotEnd(), total }, fromFastPipe } };
 }
 
 int UnixPty::write(std::string_view data)
 {
-    auto const* buf = data.data();
-    auto const size = data.size();
+    auto const _ = scoped_lock { _writeMutex };
 
-    ssize_t const rv = ::write(_masterFd, buf, size);
-    if (ptyOutLog)
+    // Anything that is still queued must be written first, to keep the order.
+    auto written = size_t { 0 };
+    if (_writeQueue.empty())
     {
-        if (rv >= 0)
-            ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf, buf + rv));
-
+        auto const rv = writeSome(data);
         if (rv < 0)
-            // errorlog()("PTY write failed: {}", strerror(errno));
-            ptyOutLog()("PTY write of {} bytes failed. {}\n", size, strerror(errno));
-        else if (0 <= rv && static_cast<size_t>(rv) < size)
-            // clang-format off
+            return -1;
+        written = static_cast<size_t>(rv);
+    }
+
+    if (written < data.size())
+    {
+        auto const rest = data.substr(written);
+        ptyOutLog()(
+            "Queueing {} bytes, in addition to {} bytes already queued.", rest.size(), _writeQueueSize);
+        _writeQueue.emplace_back(rest);
+        _writeQueueSize += rest.size();
+
+        // Makes read() wait for the master to become writable, too.
+        if (!_wantWrite)
+            wakeupReader();
+    }
+
+    return static_cast<int>(data.size());
+}
+
+size_t UnixPty::pendingWriteBytes() const noexcept
+{
+    auto const _ = scoped_lock { _writeMutex };
+    return _writeQueueSize;
+}
+
+std::optional<int> UnixPty::readinessHandle() const noexcept
+{
+#if defined(__linux__)
+    return _readSelector.native_handle();
+#else
+    return nullopt;
+#endif
+}
+
+ssize_t UnixPty::writeSome(std::string_view data) noexcept
+{
+    auto const rv = ::write(_masterFd, data.data(), data.size());
+    if (rv < 0)
+    {
+        if (errno == EAGAIN || errno == EINTR)
+            return 0;
+        ptyOutLog()("PTY write of {} bytes failed. {}", data.size(), strerror(errno));
+        return rv;
+    }
+
+    if (ptyOutLog)
+    {
+        ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(data.data(), data.data() + rv));
+        if (static_cast<size_t>(rv) < data.size())
             ptyOutLog()("Partial write. {} bytes written and {} bytes left.",
                         rv,
-                        size - static_cast<size_t>(rv));
-        // clang-format on
+                        data.size() - static_cast<size_t>(rv));
     }
 
-    if (0 <= rv && static_cast<size_t>(rv) < size)
+    return rv;
+}
+
+void UnixPty::flushWriteQueue()
+{
+    auto const _ = scoped_lock { _writeMutex };
+    while (!_writeQueue.empty())
     {
-        util::setFileBlocking(_masterFd, true);
-        auto const rv2 = ::write(_masterFd, buf + rv, size - rv);
-        util::setFileBlocking(_masterFd, false);
-        if (rv2 >= 0)
+        auto const segment = string_view(_writeQueue.front()).substr(_writeQueueOffset);
+        auto const rv = writeSome(segment);
+        if (rv < 0)
+        {
+            // The other end is gone, which the next read will tell.
+            _writeQueue.clear();
+            _writeQueueOffset = 0;
+            _writeQueueSize = 0;
+            return;
+        }
+
+        _writeQueueSize -= static_cast<size_t>(rv);
+        if (static_cast<size_t>(rv) < segment.size())
         {
-            if (ptyOutLog)
-                ptyOutLog()("Sending bytes: \"{}\"", crispy::escape(buf + rv, buf + rv + rv2));
-            return static_cast<int>(rv + rv2);
+            _writeQueueOffset += static_cast<size_t>(rv);
+            return;
         }
+
+        _writeQueue.pop_front();
+        _writeQueueOffset = 0;
     }
+}
 
-    return static_cast<int>(rv);
+void UnixPty::updateWriteInterest()
+{
+    auto const _ = scoped_lock { _writeMutex };
+    auto const wantWrite = !_writeQueue.empty() && _masterFd != -1;
+    if (wantWrite == _wantWrite)
+        return;
+
+    if (_masterFd != -1)
+        _readSelector.want_write(_masterFd, wantWrite);
+    _wantWrite = wantWrite;
 }
 
 PageSize UnixPty::pageSize() const noexcept
@@ -8,9 +8,12 @@
 #include <crispy/file_descriptor.h>
 #include <crispy/read_selector.h>
 
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <mutex>
 #include <optional>
+#include <string>
 
 #if defined(__APPLE__)
     #include <util.h>
@@ -48,6 +51,14 @@ class UnixPty final: public Pty
         PtySlaveHandle slave;
     };
 
+    /// Counts the system calls issued by read().
+    struct ReadStatistics
+    {
+        uint64_t waits = 0; ///< Number of times waited for the PTY to become readable.
+        uint64_t reads = 0; ///< Number of read() system calls, including those that found nothing to read.
+        uint64_t bytes = 0; ///< Number of bytes read.
+    };
+
     UnixPty(PageSize pageSize, std::optional<ImageSize> pixels);
     ~UnixPty() override;
 
@@ -63,23 +74,39 @@ class UnixPty final: public Pty
                                   std::optional<std::chrono::milliseconds> timeout,
                                   size_t size) override;
     int write(std::string_view data) override;
+    [[nodiscard]] size_t pendingWriteBytes() const noexcept override;
+    [[nodiscard]] std::optional<int> readinessHandle() const noexcept override;
     [[nodiscard]] PageSize pageSize() const noexcept override;
     void resizeScreen(PageSize cells, std::optional<ImageSize> pixels = std::nullopt) override;
 
     UnixPipe& stdoutFastPipe() noexcept { return _stdoutFastPipe; }
 
+    [[nodiscard]] ReadStatistics const& readStatistics() const noexcept { return _readStatistics; }
+
   private:
     std::optional<std::string_view> readSome(int fd, char* target, size_t n) noexcept;
+    ssize_t writeSome(std::string_view data) noexcept;
+    void flushWriteQueue();
+    void updateWriteInterest();
 
     [[nodiscard]] bool started() const noexcept { return _masterFd != -1; }
 
     file_descriptor _masterFd;
     UnixPipe _stdoutFastPipe;
-    crispy::read_selector _readSelector;
+    crispy::read_selector _readSelector { crispy::read_trigger::Edge };
+    std::deque<int> _readyFds; // Readable file descriptors that may not have been read from exhaustively.
     PageSize _pageSize;
     std::optional<ImageSize> _pixels;
     std::unique_ptr<Slave> _slave;
     std::mutex _mutex;
+    ReadStatistics _readStatistics;
+
+    // Data that write() could not pass to the master right away, written by read() once it is writable.
+    mutable std::mutex _writeMutex;
+    std::deque<std::string> _writeQueue;
+    size_t _writeQueueOffset = 0; // Number of bytes of the front segment that have been written already.
+    size_t _writeQueueSize = 0;   // Number of bytes in the queue that are yet to be written.
+    bool _wantWrite = false;      // Whether the read selector waits for the master to become writable.
 };
 
 } // namespace vtpty
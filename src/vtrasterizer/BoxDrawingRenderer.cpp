@@ -897,9 +897,19 @@ namespace detail
     } // namespace
 } // namespace detail
 
+namespace
+{
+    // Box drawing and block elements, which are the most commonly used glyphs of this renderer,
+    // are kept in direct-mapped tiles.
+    constexpr auto FirstDirectMappedCodepoint = char32_t { 0x2500 };
+    constexpr auto LastDirectMappedCodepoint = char32_t { 0x259F };
+    constexpr auto DirectMappedCodepointCount = LastDirectMappedCodepoint - FirstDirectMappedCodepoint + 1;
+} // namespace
+
 void BoxDrawingRenderer::setRenderTarget(RenderTarget& renderTarget,
                                          DirectMappingAllocator& directMappingAllocator)
 {
+    _directMapping = directMappingAllocator.allocate(DirectMappedCodepointCount);
     Renderable::setRenderTarget(renderTarget, directMappingAllocator);
     clearCache();
 }
@@ -1001,6 +1011,9 @@ auto BoxDrawingRenderer::createTileData(char32_t codepoint, atlas::TileLocation
 
 Renderable::AtlasTileAttributes const* BoxDrawingRenderer::getOrCreateCachedTileAttributes(char32_t codepoint)
 {
+    if (_directMapping && FirstDirectMappedCodepoint <= codepoint && codepoint <= LastDirectMappedCodepoint)
+        return ensureRasterizedIfDirectMapped(codepoint);
+
     return textureAtlas().get_or_try_emplace(
         crispy::strong_hash { 31, 13, 8, static_cast<uint32_t>(codepoint) },
         [this, codepoint](atlas::TileLocation tileLocation) -> optional<TextureAtlas::TileCreateData> {
@@ -1008,6 +1021,26 @@ Renderable::AtlasTileAttributes const* BoxDrawingRenderer::getOrCreateCachedTile
         });
 }
 
+Renderable::AtlasTileAttributes const* BoxDrawingRenderer::ensureRasterizedIfDirectMapped(char32_t codepoint)
+{
+    auto const tileIndex = _directMapping.toTileIndex(codepoint - FirstDirectMappedCodepoint);
+
+    if (textureAtlas().directMapped(tileIndex).bitmapSize.width.value)
+    {
+        ++_directMappingStats.hits;
+        return &textureAtlas().directMapped(tileIndex);
+    }
+
+    ++_directMappingStats.misses;
+
+    auto tileCreateData = createTileData(codepoint, textureAtlas().tileLocation(tileIndex));
+    if (!tileCreateData)
+        return nullptr;
+
+    textureAtlas().setDirectMapping(tileIndex, std::move(*tileCreateData));
+    return &textureAtlas().directMapped(tileIndex);
+}
+
 bool BoxDrawingRenderer::renderable(char32_t codepoint) noexcept
 {
     auto const ascending = [codepoint](char32_t a, char32_t b) noexcept -> bool {
@@ -1741,8 +1774,10 @@ optional<atlas::Buffer> BoxDrawingRenderer::buildBoxElements(char32_t codepoint,
     return image;
 }
 
-void BoxDrawingRenderer::inspect(std::ostream& /*output*/) const
+void BoxDrawingRenderer::inspect(std::ostream& output) const
 {
+    output << fmt::format(
+        "direct mapped box drawing : {} tiles, {}\n", _directMapping.count, _directMappingStats);
 }
 
 } // namespace vtrasterizer
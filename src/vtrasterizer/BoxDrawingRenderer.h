@@ -43,6 +43,7 @@ class BoxDrawingRenderer: public Renderable
 
   private:
     AtlasTileAttributes const* getOrCreateCachedTileAttributes(char32_t codepoint);
+    AtlasTileAttributes const* ensureRasterizedIfDirectMapped(char32_t codepoint);
 
     using Renderable::createTileData;
     [[nodiscard]] std::optional<TextureAtlas::TileCreateData> createTileData(
@@ -52,6 +53,11 @@ class BoxDrawingRenderer: public Renderable
                                                                        ImageSize size,
                                                                        int lineThickness);
     [[nodiscard]] std::optional<atlas::Buffer> buildElements(char32_t codepoint);
+
+    DirectMapping _directMapping {};
+
+    // Hits and misses (rasterizations) of the direct-mapped tiles, which are never evicted.
+    crispy::lru_hashtable_stats _directMappingStats {};
 };
 
 } // namespace vtrasterizer
@@ -7,6 +7,7 @@
 #include <text_shaper/open_shaper.h>
 
 #include <crispy/StrongLRUHashtable.h>
+#include <crispy/metrics.h>
 
 #if defined(_WIN32)
     #include <text_shaper/directwrite_shaper.h>
@@ -114,15 +115,17 @@ Renderer::Renderer(vtbackend::PageSize pageSize,
                    crispy::lru_capacity atlasTileCount,
                    bool atlasDirectMapping,
                    Decorator hyperlinkNormal,
-                   Decorator hyperlinkHover):
+                   Decorator hyperlinkHover,
+                   unique_ptr<text::shaper> textShaper):
     _atlasHashtableSlotCount { crispy::nextPowerOfTwo(atlasHashtableSlotCount.value) },
     _atlasTileCount { std::max(atlasTileCount.value, static_cast<uint32_t>(pageSize.area())) },
     _atlasDirectMapping { atlasDirectMapping },
     //.
     _fontDescriptions { std::move(fontDescriptions) },
-    _textShaper { createTextShaper(_fontDescriptions.textShapingEngine,
-                                   _fontDescriptions.dpi,
-                                   createFontLocator(_fontDescriptions.fontLocator)) },
+    _textShaper { textShaper ? std::move(textShaper)
+                             : createTextShaper(_fontDescriptions.textShapingEngine,
+                                                _fontDescriptions.dpi,
+                                                createFontLocator(_fontDescriptions.fontLocator)) },
     _fonts { loadFontKeys(_fontDescriptions, *_textShaper) },
     _gridMetrics { loadGridMetrics(_fonts.regular, pageSize, *_textShaper) },
     //.
@@ -295,7 +298,7 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
     {
         vtbackend::RenderBufferRef const renderBuffer = terminal.renderBuffer();
         cursorOpt = renderBuffer.get().cursor;
-        renderCells(renderBuffer.get().cells);
+        renderCells(renderBuffer.get());
         renderLines(renderBuffer.get().lines);
     }
     _textRenderer.endFrame();
@@ -317,18 +320,24 @@ void Renderer::render(vtbackend::Terminal& terminal, bool pressure)
         _cursorRenderer.render(_gridMetrics.map(cursor.position), cursor.width, cursorColor);
     }
 
+    // The frame's metrics are attributed to the terminal it renders.
+    auto& metrics = terminal.metrics();
+    _textureAtlas->recordMetrics(metrics.atlasUploads, metrics.atlasEvictions);
+    _textRenderer.recordMetrics(metrics.shapingCache);
+
+    auto const _ = crispy::metrics::scoped_timer { metrics.frameSubmit };
     _renderTarget->execute(terminal.currentTime());
 }
 
-void Renderer::renderCells(vector<vtbackend::RenderCell> const& renderableCells)
+void Renderer::renderCells(vtbackend::RenderBuffer const& renderBuffer)
 {
-    for (vtbackend::RenderCell const& cell: renderableCells)
+    for (vtbackend::RenderCell const& cell: renderBuffer.cells)
     {
         _backgroundRenderer.renderCell(cell);
         _decorationRenderer.renderCell(cell);
-        _textRenderer.renderCell(cell);
-        if (cell.image)
-            _imageRenderer.renderImage(_gridMetrics.map(cell.position), *cell.image);
+        _textRenderer.renderCell(cell, renderBuffer.codepointsOf(cell));
+        if (auto const* image = renderBuffer.imageOf(cell))
+            _imageRenderer.renderImage(_gridMetrics.map(cell.position), *image);
     }
 }
 
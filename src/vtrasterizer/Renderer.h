@@ -52,6 +52,8 @@ class Renderer
      * @p projectionMatrix   Projection matrix to apply to the rendered scene when rendering the screen.
      * @p atlasDirectMapping Indicates whether or not direct mapped tiles are allowed.
      * @p atlasTileCount     Number of tiles guaranteed to be available in LRU cache.
+     * @p textShaper         Text shaper to use rather than the one of the configured engine,
+     *                       such as a mock for benchmarking.
      */
     Renderer(vtbackend::PageSize pageSize,
              FontDescriptions fontDescriptions,
@@ -60,7 +62,8 @@ class Renderer
              crispy::lru_capacity atlasTileCount,
              bool atlasDirectMapping,
              Decorator hyperlinkNormal,
-             Decorator hyperlinkHover);
+             Decorator hyperlinkHover,
+             std::unique_ptr<text::shaper> textShaper = nullptr);
 
     [[nodiscard]] ImageSize cellSize() const noexcept { return _gridMetrics.cellSize; }
 
@@ -111,6 +114,12 @@ class Renderer
 
     void inspect(std::ostream& textOutput) const;
 
+    /// Retrieves the texture atlas' tile cache hits and misses since the last call.
+    [[nodiscard]] crispy::lru_hashtable_stats fetchAndClearAtlasStats() noexcept
+    {
+        return _textureAtlas ? _textureAtlas->fetchAndClearStats() : crispy::lru_hashtable_stats {};
+    }
+
     std::array<gsl::not_null<Renderable*>, 5> renderables()
     {
         return std::array<gsl::not_null<Renderable*>, 5> {
@@ -127,7 +136,7 @@ class Renderer
 
   private:
     void configureTextureAtlas();
-    void renderCells(std::vector<vtbackend::RenderCell> const& renderableCells);
+    void renderCells(vtbackend::RenderBuffer const& renderBuffer);
     void renderLines(std::vector<vtbackend::RenderLine> const& renderableLines);
     void executeImageDiscards();
 
@@ -0,0 +1,470 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SoftwareRenderer.h>
+#include <vtrasterizer/utils.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <ostream>
+
+#if defined(__x86_64__) || defined(_M_X64)
+    #include <emmintrin.h>
+    #define VTRASTERIZER_BLEND_SSE2 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+    #include <arm_neon.h>
+    #define VTRASTERIZER_BLEND_NEON 1
+#endif
+
+using std::max;
+using std::min;
+
+namespace vtrasterizer
+{
+
+namespace
+{
+    /// Computes x * a / 255 + y * (255 - a) / 255, rounded to nearest, for x, y, a in [0, 255].
+    constexpr uint8_t mix(unsigned x, unsigned y, unsigned a) noexcept
+    {
+        auto const t = x * a + y * (255 - a) + 128;
+        return static_cast<uint8_t>((t + (t >> 8)) >> 8);
+    }
+
+    /// Blends a single straight alpha RGBA pixel onto another one.
+    ///
+    /// This mirrors the OpenGL renderer's blend function, which is
+    /// (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) for the color and (GL_ONE, GL_ONE) for the alpha channel.
+    inline void blendPixel(uint8_t* target, uint8_t const* source) noexcept
+    {
+        auto const alpha = source[3];
+        target[0] = mix(source[0], target[0], alpha);
+        target[1] = mix(source[1], target[1], alpha);
+        target[2] = mix(source[2], target[2], alpha);
+        target[3] = static_cast<uint8_t>(min(255, source[3] + target[3]));
+    }
+
+    /// Blends @p count RGBA pixels of @p source onto @p target.
+    void blendSpan(uint8_t* target, uint8_t const* source, size_t count) noexcept
+    {
+        size_t i = 0;
+#if defined(VTRASTERIZER_BLEND_SSE2)
+        auto const zero = _mm_setzero_si128();
+        auto const full = _mm_set1_epi16(255);
+        auto const half = _mm_set1_epi16(128);
+        auto const alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+        for (; i + 4 <= count; i += 4)
+        {
+            auto const s = _mm_loadu_si128(reinterpret_cast<__m128i const*>(source + i * 4));
+            auto const d = _mm_loadu_si128(reinterpret_cast<__m128i const*>(target + i * 4));
+
+            auto const blend = [&](__m128i s16, __m128i d16) {
+                // Broadcasts each pixel's alpha into all four of its 16-bit lanes.
+                auto const a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s16, 0xFF), 0xFF);
+                auto t = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(s16, a),
+                                                     _mm_mullo_epi16(d16, _mm_sub_epi16(full, a))),
+                                       half);
+                return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+            };
+
+            auto const low = blend(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+            auto const high = blend(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+            auto const color = _mm_andnot_si128(alphaMask, _mm_packus_epi16(low, high));
+            auto const alpha = _mm_and_si128(alphaMask, _mm_adds_epu8(s, d));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(target + i * 4), _mm_or_si128(color, alpha));
+        }
+#elif defined(VTRASTERIZER_BLEND_NEON)
+        for (; i + 8 <= count; i += 8)
+        {
+            auto const s = vld4_u8(source + i * 4);
+            auto d = vld4_u8(target + i * 4);
+            auto const alpha = s.val[3];
+            auto const inverse = vmvn_u8(alpha);
+            for (int c = 0; c < 3; ++c)
+            {
+                auto t = vmlal_u8(vmull_u8(s.val[c], alpha), d.val[c], inverse);
+                t = vaddq_u16(t, vdupq_n_u16(128));
+                d.val[c] = vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+            }
+            d.val[3] = vqadd_u8(alpha, d.val[3]);
+            vst4_u8(target + i * 4, d);
+        }
+#endif
+        for (; i < count; ++i)
+            blendPixel(target + i * 4, source + i * 4);
+    }
+
+    constexpr uint8_t toByte(float value) noexcept
+    {
+        return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+    }
+
+    /// Computes the pixel the text shader would output for an LCD subpixel antialiased glyph.
+    void shadeLcdGlyph(uint8_t* output, uint8_t const* texel, std::array<float, 4> const& color) noexcept
+    {
+        auto const r = static_cast<float>(texel[0]) / 255.0f;
+        auto const g = static_cast<float>(texel[1]) / 255.0f;
+        auto const b = static_cast<float>(texel[2]) / 255.0f;
+        auto const rgbAvg = (r + g + b) / 3.0f;
+        auto const rgbMin = min(min(r, g), b);
+        auto const rgbMax = max(max(r, g), b);
+        auto const complement = 1.0f - rgbMax;
+        output[0] = toByte(color[0] * rgbMax + r * complement);
+        output[1] = toByte(color[1] * rgbMax + g * complement);
+        output[2] = toByte(color[2] * rgbMax + b * complement);
+        output[3] = toByte((rgbAvg * rgbMax + rgbMin * complement) * color[3]);
+    }
+
+    /// Computes the pixels to blend for a row of a tile, such as the text shader does,
+    /// sampling the texture atlas with nearest filtering.
+    ///
+    /// @param texels   the tile's row in the texture atlas
+    /// @param columns  for each target pixel, the tile's column to sample
+    void shadeRow(uint8_t* output,
+                  uint8_t const* texels,
+                  std::vector<int> const& columns,
+                  atlas::RenderTile const& tile) noexcept
+    {
+        auto const& color = tile.color;
+        switch (tile.fragmentShaderSelector)
+        {
+            case FRAGMENT_SELECTOR_IMAGE_BGRA:
+                for (auto const column: columns)
+                {
+                    std::memcpy(output, texels + column * 4, 4);
+                    output += 4;
+                }
+                break;
+            case FRAGMENT_SELECTOR_GLYPH_LCD_SIMPLE:
+                for (auto const column: columns)
+                {
+                    auto const* texel = texels + column * 4;
+                    output[0] = static_cast<uint8_t>(texel[0] * toByte(color[0]) / 255);
+                    output[1] = static_cast<uint8_t>(texel[1] * toByte(color[1]) / 255);
+                    output[2] = static_cast<uint8_t>(texel[2] * toByte(color[2]) / 255);
+                    output[3] = static_cast<uint8_t>((texel[0] + texel[1] + texel[2]) / 3);
+                    output += 4;
+                }
+                break;
+            case FRAGMENT_SELECTOR_GLYPH_LCD:
+                for (auto const column: columns)
+                {
+                    shadeLcdGlyph(output, texels + column * 4, color);
+                    output += 4;
+                }
+                break;
+            case FRAGMENT_SELECTOR_GLYPH_ALPHA:
+            default: {
+                // Using the red channel as alpha mask of an antialiased glyph.
+                auto const red = toByte(color[0]);
+                auto const green = toByte(color[1]);
+                auto const blue = toByte(color[2]);
+                auto const alpha = toByte(color[3]);
+                for (auto const column: columns)
+                {
+                    output[0] = red;
+                    output[1] = green;
+                    output[2] = blue;
+                    output[3] = static_cast<uint8_t>((texels[column * 4] * alpha + 127) / 255);
+                    output += 4;
+                }
+                break;
+            }
+        }
+    }
+} // namespace
+
+SoftwareRenderer::SoftwareRenderer(ImageSize renderSize, size_t threadCount):
+    _threadCount { max(threadCount, size_t { 1 }) }
+{
+    setRenderSize(renderSize);
+
+    for (size_t band = 1; band < _threadCount; ++band)
+        _workers.emplace_back([this, band]() { work(band); });
+}
+
+SoftwareRenderer::~SoftwareRenderer()
+{
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _stopping = true;
+    }
+    _jobAvailable.notify_all();
+    for (auto& worker: _workers)
+        worker.join();
+}
+
+void SoftwareRenderer::setRenderSize(ImageSize size)
+{
+    _renderSize = size;
+    _frameBuffer.resize(size.area() * 4);
+}
+
+void SoftwareRenderer::renderRectangle(int x, int y, Width width, Height height, RGBAColor color)
+{
+    _rectangles.emplace_back(Rectangle { x, y, unbox<int>(width), unbox<int>(height), color });
+}
+
+void SoftwareRenderer::scheduleScreenshot(ScreenshotCallback callback)
+{
+    _pendingScreenshotCallback = std::move(callback);
+}
+
+void SoftwareRenderer::configureAtlas(atlas::ConfigureAtlas atlas)
+{
+    _configureAtlas.emplace(atlas);
+    _atlasSize = atlas.size;
+
+    rendererLog()("Software renderer: configure atlas: {} {}", atlas.size, atlas.properties.format);
+}
+
+void SoftwareRenderer::uploadTile(atlas::UploadTile tile)
+{
+    _uploads.emplace_back(std::move(tile));
+}
+
+void SoftwareRenderer::renderTile(atlas::RenderTile tile)
+{
+    _tiles.emplace_back(tile);
+}
+
+void SoftwareRenderer::execute(std::chrono::steady_clock::time_point /*now*/)
+{
+    if (_configureAtlas)
+    {
+        _atlas.assign(_configureAtlas->size.area() * 4, 0);
+        _configureAtlas.reset();
+    }
+
+    for (auto const& upload: _uploads)
+        uploadTileNow(upload);
+
+    runBands([this](int firstRow, int lastRow) { rasterize(firstRow, lastRow); });
+
+    _statistics.frames++;
+    _statistics.rectangles += _rectangles.size();
+    _statistics.tiles += _tiles.size();
+    _statistics.tileUploads += _uploads.size();
+    _rectangles.clear();
+    _uploads.clear();
+    _tiles.clear();
+
+    if (_pendingScreenshotCallback)
+    {
+        (*_pendingScreenshotCallback)(_frameBuffer, _renderSize);
+        _pendingScreenshotCallback.reset();
+    }
+}
+
+std::optional<AtlasTextureScreenshot> SoftwareRenderer::readAtlas()
+{
+    return AtlasTextureScreenshot { 0, _atlasSize, atlas::Format::RGBA, _atlas };
+}
+
+void SoftwareRenderer::inspect(std::ostream& output) const
+{
+    output << fmt::format("Software renderer: {} pixels, {} threads\n", _renderSize, threadCount());
+    output << fmt::format("Frames rendered: {}\n", _statistics.frames);
+    output << fmt::format("Rectangles rendered: {}\n", _statistics.rectangles);
+    output << fmt::format("Tiles rendered: {}\n", _statistics.tiles);
+    output << fmt::format("Tiles uploaded: {} ({} bytes)\n", _statistics.tileUploads, _statistics.uploadedBytes);
+}
+
+void SoftwareRenderer::uploadTileNow(atlas::UploadTile const& tile)
+{
+    auto const components = element_count(tile.bitmapFormat);
+    auto const bitmapWidth = unbox<size_t>(tile.bitmapSize.width);
+    auto const alignment = static_cast<size_t>(max(tile.rowAlignment, 1));
+    auto const pitch = (bitmapWidth * components + alignment - 1) / alignment * alignment;
+
+    // Clips the tile to the atlas, as the OpenGL driver would.
+    auto const atlasWidth = unbox<size_t>(_atlasSize.width);
+    auto const x0 = static_cast<size_t>(tile.location.x.value);
+    auto const y0 = static_cast<size_t>(tile.location.y.value);
+    auto const width = x0 < atlasWidth ? min(bitmapWidth, atlasWidth - x0) : 0;
+    auto const height = min(unbox<size_t>(tile.bitmapSize.height),
+                            unbox<size_t>(_atlasSize.height) - min(y0, unbox<size_t>(_atlasSize.height)));
+
+    for (size_t row = 0; row < height; ++row)
+    {
+        auto const* source = tile.bitmap.data() + row * pitch;
+        auto* target = _atlas.data() + ((y0 + row) * atlasWidth + x0) * 4;
+        switch (tile.bitmapFormat)
+        {
+            case atlas::Format::RGBA: std::memcpy(target, source, width * 4); break;
+            case atlas::Format::RGB:
+                for (size_t i = 0; i < width; ++i, source += 3, target += 4)
+                {
+                    std::memcpy(target, source, 3);
+                    target[3] = 0xFF;
+                }
+                break;
+            case atlas::Format::Red:
+                for (size_t i = 0; i < width; ++i, ++source, target += 4)
+                {
+                    target[0] = *source;
+                    target[1] = 0x00;
+                    target[2] = 0x00;
+                    target[3] = 0xFF;
+                }
+                break;
+        }
+    }
+
+    _statistics.uploadedBytes += tile.bitmap.size();
+}
+
+void SoftwareRenderer::rasterize(int firstRow, int lastRow)
+{
+    auto const width = unbox<size_t>(_renderSize.width);
+    auto const clearColor = std::array<uint8_t, 4> {
+        _clearColor.red(), _clearColor.green(), _clearColor.blue(), _clearColor.alpha()
+    };
+    for (auto row = firstRow; row < lastRow; ++row)
+    {
+        auto* pixel = _frameBuffer.data() + static_cast<size_t>(row) * width * 4;
+        for (size_t i = 0; i < width; ++i, pixel += 4)
+            std::memcpy(pixel, clearColor.data(), 4);
+    }
+
+    auto scanline = Scanline {};
+    for (auto const& rectangle: _rectangles)
+        fillRectangle(rectangle, firstRow, lastRow, scanline);
+
+    for (auto const& tile: _tiles)
+        blendTile(tile, firstRow, lastRow, scanline);
+}
+
+void SoftwareRenderer::fillRectangle(Rectangle const& rectangle,
+                                     int firstRow,
+                                     int lastRow,
+                                     Scanline& scanline)
+{
+    auto const left = max(rectangle.x, 0);
+    auto const right = min(rectangle.x + rectangle.width, unbox<int>(_renderSize.width));
+    auto const top = max(rectangle.y, firstRow);
+    auto const bottom = min(rectangle.y + rectangle.height, lastRow);
+    if (left >= right || top >= bottom)
+        return;
+
+    auto const count = static_cast<size_t>(right - left);
+    auto const& color = rectangle.color;
+    auto& span = scanline.pixels;
+    span.resize(count * 4);
+    for (size_t i = 0; i < count; ++i)
+    {
+        span[i * 4 + 0] = color.red();
+        span[i * 4 + 1] = color.green();
+        span[i * 4 + 2] = color.blue();
+        span[i * 4 + 3] = color.alpha();
+    }
+
+    auto const width = unbox<size_t>(_renderSize.width);
+    for (auto row = top; row < bottom; ++row)
+    {
+        auto* target = _frameBuffer.data() + (static_cast<size_t>(row) * width + static_cast<size_t>(left)) * 4;
+        blendSpan(target, span.data(), count);
+    }
+}
+
+void SoftwareRenderer::blendTile(atlas::RenderTile const& tile,
+                                 int firstRow,
+                                 int lastRow,
+                                 Scanline& scanline)
+{
+    auto const bitmapWidth = unbox<int>(tile.bitmapSize.width);
+    auto const bitmapHeight = unbox<int>(tile.bitmapSize.height);
+    auto const targetWidth = unbox<int>(tile.targetSize.width) ? unbox<int>(tile.targetSize.width) : bitmapWidth;
+    auto const targetHeight =
+        unbox<int>(tile.targetSize.height) ? unbox<int>(tile.targetSize.height) : bitmapHeight;
+
+    auto const left = max(tile.x.value, 0);
+    auto const right = min(tile.x.value + targetWidth, unbox<int>(_renderSize.width));
+    auto const top = max(tile.y.value, firstRow);
+    auto const bottom = min(tile.y.value + targetHeight, lastRow);
+    if (left >= right || top >= bottom || _atlas.empty())
+        return;
+
+    // Maps target pixels onto the tile's pixels, sampling at the pixel centers.
+    auto const sample = [](int offset, int bitmapExtent, int targetExtent) {
+        return (2 * offset + 1) * bitmapExtent / (2 * targetExtent);
+    };
+
+    auto const atlasWidth = unbox<size_t>(_atlasSize.width);
+    auto const atlasHeight = unbox<int>(_atlasSize.height);
+    auto const maxColumn = static_cast<int>(atlasWidth) - 1;
+    auto& columns = scanline.columns;
+    columns.resize(static_cast<size_t>(right - left));
+    for (auto x = left; x < right; ++x)
+        columns[static_cast<size_t>(x - left)] =
+            min(tile.tileLocation.x.value + sample(x - tile.x.value, bitmapWidth, targetWidth), maxColumn);
+
+    auto const count = columns.size();
+    auto& pixels = scanline.pixels;
+    pixels.resize(count * 4);
+    auto const width = unbox<size_t>(_renderSize.width);
+    for (auto y = top; y < bottom; ++y)
+    {
+        auto const atlasRow =
+            min(tile.tileLocation.y.value + sample(y - tile.y.value, bitmapHeight, targetHeight), atlasHeight - 1);
+        shadeRow(pixels.data(), _atlas.data() + static_cast<size_t>(atlasRow) * atlasWidth * 4, columns, tile);
+        auto* target = _frameBuffer.data() + (static_cast<size_t>(y) * width + static_cast<size_t>(left)) * 4;
+        blendSpan(target, pixels.data(), count);
+    }
+}
+
+void SoftwareRenderer::runBands(std::function<void(int, int)> const& job)
+{
+    auto const height = unbox<int>(_renderSize.height);
+    auto const bandCount = static_cast<int>(threadCount());
+    if (bandCount == 1)
+    {
+        job(0, height);
+        return;
+    }
+
+    {
+        auto const _ = std::lock_guard { _mutex };
+        _job = &job;
+        _pendingBands = _workers.size();
+        ++_jobGeneration;
+    }
+    _jobAvailable.notify_all();
+
+    job(0, height / bandCount);
+
+    auto lock = std::unique_lock { _mutex };
+    _jobFinished.wait(lock, [this]() { return _pendingBands == 0; });
+    _job = nullptr;
+}
+
+void SoftwareRenderer::work(size_t band)
+{
+    auto generation = uint64_t { 0 };
+    auto lock = std::unique_lock { _mutex };
+    for (;;)
+    {
+        _jobAvailable.wait(lock, [&]() { return _stopping || _jobGeneration != generation; });
+        if (_stopping)
+            return;
+        generation = _jobGeneration;
+
+        auto const& job = *_job;
+        auto const height = unbox<int>(_renderSize.height);
+        auto const bandCount = static_cast<int>(threadCount());
+        auto const index = static_cast<int>(band);
+        lock.unlock();
+
+        job(height * index / bandCount, height * (index + 1) / bandCount);
+
+        lock.lock();
+        if (--_pendingBands == 0)
+            _jobFinished.notify_one();
+    }
+}
+
+} // namespace vtrasterizer
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: Apache-2.0
+#pragma once
+
+#include <vtrasterizer/RenderTarget.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace vtrasterizer
+{
+
+/**
+ * Render target that rasterizes on the CPU into an RGBA framebuffer in host memory.
+ *
+ * This does not require any GPU context, and is therefore suitable for benchmarking
+ * and testing everything downstream of the render buffer, e.g. in CI.
+ *
+ * Render commands are executed in the same order as OpenGLRenderer does:
+ * all rectangles first, then the atlas tile uploads, and then all tiles.
+ * Tiles are blended onto the framebuffer just like the OpenGL text shader does,
+ * using the SIMD instructions available (SSE2 or NEON).
+ *
+ * The framebuffer is split into horizontal bands of rows that are rasterized in parallel,
+ * each band executing all render commands that intersect with it.
+ *
+ * @see OpenGLRenderer
+ */
+class SoftwareRenderer final: public RenderTarget, public atlas::AtlasBackend
+{
+  public:
+    struct Statistics
+    {
+        uint64_t frames = 0;
+        uint64_t rectangles = 0;    // Number of rectangles rendered.
+        uint64_t tiles = 0;         // Number of atlas tiles rendered.
+        uint64_t tileUploads = 0;   // Number of tiles uploaded into the atlas.
+        uint64_t uploadedBytes = 0; // Number of bytes uploaded into the atlas.
+    };
+
+    /// @param renderSize  size of the framebuffer in pixels.
+    /// @param threadCount number of threads to rasterize a frame with, including the calling thread.
+    explicit SoftwareRenderer(ImageSize renderSize, size_t threadCount = 1);
+    ~SoftwareRenderer() override;
+
+    SoftwareRenderer(SoftwareRenderer const&) = delete;
+    SoftwareRenderer(SoftwareRenderer&&) = delete;
+    SoftwareRenderer& operator=(SoftwareRenderer const&) = delete;
+    SoftwareRenderer& operator=(SoftwareRenderer&&) = delete;
+
+    // {{{ RenderTarget
+    void setRenderSize(ImageSize size) override;
+    void setMargin(PageMargin margin) override { _margin = margin; }
+    atlas::AtlasBackend& textureScheduler() override { return *this; }
+    void renderRectangle(int x, int y, Width width, Height height, RGBAColor color) override;
+    void scheduleScreenshot(ScreenshotCallback callback) override;
+    void execute(std::chrono::steady_clock::time_point now) override;
+    void clearCache() override {}
+    std::optional<AtlasTextureScreenshot> readAtlas() override;
+    void inspect(std::ostream& output) const override;
+    // }}}
+
+    // {{{ AtlasBackend
+    [[nodiscard]] ImageSize atlasSize() const noexcept override { return _atlasSize; }
+    void configureAtlas(atlas::ConfigureAtlas atlas) override;
+    void uploadTile(atlas::UploadTile tile) override;
+    void renderTile(atlas::RenderTile tile) override;
+    // }}}
+
+    /// Sets the color the framebuffer is cleared with at the start of every frame.
+    void setClearColor(RGBAColor color) noexcept { _clearColor = color; }
+
+    [[nodiscard]] ImageSize renderSize() const noexcept { return _renderSize; }
+    [[nodiscard]] size_t threadCount() const noexcept { return _threadCount; }
+
+    /// @returns the RGBA pixels of the last frame, top row first.
+    [[nodiscard]] std::vector<uint8_t> const& frameBuffer() const noexcept { return _frameBuffer; }
+
+    [[nodiscard]] Statistics const& statistics() const noexcept { return _statistics; }
+    void resetStatistics() noexcept { _statistics = {}; }
+
+  private:
+    struct Rectangle
+    {
+        int x;
+        int y;
+        int width;
+        int height;
+        RGBAColor color;
+    };
+
+    // Per band buffers for the pixels of a row to be blended.
+    struct Scanline
+    {
+        std::vector<uint8_t> pixels;
+        std::vector<int> columns; // Atlas column to sample for each pixel.
+    };
+
+    void uploadTileNow(atlas::UploadTile const& tile);
+    void rasterize(int firstRow, int lastRow);
+    void fillRectangle(Rectangle const& rectangle, int firstRow, int lastRow, Scanline& scanline);
+    void blendTile(atlas::RenderTile const& tile, int firstRow, int lastRow, Scanline& scanline);
+    void runBands(std::function<void(int, int)> const& job);
+    void work(size_t band);
+
+    ImageSize _renderSize;
+    PageMargin _margin {};
+    RGBAColor _clearColor { 0, 0, 0, 0 };
+    std::vector<uint8_t> _frameBuffer;
+
+    ImageSize _atlasSize {};
+    std::vector<uint8_t> _atlas; // RGBA pixels of the texture atlas.
+
+    // Render commands scheduled for the next execute().
+    std::vector<Rectangle> _rectangles;
+    std::optional<atlas::ConfigureAtlas> _configureAtlas;
+    std::vector<atlas::UploadTile> _uploads;
+    std::vector<atlas::RenderTile> _tiles;
+    std::optional<ScreenshotCallback> _pendingScreenshotCallback;
+
+    Statistics _statistics;
+
+    // Worker threads rasterizing all but the first band of rows.
+    size_t _threadCount;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::condition_variable _jobAvailable;
+    std::condition_variable _jobFinished;
+    std::function<void(int, int)> const* _job = nullptr;
+    uint64_t _jobGeneration = 0;
+    size_t _pendingBands = 0;
+    bool _stopping = false;
+};
+
+} // namespace vtrasterizer
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: Apache-2.0
+#include <vtrasterizer/SoftwareRenderer.h>
+
+#include <catch2/catch_test_macros.hpp>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+using namespace vtbackend;
+using namespace vtrasterizer;
+
+using std::array;
+using std::vector;
+
+namespace
+{
+using Pixel = array<uint8_t, 4>;
+
+Pixel pixelAt(SoftwareRenderer const& renderer, int x, int y)
+{
+    auto const offset = (static_cast<size_t>(y) * unbox<size_t>(renderer.renderSize().width) + x) * 4;
+    auto const& frame = renderer.frameBuffer();
+    return Pixel { frame[offset], frame[offset + 1], frame[offset + 2], frame[offset + 3] };
+}
+
+// Reference implementation of blending (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) for the color,
+// and (GL_ONE, GL_ONE) for the alpha channel.
+Pixel blend(Pixel source, Pixel target)
+{
+    auto const mix = [&](int i) {
+        auto const value = (source[i] * source[3] + target[i] * (255 - source[3])) / 255.0;
+        return static_cast<uint8_t>(value + 0.5);
+    };
+    return Pixel { mix(0), mix(1), mix(2), static_cast<uint8_t>(std::min(255, source[3] + target[3])) };
+}
+
+void configureAtlas(SoftwareRenderer& renderer)
+{
+    auto atlas = atlas::ConfigureAtlas {};
+    atlas.size = ImageSize { Width(16), Height(16) };
+    atlas.properties.format = atlas::Format::RGBA;
+    atlas.properties.tileSize = ImageSize { Width(4), Height(4) };
+    renderer.configureAtlas(atlas);
+}
+
+atlas::RenderTile renderTile(int x, int y, ImageSize bitmapSize, uint32_t selector, RGBAColor color)
+{
+    auto tile = atlas::RenderTile {};
+    tile.x = atlas::RenderTile::X { x };
+    tile.y = atlas::RenderTile::Y { y };
+    tile.bitmapSize = bitmapSize;
+    tile.color = atlas::normalize(color);
+    tile.tileLocation = atlas::TileLocation { atlas::TileLocation::X { 4 }, atlas::TileLocation::Y { 4 } };
+    tile.fragmentShaderSelector = selector;
+    return tile;
+}
+} // namespace
+
+TEST_CASE("SoftwareRenderer.rectangle", "[software]")
+{
+    auto renderer = SoftwareRenderer { ImageSize { Width(8), Height(4) } };
+    renderer.setClearColor(RGBAColor { 0x10, 0x20, 0x30, 0x00 });
+    renderer.renderRectangle(2, 1, Width(4), Height(2), RGBAColor { 0xFF, 0x00, 0x00, 0xFF });
+    renderer.renderRectangle(4, 2, Width(10), Height(10), RGBAColor { 0x00, 0x00, 0xFF, 0x80 });
+    renderer.execute(std::chrono::steady_clock::now());
+
+    CHECK(pixelAt(renderer, 0, 0) == Pixel { 0x10, 0x20, 0x30, 0x00 });
+    CHECK(pixelAt(renderer, 2, 1) == Pixel { 0xFF, 0x00, 0x00, 0xFF });
+    CHECK(pixelAt(renderer, 5, 2)
+          == blend(Pixel { 0x00, 0x00, 0xFF, 0x80 }, Pixel { 0xFF, 0x00, 0x00, 0xFF }));
+    CHECK(pixelAt(renderer, 7, 3)
+          == blend(Pixel { 0x00, 0x00, 0xFF, 0x80 }, Pixel { 0x10, 0x20, 0x30, 0x00 }));
+    CHECK(pixelAt(renderer, 6, 1) == Pixel { 0x10, 0x20, 0x30, 0x00 });
+
+    CHECK(renderer.statistics().frames == 1);
+    CHECK(renderer.statistics().rectangles == 2);
+}
+
+TEST_CASE("SoftwareRenderer.tiles", "[software]")
+{
+    auto renderer = SoftwareRenderer { ImageSize { Width(8), Height(8) } };
+    renderer.setClearColor(RGBAColor { 0x00, 0x00, 0x00, 0xFF });
+    configureAtlas(renderer);
+
+    auto const tileSize = ImageSize { Width(2), Height(2) };
+    auto upload = atlas::UploadTile {};
+    upload.location = atlas::TileLocation { atlas::TileLocation::X { 4 }, atlas::TileLocation::Y { 4 } };
+    upload.bitmapSize = tileSize;
+
+    SECTION("alpha glyph")
+    {
+        upload.bitmap = { 0xFF, 0x00, 0x80, 0x40 };
+        upload.bitmapFormat = atlas::Format::Red;
+        renderer.uploadTile(upload);
+        auto const color = RGBAColor { 0xFF, 0xFF, 0x00, 0xFF };
+        renderer.renderTile(renderTile(1, 2, tileSize, FRAGMENT_SELECTOR_GLYPH_ALPHA, color));
+        renderer.execute(std::chrono::steady_clock::now());
+
+        auto const black = Pixel { 0x00, 0x00, 0x00, 0xFF };
+        CHECK(pixelAt(renderer, 1, 2) == Pixel { 0xFF, 0xFF, 0x00, 0xFF });
+        CHECK(pixelAt(renderer, 2, 2) == black);
+        CHECK(pixelAt(renderer, 1, 3) == blend(Pixel { 0xFF, 0xFF, 0x00, 0x80 }, black));
+        CHECK(pixelAt(renderer, 2, 3) == blend(Pixel { 0xFF, 0xFF, 0x00, 0x40 }, black));
+        CHECK(pixelAt(renderer, 3, 2) == black);
+        CHECK(renderer.statistics().tileUploads == 1);
+        CHECK(renderer.statistics().tiles == 1);
+    }
+
+    SECTION("image")
+    {
+        upload.bitmap = { 1, 2, 3, 0xFF, 4, 5, 6, 0xFF, 7, 8, 9, 0xFF, 10, 11, 12, 0xFF };
+        upload.bitmapFormat = atlas::Format::RGBA;
+        renderer.uploadTile(upload);
+
+        // Scaled up to twice the size.
+        auto tile = renderTile(0, 0, tileSize, FRAGMENT_SELECTOR_IMAGE_BGRA, RGBAColor {});
+        tile.targetSize = ImageSize { Width(4), Height(4) };
+        renderer.renderTile(tile);
+        renderer.execute(std::chrono::steady_clock::now());
+
+        CHECK(pixelAt(renderer, 0, 0) == Pixel { 1, 2, 3, 0xFF });
+        CHECK(pixelAt(renderer, 1, 1) == Pixel { 1, 2, 3, 0xFF });
+        CHECK(pixelAt(renderer, 2, 1) == Pixel { 4, 5, 6, 0xFF });
+        CHECK(pixelAt(renderer, 1, 2) == Pixel { 7, 8, 9, 0xFF });
+        CHECK(pixelAt(renderer, 3, 3) == Pixel { 10, 11, 12, 0xFF });
+        CHECK(pixelAt(renderer, 4, 4) == Pixel { 0x00, 0x00, 0x00, 0xFF });
+
+        // Tiles stay in the atlas across frames.
+        renderer.renderTile(renderTile(6, 6, tileSize, FRAGMENT_SELECTOR_IMAGE_BGRA, RGBAColor {}));
+        renderer.execute(std::chrono::steady_clock::now());
+        CHECK(pixelAt(renderer, 0, 0) == Pixel { 0x00, 0x00, 0x00, 0xFF });
+        CHECK(pixelAt(renderer, 7, 7) == Pixel { 10, 11, 12, 0xFF });
+    }
+
+    auto const atlasScreenshot = renderer.readAtlas();
+    REQUIRE(atlasScreenshot.has_value());
+    CHECK(atlasScreenshot->size == ImageSize { Width(16), Height(16) });
+}
+
+TEST_CASE("SoftwareRenderer.threads", "[software]")
+{
+    // Renders a scene of randomly blended rectangles and tiles, which must come out the same,
+    // regardless of how many threads are rasterizing it.
+    auto const renderSize = ImageSize { Width(37), Height(29) };
+    auto const render = [&](size_t threadCount) {
+        auto renderer = SoftwareRenderer { renderSize, threadCount };
+        configureAtlas(renderer);
+
+        auto upload = atlas::UploadTile {};
+        upload.location = atlas::TileLocation { atlas::TileLocation::X { 4 }, atlas::TileLocation::Y { 4 } };
+        upload.bitmapSize = ImageSize { Width(4), Height(4) };
+        upload.bitmapFormat = atlas::Format::RGBA;
+        for (int i = 0; i < 64; ++i)
+            upload.bitmap.push_back(static_cast<uint8_t>(i * 37));
+        renderer.uploadTile(upload);
+
+        std::srand(42);
+        auto const randomColor = []() {
+            return RGBAColor { static_cast<uint8_t>(std::rand()),
+                               static_cast<uint8_t>(std::rand()),
+                               static_cast<uint8_t>(std::rand()),
+                               static_cast<uint8_t>(std::rand()) };
+        };
+        for (int i = 0; i < 20; ++i)
+            renderer.renderRectangle(std::rand() % 40 - 5,
+                                     std::rand() % 30 - 5,
+                                     Width::cast_from(std::rand() % 20),
+                                     Height::cast_from(std::rand() % 20),
+                                     randomColor());
+        for (int i = 0; i < 40; ++i)
+        {
+            auto tile = renderTile(std::rand() % 40 - 4,
+                                   std::rand() % 30 - 4,
+                                   upload.bitmapSize,
+                                   static_cast<uint32_t>(std::rand() % 4),
+                                   randomColor());
+            tile.targetSize = ImageSize { Width::cast_from(1 + std::rand() % 8), Height::cast_from(4) };
+            renderer.renderTile(tile);
+        }
+
+        auto screenshot = vector<uint8_t> {};
+        renderer.scheduleScreenshot([&](vector<uint8_t> const& pixels, ImageSize size) {
+            CHECK(size == renderSize);
+            screenshot = pixels;
+        });
+        renderer.execute(std::chrono::steady_clock::now());
+        CHECK(renderer.threadCount() == threadCount);
+        return screenshot;
+    };
+
+    auto const expected = render(1);
+    REQUIRE(expected.size() == renderSize.area() * 4);
+    CHECK(render(2) == expected);
+    CHECK(render(5) == expected);
+}
+
+TEST_CASE("SoftwareRenderer.blend", "[software]")
+{
+    // Covers the SIMD code path, as well as the scalar one for the remaining pixels of a row.
+    auto const renderSize = ImageSize { Width(19), Height(1) };
+    auto renderer = SoftwareRenderer { renderSize };
+    for (unsigned alpha = 0; alpha < 256; alpha += 15)
+    {
+        auto const background = RGBAColor { 0x12, 0x34, 0x56, static_cast<uint8_t>(255 - alpha) };
+        auto const foreground =
+            RGBAColor { static_cast<uint8_t>(alpha), 0xF0, 0x0F, static_cast<uint8_t>(alpha) };
+        renderer.setClearColor(background);
+        renderer.renderRectangle(0, 0, Width(19), Height(1), foreground);
+        renderer.execute(std::chrono::steady_clock::now());
+
+        auto const expected = blend(Pixel { foreground.red(), 0xF0, 0x0F, foreground.alpha() },
+                                    Pixel { 0x12, 0x34, 0x56, background.alpha() });
+        for (int x = 0; x < 19; ++x)
+            CHECK(pixelAt(renderer, x, 0) == expected);
+    }
+}
@@ -182,6 +182,7 @@ namespace
     constexpr auto FirstReservedChar = char32_t { 0x21 };
     constexpr auto LastReservedChar = char32_t { 0x7E };
     constexpr auto DirectMappedCharsCount = LastReservedChar - FirstReservedChar + 1;
+    constexpr auto DirectMappedTileCount = DirectMappedCharsCount * DirectMappedFontCount;
 
     strong_hash hashGlyphKeyAndPresentation(text::glyph_key const& glyphKey,
                                             unicode::PresentationStyle presentation) noexcept
@@ -286,6 +287,9 @@ text::font_locator& createFontLocator(FontLocatorEngine engine)
 // or even computed based on memory resources available?
 constexpr uint32_t TextShapingCacheSize = 4000;
 
+// Number of shaping cache entries reserved for text that was shaped only once so far.
+constexpr uint32_t TextShapingCacheProbationSize = TextShapingCacheSize / 5;
+
 TextRenderer::TextRenderer(GridMetrics const& gridMetrics,
                            text::shaper& textShaper,
                            FontDescriptions& fontDescriptions,
@@ -298,7 +302,9 @@ TextRenderer::TextRenderer(GridMetrics const& gridMetrics,
     _fonts { fontKeys },
     _textShapingCache { ShapingResultCache::create(crispy::strong_hashtable_size { 16384 },
                                                    crispy::lru_capacity { TextShapingCacheSize },
-                                                   "Text shaping cache") },
+                                                   "Text shaping cache",
+                                                   crispy::lru_probation_capacity {
+                                                       TextShapingCacheProbationSize }) },
     _textShaper { textShaper },
     _boxDrawingRenderer { gridMetrics }
 {
@@ -307,6 +313,8 @@ TextRenderer::TextRenderer(GridMetrics const& gridMetrics,
 void TextRenderer::inspect(ostream& textOutput) const
 {
     textOutput << "TextRenderer:\n";
+    textOutput << fmt::format(
+        "direct mapped glyphs : {} tiles, {}\n", _directMapping.count, _directMappingStats);
     _textShapingCache->inspect(textOutput);
     _boxDrawingRenderer.inspect(textOutput);
 }
@@ -314,7 +322,7 @@ void TextRenderer::inspect(ostream& textOutput) const
 void TextRenderer::setRenderTarget(
     RenderTarget& renderTarget, atlas::DirectMappingAllocator<RenderTileAttributes>& directMappingAllocator)
 {
-    _directMapping = directMappingAllocator.allocate(DirectMappedCharsCount);
+    _directMapping = directMappingAllocator.allocate(DirectMappedTileCount);
     Renderable::setRenderTarget(renderTarget, directMappingAllocator);
     _boxDrawingRenderer.setRenderTarget(renderTarget, directMappingAllocator);
     clearCache();
@@ -329,6 +337,13 @@ void TextRenderer::setTextureAtlas(TextureAtlas& atlas)
         initializeDirectMapping();
 }
 
+void TextRenderer::recordMetrics(crispy::metrics::hit_rate& shapingCache) noexcept
+{
+    auto const stats = _textShapingCache->fetchAndClearStats();
+    shapingCache.hit(stats.hits);
+    shapingCache.miss(stats.misses);
+}
+
 void TextRenderer::clearCache()
 {
     if (_textureAtlas && _directMapping)
@@ -386,21 +401,27 @@ void TextRenderer::restrictToTileSize(TextureAtlas::TileCreateData& tileCreateDa
 void TextRenderer::initializeDirectMapping()
 {
     Require(_textureAtlas);
-    Require(_directMapping.count == DirectMappedCharsCount);
+    Require(_directMapping.count == DirectMappedTileCount);
 
-    _directMappedGlyphKeyToTileIndex.clear();
-    _directMappedGlyphKeyToTileIndex.resize(LastReservedChar + 1);
-
-    for (char32_t codepoint = FirstReservedChar; codepoint <= LastReservedChar; ++codepoint)
+    auto const fonts = directMappedFonts();
+    for (size_t fontIndex = 0; fontIndex < fonts.size(); ++fontIndex)
     {
-        if (optional<text::glyph_position> gposOpt = _textShaper.shape(_fonts.regular, codepoint))
+        auto& glyphKeyToTileIndex = _directMappedGlyphKeyToTileIndex[fontIndex];
+        auto const baseIndex = static_cast<uint32_t>(fontIndex * DirectMappedCharsCount);
+
+        glyphKeyToTileIndex.clear();
+        glyphKeyToTileIndex.resize(LastReservedChar + 1);
+
+        for (char32_t codepoint = FirstReservedChar; codepoint <= LastReservedChar; ++codepoint)
         {
-            text::glyph_key const& glyph = gposOpt.value().glyph;
-            if (glyph.index.value >= _directMappedGlyphKeyToTileIndex.size())
-                _directMappedGlyphKeyToTileIndex.resize(glyph.index.value
-                                                        + (LastReservedChar - codepoint + 1));
-            _directMappedGlyphKeyToTileIndex[glyph.index.value] =
-                _directMapping.toTileIndex(codepoint - FirstReservedChar);
+            if (optional<text::glyph_position> gposOpt = _textShaper.shape(fonts[fontIndex], codepoint))
+            {
+                text::glyph_key const& glyph = gposOpt.value().glyph;
+                if (glyph.index.value >= glyphKeyToTileIndex.size())
+                    glyphKeyToTileIndex.resize(glyph.index.value + (LastReservedChar - codepoint + 1));
+                glyphKeyToTileIndex[glyph.index.value] =
+                    _directMapping.toTileIndex(baseIndex + codepoint - FirstReservedChar);
+            }
         }
     }
 }
@@ -408,15 +429,19 @@ void TextRenderer::initializeDirectMapping()
 Renderable::AtlasTileAttributes const* TextRenderer::ensureRasterizedIfDirectMapped(
     text::glyph_key const& glyph)
 {
-    if (!isGlyphDirectMapped(glyph))
+    auto const tileIndex = directMappedTileIndex(glyph);
+    if (!tileIndex)
         return nullptr;
 
-    auto const tileIndex = _directMappedGlyphKeyToTileIndex[glyph.index.value];
-
     if (_textureAtlas->directMapped(tileIndex).bitmapSize.width.value)
+    {
         // TODO: Find a better way to test if the glyph was rasterized&uploaded already.
         // like: if (_textureAtlas->isDirectMappingSet(tileIndex)) ...
+        ++_directMappingStats.hits;
         return &_textureAtlas->directMapped(tileIndex);
+    }
+
+    ++_directMappingStats.misses;
 
     auto const tileLocation = _textureAtlas->tileLocation(tileIndex);
     auto tileCreateData = createRasterizedGlyph(tileLocation, glyph, unicode::PresentationStyle::Text);
@@ -458,11 +483,11 @@ void TextRenderer::renderLine(vtbackend::RenderLine const& renderLine)
                                    makeTextStyle(renderLine.textAttributes.flags));
 }
 
-void TextRenderer::renderCell(vtbackend::RenderCell const& cell)
+void TextRenderer::renderCell(vtbackend::RenderCell const& cell, std::u32string_view graphemeCluster)
 {
     // fmt::print("renderCell: {} {} {} {} {}\n",
     //            cell.position,
-    //            unicode::convert_to<char>(u32string_view(cell.codepoints)),
+    //            unicode::convert_to<char>(graphemeCluster),
     //            _forceUpdateInitialPenPosition ? "forcedRestart" : "-",
     //            cell.groupStart ? "groupStart" : "-",
     //            cell.groupEnd ? "groupEnd" : "-");
@@ -471,7 +496,7 @@ void TextRenderer::renderCell(vtbackend::RenderCell const& cell)
         _textClusterGrouper.forceGroupStart();
 
     _textClusterGrouper.renderCell(cell.position,
-                                   cell.codepoints,
+                                   graphemeCluster,
                                    makeTextStyle(cell.attributes.flags),
                                    cell.attributes.foregroundColor);
 
@@ -17,6 +17,7 @@
 #include <crispy/FNV.h>
 #include <crispy/StrongHash.h>
 #include <crispy/StrongLRUHashtable.h>
+#include <crispy/metrics.h>
 #include <crispy/point.h>
 #include <crispy/size.h>
 
@@ -26,6 +27,7 @@
 #include <gsl/span>
 #include <gsl/span_ext>
 
+#include <array>
 #include <vector>
 
 namespace vtrasterizer
@@ -42,6 +44,9 @@ struct FontKeys
     text::font_key emoji;
 };
 
+// Number of font styles (regular, bold, italic, bold italic) whose ASCII glyphs are direct-mapped.
+constexpr size_t DirectMappedFontCount = 4;
+
 struct TextRendererEvents
 {
     virtual ~TextRendererEvents() = default;
@@ -75,8 +80,8 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
     void beginFrame();
 
     /// Renders a given terminal's grid cell that has been
-    /// transformed into a RenderCell.
-    void renderCell(vtbackend::RenderCell const& cell);
+    /// transformed into a RenderCell, along with its grapheme cluster.
+    void renderCell(vtbackend::RenderCell const& cell, std::u32string_view graphemeCluster);
 
     void renderCell(vtbackend::CellLocation position,
                     std::u32string_view graphemeCluster,
@@ -88,6 +93,9 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
     /// Must be invoked when rendering the terminal's text has finished for this frame.
     void endFrame();
 
+    /// Adds the text shaping cache's hits and misses since the last call to the given metric.
+    void recordMetrics(crispy::metrics::hit_rate& shapingCache) noexcept;
+
   private:
     void initializeDirectMapping();
 
@@ -163,15 +171,36 @@ class TextRenderer: public Renderable, public TextClusterGrouper::Events
 
     DirectMapping _directMapping {};
 
-    // Maps from glyph index to tile index.
-    std::vector<uint32_t> _directMappedGlyphKeyToTileIndex {};
+    // Maps from glyph index to tile index, for each of the directMappedFonts().
+    std::array<std::vector<uint32_t>, DirectMappedFontCount> _directMappedGlyphKeyToTileIndex {};
+
+    // Hits and misses (rasterizations) of the direct-mapped tiles, which are never evicted.
+    crispy::lru_hashtable_stats _directMappingStats {};
+
+    [[nodiscard]] std::array<text::font_key, DirectMappedFontCount> directMappedFonts() const noexcept
+    {
+        // The emoji font is not direct-mapped.
+        return { _fonts.regular, _fonts.bold, _fonts.italic, _fonts.boldItalic };
+    }
 
-    [[nodiscard]] bool isGlyphDirectMapped(text::glyph_key const& glyph) const noexcept
+    // Returns the direct-mapped tile index of the given glyph, or 0 if it is not direct-mapped.
+    [[nodiscard]] uint32_t directMappedTileIndex(text::glyph_key const& glyph) const noexcept
     {
-        return _directMapping                  // Is direct mapping enabled?
-               && glyph.font == _fonts.regular // Only regular font is direct-mapped for now.
-               && glyph.index.value < _directMappedGlyphKeyToTileIndex.size()
-               && _directMappedGlyphKeyToTileIndex[glyph.index.value] != 0;
+        if (!_directMapping) // Is direct mapping enabled?
+            return 0;
+
+        auto const fonts = directMappedFonts();
+        for (size_t fontIndex = 0; fontIndex < fonts.size(); ++fontIndex)
+        {
+            if (glyph.font == fonts[fontIndex])
+            {
+                auto const& glyphKeyToTileIndex = _directMappedGlyphKeyToTileIndex[fontIndex];
+                if (glyph.index.value < glyphKeyToTileIndex.size())
+                    return glyphKeyToTileIndex[glyph.index.value];
+                return 0;
+            }
+        }
+        return 0;
     }
 
     AtlasTileAttributes const* ensureRasterizedIfDirectMapped(text::glyph_key const& glyphKey);
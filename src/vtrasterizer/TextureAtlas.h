@@ -7,9 +7,11 @@
 #include <crispy/StrongHash.h>
 #include <crispy/StrongLRUHashtable.h>
 #include <crispy/assert.h>
+#include <crispy/metrics.h>
 
 #include <fmt/format.h>
 
+#include <utility>
 #include <variant> // monostate
 #include <vector>
 
@@ -303,6 +305,21 @@ class TextureAtlas
 
     void inspect(std::ostream& output) const;
 
+    // Retrieves the tile cache's hits, misses and evictions since the last call.
+    [[nodiscard]] crispy::lru_hashtable_stats fetchAndClearStats() noexcept
+    {
+        collectStats();
+        return std::exchange(_stats, crispy::lru_hashtable_stats {});
+    }
+
+    // Adds the tiles uploaded and evicted since the last call to the given metrics.
+    void recordMetrics(crispy::metrics::counter& uploads, crispy::metrics::counter& evictions) noexcept
+    {
+        collectStats();
+        uploads.add(std::exchange(_uploadCount, 0));
+        evictions.add(std::exchange(_evictionCount, 0));
+    }
+
     [[nodiscard]] uint32_t tilesInX() const noexcept { return _tilesInX; }
     [[nodiscard]] uint32_t tilesInY() const noexcept { return _tilesInY; }
 
@@ -314,6 +331,16 @@ class TextureAtlas
     std::optional<TileAttributes<Metadata>> constructTile(CreateTileDataFn createTileData,
                                                           uint32_t entryIndex);
 
+    // Takes over the tile cache's statistics, for both fetchAndClearStats() and recordMetrics().
+    void collectStats() noexcept
+    {
+        auto const stats = _tileCache->fetchAndClearStats();
+        _stats.hits += stats.hits;
+        _stats.misses += stats.misses;
+        _stats.recycles += stats.recycles;
+        _evictionCount += stats.recycles;
+    }
+
     AtlasBackend& _backend;
     AtlasProperties _atlasProperties;
     vtbackend::ImageSize _atlasSize;
@@ -324,6 +351,13 @@ class TextureAtlas
     // of tiles that can be stored into the atlas.
     TileCachePtr _tileCache;
 
+    // Tile cache statistics taken over by collectStats(), until fetched by fetchAndClearStats().
+    crispy::lru_hashtable_stats _stats {};
+
+    // Tiles uploaded and evicted, until recorded by recordMetrics().
+    uint64_t _uploadCount = 0;
+    uint64_t _evictionCount = 0;
+
     // A vector of precomputed mappings from entry index to TileLocation.
     std::vector<TileLocation> _tileLocations;
 
@@ -496,7 +530,12 @@ TextureAtlas<Metadata>::TextureAtlas(AtlasBackend& backend, AtlasProperties atla
                                // minus one for the LRU-sentinel entry (which is why entryIndex
                                // is between 1 and capacity inclusive)
                                _tilesInX * _tilesInY - _atlasProperties.directMappingCount - 1 },
-        "LRU cache for texture atlas") },
+        "LRU cache for texture atlas",
+        crispy::lru_probation_capacity { // Tiles are admitted into the probationary segment first,
+                                         // which is large enough for all tiles of a single frame,
+                                         // so that a frame full of rarely used glyphs
+                                         // does not evict the tiles in regular use.
+                                         atlasProperties.tileCount.value }) },
     _tileLocations { static_cast<size_t>(_tilesInX * _tilesInY) }
 {
     Require(_atlasProperties.tileCount.value <= _tileCache->capacity());
@@ -562,6 +601,7 @@ auto TextureAtlas<Metadata>::constructTile(CreateTileDataFn createTileData, uint
     tileUpload.bitmapFormat = tileCreateData.bitmapFormat;
     tileUpload.bitmap = std::move(tileCreateData.bitmap);
     _backend.uploadTile(std::move(tileUpload));
+    ++_uploadCount;
 
     auto instance = TileAttributes<Metadata> {};
     instance.location = tileLocation;
@@ -654,6 +694,7 @@ void TextureAtlas<Metadata>::setDirectMapping(uint32_t tileIndex, TileCreateData
     tileUpload.bitmapFormat = tileCreateData.bitmapFormat;
     tileUpload.bitmap = std::move(tileCreateData.bitmap);
     _backend.uploadTile(std::move(tileUpload));
+    ++_uploadCount;
 
     auto instance = TileAttributes<Metadata> {};
     instance.location = tileLocation;